@@ -22,6 +22,8 @@ check_include_files("sys/types.h;sys/time.h"    LOG4CPLUS_HAVE_SYS_TIME_H )
 check_include_files("sys/types.h;sys/timeb.h"   LOG4CPLUS_HAVE_SYS_TIMEB_H )
 check_include_files("sys/types.h;sys/stat.h"    LOG4CPLUS_HAVE_SYS_STAT_H )
 check_include_files(sys/file.h    LOG4CPLUS_HAVE_SYS_FILE_H )
+check_include_files("sys/types.h;sys/mman.h" LOG4CPLUS_HAVE_SYS_MMAN_H )
+check_include_files("sys/types.h;sys/uio.h" LOG4CPLUS_HAVE_SYS_UIO_H )
 check_include_files(syslog.h      LOG4CPLUS_HAVE_SYSLOG_H )
 check_include_files(arpa/inet.h   LOG4CPLUS_HAVE_ARPA_INET_H )
 check_include_files(netinet/in.h  LOG4CPLUS_HAVE_NETINET_IN_H )
@@ -73,6 +75,8 @@ check_function_exists(lstat         LOG4CPLUS_HAVE_LSTAT )
 check_function_exists(fcntl         LOG4CPLUS_HAVE_FCNTL )
 check_function_exists(lockf         LOG4CPLUS_HAVE_FLOCK )
 check_function_exists(flock         LOG4CPLUS_HAVE_LOCKF )
+check_function_exists(posix_fallocate LOG4CPLUS_HAVE_POSIX_FALLOCATE )
+check_function_exists(fdatasync     LOG4CPLUS_HAVE_FDATASYNC )
 check_function_exists(htons         LOG4CPLUS_HAVE_HTONS )
 check_function_exists(ntohs         LOG4CPLUS_HAVE_NTOHS )
 check_function_exists(htonl         LOG4CPLUS_HAVE_HTONL )
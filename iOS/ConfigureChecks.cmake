@@ -18,6 +18,8 @@ set(LOG4CPLUS_HAVE_SYS_TIME_H 1)
 set(LOG4CPLUS_HAVE_SYS_TIMEB_H 1)
 set(LOG4CPLUS_HAVE_SYS_STAT_H 1)
 set(LOG4CPLUS_HAVE_SYS_FILE_H 1)
+set(LOG4CPLUS_HAVE_SYS_MMAN_H 1)
+set(LOG4CPLUS_HAVE_SYS_UIO_H 1)
 set(LOG4CPLUS_HAVE_SYSLOG_H 1)
 set(LOG4CPLUS_HAVE_ARPA_INET_H 1)
 set(LOG4CPLUS_HAVE_NETINET_IN_H 1)
@@ -41,6 +41,8 @@
 #include <mutex>
 #include <atomic>
 #include <condition_variable>
+#include <span>
+#include <vector>
 
 
 namespace log4cplus {
@@ -176,6 +178,15 @@ namespace log4cplus {
          */
         void syncDoAppend(const log4cplus::spi::InternalLoggingEvent& event);
 
+        /**
+         * Batch variant of syncDoAppend(). The appender is locked only
+         * once for the whole batch. Threshold and filters are evaluated
+         * for each event and events that pass are handed over to {@link
+         * #appendBatch} together.
+         */
+        void syncDoAppendBatch(
+            std::span<log4cplus::spi::InternalLoggingEvent const> events);
+
         /**
          * This method performs book keeping related to asynchronous logging
          * and executes `syncDoAppend()` to do the actual logging.
@@ -183,6 +194,21 @@ namespace log4cplus {
 
         void asyncDoAppend(const log4cplus::spi::InternalLoggingEvent& event);
 
+        /**
+         * This method appends all events queued by `doAppend()` for
+         * asynchronous logging so far as one batch using
+         * `syncDoAppendBatch()`. It is executed by thread pool threads.
+         */
+        void asyncDoAppendBatch();
+
+        /**
+         * Discards events queued by `doAppend()` for asynchronous
+         * logging when they cannot be handed over to the thread pool.
+         *
+         * \return Number of discarded events.
+         */
+        std::size_t discardAsyncBatch();
+
         /**
          * This function checks `async` flag. It either executes
          * `syncDoAppend()` directly or enqueues its execution to thread pool
@@ -190,6 +216,14 @@ namespace log4cplus {
          */
         void doAppend(const log4cplus::spi::InternalLoggingEvent& event);
 
+        /**
+         * Batch variant of doAppend(). In asynchronous mode the events
+         * are queued one by one, otherwise `syncDoAppendBatch()` is
+         * executed directly.
+         */
+        void doAppendBatch(
+            std::span<log4cplus::spi::InternalLoggingEvent const> events);
+
         /**
          * Get the name of this appender. The name uniquely identifies the
          * appender.
@@ -288,6 +322,29 @@ namespace log4cplus {
          */
         virtual void append(const log4cplus::spi::InternalLoggingEvent& event) = 0;
 
+        /**
+         * Appends a batch of events that have already passed threshold
+         * and filter checks. The default implementation calls {@link
+         * #append} for each of them. Subclasses can override it to pay
+         * per-event costs like flushes or system calls only once per
+         * batch.
+         */
+        virtual void appendBatch(
+            std::span<log4cplus::spi::InternalLoggingEvent const * const>
+                events);
+
+        /**
+         * Called by syncDoAppend() and syncDoAppendBatch() after the
+         * event or events have been appended and the appender has been
+         * unlocked. It lets subclasses wait for something, e.g., for
+         * appended data to reach storage, without blocking other
+         * threads logging into the same appender. The default
+         * implementation does nothing.
+         *
+         * @param maxLevel Highest log level of the appended events.
+         */
+        virtual void afterAppend (LogLevel maxLevel);
+
         tstring & formatEvent (const log4cplus::spi::InternalLoggingEvent& event) const;
 
       // Data
@@ -321,14 +378,32 @@ namespace log4cplus {
         std::atomic<std::size_t> in_flight;
         std::mutex in_flight_mutex;
         std::condition_variable in_flight_condition;
+
+        //! Events queued for asynchronous append by `doAppend()` and not
+        //! yet taken by `asyncDoAppendBatch()`. Its size is limited by
+        //! thread pool queue size limit.
+        std::vector<spi::InternalLoggingEvent> async_batch;
+        //! Emptied vector returned by `asyncDoAppendBatch()` so that its
+        //! capacity is reused by the following batch.
+        std::vector<spi::InternalLoggingEvent> async_batch_spare;
+        std::mutex async_batch_mutex;
+        //! Signalled when `async_batch` has been taken or discarded.
+        std::condition_variable async_batch_condition;
+        //! True when `asyncDoAppendBatch()` has been enqueued into
+        //! thread pool and it has not taken `async_batch` yet.
+        bool async_batch_scheduled;
 #endif
 
         /** Is this appender closed? */
         bool closed;
 
     private:
+        //! Checks threshold and filters of this appender.
+        bool isAccepted(const log4cplus::spi::InternalLoggingEvent& event)
+            const;
+
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
-        void subtract_in_flight();
+        void subtract_in_flight(std::size_t count = 1);
 #endif
     };
 
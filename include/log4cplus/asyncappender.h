@@ -59,6 +59,24 @@ namespace log4cplus
    attached appendres are then appended to from a separate thread which reads
    events appended to this appender from a queue.
 
+   <h3>Properties</h3>
+   <dl>
+   <dt><tt>Appender</tt></dt>
+   <dd>Name of appender factory of the attached appender. Its properties
+   are in the <tt>Appender.</tt> subkey.</dd>
+
+   <dt><tt>QueueLimit</tt></dt>
+   <dd>Maximal number of events in the queue. Producers block when the
+   queue is full. Default is 100.</dd>
+
+   <dt><tt>QueueType</tt></dt>
+   <dd>Implementation of the events queue. <tt>Mutex</tt>, the default,
+   selects thread::Queue, which serializes producers on a mutex and a
+   semaphore. <tt>RingBuffer</tt> selects thread::RingBufferQueue, a
+   lock-free ring buffer which scales better with many producer threads.
+   Its capacity is <tt>QueueLimit</tt> rounded up to power of two.</dd>
+   </dl>
+
    \sa helpers::AppenderAttachableImpl
  */
 class LOG4CPLUS_EXPORT AsyncAppender
@@ -66,7 +84,11 @@ class LOG4CPLUS_EXPORT AsyncAppender
     , public helpers::AppenderAttachableImpl
 {
 public:
-    AsyncAppender (SharedAppenderPtr const & app, unsigned max_len);
+    //! Events queue implementation.
+    enum class QueueType { MUTEX, RING_BUFFER };
+
+    AsyncAppender (SharedAppenderPtr const & app, unsigned max_len,
+        QueueType queue_type = QueueType::MUTEX);
     AsyncAppender (helpers::Properties const &);
 
     AsyncAppender (AsyncAppender const &) = delete;
@@ -79,7 +101,7 @@ public:
 protected:
     virtual void append (spi::InternalLoggingEvent const &) override;
 
-    void init_queue_thread (unsigned);
+    void init_queue_thread (unsigned, QueueType);
 
     thread::AbstractThreadPtr queue_thread;
     thread::QueuePtr queue;
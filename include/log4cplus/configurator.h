@@ -211,6 +211,10 @@ namespace log4cplus
          * The items that could not be inserted are dropped instead.</li>
          * <li>Property <pre>log4cplus.threadPoolQueueSizeLimit</pre> can be used to
          * set thread pool queue size limit.</li>
+         * <li>Property <pre>log4cplus.eventClock</pre> selects the clock
+         * used for time stamps of logging events: <pre>PRECISE</pre>
+         * (the default), <pre>COARSE</pre> or <pre>TSC</pre>. See
+         * helpers::EventClock.</li>
          * </ul>
          *
          * <h3>Example</h3>
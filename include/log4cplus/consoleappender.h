@@ -31,6 +31,7 @@
 #endif
 
 #include <log4cplus/appender.h>
+#include <log4cplus/helpers/housekeeping.h>
 #include <locale>
 
 namespace log4cplus {
@@ -49,6 +50,12 @@ namespace log4cplus {
      * <dd>When it is set true, output stream will be flushed after
      * each appended event.</dd>
      *
+     * <dt><tt>MaxFlushDelay</tt></dt>
+     * <dd>When <tt>ImmediateFlush</tt> is false, non-zero value of this
+     * property, in milliseconds, limits how long appended events can
+     * stay buffered in the output stream. The stream is flushed by a
+     * housekeeping thread shared by all appenders.</dd>
+     *
      * <dt><tt>Locale</tt></dt>
      * <dd>This property specifies a locale name that will be imbued
      * into output stream. Locale can be specified either by system
@@ -69,7 +76,10 @@ namespace log4cplus {
      * </dl>
      * \sa Appender
      */
-    class LOG4CPLUS_EXPORT ConsoleAppender : public Appender {
+    class LOG4CPLUS_EXPORT ConsoleAppender
+        : public Appender
+        , protected helpers::IDelayedFlushClient
+    {
     public:
       // Ctors
         ConsoleAppender(bool logToStdErr = false, bool immediateFlush = false);
@@ -88,6 +98,10 @@ namespace log4cplus {
     protected:
         virtual void append(const spi::InternalLoggingEvent& event) override;
 
+        // helpers::IDelayedFlushClient interface.
+        virtual thread::Mutex const & dfcGetAccessMutex () const override;
+        virtual void dfcFlush () override;
+
       // Data
         bool logToStdErr;
         /**
@@ -97,6 +111,9 @@ namespace log4cplus {
         bool immediateFlush;
 
         std::unique_ptr<std::locale> locale;
+
+        //! Set up when <tt>MaxFlushDelay</tt> applies.
+        std::unique_ptr<helpers::DelayedFlusher> flusher;
     };
 
 } // end namespace log4cplus
@@ -34,7 +34,15 @@
 #include <log4cplus/fstreams.h>
 #include <log4cplus/helpers/timehelper.h>
 #include <log4cplus/helpers/lockfile.h>
+#include <log4cplus/helpers/circularfile.h>
+#include <log4cplus/helpers/compressedfile.h>
+#include <log4cplus/helpers/directfile.h>
+#include <log4cplus/helpers/filesync.h>
+#include <log4cplus/helpers/housekeeping.h>
+#include <log4cplus/helpers/timeindex.h>
 #include <fstream>
+#include <functional>
+#include <limits>
 #include <locale>
 #include <memory>
 
@@ -42,6 +50,18 @@
 namespace log4cplus
 {
 
+    //! Selects how FileAppenderBase writes its file.
+    enum class FileBackend
+    {
+        //! Output goes through `std::basic_ofstream`.
+        Stream,
+        //! Output goes through helpers::DirectFile.
+        Direct,
+        //! Output goes through helpers::DirectFile with io_uring.
+        IoUring
+    };
+
+
     /**
      * Base class for Appenders writing log events to a file.
      * It is constructed with uninitialized file object, so all
@@ -112,9 +132,137 @@ namespace log4cplus
      * not translate EOLs to OS specific character sequence. The default value
      * is <tt>Text</tt> and the underlying stream will be opened in text
      * mode.</dd>
+     *
+     * <dt><tt>Backend</tt></dt>
+     * <dd>This property selects how the file is written. The default
+     * value <tt>Stream</tt> uses <code>std::basic_ofstream</code>. The
+     * value <tt>Direct</tt> uses helpers::DirectFile, a file descriptor
+     * opened in append mode with a user space buffer that is drained
+     * using <code>write()</code> or <code>writev()</code>. With the
+     * <tt>Direct</tt> backend, <tt>BufferSize</tt> is in bytes and it
+     * defaults to 64 KiB. In <code>UNICODE</code> builds, formatted
+     * events are converted using <code>LOG4CPLUS_TSTRING_TO_STRING</code>
+     * and <tt>Locale</tt> is not used.
+     *
+     * The value <tt>IoUring</tt> works like <tt>Direct</tt> but the
+     * buffer is written asynchronously using io_uring, while the next
+     * events are formatted into another buffer. <tt>ImmediateFlush</tt>
+     * then submits each event for writing without waiting for the write
+     * to complete. It requires log4cplus built with
+     * <tt>LOG4CPLUS_ENABLE_IO_URING</tt> and a kernel that allows
+     * io_uring, otherwise <tt>Direct</tt> is used instead.</dd>
+     *
+     * <dt><tt>Compression</tt></dt>
+     * <dd>Setting this property to <tt>Gzip</tt> or <tt>Zstd</tt> makes
+     * the appender write the file compressed in independently
+     * decompressible blocks, using helpers::BlockCompressedFile. Blocks
+     * are compressed by the maintenance thread, never by the logging
+     * thread. The file stays readable by <code>zcat</code>,
+     * <code>zgrep</code> or <code>zstdcat</code> and
+     * helpers::BlockCompressedReader can read only blocks of a time
+     * range. <tt>Gzip</tt> requires log4cplus built with
+     * <tt>LOG4CPLUS_WITH_ZLIB</tt>, <tt>Zstd</tt> with
+     * <tt>LOG4CPLUS_WITH_ZSTD</tt>, otherwise the file is written
+     * uncompressed. <tt>Backend</tt>, <tt>BufferSize</tt> and
+     * <tt>ImmediateFlush</tt> do not apply; use <tt>MaxFlushDelay</tt>
+     * to limit how long events can stay in an incomplete block.
+     * Compression cannot be used with <tt>UseLockFile</tt>. Sizes of
+     * rolling appenders are sizes of compressed data, blocks not yet
+     * compressed are counted with their uncompressed size. The default
+     * is <tt>None</tt>.</dd>
+     *
+     * <dt><tt>CompressionBlockSize</tt></dt>
+     * <dd>Size of uncompressed data of one block. <tt>MB</tt> and
+     * <tt>KB</tt> suffixes can be used. The default is 64 KiB.</dd>
+     *
+     * <dt><tt>CompressionLevel</tt></dt>
+     * <dd>Compression level passed to zlib or libzstd. The default
+     * value -1 selects the default level of the library.</dd>
+     *
+     * <dt><tt>MaxFlushDelay</tt></dt>
+     * <dd>When <tt>ImmediateFlush</tt> is false or <tt>Compression</tt> is
+     * set, non-zero value of this
+     * property, in milliseconds, limits how long appended events can
+     * stay in the buffer before they are written into the file. The
+     * buffer is flushed by a housekeeping thread shared by all
+     * appenders, so that quiet appenders with large buffers do not
+     * hold their last events indefinitely.</dd>
+     *
+     * <dt><tt>AsyncRollover</tt></dt>
+     * <dd>When this property is <tt>true</tt>, appenders that roll over
+     * files only move the current file out of the way, by renaming it to
+     * a staging name with <tt>.rolling</tt> suffix, and open the new file.
+     * Renaming of backups and removal of old files are done by the
+     * maintenance thread, see helpers::queueMaintenanceJob(). Failures
+     * are reported through LogLog. Rollover is synchronous when
+     * <tt>UseLockFile</tt> is set. The default is <tt>false</tt>.</dd>
+     *
+     * <dt><tt>CompressBackups</tt></dt>
+     * <dd>When this property is <tt>true</tt>, appenders that roll over
+     * files compress each rolled over file using gzip, e.g.,
+     * <tt>log.1</tt> becomes <tt>log.1.gz</tt>, and remove the original.
+     * Compression is done by a low priority background thread, see
+     * helpers::queueBackgroundJob(), so it delays neither logging nor
+     * the maintenance thread. The compressed file is then moved to its
+     * place by the maintenance thread. While a backup is being
+     * compressed, it is kept under a private name with
+     * <tt>.compressing.</tt><i>N</i> suffix and rollovers shift the
+     * other backups without waiting for it.
+     * <tt>MaxBackupIndex</tt> and <tt>MaxHistory</tt> treat the
+     * compressed files as the backups they were made from. It requires
+     * log4cplus built with <tt>LOG4CPLUS_WITH_ZLIB</tt> and it does not
+     * apply together with <tt>Compression</tt>. The default is
+     * <tt>false</tt>.</dd>
+     *
+     * <dt><tt>TimeIndex</tt></dt>
+     * <dd>When this property is <tt>true</tt>, the appender writes a
+     * sidecar time index, e.g., <tt>log.idx</tt> for <tt>log</tt>, that
+     * maps start of each interval to offset of its first record. See
+     * helpers::TimeIndexWriter. The index is renamed and removed
+     * together with the file when it is rolled over.
+     * helpers::TimeIndexReader uses it to find records of a time range
+     * without reading the whole file. Offsets in indices of backups
+     * compressed by <tt>CompressBackups</tt> are offsets in decompressed
+     * data. It does not apply together with <tt>Compression</tt>, which
+     * indexes its blocks by time itself, and <tt>UseLockFile</tt>. The
+     * default is <tt>false</tt>.</dd>
+     *
+     * <dt><tt>TimeIndexInterval</tt></dt>
+     * <dd>Interval of the time index in seconds. The default is 1.</dd>
+     *
+     * <dt><tt>SyncInterval</tt></dt>
+     * <dd>Non-zero value of this property, in milliseconds, makes
+     * appended data reach storage, using <code>fdatasync()</code> or
+     * <code>fsync()</code>, at most this long after they have been
+     * appended. Synchronization is done by a background thread shared
+     * by all file appenders.</dd>
+     *
+     * <dt><tt>SyncSize</tt></dt>
+     * <dd>Non-zero value of this property makes the background thread
+     * synchronize the file once this many bytes have been appended
+     * since the last synchronization. <tt>MB</tt> and <tt>KB</tt>
+     * suffixes can be used.</dd>
+     *
+     * <dt><tt>SyncLevel</tt></dt>
+     * <dd>Logging an event of this or higher log level, e.g.,
+     * <tt>ERROR</tt>, waits until the event reaches storage. Threads
+     * waiting at the same time share a single synchronization.</dd>
+     *
+     * <dt><tt>SyncMethod</tt></dt>
+     * <dd>This property selects <tt>FDataSync</tt> (the default) or
+     * <tt>FSync</tt>. <code>fsync()</code> is always used where
+     * <code>fdatasync()</code> is not available.</dd>
      * </dl>
+     *
+     * When any of the <tt>Sync*</tt> triggers is set, unsynchronized
+     * data are also synchronized before the file is closed or rolled
+     * over.
      */
-    class LOG4CPLUS_EXPORT FileAppenderBase : public Appender {
+    class LOG4CPLUS_EXPORT FileAppenderBase
+        : public Appender
+        , protected helpers::IFileSyncClient
+        , protected helpers::IDelayedFlushClient
+    {
     public:
       // Methods
         virtual void close() override;
@@ -139,9 +287,105 @@ namespace log4cplus
 
         virtual void append(const spi::InternalLoggingEvent& event) override;
 
+        /**
+         * Appends the events using append(), which formats them into
+         * one buffer that is written at once, and flushes the file only
+         * once at the end of the batch. Subclasses that override append()
+         * to roll over the file get batching without further changes,
+         * closeFile() writes the buffer. In lock file mode, with
+         * compression, or when positions of events in the file cannot be
+         * computed from their lengths, the events are written one by
+         * one.
+         */
+        virtual void appendBatch(
+            std::span<spi::InternalLoggingEvent const * const> events)
+            override;
+
+        //! Waits for synchronization of events of level `SyncLevel`
+        //! or higher.
+        virtual void afterAppend(LogLevel maxLevel) override;
+
+        // helpers::IFileSyncClient interface.
+        virtual thread::Mutex const & fscGetAccessMutex () const override;
+        virtual void fscFlush () override;
+
+        // helpers::IDelayedFlushClient interface.
+        virtual thread::Mutex const & dfcGetAccessMutex () const override;
+        virtual void dfcFlush () override;
+
         virtual void open(std::ios_base::openmode mode);
         bool reopen();
 
+        //! Opens `name` using the selected backend.
+        //! \return true on success.
+        bool openFile(const log4cplus::tstring& name,
+            std::ios_base::openmode mode);
+        //! Writes events formatted by appendBatch(), closes the file
+        //! and resets its error state.
+        void closeFile();
+        bool isFileGood() const;
+        void flushFile();
+        //! Moves to the end of the file. Used when other processes can
+        //! write into the file as well.
+        void seekFileEnd();
+        //! \return Current size of the file as seen by this appender.
+        std::streamoff getFilePosition();
+        //! Seeks to the end of the file and sets `fileSize` from its
+        //! position.
+        void resyncFileSize();
+
+        //! \return true when rollover maintenance should be done by the
+        //! maintenance thread.
+        bool useAsyncRollover() const;
+        //! \return Files that make up backups besides the file itself,
+        //! i.e., compressed backups and time indices, as bit mask.
+        unsigned backupParts() const;
+        //! Queues `job` for the maintenance thread.
+        void queueMaintenance(std::function<void ()> job);
+        //! Waits for maintenance jobs queued by this appender.
+        void waitForMaintenance();
+        /**
+         * Waits for maintenance jobs queued by this appender and
+         * renames file `name` to its staging name.
+         *
+         * \return The staging name or empty string when the file could
+         * not be renamed.
+         */
+        tstring stageForRollover(const tstring& name);
+        /**
+         * Queues compression of backup `index` of `base`, i.e., `base`
+         * itself for index 0, otherwise e.g. <tt>base.1</tt>, when
+         * `compressBackups` is set. Backups of `base` with index above
+         * `maxIndex` are removed by rollovers.
+         */
+        void compressBackup(const tstring& base, unsigned index = 0,
+            unsigned maxIndex = (std::numeric_limits<unsigned>::max) ());
+
+        struct BackupCompressor;
+        using BackupCompressorPtr = std::shared_ptr<BackupCompressor>;
+
+        //! Variant of compressBackup() for maintenance jobs, which must
+        //! not use the appender.
+        static void compressBackup(BackupCompressorPtr const & compressor,
+            const tstring& base, unsigned index, unsigned maxIndex);
+
+        /**
+         * Removes backup `name` and its optional `parts`, which has
+         * fallen out of the history. Its compression, if it is still in
+         * progress, discards the compressed output.
+         */
+        static void removeExpiredBackup(
+            BackupCompressorPtr const & compressor, const tstring& name,
+            unsigned parts);
+
+        /**
+         * Runs `shift`, which moves backup `i` of `base` to `i + 1` for
+         * all `i`, so that it does not interfere with backups of `base`
+         * being compressed.
+         */
+        static void shiftBackups(BackupCompressorPtr const & compressor,
+            const tstring& base, std::function<void ()> const & shift);
+
       // Data
         /**
          * Immediate flush means that the underlying writer or output stream
@@ -175,9 +419,27 @@ namespace log4cplus
         int reopenDelay;
 
         unsigned long bufferSize;
+        //! Maximal time in milliseconds that output stays buffered or 0.
+        unsigned long maxFlushDelay = 0;
+        bool asyncRollover = false;
+        bool compressBackups = false;
+        //! Compressor of backups, set when `compressBackups` is set.
+        //! Queued jobs share it.
+        BackupCompressorPtr backupCompressor;
+        helpers::CompressionCodec compression = helpers::CompressionCodec::None;
+        int compressionLevel = -1;
+        //! Size of compressed blocks or 0 for the default.
+        unsigned long compressionBlockSize = 0;
         std::unique_ptr<log4cplus::tchar[]> buffer;
 
         log4cplus::tofstream out;
+        FileBackend backend;
+        //! File used instead of `out` by FileBackend::Direct.
+        std::unique_ptr<helpers::DirectFile> directOut;
+        //! File used instead of `out` when `compression` is set.
+        std::unique_ptr<helpers::BlockCompressedFile> compressedOut;
+        //! Set up by init() when <tt>TimeIndex</tt> is set.
+        std::unique_ptr<helpers::TimeIndexWriter> timeIndex;
         log4cplus::tstring filename;
         log4cplus::tstring localeName;
         log4cplus::tstring lockFileName;
@@ -185,7 +447,52 @@ namespace log4cplus
 
         log4cplus::helpers::Time reopen_time;
 
+        /**
+         * Size of the file as seen by this appender. It is set by
+         * openFile() and, in lock file mode, before each append. When
+         * `trackFileSize` is true, append() keeps it up to date from
+         * the length of formatted events so that the file position
+         * does not have to be queried for each event.
+         */
+        std::streamoff fileSize = 0;
+        bool trackFileSize = false;
+
+        helpers::FileSyncPolicy syncPolicy;
+        //! Set up by init() when `syncPolicy` is enabled. It and
+        //! `flusher` are declared after the file members so that they are
+        //! destroyed before them.
+        std::unique_ptr<helpers::FileSync> fileSync;
+        //! Set up by init() when `maxFlushDelay` applies.
+        std::unique_ptr<helpers::DelayedFlusher> flusher;
+
     private:
+        //! Identifier of the last maintenance job queued by this appender.
+        std::uint64_t lastMaintenanceJob = 0;
+
+        //! Position of the file at the last call of
+        //! FileSync::appended().
+        std::streamoff syncPosition = 0;
+
+        //! True when characters written into `out` map one to one to
+        //! bytes of the file. Set by imbue().
+        bool countChars = false;
+
+        //! Set while appendBatch() is in progress. It defers flushing of
+        //! the file to the end of the batch.
+        bool deferFlush = false;
+
+        //! Set while appendBatch() is in progress and append() formats
+        //! events into `batchBuffer` instead of writing them. `fileSize`
+        //! includes the buffered events then.
+        bool batching = false;
+        log4cplus::tstring batchBuffer;
+
+        //! Writes `batchBuffer` into the file and clears it.
+        void writeBatchBuffer();
+        //! Calls FileSync::appended() with the size appended since the
+        //! last call.
+        void syncAppended();
+
       // Disallow copying of instances of this class
         FileAppenderBase(const FileAppenderBase&);
         FileAppenderBase& operator=(const FileAppenderBase&);
@@ -237,6 +544,18 @@ namespace log4cplus
      * <dd>This property limits the number of backup output
      * files; e.g. how many <tt>log.1</tt>, <tt>log.2</tt> etc. files
      * will be kept.</dd>
+     *
+     * <dt><tt>RollingStrategy</tt></dt>
+     * <dd>The default value <tt>Rename</tt> writes into <tt>File</tt>
+     * and rollover renames <tt>log.1</tt> to <tt>log.2</tt> etc., which
+     * takes up to <tt>MaxBackupIndex</tt> renames. With the value
+     * <tt>Indexed</tt>, events are written into files with increasing
+     * index, e.g., <tt>log.000123</tt>, and rollover only opens the next
+     * file and removes the file that falls out of the last
+     * <tt>MaxBackupIndex</tt> backups. At start, the directory is scanned
+     * for existing files and writing continues with the newest one, or
+     * with a new one when <tt>Append</tt> is false. The lock file
+     * defaults to <tt>File</tt> with <tt>.lock</tt> suffix.</dd>
      * </dl>
      */
     class LOG4CPLUS_EXPORT RollingFileAppender : public FileAppender {
@@ -260,6 +579,13 @@ namespace log4cplus
         long maxFileSize;
         int maxBackupIndex;
 
+        //! Set when <tt>RollingStrategy</tt> is <tt>Indexed</tt>.
+        bool indexedRolling = false;
+        //! Value of <tt>File</tt> property for indexed rolling.
+        tstring baseFilename;
+        //! Index of the current file for indexed rolling.
+        unsigned long fileIndex = 0;
+
     private:
         LOG4CPLUS_PRIVATE void init(long maxFileSize, int maxBackupIndex);
     };
@@ -269,6 +595,173 @@ namespace log4cplus
         SharedRollingFileAppenderPtr;
 
 
+    /**
+     * MappedSegmentAppender writes log events into fixed size segment
+     * files that are preallocated and mapped into memory. Formatted
+     * events are copied straight into the mapping, so appending does
+     * not need any system call. Data are in page cache as soon as they
+     * are copied, so they survive crash of the process.
+     *
+     * When the current segment cannot hold the next event, it is
+     * truncated to its used length, backups are rotated the same way
+     * as by RollingFileAppender and a new segment is started. Until
+     * then, the tail of the current segment is filled with zero bytes.
+     * When an existing file is opened for appending, the appender
+     * continues after its last non-zero byte.
+     *
+     * This appender is only available on platforms with
+     * <code>mmap()</code>. Writing into the same segment from several
+     * processes is not supported.
+     *
+     * <h3>Properties</h3>
+     * <dl>
+     * <dt><tt>File</tt></dt>
+     * <dd>This property specifies output file name.</dd>
+     *
+     * <dt><tt>SegmentSize</tt></dt>
+     * <dd>This property specifies size of segment file. The value is
+     * in bytes. It is possible to use <tt>MB</tt> and <tt>KB</tt>
+     * suffixes to specify the value in megabytes or kilobytes
+     * instead. The default is 10 MB.</dd>
+     *
+     * <dt><tt>MaxBackupIndex</tt></dt>
+     * <dd>This property limits the number of backup segments;
+     * e.g. how many <tt>log.1</tt>, <tt>log.2</tt> etc. files will be
+     * kept.</dd>
+     *
+     * <dt><tt>Append</tt></dt>
+     * <dd>When it is set true, which is the default, output file
+     * will be appended to instead of being truncated at opening.</dd>
+     *
+     * <dt><tt>CreateDirs</tt></dt>
+     * <dd>Set this property to <tt>true</tt> if you want to create
+     * missing directories in path leading to log file.</dd>
+     * </dl>
+     */
+    class LOG4CPLUS_EXPORT MappedSegmentAppender : public Appender {
+    public:
+      // Ctors
+        MappedSegmentAppender(const log4cplus::tstring& filename,
+                              long segmentSize = 10*1024*1024, // 10 MB
+                              int maxBackupIndex = 1,
+                              bool createDirs = false);
+        MappedSegmentAppender(const log4cplus::helpers::Properties& properties);
+
+      // Dtor
+        virtual ~MappedSegmentAppender();
+
+      // Methods
+        virtual void close() override;
+
+    protected:
+        virtual void append(const spi::InternalLoggingEvent& event) override;
+
+        //! Opens and maps segment file of at least `minSize` bytes.
+        bool openSegment(bool appendToFile, std::size_t minSize);
+        //! Unmaps and truncates the current segment to its used length.
+        void closeSegment();
+        //! Starts a new segment that can hold at least `minSize` bytes.
+        void rollover(std::size_t minSize);
+
+      // Data
+        log4cplus::tstring filename;
+        long segmentSize;
+        int maxBackupIndex;
+        bool appendToFile;
+        bool createDirs;
+
+        int fd;
+        char * mapping;
+        std::size_t mappingSize;
+        //! Used length of the current segment.
+        std::size_t offset;
+
+    private:
+        LOG4CPLUS_PRIVATE void init();
+
+      // Disallow copying of instances of this class
+        MappedSegmentAppender(const MappedSegmentAppender&);
+        MappedSegmentAppender& operator=(const MappedSegmentAppender&);
+    };
+
+    typedef helpers::SharedObjectPtr<MappedSegmentAppender>
+        SharedMappedSegmentAppenderPtr;
+
+
+    /**
+     * CircularFileAppender writes log events into a single
+     * preallocated file of fixed size. When the file is full, the
+     * oldest events are overwritten, see helpers::CircularFile. Disk
+     * usage stays constant and, unlike with RollingFileAppender, there
+     * is no renaming or removing of files. Events are copied into the
+     * file mapped into memory, so appending does not need any system
+     * call.
+     *
+     * The file is not a text file. Use helpers::CircularFileReader to
+     * read events from the oldest to the newest one.
+     *
+     * This appender is only available on platforms with
+     * <code>mmap()</code>. Writing into the same file from several
+     * processes is not supported.
+     *
+     * <h3>Properties</h3>
+     * <dl>
+     * <dt><tt>File</tt></dt>
+     * <dd>This property specifies output file name.</dd>
+     *
+     * <dt><tt>FileSize</tt></dt>
+     * <dd>This property specifies size of the file. The value is in
+     * bytes. It is possible to use <tt>MB</tt> and <tt>KB</tt>
+     * suffixes to specify the value in megabytes or kilobytes
+     * instead. The default is 10 MB.</dd>
+     *
+     * <dt><tt>Append</tt></dt>
+     * <dd>When it is set true, which is the default, events of an
+     * existing file of the same size are kept. Otherwise the file is
+     * started empty.</dd>
+     *
+     * <dt><tt>CreateDirs</tt></dt>
+     * <dd>Set this property to <tt>true</tt> if you want to create
+     * missing directories in path leading to log file.</dd>
+     * </dl>
+     */
+    class LOG4CPLUS_EXPORT CircularFileAppender : public Appender {
+    public:
+      // Ctors
+        CircularFileAppender(const log4cplus::tstring& filename,
+                             long fileSize = 10*1024*1024, // 10 MB
+                             bool createDirs = false);
+        CircularFileAppender(const log4cplus::helpers::Properties& properties);
+
+      // Dtor
+        virtual ~CircularFileAppender();
+
+      // Methods
+        virtual void close() override;
+
+    protected:
+        virtual void append(const spi::InternalLoggingEvent& event) override;
+
+      // Data
+        log4cplus::tstring filename;
+        long fileSize;
+        bool appendToFile;
+        bool createDirs;
+
+        helpers::CircularFile file;
+
+    private:
+        LOG4CPLUS_PRIVATE void init();
+
+      // Disallow copying of instances of this class
+        CircularFileAppender(const CircularFileAppender&);
+        CircularFileAppender& operator=(const CircularFileAppender&);
+    };
+
+    typedef helpers::SharedObjectPtr<CircularFileAppender>
+        SharedCircularFileAppenderPtr;
+
+
     enum class DailyRollingFileSchedule { MONTHLY, WEEKLY, DAILY,
                                     TWICE_DAILY, HOURLY, MINUTELY};
 
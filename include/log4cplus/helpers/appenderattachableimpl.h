@@ -35,7 +35,9 @@
 #include <log4cplus/spi/appenderattachable.h>
 #include <log4cplus/thread/syncprims.h>
 
+#include <atomic>
 #include <memory>
+#include <span>
 #include <vector>
 
 
@@ -44,12 +46,23 @@ namespace log4cplus {
 
         /**
          * This Interface is for attaching Appenders to objects.
+         *
+         * The list of appenders is published as an immutable snapshot
+         * (read-copy-update). Readers, most importantly
+         * appendLoopOnAppenders(), iterate the current snapshot through
+         * a raw pointer without locking and without touching reference
+         * counts. Modifying methods copy the current list, modify the
+         * copy and atomically swap it in. Replaced snapshots, and
+         * appenders only they refer to, are destroyed once the last
+         * reader that could have seen them is done.
          */
         class LOG4CPLUS_EXPORT AppenderAttachableImpl
             : public log4cplus::spi::AppenderAttachable
         {
         public:
           // Data
+            /** Serializes modifications of the appender list. It is not
+             *  taken by readers. */
             thread::Mutex appender_list_mutex;
 
           // Ctors
@@ -106,13 +119,33 @@ namespace log4cplus {
              */
             int appendLoopOnAppenders(const spi::InternalLoggingEvent& event) const;
 
+            /**
+             * Call the <code>doAppendBatch</code> method on all attached
+             * appenders.
+             */
+            int appendBatchLoopOnAppenders(
+                std::span<spi::InternalLoggingEvent const> events) const;
+
         protected:
           // Types
             typedef std::vector<SharedAppenderPtr> ListType;
+            typedef ListType const * ListPtr;
+
+          // Methods
+            /** Returns current snapshot of appenders list. It can be
+             *  null if there are no appenders. The snapshot may only be
+             *  used inside of read-side critical section. */
+            ListPtr loadAppenderList() const;
+
+            /** Publishes new snapshot of appenders list and retires
+             *  the previous one. The caller must hold
+             *  <code>appender_list_mutex</code>. */
+            void replaceAppenderList(std::unique_ptr<ListType> newList);
 
           // Data
-            /** Array of appenders. */
-            ListType appenderList;
+            /** Current snapshot of appenders. Published snapshots are
+             *  never modified. */
+            std::atomic<ListPtr> appenderList;
         };  // end class AppenderAttachableImpl
 
     } // end namespace helpers
@@ -0,0 +1,167 @@
+// -*- C++ -*-
+//
+//  Copyright (C) 2026, Vaclav Haisman. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef LOG4CPLUS_HELPERS_CIRCULARFILE_H
+#define LOG4CPLUS_HELPERS_CIRCULARFILE_H
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_HAVE_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#include <log4cplus/tstring.h>
+#include <log4cplus/helpers/timehelper.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace log4cplus {
+
+namespace helpers {
+
+
+/**
+ * Fixed size log file that is written in circles. The file is
+ * preallocated and mapped into memory. When its data area is full, the
+ * oldest records are overwritten. Disk usage thus stays constant and
+ * there is no renaming or removing of files.
+ *
+ * The file starts with a 64 bytes long header: magic
+ * <tt>L4CPCIRC</tt>, format version, size of the data area, offset of
+ * the write head, offset of the oldest complete record and sequence
+ * number of the next record. Each record in the data area is framed by
+ * a 24 bytes long header: marker <tt>L4CR</tt>, length of the record,
+ * its sequence number and timestamp in microseconds since the Unix
+ * epoch. Records are aligned to 8 bytes. A record that does not fit
+ * before the end of the data area is written at its start, the rest
+ * of the area is marked with marker <tt>L4CW</tt>. All numbers are
+ * little endian.
+ *
+ * The offset of the oldest record is updated before older records are
+ * overwritten and the write head after the new record has been
+ * copied, so the header never points to a partially written record
+ * after a crash of the process.
+ *
+ * This class is only available on platforms with <code>mmap()</code>.
+ * Writing into the same file from several processes is not supported.
+ *
+ * \sa CircularFileReader
+ */
+class LOG4CPLUS_EXPORT CircularFile
+{
+public:
+    static std::size_t const header_size = 64;
+    static std::size_t const record_header_size = 24;
+
+    CircularFile ();
+    ~CircularFile ();
+
+    CircularFile (CircularFile const &) = delete;
+    CircularFile & operator = (CircularFile const &) = delete;
+
+    /**
+     * Opens file `name` of `size` bytes, header included. When
+     * `append` is true, records of an existing file of the same size
+     * are kept. Otherwise the file is started empty.
+     *
+     * \return true when the file has been opened.
+     */
+    bool open (tstring const & name, std::size_t size, bool append);
+
+    void close ();
+
+    bool is_open () const;
+
+    /**
+     * Appends `record` with `timestamp`, overwriting the oldest
+     * records when necessary. A record longer than the data area is
+     * truncated.
+     */
+    void write (std::string_view record, Time const & timestamp);
+
+private:
+    std::uint64_t load (std::size_t field) const;
+    void store (std::size_t field, std::uint64_t value);
+    std::uint64_t nextRecord (std::uint64_t pos) const;
+
+    int fd;
+    char * mapping;
+    std::size_t mappingSize;
+    //! Size of the data area.
+    std::uint64_t capacity;
+};
+
+
+//! One record of a circular file.
+struct LOG4CPLUS_EXPORT CircularFileRecord
+{
+    std::uint64_t sequence = 0;
+    Time timestamp;
+    //! Points into data of the CircularFileReader.
+    std::string_view data;
+};
+
+
+/**
+ * Reads files written by CircularFile. The file is read at once and
+ * its records are available from the oldest to the newest one.
+ */
+class LOG4CPLUS_EXPORT CircularFileReader
+{
+public:
+    CircularFileReader ();
+    ~CircularFileReader ();
+
+    CircularFileReader (CircularFileReader const &) = delete;
+    CircularFileReader & operator = (CircularFileReader const &) = delete;
+
+    /**
+     * Reads file `name`.
+     *
+     * \return true when the file is a circular log file.
+     */
+    bool open (tstring const & name);
+
+    void close ();
+
+    //! \return Records in chronological order.
+    std::vector<CircularFileRecord> const & records () const;
+
+private:
+    std::string contents;
+    std::vector<CircularFileRecord> items;
+};
+
+
+} // namespace helpers
+
+} // namespace log4cplus
+
+
+#endif // LOG4CPLUS_HELPERS_CIRCULARFILE_H
@@ -0,0 +1,258 @@
+// -*- C++ -*-
+//
+//  Copyright (C) 2026, Vaclav Haisman. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef LOG4CPLUS_HELPERS_COMPRESSEDFILE_H
+#define LOG4CPLUS_HELPERS_COMPRESSEDFILE_H
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_HAVE_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#include <log4cplus/tstring.h>
+#include <log4cplus/helpers/timehelper.h>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <ios>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace log4cplus {
+
+namespace helpers {
+
+
+//! Compression used by BlockCompressedFile.
+enum class CompressionCodec
+{
+    None,
+    //! Blocks are gzip members. Requires `LOG4CPLUS_WITH_ZLIB`.
+    Gzip,
+    //! Blocks are Zstandard frames. Requires `LOG4CPLUS_WITH_ZSTD`.
+    Zstd
+};
+
+
+//! \return true when log4cplus has been built with support for `codec`.
+LOG4CPLUS_EXPORT bool isCompressionSupported (CompressionCodec codec);
+
+
+/**
+ * Compresses file `src` into gzip file `target`, replacing it. It
+ * requires `LOG4CPLUS_WITH_ZLIB`. Failures are reported using LogLog.
+ *
+ * @param level Compression level, -1 selects the zlib default.
+ * \return true on success.
+ */
+LOG4CPLUS_EXPORT bool gzipFile (tstring const & src, tstring const & target,
+    int level = -1);
+
+
+//! Describes one block of a block compressed file.
+struct LOG4CPLUS_EXPORT CompressedBlockInfo
+{
+    //! Offset of the block in the file.
+    std::uint64_t offset = 0;
+    //! Size of the block in the file, including its framing.
+    std::uint32_t size = 0;
+    //! Size of the block data after decompression.
+    std::uint32_t rawSize = 0;
+    //! Timestamp of the first record of the block.
+    Time first;
+    //! Timestamp of the last record of the block.
+    Time last;
+};
+
+
+/**
+ * Output file that compresses data in independently decompressible
+ * blocks. Records are collected in a block until it reaches the block
+ * size. The block is then compressed and appended to the file by the
+ * maintenance thread (see queueMaintenanceJob()), so the writing thread
+ * never compresses. At most max_pending_blocks blocks wait for the
+ * maintenance thread, writes wait when there are more.
+ *
+ * With CompressionCodec::Gzip, each block is a gzip member. Its header
+ * carries an extra field with subfield ID `LB` and the size of the
+ * member, the size of the uncompressed data and timestamps of the
+ * first and the last record, all little endian, timestamps in
+ * microseconds since the Unix epoch. With CompressionCodec::Zstd, each
+ * block is a Zstandard frame preceded by a skippable frame with the
+ * same data. The whole file is thus readable by standard `zcat`,
+ * `zgrep` or `zstdcat`.
+ *
+ * When the file is closed, a footer is appended. It consists of the
+ * index of all blocks, gzip members with empty content and subfield ID
+ * `LI` or a skippable frame, followed by a fixed size locator, an empty
+ * gzip member with subfield ID `LL` or a skippable frame, that points
+ * to the index. See BlockCompressedReader.
+ *
+ * When a file is opened for appending, its footer is removed and
+ * written again on close. A file without footer, e.g., after a crash,
+ * is scanned block by block and an incomplete last block is cut off.
+ */
+class LOG4CPLUS_EXPORT BlockCompressedFile
+{
+public:
+    //! Default size of uncompressed data of one block.
+    static std::size_t const default_block_size = 64 * 1024;
+
+    //! Maximal number of blocks waiting to be compressed.
+    static unsigned const max_pending_blocks = 4;
+
+    /**
+     * @param codec Compression to use. It must be supported, see
+     * isCompressionSupported().
+     * @param level Compression level, -1 selects the codec default.
+     * @param blockSize Size of uncompressed data of one block, 0
+     * selects default_block_size.
+     */
+    BlockCompressedFile (CompressionCodec codec, int level = -1,
+        std::size_t blockSize = 0);
+    ~BlockCompressedFile ();
+
+    BlockCompressedFile (BlockCompressedFile const &) = delete;
+    BlockCompressedFile & operator = (BlockCompressedFile const &) = delete;
+
+    /**
+     * Opens the file. When `mode` contains `std::ios_base::trunc` but
+     * not `std::ios_base::app` or `std::ios_base::ate`, the file is
+     * truncated, otherwise blocks are appended to existing ones. A non
+     * empty file that does not start with a block of the same codec is
+     * not opened.
+     *
+     * \return true when the file has been opened.
+     */
+    bool open (tstring const & name, std::ios_base::openmode mode);
+
+    //! Writes the last block and the footer and closes the file. It
+    //! also clears the error state.
+    void close ();
+
+    bool is_open () const;
+
+    //! \return true when the file is open and no write has failed.
+    bool good () const;
+
+    //! Appends one record. `timestamp` is recorded in the block.
+    void write (std::string_view record, Time const & timestamp);
+
+    //! Hands over the incomplete block to the maintenance thread.
+    void flush ();
+
+    //! Flushes and waits for all blocks to be written.
+    //! \return good()
+    bool wait ();
+
+    /**
+     * \return Size of the file. Blocks that have not been written yet
+     * are counted with their uncompressed size.
+     */
+    std::uint64_t size () const;
+
+private:
+    struct Impl;
+
+    void submitBlock ();
+
+    std::unique_ptr<Impl> impl;
+    std::string block;
+    Time block_first;
+    Time block_last;
+    //! Maintenance job identifiers of submitted blocks.
+    std::deque<std::uint64_t> pending;
+    bool opened;
+};
+
+
+/**
+ * Reads files written by BlockCompressedFile. The list of blocks is
+ * taken from the footer. When there is no footer, blocks are found by
+ * walking from one block header to the next one. Timestamps of blocks
+ * allow decompressing only blocks of a time range.
+ */
+class LOG4CPLUS_EXPORT BlockCompressedReader
+{
+public:
+    BlockCompressedReader ();
+    ~BlockCompressedReader ();
+
+    BlockCompressedReader (BlockCompressedReader const &) = delete;
+    BlockCompressedReader & operator = (BlockCompressedReader const &)
+        = delete;
+
+    /**
+     * Opens the file and reads the list of its blocks.
+     *
+     * \return true when the file is a block compressed file with a
+     * supported codec.
+     */
+    bool open (tstring const & name);
+
+    void close ();
+
+    CompressionCodec codec () const;
+
+    //! \return true when the list of blocks has been read from the
+    //! footer.
+    bool indexed () const;
+
+    std::vector<CompressedBlockInfo> const & blocks () const;
+
+    /**
+     * Decompresses `block` and appends its data to `out`.
+     *
+     * \return true on success.
+     */
+    bool readBlock (CompressedBlockInfo const & block, std::string & out);
+
+    /**
+     * Decompresses all blocks that contain records with timestamps
+     * from `from` to `to`, inclusive, and appends them to `out`.
+     * Records of the boundary blocks that are out of the range are
+     * included as well.
+     *
+     * \return true on success.
+     */
+    bool readRange (Time const & from, Time const & to, std::string & out);
+
+private:
+    struct Impl;
+
+    std::unique_ptr<Impl> impl;
+};
+
+
+} // namespace helpers
+
+} // namespace log4cplus
+
+
+#endif // LOG4CPLUS_HELPERS_COMPRESSEDFILE_H
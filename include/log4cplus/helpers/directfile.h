@@ -0,0 +1,208 @@
+// -*- C++ -*-
+//
+//  Copyright (C) 2026, Vaclav Haisman. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef LOG4CPLUS_HELPERS_DIRECTFILE_H
+#define LOG4CPLUS_HELPERS_DIRECTFILE_H
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_HAVE_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#include <log4cplus/tstring.h>
+#include <cstddef>
+#include <cstdint>
+#include <ios>
+#include <memory>
+#include <ostream>
+#include <streambuf>
+#include <string_view>
+
+
+namespace log4cplus {
+
+namespace helpers {
+
+/**
+ * Output file that bypasses C++ IOStreams file streams. It owns a file
+ * descriptor opened with `O_APPEND` and a user space buffer. Data are
+ * put into the buffer, either through write() or by formatting into
+ * stream(), and the buffer is drained using `write()`, or `writev()`
+ * together with data that do not fit into it, so that each drain is a
+ * single system call.
+ *
+ * When io_uring is enabled using setIoUring(), drains are submitted
+ * asynchronously instead. Data are then put into one of a small ring
+ * of buffers registered with the kernel while the others are being
+ * written. Completions are reaped without blocking unless all the
+ * buffers are in flight. flush() then only submits the buffer; use
+ * wait() to wait for the data to reach the file. The file does not
+ * use `O_APPEND` then, each write goes to the offset following the
+ * previous one so that they can complete in any order. Other writers
+ * of the file have to be excluded, e.g., by a lock file, and
+ * seekToEnd() called before writing.
+ *
+ * Errors are sticky, like `failbit` of streams. Once a write fails,
+ * good() returns false and further output is discarded until the
+ * file is closed and opened again.
+ */
+class LOG4CPLUS_EXPORT DirectFile
+    : private std::streambuf
+{
+public:
+    //! Default size of the user space buffer.
+    static std::size_t const default_buffer_size = 64 * 1024;
+
+    //! Number of buffers used with io_uring.
+    static unsigned const io_uring_buffers = 4;
+
+    DirectFile ();
+    ~DirectFile ();
+
+    DirectFile (DirectFile const &) = delete;
+    DirectFile & operator = (DirectFile const &) = delete;
+
+    /**
+     * Opens the file. The file is always written at its end. When
+     * `mode` contains `std::ios_base::trunc` but not
+     * `std::ios_base::app` or `std::ios_base::ate`, the file is
+     * truncated. `std::ios_base::binary` only makes a difference on
+     * Windows where it disables EOL translation.
+     *
+     * \return true when the file has been opened.
+     */
+    bool open (tstring const & name, std::ios_base::openmode mode);
+
+    //! Flushes the buffer and closes the file. It also clears the
+    //! error state.
+    void close ();
+
+    bool is_open () const;
+
+    //! \return true when the file is open and no write has failed.
+    bool good () const;
+
+    //! \return OS error code of the last failure or 0.
+    int error () const;
+
+    /**
+     * Sets size of the user space buffer. Buffered data are flushed
+     * first. Size 0 selects default_buffer_size.
+     */
+    void setBufferSize (std::size_t size);
+
+    /**
+     * Enables or disables asynchronous writes using io_uring. When
+     * io_uring is not compiled in (see `LOG4CPLUS_ENABLE_IO_URING`)
+     * or the kernel does not allow its use, it stays disabled and
+     * writes are done synchronously.
+     *
+     * \return true when io_uring is in use.
+     */
+    bool setIoUring (bool enable);
+
+    //! \return true when io_uring is in use.
+    bool usingIoUring () const;
+
+    //! Appends data to the buffer, draining it when it is full.
+    void write (char const * data, std::size_t size);
+
+    void write (std::string_view str)
+    {
+        write (str.data (), str.size ());
+    }
+
+    //! \return Stream that formats directly into the buffer.
+    std::ostream & stream ()
+    {
+        return os;
+    }
+
+    //! Drains the buffer into the file. With io_uring, the buffer is
+    //! only submitted.
+    //! \return good()
+    bool flush ();
+
+    //! Flushes the buffer and waits for all submitted writes.
+    //! \return good()
+    bool wait ();
+
+    /**
+     * Updates the tracked file size from the file system. This is
+     * necessary when other processes append to the same file.
+     * Buffered data are flushed first.
+     */
+    void seekToEnd ();
+
+    //! \return Size of the file including buffered data.
+    std::uint64_t size () const;
+
+    //! \return Underlying file descriptor or -1.
+    int fd () const;
+
+private:
+    // std::streambuf interface.
+    virtual int_type overflow (int_type c) override;
+    virtual std::streamsize xsputn (char const * s, std::streamsize n)
+        override;
+    virtual int sync () override;
+
+    bool drain (char const * data, std::size_t size);
+
+    struct IoUring;
+
+    // These are only defined when LOG4CPLUS_ENABLE_IO_URING is set.
+    int setAppendMode (bool append);
+    bool drainIoUring (char const * data, std::size_t size);
+    bool submitIoUring ();
+    bool acquireIoUringBuffer ();
+    bool reapIoUring (bool block);
+
+    std::unique_ptr<IoUring> uring;
+    int file_fd;
+    int last_error;
+    std::unique_ptr<char[]> buffer;
+    std::size_t buffer_size;
+    //! Size of the file without buffered data.
+    std::uint64_t file_size;
+#if defined (_WIN32)
+    //! True when the file is opened in text mode, which writes CR LF
+    //! for each LF.
+    bool text_mode = false;
+    //! Number of CRs added by text mode to data passed to write() since
+    //! `file_size` has been read from the file.
+    std::uint64_t added_crs = 0;
+#endif
+    std::ostream os;
+};
+
+
+} // namespace helpers
+
+} // namespace log4cplus
+
+
+#endif // LOG4CPLUS_HELPERS_DIRECTFILE_H
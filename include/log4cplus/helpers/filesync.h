@@ -0,0 +1,197 @@
+// -*- C++ -*-
+//
+//  Copyright (C) 2026, Vaclav Haisman. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef LOG4CPLUS_HELPERS_FILESYNC_H
+#define LOG4CPLUS_HELPERS_FILESYNC_H
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_HAVE_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#include <log4cplus/loglevel.h>
+#include <log4cplus/tstring.h>
+#include <log4cplus/helpers/housekeeping.h>
+#include <log4cplus/thread/syncprims.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+
+namespace log4cplus {
+
+namespace helpers {
+
+
+class LOG4CPLUS_EXPORT FileSync;
+
+
+//! Interface implemented by users of FileSync.
+class LOG4CPLUS_EXPORT IFileSyncClient
+{
+protected:
+    virtual ~IFileSyncClient ();
+
+    //! \return Mutex protecting the client's file. This is usually
+    //! SharedObject::access_mutex.
+    virtual thread::Mutex const & fscGetAccessMutex () const = 0;
+
+    //! Writes buffered data of the client's file into the OS. It is
+    //! called with the mutex returned by fscGetAccessMutex() locked.
+    virtual void fscFlush () = 0;
+
+    friend class LOG4CPLUS_EXPORT FileSync;
+};
+
+
+//! Describes when FileSync synchronizes a file with its storage.
+struct LOG4CPLUS_EXPORT FileSyncPolicy
+{
+    //! Appended data are synchronized at most this long after they
+    //! have been appended. Zero disables the trigger.
+    std::chrono::milliseconds interval {0};
+
+    //! Appended data are synchronized once this many bytes have
+    //! accumulated. Zero disables the trigger.
+    std::uint64_t bytes = 0;
+
+    //! Appending an event of this or higher level waits until the
+    //! event is synchronized. `NOT_SET_LOG_LEVEL` disables the
+    //! trigger.
+    LogLevel level = NOT_SET_LOG_LEVEL;
+
+    //! Use `fdatasync()` instead of `fsync()` where it is available.
+    bool dataOnly = true;
+
+    //! \return true when any trigger is enabled.
+    bool enabled () const;
+};
+
+
+/**
+ * Synchronizes a file with its storage using `fsync()` or
+ * `fdatasync()` according to FileSyncPolicy.
+ *
+ * Synchronization is done by the housekeeping thread. The thread flushes the client's buffers with
+ * the client's mutex locked but it calls `fsync()` with the mutex
+ * unlocked, so that logging continues while storage is being
+ * synchronized. Threads that wait() for their events to be
+ * synchronized share a single `fsync()` call: a group commit.
+ *
+ * The file is synchronized using its own file descriptor, opened by
+ * name in attach(). This works for any way the client writes the
+ * file.
+ *
+ * In single-threaded builds, synchronization is done synchronously
+ * by appended() and wait().
+ */
+class LOG4CPLUS_EXPORT FileSync
+    : private IHousekeepingTask
+{
+public:
+    //! Registers with the housekeeping thread.
+    FileSync (IFileSyncClient & client, FileSyncPolicy const & policy);
+
+    //! Unregisters from the housekeeping thread. It must not be
+    //! called with the client's mutex locked.
+    ~FileSync ();
+
+    FileSync (FileSync const &) = delete;
+    FileSync & operator = (FileSync const &) = delete;
+
+    FileSyncPolicy const & getPolicy () const
+    {
+        return policy;
+    }
+
+    //! Opens the file descriptor used to synchronize `name`. Call it
+    //! with the client's mutex locked, after the client has opened
+    //! the file.
+    void attach (tstring const & name);
+
+    //! Synchronizes the file, if it has unsynchronized data, and
+    //! closes the file descriptor. Call it with the client's mutex
+    //! locked, before the client closes the file.
+    void detach ();
+
+    //! Records that `size` bytes have been appended. Call it with
+    //! the client's mutex locked.
+    void appended (std::uint64_t size);
+
+    //! Waits until all data appended so far are synchronized. Call
+    //! it with the client's mutex unlocked.
+    void wait ();
+
+    //! Synchronizes the file. The client's mutex must not be locked.
+    void sync ();
+
+private:
+    // IHousekeepingTask interface.
+    virtual std::chrono::steady_clock::time_point hkNextRunTime ()
+        override;
+    virtual void hkRun () override;
+
+    int syncFile (int fd) const;
+    void notifySynced (std::uint64_t seq);
+
+    IFileSyncClient & fsc;
+    FileSyncPolicy const policy;
+
+    // These are protected by the client's mutex.
+
+    //! File descriptor used for synchronization or -1.
+    int sync_fd;
+    //! True when appended data have not been synchronized, yet.
+    bool dirty;
+    //! Bytes appended since the last synchronization.
+    std::uint64_t unsynced_bytes;
+
+    //! Count of appended() calls.
+    std::atomic<std::uint64_t> append_seq;
+
+    // These are protected by `mtx`.
+
+    std::mutex mtx;
+    std::condition_variable synced_cv;
+    //! Value of `append_seq` covered by the last synchronization.
+    std::uint64_t synced_seq;
+    //! Time when the file became dirty.
+    std::chrono::steady_clock::time_point dirty_since;
+    bool dirty_pending;
+    //! Set when synchronization has been requested explicitly.
+    bool requested;
+};
+
+
+} // namespace helpers
+
+} // namespace log4cplus
+
+
+#endif // LOG4CPLUS_HELPERS_FILESYNC_H
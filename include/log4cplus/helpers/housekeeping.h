@@ -0,0 +1,220 @@
+// -*- C++ -*-
+//
+//  Copyright (C) 2026, Vaclav Haisman. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef LOG4CPLUS_HELPERS_HOUSEKEEPING_H
+#define LOG4CPLUS_HELPERS_HOUSEKEEPING_H
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_HAVE_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#include <log4cplus/thread/syncprims.h>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+
+
+namespace log4cplus {
+
+namespace helpers {
+
+
+/**
+ * Task run by the housekeeping thread. The thread is shared by all
+ * registered tasks. It calls hkRun() of each task once its
+ * hkNextRunTime() has passed.
+ */
+class LOG4CPLUS_EXPORT IHousekeepingTask
+{
+public:
+    virtual ~IHousekeepingTask ();
+
+    //! \return Time when hkRun() should be called next, or
+    //! `time_point::max()` when there is nothing to do. It is called
+    //! by the housekeeping thread with its internal mutex locked.
+    virtual std::chrono::steady_clock::time_point hkNextRunTime () = 0;
+
+    //! Does the work of the task.
+    virtual void hkRun () = 0;
+};
+
+
+/**
+ * Registers `task` with the housekeeping thread. The thread is
+ * started when the first task is registered. This does nothing in
+ * single-threaded builds.
+ */
+LOG4CPLUS_EXPORT void registerHousekeepingTask (IHousekeepingTask * task);
+
+/**
+ * Unregisters `task`. When hkRun() of the task is in progress, this
+ * waits for it to finish, so it must not be called while holding
+ * locks taken by hkRun(). The thread is stopped when the last task
+ * is unregistered.
+ */
+LOG4CPLUS_EXPORT void unregisterHousekeepingTask (IHousekeepingTask * task);
+
+/**
+ * Makes the housekeeping thread call hkNextRunTime() of all tasks
+ * again. Call it when the next run time of a task becomes earlier.
+ */
+LOG4CPLUS_EXPORT void wakeHousekeepingThread ();
+
+
+/**
+ * Queues `job` for the maintenance thread. It is meant for slow file
+ * system work, like renaming and removing of rolled over files, that
+ * should not delay logging. Jobs are executed one at a time in the
+ * order they have been queued. Exceptions thrown by jobs are reported
+ * using LogLog. The thread is started on demand and it exits when the
+ * queue is empty.
+ *
+ * In single-threaded builds, `job` is executed immediately.
+ *
+ * \return Identifier of the job for waitForMaintenanceJob().
+ */
+LOG4CPLUS_EXPORT std::uint64_t queueMaintenanceJob (
+    std::function<void ()> job);
+
+/**
+ * Waits until the job `id` and all jobs queued before it have been
+ * executed. Identifier 0 is always complete.
+ */
+LOG4CPLUS_EXPORT void waitForMaintenanceJob (std::uint64_t id);
+
+
+/**
+ * Queues `job` for the background thread. It is meant for long running
+ * work, like compression of whole rolled over files, that must not
+ * delay jobs of the maintenance thread. The background thread runs with
+ * lowered scheduling priority where the platform allows it. Otherwise
+ * it behaves like queueMaintenanceJob().
+ *
+ * \return Identifier of the job for waitForBackgroundJob().
+ */
+LOG4CPLUS_EXPORT std::uint64_t queueBackgroundJob (
+    std::function<void ()> job);
+
+/**
+ * Waits until the background job `id` and all background jobs queued
+ * before it have been executed. Identifier 0 is always complete.
+ */
+LOG4CPLUS_EXPORT void waitForBackgroundJob (std::uint64_t id);
+
+
+//! Interface implemented by users of DelayedFlusher.
+class LOG4CPLUS_EXPORT IDelayedFlushClient
+{
+protected:
+    virtual ~IDelayedFlushClient ();
+
+    //! \return Mutex protecting the client's output. This is usually
+    //! SharedObject::access_mutex.
+    virtual thread::Mutex const & dfcGetAccessMutex () const = 0;
+
+    //! Flushes the client's output. It is called with the mutex
+    //! returned by dfcGetAccessMutex() locked.
+    virtual void dfcFlush () = 0;
+
+    friend class LOG4CPLUS_EXPORT DelayedFlusher;
+};
+
+
+/**
+ * Bounds the time that output of a buffering appender can stay in its
+ * buffer. The appender calls written() after it has buffered output
+ * and flushed() after it has flushed it. When output stays unflushed
+ * for the maximal delay, the housekeeping thread locks the appender
+ * and flushes it.
+ *
+ * In single-threaded builds, the delay is only checked by written().
+ */
+class LOG4CPLUS_EXPORT DelayedFlusher
+    : private IHousekeepingTask
+{
+public:
+    DelayedFlusher (IDelayedFlushClient & client,
+        std::chrono::milliseconds maxDelay);
+
+    //! It must not be called with the client's mutex locked.
+    ~DelayedFlusher ();
+
+    DelayedFlusher (DelayedFlusher const &) = delete;
+    DelayedFlusher & operator = (DelayedFlusher const &) = delete;
+
+    //! Records that unflushed output has been written. Call it with
+    //! the client's mutex locked.
+    void written ()
+    {
+        if (! dirty)
+            becameDirty ();
+#if defined (LOG4CPLUS_SINGLE_THREADED)
+        else if (std::chrono::steady_clock::now () - dirty_since
+            >= max_delay)
+            hkRun ();
+#endif
+    }
+
+    //! Records that the client has flushed its output. Call it with
+    //! the client's mutex locked.
+    void flushed ()
+    {
+        dirty = false;
+    }
+
+private:
+    void becameDirty ();
+
+    // IHousekeepingTask interface.
+    virtual std::chrono::steady_clock::time_point hkNextRunTime ()
+        override;
+    virtual void hkRun () override;
+
+    IDelayedFlushClient & dfc;
+    std::chrono::milliseconds const max_delay;
+
+    //! True when the client has unflushed output. It is protected by
+    //! the client's mutex.
+    bool dirty;
+
+    // These are protected by `mtx`.
+
+    std::mutex mtx;
+    //! Time when the client's output became unflushed.
+    std::chrono::steady_clock::time_point dirty_since;
+    bool dirty_pending;
+};
+
+
+} // namespace helpers
+
+} // namespace log4cplus
+
+
+#endif // LOG4CPLUS_HELPERS_HOUSEKEEPING_H
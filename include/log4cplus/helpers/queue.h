@@ -33,7 +33,10 @@
 
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
 
-#include <deque>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
 #include <log4cplus/spi/loggingevent.h>
 #include <log4cplus/thread/threads.h>
 #include <log4cplus/thread/syncprims.h>
@@ -42,8 +45,8 @@
 namespace log4cplus { namespace thread {
 
 
-//! Single consumer, multiple producers queue.
-class LOG4CPLUS_EXPORT Queue
+//! Interface of single consumer, multiple producers queues.
+class LOG4CPLUS_EXPORT QueueBase
     : public virtual helpers::SharedObject
 {
 public:
@@ -51,58 +54,43 @@ public:
     typedef unsigned flags_type;
 
     //! Queue storage type.
-    typedef std::deque<spi::InternalLoggingEvent> queue_storage_type;
+    typedef std::vector<spi::InternalLoggingEvent> queue_storage_type;
 
-    explicit Queue (unsigned len = 100);
-    virtual ~Queue ();
+    QueueBase ();
+    virtual ~QueueBase ();
 
-    Queue (Queue const &) = delete;
-    Queue (Queue &&) = delete;
+    QueueBase (QueueBase const &) = delete;
+    QueueBase (QueueBase &&) = delete;
 
-    Queue & operator = (Queue const &) = delete;
-    Queue & operator = (Queue &&) = delete;
+    QueueBase & operator = (QueueBase const &) = delete;
+    QueueBase & operator = (QueueBase &&) = delete;
 
     // Producers' methods.
 
-    //! Puts event <code>ev</code> into queue, sets QUEUE flag and
-    //! sets internal event object into signaled state. If the EXIT
-    //! flags is already set upon entering the function, nothing is
-    //! inserted into the queue. The function can block on internal
-    //! semaphore if the queue has reached maximal allowed
-    //! length. Calling thread is unblocked either by consumer thread
-    //! removing item from queue or by any other thread calling
-    //! signal_exit().
+    //! Puts event <code>ev</code> into queue. If the EXIT flag is
+    //! already set, nothing is inserted into the queue. The function
+    //! can block if the queue is full.
     //!
     //! \param ev spi::InternalLoggingEvent to be put into the queue.
     //! \return Flags.
-    flags_type put_event (spi::InternalLoggingEvent const & ev);
+    virtual flags_type put_event (spi::InternalLoggingEvent const & ev) = 0;
 
-    //! Sets EXIT flag and DRAIN flag and sets internal event object
-    //! into signaled state.
+    //! Sets EXIT flag and, depending on <code>drain</code>, DRAIN flag
+    //! and wakes up the consumer.
     //! \param drain If true, DRAIN flag will be set, otherwise unset.
     //! \return Flags, ERROR_BIT can be set upon error.
-    flags_type signal_exit (bool drain = true);
+    virtual flags_type signal_exit (bool drain = true) = 0;
 
     // Consumer's methods.
 
-    //! The get_events() function is used by queue's consumer. It
-    //! fills <code>buf</code> argument and sets EVENT flag in return
-    //! value. If EXIT flag is already set in flags member upon
-    //! entering the function then depending on DRAIN flag it either
-    //! fills <code>buf</code> argument or does not fill the argument,
-    //! if the queue is non-empty. The function blocks by waiting for
-    //! internal event object to be signaled if the queue is empty,
-    //! unless EXIT flag is set. The calling thread is unblocked when
-    //! items are added into the queue or when exit is signaled using
-    //! the signal_exit() function.
-    //!
-    //!
-    //! Upon error, return value has one of the error flags set.
+    //! Fills <code>buf</code> with queued events and sets EVENT flag
+    //! in return value. It blocks while the queue is empty, unless
+    //! EXIT flag is set.
     //!
     //! \param buf Pointer to storage of spi::InternalLoggingEvent
     //! instances to be filled from queue.
     //! \return Flags.
-    flags_type get_events (queue_storage_type * buf);
+    virtual flags_type get_events (queue_storage_type * buf) = 0;
 
     //! Possible state flags.
     enum Flags
@@ -130,6 +118,59 @@ public:
         //! already been touched.
         ERROR_AFTER = 0x0020
     };
+};
+
+
+//! Single consumer, multiple producers queue.
+class LOG4CPLUS_EXPORT Queue
+    : public QueueBase
+{
+public:
+    explicit Queue (unsigned len = 100);
+    virtual ~Queue ();
+
+    // Producers' methods.
+
+    //! Puts event <code>ev</code> into queue, sets QUEUE flag and
+    //! sets internal event object into signaled state. If the EXIT
+    //! flags is already set upon entering the function, nothing is
+    //! inserted into the queue. The function can block on internal
+    //! semaphore if the queue has reached maximal allowed
+    //! length. Calling thread is unblocked either by consumer thread
+    //! removing item from queue or by any other thread calling
+    //! signal_exit().
+    //!
+    //! \param ev spi::InternalLoggingEvent to be put into the queue.
+    //! \return Flags.
+    virtual flags_type put_event (spi::InternalLoggingEvent const & ev)
+        override;
+
+    //! Sets EXIT flag and DRAIN flag and sets internal event object
+    //! into signaled state.
+    //! \param drain If true, DRAIN flag will be set, otherwise unset.
+    //! \return Flags, ERROR_BIT can be set upon error.
+    virtual flags_type signal_exit (bool drain = true) override;
+
+    // Consumer's methods.
+
+    //! The get_events() function is used by queue's consumer. It
+    //! fills <code>buf</code> argument and sets EVENT flag in return
+    //! value. If EXIT flag is already set in flags member upon
+    //! entering the function then depending on DRAIN flag it either
+    //! fills <code>buf</code> argument or does not fill the argument,
+    //! if the queue is non-empty. The function blocks by waiting for
+    //! internal event object to be signaled if the queue is empty,
+    //! unless EXIT flag is set. The calling thread is unblocked when
+    //! items are added into the queue or when exit is signaled using
+    //! the signal_exit() function.
+    //!
+    //!
+    //! Upon error, return value has one of the error flags set.
+    //!
+    //! \param buf Pointer to storage of spi::InternalLoggingEvent
+    //! instances to be filled from queue.
+    //! \return Flags.
+    virtual flags_type get_events (queue_storage_type * buf) override;
 
 protected:
     //! Queue storage.
@@ -149,7 +190,91 @@ protected:
 };
 
 
-typedef helpers::SharedObjectPtr<Queue> QueuePtr;
+//! Bounded, lock-free multiple producers, single consumer queue.
+//!
+//! The queue is a ring buffer of pre-allocated slots, each carrying a
+//! sequence number (D. Vyukov's bounded queue algorithm). A producer
+//! claims a slot with a single compare-and-swap on the enqueue
+//! position and publishes it with a release store of the slot's
+//! sequence number. The consumer is the only thread that advances the
+//! dequeue position, so it needs no read-modify-write operations to
+//! take events. Events are used only to put the consumer or producers
+//! to sleep when the queue is empty or full respectively. The consumer
+//! announces that it sleeps by a flag in the enqueue position, so
+//! producers learn about it from their compare-and-swap. All of the
+//! synchronization uses acquire and release ordering only.
+//!
+//! The EXIT and DRAIN semantics are the same as those of Queue.
+class LOG4CPLUS_EXPORT RingBufferQueue
+    : public QueueBase
+{
+public:
+    //! \param len Requested capacity. It is rounded up to the nearest
+    //! power of two.
+    explicit RingBufferQueue (unsigned len = 128);
+    virtual ~RingBufferQueue ();
+
+    virtual flags_type put_event (spi::InternalLoggingEvent const & ev)
+        override;
+    virtual flags_type signal_exit (bool drain = true) override;
+    virtual flags_type get_events (queue_storage_type * buf) override;
+
+    //! Assumed size of cache line. It is used to keep the producers'
+    //! and the consumer's hot variables apart.
+    static constexpr std::size_t cache_line_size = 64;
+
+protected:
+    struct alignas (cache_line_size) Slot
+    {
+        std::atomic<std::size_t> sequence;
+        spi::InternalLoggingEvent event;
+        //! False when copying of the event into the slot has failed.
+        bool valid;
+    };
+
+    //! Wait until the slot at position `pos` is freed by the consumer or
+    //! until exit is signaled.
+    //! \return False if the EXIT flag has been set.
+    bool wait_for_space (std::size_t pos);
+
+    //! Move all published events into `buf`, or throw them away if
+    //! `buf` is null.
+    //! \return Number of consumed slots.
+    std::size_t consume (queue_storage_type * buf);
+
+    //! Number of slots, always a power of two.
+    std::size_t const capacity;
+
+    //! Ring buffer storage.
+    std::unique_ptr<Slot[]> slots;
+
+    //! Next position to be claimed by producers, shifted left by one
+    //! bit. The lowest bit is `consumer_sleeping`.
+    alignas (cache_line_size) std::atomic<std::size_t> enqueue_pos;
+
+    //! Bit of `enqueue_pos` set by the consumer before it goes to sleep
+    //! on `ev_consumer`. The producer that clears it wakes the consumer.
+    static constexpr std::size_t consumer_sleeping = 1;
+
+    //! Next position to be read by consumer. Only the consumer thread
+    //! touches it.
+    alignas (cache_line_size) std::size_t dequeue_pos;
+
+    //! EXIT and DRAIN flags.
+    alignas (cache_line_size) std::atomic<flags_type> state;
+
+    //! Number of producers waiting on `ev_producers` for free slot.
+    std::atomic<unsigned> producers_waiting;
+
+    //! Event on which consumer waits when it finds the queue empty.
+    ManualResetEvent ev_consumer;
+
+    //! Event on which producers wait when the queue is full.
+    ManualResetEvent ev_producers;
+};
+
+
+typedef helpers::SharedObjectPtr<QueueBase> QueuePtr;
 
 
 } } // namespace log4cplus { namespace thread {
@@ -157,10 +157,11 @@ namespace log4cplus {
         };
 
 
+        //! Appends decimal representation of value to str.
         template <class stringType, std::integral intType>
         inline
         void
-        convertIntegerToString (stringType & str, intType value)
+        appendIntegerToString (stringType & str, intType value)
         {
             typedef std::numeric_limits<intType> intTypeLimits;
             typedef typename stringType::value_type charType;
@@ -200,7 +201,17 @@ namespace log4cplus {
                 }
             }
 
-            str.assign (static_cast<charType const *>(it), buf_end);
+            str.append (static_cast<charType const *>(it), buf_end);
+        }
+
+
+        template <class stringType, std::integral intType>
+        inline
+        void
+        convertIntegerToString (stringType & str, intType value)
+        {
+            str.clear ();
+            appendIntegerToString (str, value);
         }
 
 
@@ -38,6 +38,7 @@
 
 #include <ctime>
 #include <chrono>
+#include <vector>
 
 
 namespace log4cplus {
@@ -71,6 +72,44 @@ now ()
 }
 
 
+/**
+ * Sources of time stamps of logging events.
+ *
+ * \sa setEventClock(), eventNow()
+ */
+enum class EventClock
+{
+    //! now(), i.e., <code>std::chrono::system_clock</code>. This is
+    //! the default.
+    Precise,
+    //! <code>CLOCK_REALTIME_COARSE</code>. It is cheaper to read but
+    //! its resolution is only a scheduler tick, typically 1-4 ms.
+    Coarse,
+    //! Time stamp counter of the CPU. It is calibrated against now()
+    //! and re-anchored to it every second. It requires x86 CPU with
+    //! invariant TSC.
+    TSC
+};
+
+
+/**
+ * Selects clock used by eventNow(). When the requested clock is not
+ * available on this platform, a warning is logged and
+ * EventClock::Precise is used instead.
+ *
+ * \return <code>true</code> when the requested clock has been
+ * selected.
+ */
+LOG4CPLUS_EXPORT bool setEventClock (EventClock clock);
+
+//! \return Clock selected by setEventClock().
+LOG4CPLUS_EXPORT EventClock getEventClock ();
+
+//! \return Current time according to the clock selected by
+//! setEventClock(). It is used for time stamps of logging events.
+LOG4CPLUS_EXPORT Time eventNow ();
+
+
 inline
 Time
 from_time_t (time_t t_time)
@@ -136,13 +175,38 @@ LOG4CPLUS_EXPORT
 void gmTime (tm* t, Time const &);
 
 /**
- * Populates <code>tm</code> using the <code>localtime()</code>
- * function.
+ * Populates <code>tm</code> with local time, like the
+ * <code>localtime()</code> function.
+ *
+ * The UTC offset is cached together with the interval of time it is
+ * valid for, up to the next DST transition. Times within the interval
+ * are converted arithmetically, without calling
+ * <code>localtime()</code> and without taking any lock. The cache
+ * moves on when a time past the interval is converted. Times before
+ * the interval are passed to <code>localtime()</code>.
+ *
+ * \sa refreshTimeZone()
  */
 
 LOG4CPLUS_EXPORT
 void localTime (tm* t, Time const &);
 
+/**
+ * \return Offset of local time from UTC at the given time, i.e.,
+ * local time minus UTC. It uses the same cache as localTime().
+ */
+LOG4CPLUS_EXPORT
+chrono::seconds localTimeOffset (Time const &);
+
+/**
+ * Drops the UTC offset cached by localTime() and re-reads time zone
+ * settings using <code>tzset()</code>. Call it after changing the
+ * time zone of the process, e.g., through the <code>TZ</code>
+ * environment variable.
+ */
+LOG4CPLUS_EXPORT
+void refreshTimeZone ();
+
 /**
  * Returns a string with a "formatted time" specified by
  * <code>fmt</code>.  It used the <code>strftime()</code>
@@ -161,6 +225,78 @@ log4cplus::tstring getFormattedTime (log4cplus::tstring const & fmt,
     Time const & the_time, bool use_gmtime = false);
 
 
+/**
+ * Caches output of getFormattedTime() for the last formatted second.
+ *
+ * The format string is split at <code>%q</code> and
+ * <code>%Q</code> specifiers once. When the second of the formatted
+ * time changes, the pieces in between are formatted together by a
+ * single getFormattedTime() call and the result is sliced at
+ * separator characters which do not occur in the format. Within the
+ * same second only the sub-second fields are rendered again. The <code>localtime()</code> conversion
+ * is thus done at most once per second and each second is converted
+ * anew, so DST and time zone changes take effect with the first time
+ * stamp past the change.
+ *
+ * Instances are not thread safe. They are meant to be owned by a
+ * layout or an appender and used under its lock.
+ */
+class LOG4CPLUS_EXPORT FormattedTimeCache
+{
+public:
+    FormattedTimeCache ();
+    explicit FormattedTimeCache (log4cplus::tstring const & fmt,
+        bool use_gmtime = false);
+
+    //! Changes format and invalidates the cache.
+    void setFormat (log4cplus::tstring const & fmt, bool use_gmtime = false);
+
+    //! Drops the cached second.
+    void invalidate () { valid = false; }
+
+    /**
+     * \return The same string as <code>getFormattedTime (fmt,
+     * the_time, use_gmtime)</code>. The reference is valid until the
+     * next call.
+     */
+    log4cplus::tstring const & format (Time const & the_time);
+
+    //! Appends the same string as format() to buffer.
+    void append (log4cplus::tstring & buffer, Time const & the_time);
+
+private:
+    enum SubSecond : unsigned char
+    {
+        NONE,
+        MILLIS,     // %q
+        MICROS      // %Q
+    };
+
+    struct Segment
+    {
+        //! strftime() format of the text preceding the sub-second field.
+        log4cplus::tstring fmt;
+        //! Formatted text of fmt for the cached second.
+        log4cplus::tstring text;
+        SubSecond sub_second;
+    };
+
+    void formatSegments (Time const & the_time);
+
+    std::vector<Segment> segments;
+    //! Formats of all segments joined by separator.
+    log4cplus::tstring joined_fmt;
+    log4cplus::tstring result;
+    //! Character separating segments in joined_fmt, or 0 when every
+    //! segment has to be formatted separately.
+    log4cplus::tchar separator;
+    time_t second;
+    bool use_gmtime;
+    bool valid;
+};
+
+
+
 } // namespace helpers
 
 } // namespace log4cplus
@@ -0,0 +1,202 @@
+// -*- C++ -*-
+//
+//  Copyright (C) 2026, Vaclav Haisman. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef LOG4CPLUS_HELPERS_TIMEINDEX_H
+#define LOG4CPLUS_HELPERS_TIMEINDEX_H
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_HAVE_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#include <log4cplus/tstring.h>
+#include <log4cplus/helpers/timehelper.h>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+namespace log4cplus {
+
+namespace helpers {
+
+
+//! \return Name of time index of log file `logName`, e.g.,
+//! <tt>log.idx</tt> for <tt>log</tt>.
+LOG4CPLUS_EXPORT tstring timeIndexName (tstring const & logName);
+
+
+//! One entry of time index.
+struct LOG4CPLUS_EXPORT TimeIndexEntry
+{
+    //! Start of the interval.
+    Time time;
+    //! Offset of the first record of the interval in the log file.
+    std::uint64_t offset = 0;
+};
+
+
+/**
+ * Writes time index of a log file. Time index is a sidecar file that
+ * maps coarse timestamps to offsets in the log file. An entry is
+ * recorded for the first record of each interval of the index. The
+ * file starts with a 16 bytes long header, magic <tt>L4CPTIDX</tt>,
+ * format version and the interval in seconds, followed by 16 bytes
+ * long entries, start of the interval in microseconds since the Unix
+ * epoch and the offset, all little endian.
+ *
+ * Entries are recorded only for intervals later than all previously
+ * recorded ones. All records with timestamps from the start of an
+ * entry's interval on are thus found after the entry's offset, even
+ * when records are not appended in the order of their timestamps.
+ *
+ * \sa TimeIndexReader
+ */
+class LOG4CPLUS_EXPORT TimeIndexWriter
+{
+public:
+    static std::size_t const header_size = 16;
+    static std::size_t const entry_size = 16;
+
+    //! @param interval Interval of the index in seconds, at least 1.
+    explicit TimeIndexWriter (unsigned long interval = 1);
+    ~TimeIndexWriter ();
+
+    TimeIndexWriter (TimeIndexWriter const &) = delete;
+    TimeIndexWriter & operator = (TimeIndexWriter const &) = delete;
+
+    /**
+     * Opens index file `name`. When `append` is true, entries of the
+     * existing index are kept and new entries are appended after them.
+     * The index is started again when it has been written with another
+     * interval or when it refers to offsets beyond `logSize`, i.e.,
+     * when it does not belong to the log file.
+     *
+     * @param logSize Current size of the indexed log file.
+     * \return true when the index has been opened.
+     */
+    bool open (tstring const & name, bool append, std::uint64_t logSize);
+
+    void close ();
+
+    bool is_open () const;
+
+    /**
+     * Records `offset` of a record with `timestamp` when it is the
+     * first record of a later interval than all recorded ones.
+     */
+    void
+    add (Time const & timestamp, std::uint64_t offset)
+    {
+        if (timestamp.time_since_epoch ().count () >= next)
+            addEntry (timestamp, offset);
+    }
+
+private:
+    void addEntry (Time const & timestamp, std::uint64_t offset);
+
+    std::ofstream out;
+    //! Length of the interval in microseconds.
+    long long length;
+    //! Start of the interval following the last recorded one in
+    //! microseconds since the epoch.
+    long long next;
+};
+
+
+/**
+ * Reads time index written by TimeIndexWriter and finds offsets of
+ * records of a time range in the log file using binary search. For log
+ * files compressed by <tt>CompressBackups</tt>, the offsets are
+ * offsets in the decompressed data.
+ */
+class LOG4CPLUS_EXPORT TimeIndexReader
+{
+public:
+    //! Offset that stands for the end of the log file.
+    static constexpr std::uint64_t npos
+        = (std::numeric_limits<std::uint64_t>::max) ();
+
+    TimeIndexReader ();
+    ~TimeIndexReader ();
+
+    /**
+     * Reads index file `name`. An incomplete last entry is ignored.
+     *
+     * \return true when the file is a time index.
+     */
+    bool open (tstring const & name);
+
+    void close ();
+
+    //! \return Interval of the index in seconds.
+    unsigned long interval () const;
+
+    std::vector<TimeIndexEntry> const & entries () const;
+
+    /**
+     * \return Offset in the log file from which on all records with
+     * timestamps from `time` on are found. It is 0 when `time` precedes
+     * the first entry.
+     */
+    std::uint64_t find (Time const & time) const;
+
+    /**
+     * \return Offsets of the start and of the end of the part of the
+     * log file that contains records with timestamps from `from` to
+     * `to`, inclusive. The end is the offset of the first interval
+     * after `to` or npos. Records of concurrent threads can be
+     * appended out of the order of their timestamps, the part can thus
+     * miss such records around its end.
+     */
+    std::pair<std::uint64_t, std::uint64_t> range (Time const & from,
+        Time const & to) const;
+
+    /**
+     * Reads the part of log file `logName` given by range() and
+     * appends it to `out`.
+     *
+     * \return true on success.
+     */
+    bool readRange (tstring const & logName, Time const & from,
+        Time const & to, std::string & out) const;
+
+private:
+    std::vector<TimeIndexEntry> items;
+    unsigned long seconds;
+};
+
+
+} // namespace helpers
+
+} // namespace log4cplus
+
+
+#endif // LOG4CPLUS_HELPERS_TIMEINDEX_H
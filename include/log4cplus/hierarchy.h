@@ -32,6 +32,7 @@
 
 #include <log4cplus/logger.h>
 #include <log4cplus/thread/syncprims.h>
+#include <atomic>
 #include <map>
 #include <memory>
 #include <vector>
@@ -85,6 +86,11 @@ namespace log4cplus {
          *
          * You should <em>really</em> know what you are doing before
          * invoking this method.
+         *
+         * Removed loggers are released once neither Logger instances
+         * nor lock-free lookups running concurrently with this call
+         * reference them. Loggers cached by logging macros are dropped
+         * at their next use.
          */
         virtual void clear();
 
@@ -241,6 +247,12 @@ namespace log4cplus {
         typedef std::map<log4cplus::tstring, ProvisionNode, std::less<>> ProvisionNodeMap;
         typedef std::map<log4cplus::tstring, Logger, std::less<>> LoggerMap;
 
+        /**
+         * Insert-only hash index of loggers. It allows lock-free lookups
+         * of existing loggers by name. See hierarchy.cxx.
+         */
+        struct LoggerIndex;
+
       // Methods
         /**
          * This is the implementation of the <code>getInstance()</code> method.
@@ -257,6 +269,33 @@ namespace log4cplus {
         LOG4CPLUS_PRIVATE
         void initializeLoggerList(LoggerList& list) const;
 
+        /**
+         * Lock-free lookup of existing logger in <code>loggerIndex</code>.
+         * It must be called inside of RCU read-side critical section,
+         * the returned pointer is valid only until its end.
+         *
+         * @return Pointer to the logger or <code>nullptr</code> if the
+         * logger does not exist yet.
+         */
+        LOG4CPLUS_PRIVATE
+        Logger const * findLogger(const log4cplus::tstring_view& name) const;
+
+        /**
+         * Adds new logger to <code>loggerIndex</code>, possibly replacing
+         * it with a bigger one. The replaced index is retired through
+         * RCU.
+         * NOTE: This method does not lock the <code>hashtable_mutex</code>.
+         */
+        LOG4CPLUS_PRIVATE void indexLogger(Logger const & logger);
+
+        /**
+         * Replaces <code>loggerIndex</code> with an empty index with
+         * given number of buckets. The replaced index is retired through
+         * RCU.
+         * NOTE: This method does not lock the <code>hashtable_mutex</code>.
+         */
+        LOG4CPLUS_PRIVATE void resetLoggerIndex(std::size_t buckets);
+
         /**
          * This method loops through all the *potential* parents of
          * logger'. There 3 possible cases:
@@ -303,7 +342,13 @@ namespace log4cplus {
         LoggerMap loggerPtrs;
         Logger root;
 
-        int disableValue;
+        //! Current index of loggerPtrs, published for lock-free readers.
+        //! Indexes replaced by growth or by clear() can still be in use
+        //! by concurrent readers, they are freed only after all RCU
+        //! read-side critical sections that could see them have ended.
+        std::atomic<LoggerIndex *> loggerIndex;
+
+        std::atomic<int> disableValue;
 
         bool emittedNoAppenderWarning;
 
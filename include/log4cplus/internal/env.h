@@ -71,6 +71,18 @@ bool split_path (std::vector<tstring> & components, std::size_t & special,
 //! Makes directories leading to file.
 void make_dirs (tstring const & file_path);
 
+#if ! defined (_WIN32)
+//! Checks that file is at least <code>size</code> bytes long.
+//! \return Zero or <code>errno</code> value.
+int check_file_size (int fd, std::size_t size);
+
+//! Allocates storage for first <code>size</code> bytes of the file
+//! so that it can be written through shared memory mapping. Falls
+//! back to sparse file only when preallocation is not supported.
+//! \return Zero or <code>errno</code> value.
+int preallocate_file (int fd, std::size_t size);
+#endif
+
 inline
 #if defined (_WIN32)
 DWORD
@@ -96,6 +108,11 @@ get_process_id ()
 #endif
 
 
+//! Same as get_process_id() but without a system call per call. The
+//! cached value is refreshed in child processes created by fork(2).
+decltype (get_process_id ()) get_cached_process_id ();
+
+
 } } // namespace log4cplus { namespace internal {
 
 
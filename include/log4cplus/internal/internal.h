@@ -51,6 +51,7 @@
 #include <vector>
 #include <sstream>
 #include <cstdio>
+#include <ctime>
 #include <log4cplus/tstring.h>
 #include <log4cplus/streams.h>
 #include <log4cplus/ndc.h>
@@ -58,10 +59,13 @@
 #include <log4cplus/spi/loggingevent.h>
 #include <log4cplus/thread/impl/tls.h>
 #include <log4cplus/helpers/snprintf.h>
+#include <log4cplus/internal/rcu.h>
 
 
 namespace log4cplus {
 
+class Layout;
+
 namespace internal {
 
 
@@ -97,6 +101,24 @@ struct gft_scratch_pad
 };
 
 
+//! Interval of time during which local time has constant offset from
+//! UTC. It is used by helpers::localTime().
+struct time_zone_span
+{
+    //! First second of the interval.
+    std::time_t begin;
+    //! First second past the interval.
+    std::time_t end;
+    //! Local time minus UTC, in seconds.
+    long offset;
+    //! Value of time_zone_cache generation the span was computed in.
+    unsigned generation;
+    //! localtime() result for a second of the interval. It provides
+    //! tm_isdst and platform specific fields like tm_zone.
+    std::tm local;
+};
+
+
 struct appender_sratch_pad
 {
     appender_sratch_pad ();
@@ -108,6 +130,38 @@ struct appender_sratch_pad
 };
 
 
+//! Stream buffer appending everything written to it to `target`
+//! without buffering.
+class string_append_buf
+    : public std::basic_streambuf<tchar>
+{
+public:
+    tstring * target = nullptr;
+
+protected:
+    virtual int_type overflow (int_type ch) override;
+    virtual std::streamsize xsputn (tchar const * s, std::streamsize n)
+        override;
+};
+
+
+//! State of Layout::formatAndAppendThroughStream() and
+//! Layout::formatAndAppendToStream().
+struct layout_scratch_pad
+{
+    layout_scratch_pad ();
+    ~layout_scratch_pad ();
+
+    //! Stream appending to `buf.target`.
+    string_append_buf buf;
+    tostream os;
+
+    //! Layout whose ostream overload of formatAndAppend() is calling its
+    //! buffer overload.
+    Layout const * in_stream_overload = nullptr;
+};
+
+
 //! Per thread data.
 struct per_thread_data
 {
@@ -123,11 +177,14 @@ struct per_thread_data
     log4cplus::tstring thread_name2;
     gft_scratch_pad gft_sp;
     appender_sratch_pad appender_sp;
+    layout_scratch_pad layout_sp;
     log4cplus::tstring faa_str;
     log4cplus::tstring ll_str;
     spi::InternalLoggingEvent forced_log_ev;
     std::FILE * fnull;
     log4cplus::helpers::snprintf_buf snprintf_buf;
+    std::shared_ptr<time_zone_span const> tz_span;
+    rcu::reader_state rcu;
 };
 
 
@@ -195,6 +252,14 @@ get_ptd (bool alloc = true)
 #endif // defined (LOG4CPLUS_THREAD_LOCAL_VAR)
 
 
+inline
+std::shared_ptr<time_zone_span const> &
+get_tz_span ()
+{
+    return get_ptd ()->tz_span;
+}
+
+
 inline
 tstring &
 get_thread_name_str ()
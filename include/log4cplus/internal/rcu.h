@@ -0,0 +1,122 @@
+// -*- C++ -*-
+//
+//  Copyright (C) 2026, Vaclav Haisman. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/** @file
+ * Epoch based read-copy-update. Readers access shared objects through
+ * raw pointers inside read-side critical sections, which touch only
+ * per-thread data and never write shared cache lines. Writers
+ * unpublish an object and hand it to retire(). It is destroyed once no
+ * read-side critical section that could have seen it is in progress.
+ * The destruction is done by the writer when possible, otherwise by
+ * the last such reader on exit from its critical section.
+ *
+ * This header is internal to log4cplus.
+ */
+
+#ifndef LOG4CPLUS_INTERNAL_RCU_H
+#define LOG4CPLUS_INTERNAL_RCU_H
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_HAVE_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#if ! defined (INSIDE_LOG4CPLUS)
+#  error "This header must not be be used outside log4cplus' implementation files."
+#endif
+
+
+namespace log4cplus { namespace internal { namespace rcu {
+
+struct reader_record;
+
+
+//! Read-side state of a thread. It is part of per_thread_data.
+struct reader_state
+{
+    reader_record * record = nullptr;
+    unsigned nesting = 0;
+};
+
+
+//! Enters read-side critical section. Critical sections can nest.
+reader_state & read_lock ();
+
+//! Leaves read-side critical section entered by read_lock().
+void read_unlock (reader_state &);
+
+
+//! Read-side critical section guard.
+class read_guard
+{
+public:
+    read_guard ()
+        : state (read_lock ())
+    { }
+
+    ~read_guard ()
+    {
+        read_unlock (state);
+    }
+
+    read_guard (read_guard const &) = delete;
+    read_guard & operator = (read_guard const &) = delete;
+
+private:
+    reader_state & state;
+};
+
+
+/**
+ * Schedules <code>deleter (ptr)</code> for when no read-side critical
+ * section can access <code>ptr</code> any more. The object must
+ * already be unreachable for new readers. Deleters of retired objects
+ * run in the order of retirement.
+ */
+void retire (void * ptr, void (* deleter) (void *));
+
+
+template <typename T>
+void
+retire (T * ptr)
+{
+    retire (const_cast<void *>(static_cast<void const *>(ptr)),
+        [] (void * p) { delete static_cast<T *>(p); });
+}
+
+
+//! Destroys retired objects that readers cannot access any more.
+void reclaim ();
+
+
+//! Releases reader record of exiting thread for reuse.
+void release_reader (reader_state &);
+
+
+} } } // namespace log4cplus { namespace internal { namespace rcu {
+
+
+#endif // LOG4CPLUS_INTERNAL_RCU_H
@@ -35,6 +35,8 @@
 #include <log4cplus/tstring.h>
 #include <log4cplus/helpers/timehelper.h>
 
+#include <atomic>
+#include <typeinfo>
 #include <vector>
 #include <memory>
 
@@ -84,8 +86,72 @@ namespace log4cplus {
         virtual void formatAndAppend(log4cplus::tostream& output,
             const log4cplus::spi::InternalLoggingEvent& event) = 0;
 
+        /**
+         * Formats the event and appends the result to the end of
+         * <code>buffer</code>. Appenders should prefer this overload,
+         * it does not go through iostreams.
+         *
+         * The default implementation formats into a string stream
+         * using the ostream overload, so that existing layouts keep
+         * working. Layouts of log4cplus override both overloads and
+         * their buffer overload formats into <code>buffer</code>
+         * directly. For instances of classes derived from them, which
+         * might override only the ostream overload, it calls the
+         * ostream overload instead, using a stream that appends to
+         * <code>buffer</code>. See formatAndAppendThroughStream().
+         */
+        virtual void formatAndAppend(log4cplus::tstring& buffer,
+            const log4cplus::spi::InternalLoggingEvent& event);
+
     protected:
+        /**
+         * Implements the ostream overload of formatAndAppend() using
+         * the buffer overload. While the buffer overload runs,
+         * formatAndAppendThroughStream() of this layout returns
+         * <code>false</code>.
+         */
+        void formatAndAppendToStream(log4cplus::tostream& output,
+            const log4cplus::spi::InternalLoggingEvent& event);
+
+        /**
+         * Used by the buffer overload of formatAndAppend() of layouts
+         * that format into a string directly, when isDerivedLayout()
+         * returns <code>true</code>. It calls the ostream
+         * overload, which a derived class might have overridden, with
+         * a stream appending to <code>buffer</code>. The ostream
+         * overload of the layout recognizes the stream by
+         * appendingStreamTarget() and formats into the buffer directly.
+         *
+         * \return <code>false</code> when called through
+         * formatAndAppendToStream() of this layout. The ostream
+         * overload has been applied already then and the caller has to
+         * format into the buffer itself.
+         */
+        bool formatAndAppendThroughStream(log4cplus::tstring& buffer,
+            const log4cplus::spi::InternalLoggingEvent& event);
+
+        //! \return The buffer <code>output</code> appends to, when it
+        //! is the stream of formatAndAppendThroughStream(), otherwise
+        //! <code>nullptr</code>.
+        static log4cplus::tstring * appendingStreamTarget(
+            log4cplus::tostream& output);
+
+        /**
+         * \return <code>true</code> when this layout is an instance of
+         * a class derived from the layout class <code>type</code>,
+         * which might override the ostream overload of
+         * formatAndAppend(). Only such layouts need
+         * formatAndAppendThroughStream(). The result is determined by
+         * the first call and cached.
+         */
+        bool isDerivedLayout(std::type_info const & type) const;
+
         LogLevelManager& llmCache;
+
+    private:
+        //! Cached result of isDerivedLayout(), -1 before its first
+        //! call.
+        mutable std::atomic<signed char> derivedLayout {-1};
     };
 
 
@@ -114,6 +180,12 @@ namespace log4cplus {
 
         virtual void formatAndAppend(log4cplus::tostream& output,
                                      const log4cplus::spi::InternalLoggingEvent& event) override;
+        virtual void formatAndAppend(log4cplus::tstring& buffer,
+                                     const log4cplus::spi::InternalLoggingEvent& event) override;
+
+    private:
+        void formatInto(log4cplus::tstring& buffer,
+            const log4cplus::spi::InternalLoggingEvent& event);
     };
 
 
@@ -175,6 +247,8 @@ namespace log4cplus {
 
         virtual void formatAndAppend(log4cplus::tostream& output,
                                      const log4cplus::spi::InternalLoggingEvent& event) override;
+        virtual void formatAndAppend(log4cplus::tstring& buffer,
+                                     const log4cplus::spi::InternalLoggingEvent& event) override;
 
         bool getThreadPrinting() const;
         void setThreadPrinting(bool);
@@ -191,6 +265,16 @@ namespace log4cplus {
        bool thread_printing = true;
        bool category_prefixing = true;
        bool context_printing = true;
+
+    private:
+       void formatInto(log4cplus::tstring& buffer,
+           const log4cplus::spi::InternalLoggingEvent& event);
+
+       //! Formats dateFormat; rebuilt when dateFormat or use_gmtime
+       //! change.
+       helpers::FormattedTimeCache dateFormatCache;
+       log4cplus::tstring cachedDateFormat;
+       bool cachedUseGmtime = false;
     };
 
 
@@ -338,6 +422,9 @@ namespace log4cplus {
      *
      *   For example, the pattern <b>%E{HOME}</b> will output the contents
      *   of the HOME environment variable.
+     *
+     *   <b>NOTE</b> By default the value is only retrieved once at
+     *   initialization. See the <tt>SnapshotEnvironment</tt> property.
      * </td>
      * </tr>
      *
@@ -456,7 +543,8 @@ namespace log4cplus {
      *   <td align=center><b>i</b></td>
      *
      *   <td>Used to output the process ID of the process that generated the
-     *   logging event.</td>
+     *   logging event.
+     * </td>
      * </tr>
      *
      * <tr>
@@ -607,15 +695,28 @@ namespace log4cplus {
      *
      * <dt><tt>ConversionPattern</tt></dt>
      * <dd>This property specifies conversion pattern.</dd>
+     *
+     * <dt><tt>SnapshotEnvironment</tt></dt>
+     * <dd>When this property is <tt>true</tt>, which is the default,
+     * values of environment variables used by <b>%%E</b> specifiers
+     * are read once when the layout is configured. Set it to
+     * <tt>false</tt> to read them for every logging event.</dd>
      * </dl>
      *
+     * \sa StaticPatternLayout for patterns known at compile time.
      */
     class LOG4CPLUS_EXPORT PatternLayout
         : public Layout
     {
     public:
       // Ctors and dtor
-        PatternLayout(const log4cplus::tstring& pattern);
+        /**
+         * @param pattern Conversion pattern.
+         * @param snapshotEnv When true, values of <b>%%E</b>
+         * environment variables are read once at construction.
+         */
+        PatternLayout(const log4cplus::tstring& pattern,
+            bool snapshotEnv = true);
         PatternLayout(const log4cplus::helpers::Properties& properties);
 
         PatternLayout(const PatternLayout&) = delete;
@@ -625,13 +726,20 @@ namespace log4cplus {
 
         virtual void formatAndAppend(log4cplus::tostream& output,
                                      const log4cplus::spi::InternalLoggingEvent& event) override;
+        virtual void formatAndAppend(log4cplus::tstring& buffer,
+                                     const log4cplus::spi::InternalLoggingEvent& event) override;
 
     protected:
-        void init(const log4cplus::tstring& pattern, unsigned ndcMaxDepth = 0);
+        void init(const log4cplus::tstring& pattern, unsigned ndcMaxDepth = 0,
+            bool snapshotEnv = true);
 
       // Data
         log4cplus::tstring pattern;
         std::vector<std::unique_ptr<pattern::PatternConverter> > parsedPattern;
+
+    private:
+        void formatInto(log4cplus::tstring& buffer,
+            const log4cplus::spi::InternalLoggingEvent& event);
     };
 
 
@@ -27,6 +27,7 @@
 #include <log4cplus/config.hxx>
 #include <log4cplus/appender.h>
 #include <log4cplus/helpers/socket.h>
+#include <log4cplus/helpers/timehelper.h>
 
 namespace log4cplus {
 
@@ -82,6 +83,9 @@ namespace log4cplus {
         bool ipv6 = false;
 
     private:
+        //! Formats event time stamps as milliseconds since epoch.
+        helpers::FormattedTimeCache timestampCache {LOG4CPLUS_TEXT ("%s%q")};
+
       // Disallow copying of instances of this class
         Log4jUdpAppender(const Log4jUdpAppender&);
         Log4jUdpAppender& operator=(const Log4jUdpAppender&);
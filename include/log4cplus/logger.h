@@ -36,6 +36,8 @@
 #include <log4cplus/spi/appenderattachable.h>
 #include <log4cplus/spi/loggerfactory.h>
 
+#include <atomic>
+#include <cstdint>
 #include <vector>
 
 
@@ -47,12 +49,51 @@ namespace log4cplus
     class Hierarchy;
     class HierarchyLocker;
     class DefaultLoggerFactory;
+    class LoggerRef;
 
     namespace spi
     {
 
         class LoggerImpl;
 
+        /**
+         * Process wide logger configuration epoch. It is incremented
+         * every time anything that can change effective log level of
+         * any logger changes, e.g., assigned log level, hierarchy
+         * disable value or logger parent links. Caches of effective log
+         * level are valid only as long as this value does not change.
+         */
+        LOG4CPLUS_EXPORT extern std::atomic<std::uint64_t>
+            loggerConfigurationEpoch;
+
+        /**
+         * Increments loggerConfigurationEpoch and thus invalidates all
+         * cached effective log levels.
+         */
+        LOG4CPLUS_EXPORT void bumpLoggerConfigurationEpoch ();
+
+        /**
+         * Process wide generation of logger registries. It is
+         * incremented every time loggers are removed from a hierarchy,
+         * i.e., by Hierarchy::clear(). Loggers cached by name are valid
+         * only as long as this value does not change.
+         */
+        LOG4CPLUS_EXPORT extern std::atomic<std::uint64_t>
+            loggerRegistryGeneration;
+
+        /**
+         * Increments loggerRegistryGeneration and thus invalidates all
+         * loggers cached by name.
+         */
+        LOG4CPLUS_EXPORT void bumpLoggerRegistryGeneration ();
+
+    }
+
+    namespace detail
+    {
+
+        class MacroCallSite;
+
     }
 
 
@@ -302,6 +343,67 @@ namespace log4cplus
         friend class log4cplus::Hierarchy;
         friend class log4cplus::HierarchyLocker;
         friend class log4cplus::DefaultLoggerFactory;
+        friend class log4cplus::LoggerRef;
+    };
+
+
+    /**
+     * Non-owning reference to a logger. Unlike Logger, copying or
+     * destroying instances of this class does not touch the reference
+     * count of the underlying logger implementation, so it avoids
+     * contended atomic operations when many threads log through the
+     * same logger.
+     *
+     * The referenced logger is kept alive by its Hierarchy. It is the
+     * responsibility of the user not to use LoggerRef after the logger
+     * has been removed from its Hierarchy by Hierarchy::clear() and the
+     * last Logger instance referencing it has been destroyed.
+     *
+     * The LOG4CPLUS_* logging macros accept LoggerRef as well as Logger.
+     */
+    class LOG4CPLUS_EXPORT LoggerRef
+    {
+    public:
+        LoggerRef (Logger const & logger) LOG4CPLUS_NOEXCEPT
+            : value (logger.value)
+        { }
+
+        LoggerRef (LoggerRef const &) LOG4CPLUS_NOEXCEPT = default;
+        LoggerRef & operator = (LoggerRef const &) LOG4CPLUS_NOEXCEPT
+            = default;
+
+        //! See Logger::isEnabledFor().
+        bool isEnabledFor (LogLevel ll) const;
+
+        //! See Logger::log().
+        void log (LogLevel ll, const log4cplus::tstring_view& message,
+            const char* file = nullptr, int line = -1,
+            const char* function = nullptr) const;
+
+        //! See Logger::forcedLog().
+        void forcedLog (LogLevel ll, const log4cplus::tstring_view& message,
+            const char* file = nullptr, int line = -1,
+            const char* function = nullptr) const;
+
+        //! See Logger::forcedLog().
+        void forcedLog (spi::InternalLoggingEvent const &) const;
+
+        //! See Logger::getName().
+        log4cplus::tstring const & getName () const;
+
+        /**
+         * Returns owning Logger instance for the referenced logger.
+         */
+        Logger getLogger () const;
+
+    private:
+        explicit LoggerRef (spi::LoggerImpl * impl) LOG4CPLUS_NOEXCEPT
+            : value (impl)
+        { }
+
+        spi::LoggerImpl * value;
+
+        friend class log4cplus::detail::MacroCallSite;
     };
 
 
@@ -37,8 +37,11 @@
 #include <log4cplus/tracelogger.h>
 #include <sstream>
 #include <utility>
+#include <atomic>
+#include <cstdint>
 #include <format>
 #include <iterator>
+#include <type_traits>
 
 #if defined(_MSC_VER)
 #define LOG4CPLUS_SUPPRESS_DOWHILE_WARNING()  \
@@ -83,17 +86,127 @@ namespace detail
 {
 
 
+/**
+ * Static record of single logging macro expansion. It caches whether
+ * the call site is enabled for its log level. The cached value is
+ * revalidated only when spi::loggerConfigurationEpoch changes, so that
+ * disabled statements cost only a few relaxed loads and a well
+ * predicted branch.
+ *
+ * The cache is used only as long as the call site is always used with
+ * the same logger. Once a different logger is seen, the call site
+ * falls back to Logger::isEnabledFor() permanently.
+ *
+ * For call sites that name their logger by a constant character array,
+ * usually a string literal, the record also caches the logger looked up
+ * by that name, so that the lookup in the default Hierarchy is done
+ * only once until loggers are removed by Hierarchy::clear().
+ */
+class LOG4CPLUS_EXPORT MacroCallSite
+{
+public:
+    constexpr MacroCallSite () LOG4CPLUS_NOEXCEPT = default;
+
+    MacroCallSite (MacroCallSite const &) = delete;
+    MacroCallSite & operator = (MacroCallSite const &) = delete;
+
+    bool
+    isEnabledFor (LoggerRef const & logger, LogLevel ll)
+    {
+        std::uint64_t const cached = state.load (std::memory_order_relaxed);
+        if ((cached >> 1) == spi::loggerConfigurationEpoch.load (
+                std::memory_order_relaxed)
+            && owner.load (std::memory_order_relaxed) == logger.value)
+            [[likely]]
+            return (cached & 1) != 0;
+        else
+            return revalidate (logger, ll);
+    }
+
+    class NamedLoggerRef;
+
+    /**
+     * Returns logger of given name from the default Hierarchy. The
+     * cached logger is used when <code>name</code> is the same pointer
+     * as in the call that has cached it, so the contents of
+     * <code>name</code> must not change.
+     */
+    NamedLoggerRef getLogger (tchar const * name);
+
+private:
+    //! Immutable record of the named logger cache. See loggingmacros.cxx.
+    struct NamedLogger;
+
+    bool revalidate (LoggerRef const & logger, LogLevel ll);
+
+    //! Cached enabled state in the lowest bit and the value of
+    //! spi::loggerConfigurationEpoch it has been computed for in the
+    //! rest of the bits.
+    std::atomic<std::uint64_t> state {0};
+
+    //! Logger this call site caches the state for. It is set by the
+    //! first revalidation and it never changes afterwards, except when
+    //! the call site is used with a different logger. Then it is set to
+    //! address of this record to disable caching.
+    std::atomic<void const *> owner {nullptr};
+
+    //! Named logger cache. The record is replaced as a whole and the
+    //! replaced one is released only after all RCU read-side critical
+    //! sections that could see it have ended.
+    std::atomic<NamedLogger const *> named {nullptr};
+};
+
+
+/**
+ * Reference to the logger returned by MacroCallSite::getLogger(). It
+ * keeps the RCU read-side critical section the named logger cache has
+ * been read in open until it is destroyed, so that the referenced
+ * logger cannot be released while the logging macro uses it, even if
+ * the cache is replaced concurrently.
+ */
+class LOG4CPLUS_EXPORT MacroCallSite::NamedLoggerRef
+    : public LoggerRef
+{
+public:
+    NamedLoggerRef (LoggerRef const & logger, void * section_)
+        LOG4CPLUS_NOEXCEPT
+        : LoggerRef (logger)
+        , section (section_)
+    { }
+
+    ~NamedLoggerRef ();
+
+    NamedLoggerRef (NamedLoggerRef const &) = delete;
+    NamedLoggerRef & operator = (NamedLoggerRef const &) = delete;
+
+private:
+    void * section;
+};
+
+
+// Lvalue loggers are only referenced. This avoids touching the shared
+// reference count of the logger implementation on every macro
+// invocation.
+
 inline
-Logger
-macros_get_logger (Logger const & logger)
+LoggerRef
+macros_get_logger (MacroCallSite &, Logger const & logger)
 {
-    return logger;
+    return LoggerRef (logger);
 }
 
 
 inline
-Logger const &
-macros_get_logger (Logger & logger)
+LoggerRef
+macros_get_logger (MacroCallSite &, Logger & logger)
+{
+    return LoggerRef (logger);
+}
+
+
+inline
+LoggerRef
+macros_get_logger (MacroCallSite &, LoggerRef const & logger)
 {
     return logger;
 }
@@ -101,22 +214,48 @@ macros_get_logger (Logger & logger)
 
 inline
 Logger
-macros_get_logger (Logger && logger)
+macros_get_logger (MacroCallSite &, Logger && logger)
 {
     return std::move (logger);
 }
 
 inline
 Logger
-macros_get_logger (tstring_view const & logger)
+macros_get_logger (MacroCallSite &, tstring_view const & logger)
 {
     return Logger::getInstance (logger);
 }
 
 
+//! Logger names given by pointer are looked up on every invocation.
+template <typename CharPtr>
+    requires (std::is_same_v<CharPtr, tchar const *>
+        || std::is_same_v<CharPtr, tchar *>)
+inline
+Logger
+macros_get_logger (MacroCallSite &, CharPtr const & logger)
+{
+    return Logger::getInstance (logger);
+}
+
+
+//! Logger names given by constant character array, usually a string
+//! literal, are looked up once and cached in the call site record.
+template <std::size_t N>
+inline
+MacroCallSite::NamedLoggerRef
+macros_get_logger (MacroCallSite & site, tchar const (& logger)[N])
+{
+    return site.getLogger (logger);
+}
+
+
+//! Modifiable character arrays can change their contents, so they are
+//! looked up on every invocation.
+template <std::size_t N>
 inline
 Logger
-macros_get_logger (tchar const * logger)
+macros_get_logger (MacroCallSite &, tchar (& logger)[N])
 {
     return Logger::getInstance (logger);
 }
@@ -127,10 +266,10 @@ LOG4CPLUS_EXPORT void clear_tostringstream (tostringstream &);
 
 LOG4CPLUS_EXPORT log4cplus::tostringstream & get_macro_body_oss ();
 LOG4CPLUS_EXPORT log4cplus::helpers::snprintf_buf & get_macro_body_snprintf_buf ();
-LOG4CPLUS_EXPORT void macro_forced_log (log4cplus::Logger const &,
+LOG4CPLUS_EXPORT void macro_forced_log (log4cplus::LoggerRef const &,
     log4cplus::LogLevel, log4cplus::tstring_view const &, char const *, int,
     char const *);
-LOG4CPLUS_EXPORT void macro_forced_log (log4cplus::Logger const &,
+LOG4CPLUS_EXPORT void macro_forced_log (log4cplus::LoggerRef const &,
     log4cplus::LogLevel, log4cplus::tchar const *, char const *, int,
     char const *);
 
@@ -226,10 +365,14 @@ LOG4CPLUS_EXPORT void macro_forced_log (log4cplus::Logger const &,
 #define LOG4CPLUS_MACRO_BODY(logger, logEvent, logLevel)                \
     LOG4CPLUS_SUPPRESS_DOWHILE_WARNING()                                \
     do {                                                                \
-        log4cplus::Logger const & _l                                    \
-            = log4cplus::detail::macros_get_logger (logger);            \
+        static log4cplus::detail::MacroCallSite _log4cplus_site;        \
+        auto const & _log4cplus_logger                                  \
+            = log4cplus::detail::macros_get_logger (_log4cplus_site,    \
+                logger);                                                \
+        log4cplus::LoggerRef const _l (_log4cplus_logger);              \
         if LOG4CPLUS_MACRO_LOGLEVEL_PRED (                              \
-                _l.isEnabledFor (log4cplus::logLevel), logLevel) {      \
+                _log4cplus_site.isEnabledFor (_l, log4cplus::logLevel), \
+                logLevel) {                                             \
             LOG4CPLUS_MACRO_INSTANTIATE_OSTRINGSTREAM (_log4cplus_buf); \
             _log4cplus_buf << logEvent;                                 \
             LOG4CPLUS_MACRO_LOG_LOCATION (_logLocation);                \
@@ -246,10 +389,14 @@ LOG4CPLUS_EXPORT void macro_forced_log (log4cplus::Logger const &,
 #define LOG4CPLUS_MACRO_STR_BODY(logger, logEvent, logLevel)            \
     LOG4CPLUS_SUPPRESS_DOWHILE_WARNING()                                \
     do {                                                                \
-        log4cplus::Logger const & _l                                    \
-            = log4cplus::detail::macros_get_logger (logger);            \
+        static log4cplus::detail::MacroCallSite _log4cplus_site;        \
+        auto const & _log4cplus_logger                                  \
+            = log4cplus::detail::macros_get_logger (_log4cplus_site,    \
+                logger);                                                \
+        log4cplus::LoggerRef const _l (_log4cplus_logger);              \
         if LOG4CPLUS_MACRO_LOGLEVEL_PRED (                              \
-                _l.isEnabledFor (log4cplus::logLevel), logLevel) {      \
+                _log4cplus_site.isEnabledFor (_l, log4cplus::logLevel), \
+                logLevel) {                                             \
             LOG4CPLUS_MACRO_LOG_LOCATION (_logLocation);                \
             log4cplus::detail::macro_forced_log (_l,                    \
                 log4cplus::logLevel, logEvent,                          \
@@ -263,10 +410,14 @@ LOG4CPLUS_EXPORT void macro_forced_log (log4cplus::Logger const &,
 #define LOG4CPLUS_MACRO_FMT_BODY(logger, logLevel, ...)                 \
     LOG4CPLUS_SUPPRESS_DOWHILE_WARNING()                                \
     do {                                                                \
-        log4cplus::Logger const & _l                                    \
-            = log4cplus::detail::macros_get_logger (logger);            \
+        static log4cplus::detail::MacroCallSite _log4cplus_site;        \
+        auto const & _log4cplus_logger                                  \
+            = log4cplus::detail::macros_get_logger (_log4cplus_site,    \
+                logger);                                                \
+        log4cplus::LoggerRef const _l (_log4cplus_logger);              \
         if LOG4CPLUS_MACRO_LOGLEVEL_PRED (                              \
-                _l.isEnabledFor (log4cplus::logLevel), logLevel) {      \
+                _log4cplus_site.isEnabledFor (_l, log4cplus::logLevel), \
+                logLevel) {                                             \
             LOG4CPLUS_MACRO_INSTANTIATE_SNPRINTF_BUF (_snpbuf);         \
             log4cplus::tchar const * _logEvent                          \
                 = _snpbuf.print (__VA_ARGS__);                          \
@@ -289,10 +440,14 @@ LOG4CPLUS_EXPORT void macro_forced_log (log4cplus::Logger const &,
 #define LOG4CPLUS_MACRO_FORMAT_BODY(logger, logLevel, logFormat, ...)   \
     LOG4CPLUS_SUPPRESS_DOWHILE_WARNING()                                \
     do {                                                                \
-        log4cplus::Logger const & _l                                    \
-            = log4cplus::detail::macros_get_logger (logger);            \
+        static log4cplus::detail::MacroCallSite _log4cplus_site;        \
+        auto const & _log4cplus_logger                                  \
+            = log4cplus::detail::macros_get_logger (_log4cplus_site,    \
+                logger);                                                \
+        log4cplus::LoggerRef const _l (_log4cplus_logger);              \
         if LOG4CPLUS_MACRO_LOGLEVEL_PRED (                              \
-                _l.isEnabledFor (log4cplus::logLevel), logLevel) {      \
+                _log4cplus_site.isEnabledFor (_l, log4cplus::logLevel), \
+                logLevel) {                                             \
             LOG4CPLUS_MACRO_INSTANTIATE_OSTRINGSTREAM (_oss);           \
             std::format_to (                                            \
                 std::ostreambuf_iterator<log4cplus::tchar> (_oss),      \
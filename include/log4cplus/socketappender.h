@@ -129,6 +129,21 @@ namespace log4cplus
         void initConnector ();
         virtual void append(const spi::InternalLoggingEvent& event) override;
 
+        /**
+         * Serializes the events into one buffer and sends them with a
+         * single write, as long as they fit into it.
+         */
+        virtual void appendBatch(
+            std::span<spi::InternalLoggingEvent const * const> events)
+            override;
+
+        //! Checks that the socket is connected, (re)connecting it if
+        //! possible. \return True when the socket can be written to.
+        bool ensureConnected();
+
+        //! Handles failed write to the socket.
+        void writeFailed();
+
       // Data
         log4cplus::helpers::Socket socket;
         log4cplus::tstring host;
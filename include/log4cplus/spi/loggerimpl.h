@@ -34,12 +34,15 @@
 #include <log4cplus/helpers/appenderattachableimpl.h>
 #include <log4cplus/helpers/pointer.h>
 #include <log4cplus/spi/loggerfactory.h>
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <vector>
 
 
 namespace log4cplus {
     class DefaultLoggerFactory;
+    class LoggerRef;
 
     namespace spi {
 
@@ -108,12 +111,13 @@ namespace log4cplus {
              *
              * @return LogLevel - the assigned LogLevel.
              */
-            LogLevel getLogLevel() const { return this->ll; }
+            LogLevel getLogLevel() const
+            { return this->ll.load (std::memory_order_relaxed); }
 
             /**
              * Set the LogLevel of this Logger.
              */
-            void setLogLevel(LogLevel _ll) { this->ll = _ll; }
+            void setLogLevel(LogLevel _ll);
 
             /**
              * Return the {@link Hierarchy} where this <code>Logger</code>
@@ -179,14 +183,24 @@ namespace log4cplus {
             /**
              * The assigned LogLevel of this logger.
              */
-            LogLevel ll;
+            std::atomic<LogLevel> ll;
 
             /**
              * The parent of this logger. All loggers have at least one
-             * ancestor which is the root logger.
+             * ancestor which is the root logger. This owning reference is
+             * changed only by setParent() with the Hierarchy locked.
              */
             SharedLoggerImplPtr parent;
 
+            /**
+             * Raw pointer to the parent, published for walks of the
+             * parent chain that do not lock the Hierarchy. It is read
+             * inside of RCU read-side critical sections; an owning
+             * reference replaced by setParent() is released only after
+             * all of them have ended.
+             */
+            std::atomic<LoggerImpl *> parentLink;
+
             /**
              * Additivity is set to true by default, that is children inherit
              * the appenders of their ancestors by default. If this variable is
@@ -199,12 +213,40 @@ namespace log4cplus {
             bool additive;
 
         private:
+          // Methods
+            /**
+             * Returns the lowest LogLevel this logger is enabled for,
+             * taking into account both chained LogLevel and hierarchy
+             * disable value. The value is cached in
+             * <code>thresholdCache</code> and recomputed only when
+             * {@link loggerConfigurationEpoch} changes.
+             */
+            LogLevel getEffectiveThreshold() const;
+
+            LOG4CPLUS_PRIVATE LogLevel updateThresholdCache(
+                std::uint64_t epoch) const;
+
+            /**
+             * Replaces the parent of this logger. The Hierarchy must be
+             * locked.
+             */
+            LOG4CPLUS_PRIVATE void setParent(LoggerImpl * newParent);
+
           // Data
             /** Loggers need to know what Hierarchy they are in. */
             Hierarchy& hierarchy;
 
+            /**
+             * Cached effective threshold in the lower 24 bits and the
+             * lower 40 bits of {@link loggerConfigurationEpoch} it has
+             * been computed for in the upper 40 bits. Both are read by
+             * a single load and checked by a single comparison.
+             */
+            mutable std::atomic<std::uint64_t> thresholdCache;
+
           // Friends
             friend class log4cplus::Logger;
+            friend class log4cplus::LoggerRef;
             friend class log4cplus::DefaultLoggerFactory;
             friend class log4cplus::Hierarchy;
         };
@@ -0,0 +1,657 @@
+// -*- C++ -*-
+//
+//  Copyright (C) 2026, Vaclav Haisman. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/** @file */
+
+#ifndef LOG4CPLUS_STATICPATTERNLAYOUT_HEADER_
+#define LOG4CPLUS_STATICPATTERNLAYOUT_HEADER_
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_HAVE_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#include <log4cplus/layout.h>
+#include <log4cplus/tstring.h>
+#include <log4cplus/helpers/property.h>
+#include <log4cplus/helpers/socket.h>
+#include <log4cplus/helpers/stringhelper.h>
+#include <log4cplus/helpers/timehelper.h>
+#include <log4cplus/spi/loggingevent.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <utility>
+
+
+namespace log4cplus {
+
+namespace pattern {
+
+/**
+ * @name Field formatting shared by PatternLayout and StaticPatternLayout
+ *
+ * These functions append fields of logging events that need more than
+ * a single string append. Both layouts use them so that their output
+ * is identical.
+ */
+//! @{
+
+//! Appends file name part of <code>filename</code>.
+LOG4CPLUS_EXPORT void appendBasename (tstring & buffer,
+    tstring const & filename);
+
+//! Appends id of the current process.
+LOG4CPLUS_EXPORT void appendProcessId (tstring & buffer);
+
+//! Appends <code>file:line</code> location of the event.
+LOG4CPLUS_EXPORT void appendFullLocation (tstring & buffer,
+    spi::InternalLoggingEvent const & event);
+
+//! Appends last <code>precision</code> components of logger
+//! <code>name</code>, all of them when <code>precision</code> is not
+//! positive.
+LOG4CPLUS_EXPORT void appendLoggerName (tstring & buffer,
+    tstring const & name, int precision);
+
+//! Appends value of environment variable <code>name</code>, nothing
+//! if the variable does not exist.
+LOG4CPLUS_EXPORT void appendEnvVar (tstring & buffer, tstring const & name);
+
+//! Appends milliseconds since getTTCCLayoutTimeBase().
+LOG4CPLUS_EXPORT void appendRelativeTimestamp (tstring & buffer,
+    spi::InternalLoggingEvent const & event);
+
+//! Appends MDC value of <code>key</code>, or whole MDC when
+//! <code>key</code> is empty.
+LOG4CPLUS_EXPORT void appendMDC (tstring & buffer,
+    spi::InternalLoggingEvent const & event, tstring const & key);
+
+//! Appends first <code>precision</code> levels of <code>ndc</code>,
+//! all of them when <code>precision</code> is not positive.
+LOG4CPLUS_EXPORT void appendNDC (tstring & buffer, tstring const & ndc,
+    int precision);
+
+//! @}
+
+
+/**
+ * Pads or truncates field that has been appended to <code>buffer</code>
+ * at position <code>start</code>.
+ */
+inline
+void
+padField (tstring & buffer, std::size_t start, int minLen,
+    std::size_t maxLen, bool leftAlign, bool trimStart)
+{
+    std::size_t const len = buffer.size () - start;
+
+    if (len > maxLen)
+    {
+        if (trimStart)
+            buffer.erase (start, len - maxLen);
+        else
+            buffer.resize (start + maxLen);
+    }
+    else if (static_cast<int>(len) < minLen)
+    {
+        std::size_t const padding = minLen - len;
+        if (leftAlign)
+            buffer.append (padding, LOG4CPLUS_TEXT(' '));
+        else
+            buffer.insert (start, padding, LOG4CPLUS_TEXT(' '));
+    }
+}
+
+
+/**
+ * Conversion pattern string usable as template argument of
+ * StaticPatternLayout.
+ */
+template <std::size_t N>
+struct StaticPattern
+{
+    constexpr
+    StaticPattern (tchar const (& str)[N])
+    {
+        std::copy_n (str, N, text);
+    }
+
+    //! \return Length of the pattern without the terminating NUL.
+    constexpr
+    std::size_t
+    size () const
+    {
+        return N - 1;
+    }
+
+    tchar text[N] {};
+};
+
+
+//! Element of a parsed StaticPattern: literal text or a conversion.
+struct StaticPatternItem
+{
+    //! Conversion character or NUL for literal text.
+    tchar conversion = 0;
+    int minLen = -1;
+    std::size_t maxLen = (std::numeric_limits<std::size_t>::max) ();
+    bool leftAlign = false;
+    bool trimStart = true;
+    //! Range of literal text in StaticPatternParse::text, or range of
+    //! the <code>{option}</code> in the pattern.
+    std::size_t begin = 0;
+    std::size_t length = 0;
+    //! Precision option of <b>%%c</b>.
+    int precision = 0;
+    //! Index into per layout date caches or strings.
+    std::size_t slot = 0;
+
+    constexpr
+    bool
+    formatted () const
+    {
+        return minLen >= 0
+            || maxLen != (std::numeric_limits<std::size_t>::max) ();
+    }
+};
+
+
+//! Result of parseStaticPattern().
+template <std::size_t N>
+struct StaticPatternParse
+{
+    StaticPatternItem items[N + 1] {};
+    std::size_t count = 0;
+    //! Literal text with <code>%%%%</code> escapes resolved.
+    tchar text[N] {};
+    std::size_t textLength = 0;
+    //! Number of <b>%%d</b> and <b>%%D</b> conversions.
+    std::size_t dates = 0;
+    //! Number of conversions with string state: <b>%%E</b>,
+    //! <b>%%h</b>, <b>%%H</b> and <b>%%X</b>.
+    std::size_t strings = 0;
+};
+
+
+//! Compile time equivalent of <code>std::atoi()</code>.
+constexpr
+int
+staticPatternAtoi (tchar const * str, std::size_t length)
+{
+    std::size_t i = 0;
+    while (i != length && (str[i] == LOG4CPLUS_TEXT(' ')
+            || (str[i] >= LOG4CPLUS_TEXT('\t') && str[i] <= LOG4CPLUS_TEXT('\r'))))
+        ++i;
+
+    bool negative = false;
+    if (i != length && (str[i] == LOG4CPLUS_TEXT('-')
+            || str[i] == LOG4CPLUS_TEXT('+')))
+        negative = str[i++] == LOG4CPLUS_TEXT('-');
+
+    int value = 0;
+    for (; i != length && str[i] >= LOG4CPLUS_TEXT('0')
+             && str[i] <= LOG4CPLUS_TEXT('9'); ++i)
+        value = value * 10 + (str[i] - LOG4CPLUS_TEXT('0'));
+
+    return negative ? -value : value;
+}
+
+
+/**
+ * Parses conversion pattern at compile time. It follows the same
+ * rules as the run time parser of PatternLayout, including its
+ * treatment of malformed conversion specifiers as literal text.
+ */
+template <std::size_t N>
+constexpr
+StaticPatternParse<N>
+parseStaticPattern (StaticPattern<N> const & pattern)
+{
+    StaticPatternParse<N> result;
+    std::size_t const length = pattern.size ();
+    std::size_t literalBegin = 0;
+    std::size_t pos = 0;
+
+    auto addText = [&result] (tchar c) {
+        result.text[result.textLength++] = c;
+    };
+
+    auto flushLiteral = [&result, &literalBegin] {
+        if (result.textLength != literalBegin)
+        {
+            StaticPatternItem & item = result.items[result.count++];
+            item.begin = literalBegin;
+            item.length = result.textLength - literalBegin;
+            literalBegin = result.textLength;
+        }
+    };
+
+    auto extractOption = [&pattern, &pos, length] (StaticPatternItem & item) {
+        if (pos < length && pattern.text[pos] == LOG4CPLUS_TEXT('{'))
+        {
+            std::size_t end = pos;
+            while (end != length && pattern.text[end] != LOG4CPLUS_TEXT('}'))
+                ++end;
+
+            if (end != length)
+            {
+                item.begin = pos + 1;
+                item.length = end - pos - 1;
+                pos = end + 1;
+            }
+            else
+                pos = length;
+        }
+    };
+
+    auto isDigit = [] (tchar c) {
+        return c >= LOG4CPLUS_TEXT('0') && c <= LOG4CPLUS_TEXT('9');
+    };
+
+    while (pos < length)
+    {
+        tchar const c = pattern.text[pos++];
+        if (c != LOG4CPLUS_TEXT('%') || pos == length)
+        {
+            addText (c);
+            continue;
+        }
+
+        if (pattern.text[pos] == LOG4CPLUS_TEXT('%'))
+        {
+            addText (c);
+            ++pos;
+            continue;
+        }
+
+        // Conversion specifier.
+        std::size_t const specBegin = pos - 1;
+        enum { CONVERTER, MIN, DOT, MAX } state = CONVERTER;
+        StaticPatternItem item;
+        bool finished = false;
+        bool malformed = false;
+        while (! finished && ! malformed && pos < length)
+        {
+            tchar const ch = pattern.text[pos++];
+            switch (state)
+            {
+            case CONVERTER:
+                if (ch == LOG4CPLUS_TEXT('-'))
+                    item.leftAlign = true;
+                else if (ch == LOG4CPLUS_TEXT('.'))
+                    state = DOT;
+                else if (isDigit (ch))
+                {
+                    item.minLen = ch - LOG4CPLUS_TEXT('0');
+                    state = MIN;
+                }
+                else
+                {
+                    item.conversion = ch;
+                    finished = true;
+                }
+                break;
+
+            case MIN:
+                if (isDigit (ch))
+                    item.minLen = item.minLen * 10 + (ch - LOG4CPLUS_TEXT('0'));
+                else if (ch == LOG4CPLUS_TEXT('.'))
+                    state = DOT;
+                else
+                {
+                    item.conversion = ch;
+                    finished = true;
+                }
+                break;
+
+            case DOT:
+                if (ch == LOG4CPLUS_TEXT('-'))
+                    item.trimStart = false;
+                else if (isDigit (ch))
+                {
+                    item.maxLen = static_cast<std::size_t>(
+                        ch - LOG4CPLUS_TEXT('0'));
+                    state = MAX;
+                }
+                else
+                    malformed = true;
+                break;
+
+            case MAX:
+                if (isDigit (ch))
+                    item.maxLen = item.maxLen * 10
+                        + static_cast<std::size_t>(ch - LOG4CPLUS_TEXT('0'));
+                else
+                {
+                    item.conversion = ch;
+                    finished = true;
+                }
+                break;
+            }
+        }
+
+        if (finished)
+        {
+            switch (item.conversion)
+            {
+            case LOG4CPLUS_TEXT('b'): case LOG4CPLUS_TEXT('F'):
+            case LOG4CPLUS_TEXT('i'): case LOG4CPLUS_TEXT('l'):
+            case LOG4CPLUS_TEXT('L'): case LOG4CPLUS_TEXT('m'):
+            case LOG4CPLUS_TEXT('M'): case LOG4CPLUS_TEXT('n'):
+            case LOG4CPLUS_TEXT('p'): case LOG4CPLUS_TEXT('r'):
+            case LOG4CPLUS_TEXT('t'): case LOG4CPLUS_TEXT('T'):
+            case LOG4CPLUS_TEXT('x'):
+                break;
+
+            case LOG4CPLUS_TEXT('c'):
+                extractOption (item);
+                item.precision = staticPatternAtoi (
+                    pattern.text + item.begin, item.length);
+                break;
+
+            case LOG4CPLUS_TEXT('d'): case LOG4CPLUS_TEXT('D'):
+                extractOption (item);
+                item.slot = result.dates++;
+                break;
+
+            case LOG4CPLUS_TEXT('E'): case LOG4CPLUS_TEXT('X'):
+                extractOption (item);
+                item.slot = result.strings++;
+                break;
+
+            case LOG4CPLUS_TEXT('h'): case LOG4CPLUS_TEXT('H'):
+                item.slot = result.strings++;
+                break;
+
+            default:
+                // Unknown conversion character.
+                malformed = true;
+            }
+        }
+
+        if (finished && ! malformed)
+        {
+            flushLiteral ();
+            result.items[result.count++] = item;
+        }
+        else
+        {
+            // Malformed or unterminated conversion specifiers are output
+            // as they are.
+            for (std::size_t i = specBegin; i != pos; ++i)
+                addText (pattern.text[i]);
+        }
+    }
+
+    flushLiteral ();
+
+    if (result.count == 0)
+        result.items[result.count++].conversion = LOG4CPLUS_TEXT('m');
+
+    return result;
+}
+
+} // namespace pattern
+
+
+/**
+ * PatternLayout with conversion pattern fixed at compile time.
+ *
+ * The pattern is parsed at compile time by
+ * pattern::parseStaticPattern() and the formatting code of each
+ * conversion is instantiated inline, without per converter virtual
+ * calls. Host names and, unless SnapshotEnvironment is false,
+ * environment variables are formatted once at construction. The
+ * output is identical to that of PatternLayout with the same pattern
+ * and properties. Use it like any other Layout, e.g.:
+ *
+ * <pre>
+ * appender->setLayout (std::make_unique&lt;StaticPatternLayout&lt;
+ *     LOG4CPLUS_TEXT ("%d{%H:%M:%S.%q} %-5p [%t] %c - %m%n")&gt;&gt; ());
+ * </pre>
+ *
+ * Unlike PatternLayout it cannot be created by name from
+ * configuration files.
+ *
+ * <h3>Properties</h3>
+ *
+ * <dl>
+ * <dt><tt>NDCMaxDepth</tt></dt>
+ * <dd>This property limits how many deepest NDC components will
+ * be printed by <b>%%x</b> specifier.</dd>
+ *
+ * <dt><tt>SnapshotEnvironment</tt></dt>
+ * <dd>Same as PatternLayout property of the same name.</dd>
+ * </dl>
+ */
+template <pattern::StaticPattern Pattern>
+class StaticPatternLayout
+    : public Layout
+{
+public:
+    explicit StaticPatternLayout (bool snapshotEnv_ = true)
+        : snapshotEnv (snapshotEnv_)
+    {
+        init ();
+    }
+
+    explicit StaticPatternLayout (helpers::Properties const & properties)
+        : Layout (properties)
+    {
+        properties.getUInt (ndcMaxDepth, LOG4CPLUS_TEXT ("NDCMaxDepth"));
+        properties.getBool (snapshotEnv,
+            LOG4CPLUS_TEXT ("SnapshotEnvironment"));
+        init ();
+    }
+
+    StaticPatternLayout (StaticPatternLayout const &) = delete;
+    StaticPatternLayout & operator = (StaticPatternLayout const &) = delete;
+
+    virtual void formatAndAppend (tostream & output,
+        spi::InternalLoggingEvent const & event) override
+    {
+        if (tstring * const target = appendingStreamTarget (output))
+            formatItems (*target, event,
+                std::make_index_sequence<parsed.count> ());
+        else
+            formatAndAppendToStream (output, event);
+    }
+
+    virtual void formatAndAppend (tstring & buffer,
+        spi::InternalLoggingEvent const & event) override
+    {
+        if (! isDerivedLayout (typeid (StaticPatternLayout))
+            || ! formatAndAppendThroughStream (buffer, event))
+            formatItems (buffer, event,
+                std::make_index_sequence<parsed.count> ());
+    }
+
+private:
+    static constexpr pattern::StaticPatternParse<sizeof (Pattern.text)
+        / sizeof (tchar)> parsed = pattern::parseStaticPattern (Pattern);
+
+    void
+    init ()
+    {
+        for (std::size_t i = 0; i != parsed.count; ++i)
+        {
+            pattern::StaticPatternItem const & item = parsed.items[i];
+            tstring const option (Pattern.text + item.begin, item.length);
+            switch (item.conversion)
+            {
+            case LOG4CPLUS_TEXT('d'):
+            case LOG4CPLUS_TEXT('D'):
+                dates[item.slot].setFormat (option.empty ()
+                    ? tstring (LOG4CPLUS_TEXT ("%Y-%m-%d %H:%M:%S")) : option,
+                    item.conversion == LOG4CPLUS_TEXT('d'));
+                break;
+
+            case LOG4CPLUS_TEXT('E'):
+                if (snapshotEnv)
+                    setConstant (item, [&option] (tstring & value) {
+                        pattern::appendEnvVar (value, option); });
+                else
+                    strings[item.slot] = option;
+                break;
+
+            case LOG4CPLUS_TEXT('X'):
+                strings[item.slot] = option;
+                break;
+
+            case LOG4CPLUS_TEXT('h'):
+            case LOG4CPLUS_TEXT('H'):
+                setConstant (item, [&item] (tstring & value) {
+                    value = helpers::getHostname (
+                        item.conversion == LOG4CPLUS_TEXT('H')).value_or (
+                            LOG4CPLUS_C_STR_TO_TSTRING ("-")); });
+                break;
+            }
+        }
+    }
+
+    //! Stores already padded value of conversion that is constant
+    //! for the process lifetime.
+    template <typename Func>
+    void
+    setConstant (pattern::StaticPatternItem const & item, Func && func)
+    {
+        tstring & value = strings[item.slot];
+        value.clear ();
+        func (value);
+        pattern::padField (value, 0, item.minLen, item.maxLen,
+            item.leftAlign, item.trimStart);
+    }
+
+    template <std::size_t... I>
+    void
+    formatItems (tstring & buffer, spi::InternalLoggingEvent const & event,
+        std::index_sequence<I...>)
+    {
+        (formatItem<I> (buffer, event), ...);
+    }
+
+    template <std::size_t I>
+    void
+    formatItem (tstring & buffer, spi::InternalLoggingEvent const & event)
+    {
+        constexpr pattern::StaticPatternItem item = parsed.items[I];
+        if constexpr (item.conversion == 0)
+            buffer.append (parsed.text + item.begin, item.length);
+        else if constexpr (item.conversion == LOG4CPLUS_TEXT('h')
+            || item.conversion == LOG4CPLUS_TEXT('H'))
+            buffer += strings[item.slot];
+        else if constexpr (item.conversion == LOG4CPLUS_TEXT('E'))
+        {
+            if (snapshotEnv)
+                buffer += strings[item.slot];
+            else
+                formatField<item> (buffer, event);
+        }
+        else
+            formatField<item> (buffer, event);
+    }
+
+    template <pattern::StaticPatternItem item>
+    void
+    formatField (tstring & buffer, spi::InternalLoggingEvent const & event)
+    {
+        if constexpr (item.formatted ())
+        {
+            std::size_t const start = buffer.size ();
+            appendField<item> (buffer, event);
+            pattern::padField (buffer, start, item.minLen, item.maxLen,
+                item.leftAlign, item.trimStart);
+        }
+        else
+            appendField<item> (buffer, event);
+    }
+
+    template <pattern::StaticPatternItem item>
+    void
+    appendField (tstring & buffer, spi::InternalLoggingEvent const & event)
+    {
+        constexpr tchar c = item.conversion;
+        if constexpr (c == LOG4CPLUS_TEXT('b'))
+            pattern::appendBasename (buffer, event.getFile ());
+        else if constexpr (c == LOG4CPLUS_TEXT('c'))
+        {
+            if constexpr (item.precision <= 0)
+                buffer += event.getLoggerName ();
+            else
+                pattern::appendLoggerName (buffer, event.getLoggerName (),
+                    item.precision);
+        }
+        else if constexpr (c == LOG4CPLUS_TEXT('d')
+            || c == LOG4CPLUS_TEXT('D'))
+            dates[item.slot].append (buffer, event.getTimestamp ());
+        else if constexpr (c == LOG4CPLUS_TEXT('E'))
+            pattern::appendEnvVar (buffer, strings[item.slot]);
+        else if constexpr (c == LOG4CPLUS_TEXT('F'))
+            buffer += event.getFile ();
+        else if constexpr (c == LOG4CPLUS_TEXT('i'))
+            pattern::appendProcessId (buffer);
+        else if constexpr (c == LOG4CPLUS_TEXT('l'))
+            pattern::appendFullLocation (buffer, event);
+        else if constexpr (c == LOG4CPLUS_TEXT('L'))
+        {
+            if (event.getLine () != -1)
+                helpers::appendIntegerToString (buffer, event.getLine ());
+        }
+        else if constexpr (c == LOG4CPLUS_TEXT('m'))
+            buffer += event.getMessage ();
+        else if constexpr (c == LOG4CPLUS_TEXT('M'))
+            buffer += event.getFunction ();
+        else if constexpr (c == LOG4CPLUS_TEXT('n'))
+            buffer += LOG4CPLUS_TEXT('\n');
+        else if constexpr (c == LOG4CPLUS_TEXT('p'))
+            buffer += llmCache.toString (event.getLogLevel ());
+        else if constexpr (c == LOG4CPLUS_TEXT('r'))
+            pattern::appendRelativeTimestamp (buffer, event);
+        else if constexpr (c == LOG4CPLUS_TEXT('t'))
+            buffer += event.getThread ();
+        else if constexpr (c == LOG4CPLUS_TEXT('T'))
+            buffer += event.getThread2 ();
+        else if constexpr (c == LOG4CPLUS_TEXT('x'))
+            pattern::appendNDC (buffer, event.getNDC (),
+                static_cast<int>(ndcMaxDepth));
+        else if constexpr (c == LOG4CPLUS_TEXT('X'))
+            pattern::appendMDC (buffer, event, strings[item.slot]);
+    }
+
+    std::array<helpers::FormattedTimeCache, parsed.dates> dates;
+    std::array<tstring, parsed.strings> strings;
+    unsigned ndcMaxDepth = 0;
+    bool snapshotEnv = true;
+};
+
+
+} // namespace log4cplus
+
+
+#endif // LOG4CPLUS_STATICPATTERNLAYOUT_HEADER_
@@ -33,6 +33,7 @@
 #include <log4cplus/appender.h>
 #include <log4cplus/helpers/socket.h>
 #include <log4cplus/helpers/connectorthread.h>
+#include <log4cplus/helpers/timehelper.h>
 
 
 namespace log4cplus
@@ -123,6 +124,26 @@ namespace log4cplus
         //! Remote syslog worker function.
         void appendRemote(const spi::InternalLoggingEvent& event);
 
+        /**
+         * Remote syslog over TCP sends all events of the batch using a
+         * single socket write. Other modes append the events one by one.
+         */
+        virtual void appendBatch(
+            std::span<spi::InternalLoggingEvent const * const> events)
+            override;
+
+        //! Checks connection to remote syslog, possibly (re)connecting.
+        //! \return True when the socket can be written to.
+        bool ensureRemoteConnected();
+
+        //! Formats remote syslog message, including its frame header for
+        //! stream transports, and appends it to `msg`.
+        void formatRemote(std::string & msg,
+            const spi::InternalLoggingEvent& event);
+
+        //! Writes formatted remote syslog message(s) to the socket.
+        void writeRemote(std::string const & msg);
+
       // Data
         tstring ident;
         int facility;
@@ -139,6 +160,8 @@ namespace log4cplus
         bool ipv6 = false;
 
         static tstring const remoteTimeFormat;
+        //! Caches remoteTimeFormat output of the last second.
+        helpers::FormattedTimeCache remoteTimeCache {remoteTimeFormat, true};
 
         void initConnector ();
         void openSocket ();
@@ -28,10 +28,17 @@
 #include <log4cplus/spi/loggingevent.h>
 #include <log4cplus/internal/internal.h>
 #include <log4cplus/thread/syncprims-pub-impl.h>
+#include <algorithm>
 #include <memory>
 #include <stdexcept>
 #include <utility>
 
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <catch_amalgamated.hpp>
+#include <chrono>
+#include <thread>
+#endif
+
 
 namespace log4cplus
 {
@@ -92,6 +99,7 @@ Appender::Appender()
    async(false),
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
    in_flight(0),
+   async_batch_scheduled(false),
 #endif
    closed(false)
 {
@@ -107,6 +115,7 @@ Appender::Appender(const log4cplus::helpers::Properties & properties)
     , async(false)
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
     , in_flight(0)
+    , async_batch_scheduled(false)
 #endif
     , closed(false)
 {
@@ -274,16 +283,21 @@ bool Appender::isClosed() const
 
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
 void
-Appender::subtract_in_flight ()
+Appender::subtract_in_flight (std::size_t count)
 {
 #if defined (LOG4CPLUS_ENABLE_THREAD_POOL)
+    if (count == 0)
+        return;
+
     std::size_t const prev = std::atomic_fetch_sub_explicit (&in_flight,
-        std::size_t (1), std::memory_order_acq_rel);
-    if (prev == 1)
+        count, std::memory_order_acq_rel);
+    if (prev == count)
     {
         std::unique_lock<std::mutex> lock (in_flight_mutex);
         in_flight_condition.notify_all ();
     }
+#else
+    (void) count;
 #endif
 }
 
@@ -291,8 +305,9 @@ Appender::subtract_in_flight ()
 
 
 // from global-init.cxx
-void enqueueAsyncDoAppend (SharedAppenderPtr const & appender,
-    spi::InternalLoggingEvent const & event);
+void enqueueAsyncDoAppend (SharedAppenderPtr const & appender);
+void getAsyncAppendLimits (std::size_t & limit, bool & block);
+void reportDroppedAsyncEvents (std::size_t count);
 
 
 void
@@ -304,18 +319,58 @@ Appender::doAppend(const log4cplus::spi::InternalLoggingEvent& event)
     {
         event.gatherThreadSpecificData ();
 
+        std::size_t limit;
+        bool block;
+        getAsyncAppendLimits (limit, block);
+
         std::atomic_fetch_add_explicit (&in_flight, std::size_t (1),
             std::memory_order_relaxed);
 
+        // Events are collected into a batch. Only the first event of a
+        // batch enqueues asyncDoAppendBatch() into the thread pool, the
+        // following ones just join the batch until it is taken. The
+        // batch is limited like the thread pool queue: a full batch
+        // either blocks the caller or drops the event.
+        bool schedule;
         try
         {
-            enqueueAsyncDoAppend (SharedAppenderPtr (this), event);
+            std::unique_lock<std::mutex> lock (async_batch_mutex);
+            if (async_batch.size () >= limit)
+            {
+                if (! block)
+                {
+                    lock.unlock ();
+                    subtract_in_flight ();
+                    reportDroppedAsyncEvents (1);
+                    return;
+                }
+
+                async_batch_condition.wait (lock,
+                    [&] { return async_batch.size () < limit; });
+            }
+
+            async_batch.push_back (event);
+            schedule = ! async_batch_scheduled;
+            async_batch_scheduled = true;
         }
         catch (...)
         {
             subtract_in_flight ();
             throw;
         }
+
+        if (schedule)
+        {
+            try
+            {
+                enqueueAsyncDoAppend (SharedAppenderPtr (this));
+            }
+            catch (...)
+            {
+                discardAsyncBatch ();
+                throw;
+            }
+        }
     }
     else
 #endif
@@ -323,6 +378,23 @@ Appender::doAppend(const log4cplus::spi::InternalLoggingEvent& event)
 }
 
 
+void
+Appender::doAppendBatch(
+    std::span<log4cplus::spi::InternalLoggingEvent const> events)
+{
+#if ! defined (LOG4CPLUS_SINGLE_THREADED) \
+    && defined (LOG4CPLUS_ENABLE_THREAD_POOL)
+    if (async)
+    {
+        for (auto const & event : events)
+            doAppend (event);
+    }
+    else
+#endif
+        syncDoAppendBatch (events);
+}
+
+
 void
 Appender::asyncDoAppend(const log4cplus::spi::InternalLoggingEvent& event)
 {
@@ -351,46 +423,191 @@ Appender::asyncDoAppend(const log4cplus::spi::InternalLoggingEvent& event)
 
 
 void
-Appender::syncDoAppend(const log4cplus::spi::InternalLoggingEvent& event)
+Appender::asyncDoAppendBatch()
 {
-    thread::MutexGuard guard (access_mutex);
+#if ! defined (LOG4CPLUS_SINGLE_THREADED) \
+    && defined (LOG4CPLUS_ENABLE_THREAD_POOL)
+    // The taken batch and the spare vector are swapped back and forth
+    // to reuse their capacity.
+    std::vector<spi::InternalLoggingEvent> events;
+    {
+        std::lock_guard<std::mutex> lock (async_batch_mutex);
+        events.swap (async_batch);
+        async_batch.swap (async_batch_spare);
+        async_batch_scheduled = false;
+    }
+    async_batch_condition.notify_all ();
 
-    if(closed) {
-        helpers::getLogLog().error(
-            LOG4CPLUS_TEXT("Attempted to append to closed appender named [")
-            + name
-            + LOG4CPLUS_TEXT("]."));
-        return;
+    struct handle_in_flight
+    {
+        Appender * const app;
+        std::size_t const count;
+
+        handle_in_flight (Appender * app_, std::size_t count_)
+            : app (app_)
+            , count (count_)
+        { }
+
+        ~handle_in_flight ()
+        {
+            app->subtract_in_flight (count);
+        }
+    };
+
+    handle_in_flight guard (this, events.size ());
+    syncDoAppendBatch (events);
+
+    events.clear ();
+    std::lock_guard<std::mutex> lock (async_batch_mutex);
+    if (async_batch_spare.capacity () < events.capacity ())
+        async_batch_spare.swap (events);
+#endif
+}
+
+
+std::size_t
+Appender::discardAsyncBatch()
+{
+#if ! defined (LOG4CPLUS_SINGLE_THREADED) \
+    && defined (LOG4CPLUS_ENABLE_THREAD_POOL)
+    std::size_t count;
+    {
+        std::lock_guard<std::mutex> lock (async_batch_mutex);
+        count = async_batch.size ();
+        async_batch.clear ();
+        async_batch_scheduled = false;
     }
+    async_batch_condition.notify_all ();
+
+    subtract_in_flight (count);
+    return count;
+
+#else
+    return 0;
+
+#endif
+}
+
 
+bool
+Appender::isAccepted(const log4cplus::spi::InternalLoggingEvent& event) const
+{
     // Check appender's threshold logging level.
 
     if (! isAsSevereAsThreshold(event.getLogLevel()))
-        return;
+        return false;
 
     // Evaluate filters attached to this appender.
 
-    if (checkFilter(filter.get(), event) == spi::FilterResult::DENY)
-        return;
+    return checkFilter(filter.get(), event) != spi::FilterResult::DENY;
+}
 
-    // Lock system wide lock.
 
-    helpers::LockFileGuard lfguard;
-    if (useLockFile && lockFile.get ())
+void
+Appender::syncDoAppend(const log4cplus::spi::InternalLoggingEvent& event)
+{
     {
-        try
-        {
-            lfguard.attach_and_lock (*lockFile);
+        thread::MutexGuard guard (access_mutex);
+
+        if(closed) {
+            helpers::getLogLog().error(
+                LOG4CPLUS_TEXT("Attempted to append to closed appender named [")
+                + name
+                + LOG4CPLUS_TEXT("]."));
+            return;
         }
-        catch (std::runtime_error const &)
+
+        if (! isAccepted(event))
+            return;
+
+        // Lock system wide lock.
+
+        helpers::LockFileGuard lfguard;
+        if (useLockFile && lockFile.get ())
         {
+            try
+            {
+                lfguard.attach_and_lock (*lockFile);
+            }
+            catch (std::runtime_error const &)
+            {
+                return;
+            }
+        }
+
+        // Finally append given event.
+
+        append(event);
+    }
+
+    afterAppend (event.getLogLevel ());
+}
+
+
+void
+Appender::syncDoAppendBatch(
+    std::span<log4cplus::spi::InternalLoggingEvent const> events)
+{
+    if (events.empty ())
+        return;
+
+    LogLevel maxLevel = NOT_SET_LOG_LEVEL;
+    {
+        thread::MutexGuard guard (access_mutex);
+
+        if(closed) {
+            helpers::getLogLog().error(
+                LOG4CPLUS_TEXT("Attempted to append to closed appender named [")
+                + name
+                + LOG4CPLUS_TEXT("]."));
             return;
         }
+
+        std::vector<spi::InternalLoggingEvent const *> accepted;
+        accepted.reserve (events.size ());
+        for (auto const & event : events)
+            if (isAccepted(event))
+            {
+                accepted.push_back (&event);
+                maxLevel = (std::max) (maxLevel, event.getLogLevel ());
+            }
+
+        if (accepted.empty ())
+            return;
+
+        // Lock system wide lock once for the whole batch.
+
+        helpers::LockFileGuard lfguard;
+        if (useLockFile && lockFile.get ())
+        {
+            try
+            {
+                lfguard.attach_and_lock (*lockFile);
+            }
+            catch (std::runtime_error const &)
+            {
+                return;
+            }
+        }
+
+        appendBatch(accepted);
     }
 
-    // Finally append given event.
+    afterAppend (maxLevel);
+}
+
+
+void
+Appender::afterAppend (LogLevel)
+{ }
+
 
-    append(event);
+void
+Appender::appendBatch(
+    std::span<log4cplus::spi::InternalLoggingEvent const * const> events)
+{
+    for (spi::InternalLoggingEvent const * event : events)
+        append(*event);
 }
 
 
@@ -398,9 +615,8 @@ tstring &
 Appender::formatEvent (const spi::InternalLoggingEvent& event) const
 {
     internal::appender_sratch_pad & appender_sp = internal::get_appender_sp ();
-    detail::clear_tostringstream (appender_sp.oss);
-    layout->formatAndAppend(appender_sp.oss, event);
-    appender_sp.str = appender_sp.oss.str();
+    appender_sp.str.clear ();
+    layout->formatAndAppend(appender_sp.str, event);
     return appender_sp.str;
 }
 
@@ -508,4 +724,110 @@ Appender::addFilter (std::function<
 }
 
 
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS) && ! defined (LOG4CPLUS_SINGLE_THREADED) \
+    && defined (LOG4CPLUS_ENABLE_THREAD_POOL)
+namespace
+{
+
+//! Asynchronous appender whose append() waits until it is opened.
+class GatedAppender
+    : public Appender
+{
+public:
+    GatedAppender ()
+    {
+        async = true;
+    }
+
+    ~GatedAppender () override
+    {
+        destructorImpl ();
+    }
+
+    void
+    close () override
+    {
+        closed = true;
+    }
+
+    void
+    open ()
+    {
+        {
+            std::lock_guard<std::mutex> lock (gate_mutex);
+            opened = true;
+        }
+        gate_condition.notify_all ();
+    }
+
+    std::atomic<std::size_t> appended {0};
+
+protected:
+    void
+    append (spi::InternalLoggingEvent const &) override
+    {
+        std::unique_lock<std::mutex> lock (gate_mutex);
+        gate_condition.wait (lock, [this] { return opened; });
+        ++appended;
+    }
+
+    std::mutex gate_mutex;
+    std::condition_variable gate_condition;
+    bool opened = false;
+};
+
+} // namespace
+
+
+CATCH_TEST_CASE ("Appender asynchronous batch limit", "[appender]")
+{
+    std::size_t const limit = 100;
+    std::size_t const events = 1000;
+    spi::InternalLoggingEvent const event (LOG4CPLUS_TEXT ("async"),
+        INFO_LOG_LEVEL, LOG4CPLUS_TEXT ("message"), __FILE__, __LINE__);
+    setThreadPoolQueueSizeLimit (limit);
+
+    CATCH_SECTION ("drop")
+    {
+        setThreadPoolBlockOnFull (false);
+        GatedAppender * const gated = new GatedAppender;
+        SharedAppenderPtr appender (gated);
+        for (std::size_t i = 0; i != events; ++i)
+            appender->doAppend (event);
+
+        // Each thread pool thread can hold one taken batch while the
+        // current batch is full, the rest of the events is dropped.
+        gated->open ();
+        appender->waitToFinishAsyncLogging ();
+        CATCH_REQUIRE (gated->appended >= limit);
+        CATCH_REQUIRE (gated->appended < events);
+    }
+
+    CATCH_SECTION ("block")
+    {
+        setThreadPoolBlockOnFull (true);
+        GatedAppender * const gated = new GatedAppender;
+        SharedAppenderPtr appender (gated);
+        std::atomic<bool> done {false};
+        std::thread logging ([&] {
+            for (std::size_t i = 0; i != events; ++i)
+                appender->doAppend (event);
+            done = true;
+        });
+
+        std::this_thread::sleep_for (std::chrono::milliseconds (50));
+        CATCH_REQUIRE (! done);
+        gated->open ();
+        logging.join ();
+        appender->waitToFinishAsyncLogging ();
+        CATCH_REQUIRE (gated->appended == events);
+    }
+
+    setThreadPoolBlockOnFull (true);
+    setThreadPoolQueueSizeLimit (100000);
+}
+
+#endif
+
 } // namespace log4cplus
@@ -19,6 +19,7 @@
 // limitations under the License.
 
 
+#include <log4cplus/internal/internal.h>
 #include <log4cplus/appender.h>
 #include <log4cplus/helpers/appenderattachableimpl.h>
 #include <log4cplus/helpers/loglog.h>
@@ -26,6 +27,13 @@
 #include <log4cplus/thread/syncprims-pub-impl.h>
 
 #include <algorithm>
+#include <utility>
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <catch_amalgamated.hpp>
+#include <atomic>
+#include <thread>
+#endif
 
 
 namespace log4cplus
@@ -46,14 +54,63 @@ namespace helpers
 {
 
 
+namespace
+{
+
+//! Destroys appenders list. Appenders are released in specific order
+//! because the order of destruction of std::vector elements is
+//! surprisingly unspecified and it breaks our tests' expectations.
+static
+void
+destroyAppenderList (void * ptr)
+{
+    std::unique_ptr<std::vector<SharedAppenderPtr>> list (
+        static_cast<std::vector<SharedAppenderPtr> *>(ptr));
+    for (auto & app : *list)
+        app = SharedAppenderPtr ();
+}
+
+} // namespace
+
+
 //////////////////////////////////////////////////////////////////////////////
 // log4cplus::helpers::AppenderAttachableImpl ctor and dtor
 //////////////////////////////////////////////////////////////////////////////
 
-AppenderAttachableImpl::AppenderAttachableImpl() = default;
+AppenderAttachableImpl::AppenderAttachableImpl()
+    : appenderList (nullptr)
+{ }
+
+
+AppenderAttachableImpl::~AppenderAttachableImpl()
+{
+    // Readers cannot use the object any more.
+    if (ListPtr list = appenderList.load (std::memory_order_relaxed))
+        destroyAppenderList (const_cast<ListType *>(list));
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// log4cplus::helpers::AppenderAttachableImpl protected methods
+///////////////////////////////////////////////////////////////////////////////
+
+AppenderAttachableImpl::ListPtr
+AppenderAttachableImpl::loadAppenderList() const
+{
+    return appenderList.load (std::memory_order_acquire);
+}
 
 
-AppenderAttachableImpl::~AppenderAttachableImpl() = default;
+void
+AppenderAttachableImpl::replaceAppenderList(std::unique_ptr<ListType> newList)
+{
+    ListPtr const oldList = appenderList.exchange (newList.release (),
+        std::memory_order_acq_rel);
+    if (oldList)
+        internal::rcu::retire (const_cast<ListType *>(oldList),
+            destroyAppenderList);
+}
 
 
 
@@ -72,11 +129,17 @@ AppenderAttachableImpl::addAppender(SharedAppenderPtr newAppender)
 
     thread::MutexGuard guard (appender_list_mutex);
 
-    auto it = std::find(appenderList.begin(), appenderList.end(), newAppender);
-    if (it == appenderList.end())
-    {
-        appenderList.push_back(newAppender);
-    }
+    ListPtr const current = loadAppenderList ();
+    if (current
+        && std::find(current->begin(), current->end(), newAppender)
+            != current->end())
+        return;
+
+    auto newList = current
+        ? std::make_unique<ListType> (*current)
+        : std::make_unique<ListType> ();
+    newList->push_back(std::move (newAppender));
+    replaceAppenderList (std::move (newList));
 }
 
 
@@ -84,9 +147,12 @@ AppenderAttachableImpl::addAppender(SharedAppenderPtr newAppender)
 AppenderAttachableImpl::ListType
 AppenderAttachableImpl::getAllAppenders()
 {
-    thread::MutexGuard guard (appender_list_mutex);
-
-    return appenderList;
+    internal::rcu::read_guard const guard;
+    ListPtr const current = loadAppenderList ();
+    if (current)
+        return *current;
+    else
+        return ListType ();
 }
 
 
@@ -94,12 +160,15 @@ AppenderAttachableImpl::getAllAppenders()
 SharedAppenderPtr
 AppenderAttachableImpl::getAppender(const log4cplus::tstring& name)
 {
-    thread::MutexGuard guard (appender_list_mutex);
-
-    for (SharedAppenderPtr & ptr : appenderList)
+    internal::rcu::read_guard const guard;
+    ListPtr const current = loadAppenderList ();
+    if (current)
     {
-        if (ptr->getName() == name)
-            return ptr;
+        for (SharedAppenderPtr const & ptr : *current)
+        {
+            if (ptr->getName() == name)
+                return ptr;
+        }
     }
 
     return SharedAppenderPtr ();
@@ -112,14 +181,10 @@ AppenderAttachableImpl::removeAllAppenders()
 {
     thread::MutexGuard guard (appender_list_mutex);
 
-    // Clear appenders in specific order because the order of destruction of
-    // std::vector elements is surprisingly unspecified and it breaks our
-    // tests' expectations.
-
-    for (auto & app : appenderList)
-        app = SharedAppenderPtr ();
-
-    appenderList.clear ();
+    // The old snapshot, and appenders only it refers to, are released
+    // in order as soon as no reader can be using it, possibly by the
+    // last such reader.
+    replaceAppenderList (nullptr);
 }
 
 
@@ -135,10 +200,18 @@ AppenderAttachableImpl::removeAppender(SharedAppenderPtr appender)
 
     thread::MutexGuard guard (appender_list_mutex);
 
-    auto it = std::find(appenderList.begin(), appenderList.end(), appender);
-    if (it != appenderList.end())
+    ListPtr const current = loadAppenderList ();
+    if (! current)
+        return;
+
+    auto it = std::find(current->begin(), current->end(), appender);
+    if (it != current->end())
     {
-        appenderList.erase(it);
+        auto newList = std::make_unique<ListType> ();
+        newList->reserve (current->size () - 1);
+        newList->insert (newList->end (), current->begin (), it);
+        newList->insert (newList->end (), it + 1, current->end ());
+        replaceAppenderList (std::move (newList));
     }
 }
 
@@ -157,9 +230,14 @@ AppenderAttachableImpl::appendLoopOnAppenders(const spi::InternalLoggingEvent& e
 {
     int count = 0;
 
-    thread::MutexGuard guard (appender_list_mutex);
+    // Appenders removed while we iterate the snapshot are kept alive
+    // until we leave the read-side critical section.
+    internal::rcu::read_guard const guard;
+    ListPtr const current = loadAppenderList ();
+    if (! current)
+        return count;
 
-    for (auto & appender : appenderList)
+    for (auto & appender : *current)
     {
         ++count;
         appender->doAppend(event);
@@ -169,6 +247,130 @@ AppenderAttachableImpl::appendLoopOnAppenders(const spi::InternalLoggingEvent& e
 }
 
 
+int
+AppenderAttachableImpl::appendBatchLoopOnAppenders(
+    std::span<spi::InternalLoggingEvent const> events) const
+{
+    int count = 0;
+
+    internal::rcu::read_guard const guard;
+    ListPtr const current = loadAppenderList ();
+    if (! current)
+        return count;
+
+    for (auto & appender : *current)
+    {
+        ++count;
+        appender->doAppendBatch(events);
+    }
+
+    return count;
+}
+
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS) && ! defined (LOG4CPLUS_SINGLE_THREADED)
+namespace
+{
+
+class CountingAppender
+    : public Appender
+{
+public:
+    CountingAppender (std::atomic<int> & destroyed_)
+        : destroyed (destroyed_)
+    { }
+
+    ~CountingAppender () override
+    {
+        destructorImpl ();
+        ++destroyed;
+    }
+
+    void
+    close () override
+    {
+        closed = true;
+    }
+
+    std::atomic<std::size_t> appended {0};
+
+protected:
+    void
+    append (spi::InternalLoggingEvent const &) override
+    {
+        ++appended;
+    }
+
+    std::atomic<int> & destroyed;
+};
+
+} // namespace
+
+
+CATCH_TEST_CASE ("AppenderAttachableImpl", "[appender]")
+{
+    std::atomic<int> destroyed {0};
+    std::size_t const logging_threads = 4;
+    std::size_t const events_per_thread = 20000;
+    int const replaced_appenders = 2000;
+
+    {
+        AppenderAttachableImpl attachable;
+        CountingAppender * const counting = new CountingAppender (destroyed);
+        SharedAppenderPtr permanent (counting);
+        attachable.addAppender (permanent);
+
+        std::atomic<std::size_t> misses {0};
+        std::vector<std::thread> threads;
+        for (std::size_t i = 0; i != logging_threads; ++i)
+            threads.emplace_back ([&attachable, &misses] {
+                spi::InternalLoggingEvent const event (
+                    LOG4CPLUS_TEXT ("rcu"), INFO_LOG_LEVEL,
+                    LOG4CPLUS_TEXT ("message"), __FILE__, __LINE__);
+                for (std::size_t j = 0; j != events_per_thread; ++j)
+                    if (attachable.appendLoopOnAppenders (event) < 1)
+                        ++misses;
+            });
+
+        // Add and remove appenders while the other threads log.
+        for (int i = 0; i != replaced_appenders; ++i)
+        {
+            SharedAppenderPtr temporary (new CountingAppender (destroyed));
+            temporary->setName (LOG4CPLUS_TEXT ("temporary"));
+            attachable.addAppender (temporary);
+            if (i % 2 == 0)
+                attachable.removeAppender (temporary);
+            else
+                attachable.removeAppender (LOG4CPLUS_TEXT ("temporary"));
+        }
+
+        for (auto & thread : threads)
+            thread.join ();
+
+        // Every event reached the permanent appender and every removed
+        // appender has been destroyed once the readers left.
+        CATCH_REQUIRE (misses == 0);
+        CATCH_REQUIRE (counting->appended
+            == logging_threads * events_per_thread);
+        CATCH_REQUIRE (destroyed == replaced_appenders);
+        CATCH_REQUIRE (attachable.getAllAppenders ().size () == 1);
+
+        // Removal of all appenders releases them in order even when it
+        // happens inside of read-side critical section.
+        attachable.addAppender (SharedAppenderPtr (
+            new CountingAppender (destroyed)));
+        permanent = nullptr;
+        {
+            internal::rcu::read_guard const guard;
+            attachable.removeAllAppenders ();
+            CATCH_REQUIRE (destroyed == replaced_appenders);
+        }
+        CATCH_REQUIRE (destroyed == replaced_appenders + 2);
+    }
+}
+#endif
+
+
 } // namespace helpers
 
 
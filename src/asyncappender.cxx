@@ -30,6 +30,7 @@
 #include <log4cplus/spi/factory.h>
 #include <log4cplus/helpers/loglog.h>
 #include <log4cplus/helpers/property.h>
+#include <log4cplus/helpers/stringhelper.h>
 #include <log4cplus/thread/syncprims-pub-impl.h>
 
 
@@ -69,14 +70,11 @@ QueueThread::run()
 
     while (true)
     {
+        // The whole batch of queued events is taken from the queue at
+        // once and then appended without touching the queue again.
         unsigned qflags = queue->get_events (&ev_buf);
         if (qflags & thread::Queue::EVENT)
-        {
-            auto const ev_buf_end = ev_buf.end ();
-            for (auto it = ev_buf.begin ();
-                it != ev_buf_end; ++it)
-                appenders->appendLoopOnAppenders (*it);
-        }
+            appenders->appendBatchLoopOnAppenders (ev_buf);
 
         if (((thread::Queue::EXIT | thread::Queue::DRAIN
                 | thread::Queue::EVENT) & qflags)
@@ -93,10 +91,10 @@ QueueThread::run()
 
 
 AsyncAppender::AsyncAppender (SharedAppenderPtr const & app,
-    unsigned queue_len)
+    unsigned queue_len, QueueType queue_type)
 {
     addAppender (app);
-    init_queue_thread (queue_len);
+    init_queue_thread (queue_len, queue_type);
 }
 
 
@@ -131,7 +129,19 @@ AsyncAppender::AsyncAppender (helpers::Properties const & props)
     unsigned queue_len = 100;
     props.getUInt (queue_len, LOG4CPLUS_TEXT ("QueueLimit"));
 
-    init_queue_thread (queue_len);
+    QueueType queue_type = QueueType::MUTEX;
+    tstring const queue_type_str = helpers::toUpper (
+        props.getProperty (LOG4CPLUS_TEXT ("QueueType")));
+    if (queue_type_str == LOG4CPLUS_TEXT ("RINGBUFFER"))
+        queue_type = QueueType::RING_BUFFER;
+    else if (! queue_type_str.empty ()
+        && queue_type_str != LOG4CPLUS_TEXT ("MUTEX"))
+        helpers::getLogLog ().warn (
+            LOG4CPLUS_TEXT ("AsyncAppender::AsyncAppender()")
+            LOG4CPLUS_TEXT (" - Unknown QueueType: ")
+            + props.getProperty (LOG4CPLUS_TEXT ("QueueType")));
+
+    init_queue_thread (queue_len, queue_type);
 }
 
 
@@ -142,9 +152,12 @@ AsyncAppender::~AsyncAppender ()
 
 
 void
-AsyncAppender::init_queue_thread (unsigned queue_len)
+AsyncAppender::init_queue_thread (unsigned queue_len, QueueType queue_type)
 {
-    queue = new thread::Queue (queue_len);
+    if (queue_type == QueueType::RING_BUFFER)
+        queue = new thread::RingBufferQueue (queue_len);
+    else
+        queue = new thread::Queue (queue_len);
     queue_thread = new QueueThread (AsyncAppenderPtr (this), queue);
     queue_thread->start ();
     helpers::getLogLog ().debug (LOG4CPLUS_TEXT("Queue thread started."));
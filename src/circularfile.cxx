@@ -0,0 +1,568 @@
+// -*- C++ -*-
+//
+//  Copyright (C) 2026, Vaclav Haisman. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <log4cplus/config.hxx>
+#include <log4cplus/helpers/circularfile.h>
+#include <log4cplus/helpers/loglog.h>
+#include <log4cplus/helpers/stringhelper.h>
+#include <log4cplus/internal/env.h>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+#include <cerrno>
+#ifdef LOG4CPLUS_HAVE_ERRNO_H
+#include <errno.h>
+#endif
+
+#if defined (LOG4CPLUS_HAVE_SYS_MMAN_H) && ! defined (_WIN32)
+#define LOG4CPLUS_USE_MMAP
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <catch_amalgamated.hpp>
+#endif
+
+
+namespace log4cplus::helpers {
+
+
+namespace
+{
+
+char const file_magic[8] = { 'L', '4', 'C', 'P', 'C', 'I', 'R', 'C' };
+std::uint32_t const file_version = 1;
+
+// Offsets of header fields.
+std::size_t const version_field = 8;
+std::size_t const capacity_field = 16;
+std::size_t const head_field = 24;
+std::size_t const tail_field = 32;
+std::size_t const sequence_field = 40;
+
+// "L4CR" and "L4CW" read as little endian numbers.
+std::uint32_t const record_marker = 0x5243344C;
+std::uint32_t const wrap_marker = 0x5743344C;
+
+std::size_t const record_alignment = 8;
+
+
+void
+store_le (char * out, std::uint64_t value, std::size_t bytes)
+{
+    for (std::size_t i = 0; i != bytes; ++i)
+        out[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+}
+
+
+std::uint64_t
+get_le (char const * data, std::size_t bytes)
+{
+    std::uint64_t value = 0;
+    for (std::size_t i = bytes; i != 0; --i)
+        value = (value << 8) | static_cast<unsigned char>(data[i - 1]);
+    return value;
+}
+
+
+std::uint64_t
+aligned_record_size (std::uint64_t length)
+{
+    std::uint64_t const size = CircularFile::record_header_size + length;
+    return (size + record_alignment - 1) / record_alignment
+        * record_alignment;
+}
+
+
+//! \return Offset of the record following record at `pos` in data area
+//! `data`. It is 0 when `pos` is at the end of a lap of writing. It
+//! can be equal to `capacity` when the record ends at the end of the
+//! data area.
+std::uint64_t
+next_record (char const * data, std::uint64_t capacity, std::uint64_t pos)
+{
+    if (capacity - pos < record_alignment
+        || get_le (data + pos, 4) != record_marker
+        || capacity - pos < CircularFile::record_header_size)
+        return 0;
+
+    return pos + aligned_record_size (get_le (data + pos + 4, 4));
+}
+
+
+//! \return true when `header` is a valid header of a file with data
+//! area of `size` bytes.
+bool
+check_header (char const * header, std::uint64_t size)
+{
+    if (std::memcmp (header, file_magic, sizeof (file_magic)) != 0
+        || get_le (header + version_field, 4) != file_version)
+        return false;
+
+    std::uint64_t const capacity = get_le (header + capacity_field, 8);
+    std::uint64_t const head = get_le (header + head_field, 8);
+    std::uint64_t const tail = get_le (header + tail_field, 8);
+    return capacity == size
+        && capacity % record_alignment == 0
+        && head <= capacity && head % record_alignment == 0
+        && tail < capacity && tail % record_alignment == 0;
+}
+
+} // namespace
+
+
+//
+//
+//
+
+CircularFile::CircularFile ()
+    : fd (-1)
+    , mapping (nullptr)
+    , mappingSize (0)
+    , capacity (0)
+{ }
+
+
+CircularFile::~CircularFile ()
+{
+    close ();
+}
+
+
+bool
+CircularFile::open (tstring const & name, std::size_t size, bool append)
+{
+    close ();
+
+    LogLog & loglog = getLogLog ();
+    if (size < header_size + 2 * record_header_size)
+    {
+        loglog.error (LOG4CPLUS_TEXT ("CircularFile: Size of ") + name
+            + LOG4CPLUS_TEXT (" is too small"));
+        return false;
+    }
+
+#if defined (LOG4CPLUS_USE_MMAP)
+    capacity = (size - header_size) / record_alignment * record_alignment;
+    std::size_t const fileSize = header_size
+        + static_cast<std::size_t>(capacity);
+
+    int flags = O_RDWR | O_CREAT;
+#if defined (O_CLOEXEC)
+    flags |= O_CLOEXEC;
+#endif
+
+    fd = ::open (LOG4CPLUS_TSTRING_TO_STRING (name).c_str (), flags,
+        S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH);
+    if (fd == -1)
+    {
+        loglog.error (LOG4CPLUS_TEXT ("CircularFile: Unable to open file: ")
+            + name);
+        return false;
+    }
+
+    struct stat st;
+    std::size_t const existing = fstat (fd, &st) == 0
+        ? static_cast<std::size_t>(st.st_size) : 0;
+    bool keep = append && existing == fileSize;
+    if (append && existing != 0 && existing != fileSize)
+        loglog.warn (LOG4CPLUS_TEXT ("CircularFile: ") + name
+            + LOG4CPLUS_TEXT (" has different size, starting it empty"));
+
+    int ret = 0;
+    if (! keep)
+    {
+        // Start with zeroed, preallocated file. A file that cannot be
+        // backed by storage is not mapped, the first write into an
+        // unbacked page would raise SIGBUS.
+        ret = ftruncate (fd, 0) == 0 ? 0 : errno;
+        if (ret == 0)
+            ret = internal::preallocate_file (fd, fileSize);
+    }
+    else
+        ret = internal::check_file_size (fd, fileSize);
+
+    void * ptr = MAP_FAILED;
+    if (ret == 0)
+    {
+        ptr = mmap (nullptr, fileSize, PROT_READ | PROT_WRITE, MAP_SHARED,
+            fd, 0);
+        if (ptr == MAP_FAILED)
+            ret = errno;
+    }
+
+    if (ret != 0)
+    {
+        loglog.error (LOG4CPLUS_TEXT ("CircularFile: Unable to map file: ")
+            + name + LOG4CPLUS_TEXT ("; error ")
+            + convertIntegerToString (ret));
+        ::close (fd);
+        fd = -1;
+        return false;
+    }
+
+    mapping = static_cast<char *>(ptr);
+    mappingSize = fileSize;
+
+    if (keep && ! check_header (mapping, capacity))
+    {
+        loglog.warn (LOG4CPLUS_TEXT ("CircularFile: ") + name
+            + LOG4CPLUS_TEXT (" is not a valid circular file,")
+            LOG4CPLUS_TEXT (" starting it empty"));
+        keep = false;
+    }
+
+    if (! keep)
+    {
+        std::memset (mapping, 0, header_size);
+        std::memcpy (mapping, file_magic, sizeof (file_magic));
+        store_le (mapping + version_field, file_version, 4);
+        store (capacity_field, capacity);
+    }
+
+    return true;
+
+#else
+    (void) append;
+    loglog.error (LOG4CPLUS_TEXT ("CircularFile: Not supported")
+        LOG4CPLUS_TEXT (" on this platform: ") + name);
+    return false;
+
+#endif
+}
+
+
+void
+CircularFile::close ()
+{
+#if defined (LOG4CPLUS_USE_MMAP)
+    if (mapping)
+    {
+        munmap (mapping, mappingSize);
+        mapping = nullptr;
+        mappingSize = 0;
+    }
+
+    if (fd != -1)
+    {
+        ::close (fd);
+        fd = -1;
+    }
+
+#endif
+}
+
+
+bool
+CircularFile::is_open () const
+{
+    return mapping != nullptr;
+}
+
+
+std::uint64_t
+CircularFile::load (std::size_t field) const
+{
+    return get_le (mapping + field, 8);
+}
+
+
+void
+CircularFile::store (std::size_t field, std::uint64_t value)
+{
+    store_le (mapping + field, value, 8);
+}
+
+
+std::uint64_t
+CircularFile::nextRecord (std::uint64_t pos) const
+{
+    return next_record (mapping + header_size, capacity, pos);
+}
+
+
+void
+CircularFile::write (std::string_view record, Time const & timestamp)
+{
+    if (! mapping)
+        return;
+
+    std::size_t const length = static_cast<std::size_t>((std::min<
+        std::uint64_t>) (record.size (), capacity - record_header_size));
+    std::uint64_t const size = aligned_record_size (length);
+    std::uint64_t const head = load (head_field);
+    std::uint64_t tail = load (tail_field);
+    bool const wrap = head + size > capacity;
+    std::uint64_t const start = wrap ? 0 : head;
+
+    // Move the oldest record offset past records that will be
+    // overwritten before they are overwritten.
+    if (head == tail)
+        // The file is empty.
+        tail = start;
+    else if (wrap)
+    {
+        // Records from the write head to the end of the previous lap
+        // are lost.
+        if (tail > head)
+            tail = 0;
+        while (tail != head && tail <= size)
+        {
+            std::uint64_t const next = nextRecord (tail);
+            tail = next == 0 || next > capacity ? head : next;
+        }
+        if (tail == head)
+            tail = 0;
+    }
+    else
+    {
+        // Records of the previous lap that follow the write head.
+        while (tail > head && tail <= head + size)
+        {
+            tail = nextRecord (tail);
+            if (tail >= capacity)
+                tail = 0;
+        }
+    }
+    store (tail_field, tail);
+
+    char * const data = mapping + header_size;
+    if (wrap && capacity - head >= record_alignment)
+        store_le (data + head, wrap_marker, 4);
+
+    std::uint64_t const sequence = load (sequence_field);
+    char * const out = data + start;
+    store_le (out, record_marker, 4);
+    store_le (out + 4, length, 4);
+    store_le (out + 8, sequence, 8);
+    store_le (out + 16,
+        static_cast<std::uint64_t>(timestamp.time_since_epoch ().count ()),
+        8);
+    std::memcpy (out + record_header_size, record.data (), length);
+    std::memset (out + record_header_size + length, 0,
+        static_cast<std::size_t>(size - record_header_size - length));
+
+    store (sequence_field, sequence + 1);
+    store (head_field, start + size);
+}
+
+
+//
+//
+//
+
+CircularFileReader::CircularFileReader ()
+{ }
+
+
+CircularFileReader::~CircularFileReader ()
+{ }
+
+
+bool
+CircularFileReader::open (tstring const & name)
+{
+    close ();
+
+    std::ifstream in (std::filesystem::path (name),
+        std::ios_base::in | std::ios_base::binary);
+    if (! in.is_open ())
+        return false;
+
+    contents.assign (std::istreambuf_iterator<char> (in),
+        std::istreambuf_iterator<char> ());
+    if (contents.size () < CircularFile::header_size
+        || ! check_header (contents.data (),
+            contents.size () - CircularFile::header_size))
+    {
+        contents.clear ();
+        return false;
+    }
+
+    char const * const header = contents.data ();
+    char const * const data = header + CircularFile::header_size;
+    std::uint64_t const capacity = get_le (header + capacity_field, 8);
+    std::uint64_t const head = get_le (header + head_field, 8);
+    std::uint64_t pos = get_le (header + tail_field, 8);
+
+    // Each step moves at least by record_alignment bytes or wraps, the
+    // limit only stops walking of a corrupted file.
+    for (std::uint64_t steps = capacity / record_alignment + 1;
+         pos != head && steps != 0; --steps)
+    {
+        std::uint64_t const next = next_record (data, capacity, pos);
+        if (next == 0)
+        {
+            // The end of the lap.
+            pos = 0;
+            continue;
+        }
+        else if (next > capacity)
+            // Corrupted record.
+            break;
+
+        CircularFileRecord record;
+        record.sequence = get_le (data + pos + 8, 8);
+        record.timestamp = Time (Duration (
+            static_cast<long long>(get_le (data + pos + 16, 8))));
+        record.data = std::string_view (
+            data + pos + CircularFile::record_header_size,
+            static_cast<std::size_t>(get_le (data + pos + 4, 4)));
+        items.push_back (record);
+
+        pos = next == capacity && head != capacity ? 0 : next;
+    }
+
+    return true;
+}
+
+
+void
+CircularFileReader::close ()
+{
+    items.clear ();
+    contents.clear ();
+}
+
+
+std::vector<CircularFileRecord> const &
+CircularFileReader::records () const
+{
+    return items;
+}
+
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS) && defined (LOG4CPLUS_USE_MMAP)
+CATCH_TEST_CASE ("CircularFile", "[circularfile]")
+{
+    tstring const fileName (LOG4CPLUS_TEXT ("circular_file_test.log"));
+    std::filesystem::path const path (fileName);
+    std::size_t const size = 4096;
+    Time const start = from_time_t (1000000);
+    // Records of varying length so that laps end at different offsets.
+    auto record = [] (int i) {
+        return "record " + std::to_string (i) + std::string (i % 37, '.');
+    };
+    auto write_records = [&] (CircularFile & file, int first, int count) {
+        for (int i = first; i != first + count; ++i)
+            file.write (record (i), start + chrono::seconds (i));
+    };
+    // Space taken by records found by the last check_records().
+    std::uint64_t used = 0;
+    // Checks that records are the newest ones up to `last`, in order.
+    auto check_records = [&] (int last) {
+        CircularFileReader reader;
+        CATCH_REQUIRE (reader.open (fileName));
+        std::vector<CircularFileRecord> const & records = reader.records ();
+        CATCH_REQUIRE (! records.empty ());
+        used = 0;
+        int i = last - static_cast<int>(records.size ()) + 1;
+        for (CircularFileRecord const & rec : records)
+        {
+            CATCH_REQUIRE (rec.sequence == static_cast<std::uint64_t>(i));
+            CATCH_REQUIRE (rec.timestamp == start + chrono::seconds (i));
+            CATCH_REQUIRE (rec.data == record (i));
+            used += aligned_record_size (rec.data.size ());
+            ++i;
+        }
+        CATCH_REQUIRE (used <= size - CircularFile::header_size);
+        return records.size ();
+    };
+
+    std::filesystem::remove (path);
+
+    CATCH_SECTION ("wrapping")
+    {
+        CircularFile file;
+        CATCH_REQUIRE (file.open (fileName, size, false));
+        write_records (file, 0, 10);
+        CATCH_REQUIRE (check_records (9) == 10);
+        std::uint64_t const longest
+            = aligned_record_size (record (1035).size ());
+        for (int i = 10; i < 2000; i += 7)
+        {
+            write_records (file, i, 7);
+            check_records (i + 6);
+            // Once the file is full, space of at most three of the
+            // longest records is lost at the end of the lap and around
+            // the write head.
+            if (i >= 100)
+                CATCH_REQUIRE (used + 3 * longest
+                    >= size - CircularFile::header_size);
+        }
+        CATCH_REQUIRE (std::filesystem::file_size (path) == size);
+    }
+
+    CATCH_SECTION ("append")
+    {
+        {
+            CircularFile file;
+            CATCH_REQUIRE (file.open (fileName, size, false));
+            write_records (file, 0, 500);
+        }
+        {
+            CircularFile file;
+            CATCH_REQUIRE (file.open (fileName, size, true));
+            write_records (file, 500, 10);
+        }
+        check_records (509);
+
+        // File of another size is started again.
+        {
+            CircularFile file;
+            CATCH_REQUIRE (file.open (fileName, 2 * size, true));
+            write_records (file, 0, 1);
+        }
+        CATCH_REQUIRE (check_records (0) == 1);
+    }
+
+    CATCH_SECTION ("long record")
+    {
+        CircularFile file;
+        CATCH_REQUIRE (file.open (fileName, size, false));
+        write_records (file, 0, 10);
+        std::string const long_record (2 * size, 'x');
+        file.write (long_record, start);
+        CircularFileReader reader;
+        CATCH_REQUIRE (reader.open (fileName));
+        CATCH_REQUIRE (reader.records ().size () == 1);
+        CATCH_REQUIRE (reader.records ().front ().data.size ()
+            == size - CircularFile::header_size
+                - CircularFile::record_header_size);
+    }
+
+    std::filesystem::remove (path);
+}
+#endif
+
+
+} // namespace log4cplus::helpers
@@ -0,0 +1,1333 @@
+// -*- C++ -*-
+//
+//  Copyright (C) 2026, Vaclav Haisman. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <log4cplus/config.hxx>
+#include <log4cplus/helpers/compressedfile.h>
+#include <log4cplus/helpers/housekeeping.h>
+#include <log4cplus/helpers/loglog.h>
+#include <log4cplus/helpers/stringhelper.h>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+
+#if defined (LOG4CPLUS_WITH_ZLIB)
+#include <zlib.h>
+#endif
+#if defined (LOG4CPLUS_WITH_ZSTD)
+#include <zstd.h>
+#endif
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <catch_amalgamated.hpp>
+#endif
+
+
+namespace log4cplus::helpers {
+
+
+namespace
+{
+
+// Gzip member header without extra field, see RFC 1952.
+std::size_t const gzip_header_size = 10;
+// Offset of subfield data: header, XLEN, subfield ID and its length.
+std::size_t const gzip_extra_offset = gzip_header_size + 2 + 4;
+// CRC32 and ISIZE.
+std::size_t const gzip_trailer_size = 8;
+// Raw deflate stream of empty data.
+char const empty_deflate[2] = { '\x03', '\x00' };
+
+// Skippable frames of Zstandard format use magic numbers 0x184D2A5?.
+std::uint32_t const zstd_block_magic = 0x184D2A5C;
+std::uint32_t const zstd_index_magic = 0x184D2A5D;
+std::uint32_t const zstd_locator_magic = 0x184D2A5E;
+// Magic number and size of skippable frame.
+std::size_t const skippable_header_size = 8;
+
+// Member size, raw size and two timestamps.
+std::size_t const block_data_size = 4 + 4 + 8 + 8;
+// Offset, size, raw size and two timestamps.
+std::size_t const index_entry_size = 8 + 4 + 4 + 8 + 8;
+// Index offset and number of blocks.
+std::size_t const locator_data_size = 8 + 4;
+// Number of index entries that fit into one gzip extra field.
+std::size_t const gzip_index_entries = (0xFFFF - 4) / index_entry_size;
+
+
+std::size_t
+block_header_size (CompressionCodec codec)
+{
+    return codec == CompressionCodec::Gzip
+        ? gzip_extra_offset + block_data_size
+        : skippable_header_size + block_data_size;
+}
+
+
+std::size_t
+block_trailer_size (CompressionCodec codec)
+{
+    return codec == CompressionCodec::Gzip ? gzip_trailer_size : 0;
+}
+
+
+std::size_t
+locator_size (CompressionCodec codec)
+{
+    return codec == CompressionCodec::Gzip
+        ? gzip_extra_offset + locator_data_size + sizeof (empty_deflate)
+            + gzip_trailer_size
+        : skippable_header_size + locator_data_size;
+}
+
+
+void
+put_le (std::string & out, std::uint64_t value, std::size_t bytes)
+{
+    for (std::size_t i = 0; i != bytes; ++i)
+        out += static_cast<char>((value >> (8 * i)) & 0xFF);
+}
+
+
+void
+store_le (char * out, std::uint64_t value, std::size_t bytes)
+{
+    for (std::size_t i = 0; i != bytes; ++i)
+        out[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+}
+
+
+std::uint64_t
+get_le (char const * data, std::size_t bytes)
+{
+    std::uint64_t value = 0;
+    for (std::size_t i = bytes; i != 0; --i)
+        value = (value << 8) | static_cast<unsigned char>(data[i - 1]);
+    return value;
+}
+
+
+void
+put_time (std::string & out, Time const & time)
+{
+    put_le (out, static_cast<std::uint64_t>(time.time_since_epoch ().count ()),
+        8);
+}
+
+
+Time
+get_time (char const * data)
+{
+    return Time (Duration (static_cast<long long>(get_le (data, 8))));
+}
+
+
+//! Appends gzip member header with one extra subfield `L` `id`.
+void
+put_gzip_header (std::string & out, char id, std::size_t dataSize)
+{
+    static char const header[gzip_header_size] = {
+        '\x1F', '\x8B',
+        8,              // CM: deflate
+        4,              // FLG: FEXTRA
+        0, 0, 0, 0,     // MTIME: not available
+        0,              // XFL
+        '\xFF' };       // OS: unknown
+    out.append (header, gzip_header_size);
+    put_le (out, dataSize + 4, 2);
+    out += 'L';
+    out += id;
+    put_le (out, dataSize, 2);
+}
+
+
+//! Appends content and trailer of gzip member with no data.
+void
+put_empty_gzip_content (std::string & out)
+{
+    out.append (empty_deflate, sizeof (empty_deflate));
+    // CRC32 and ISIZE of no data are both 0.
+    put_le (out, 0, gzip_trailer_size);
+}
+
+
+//! \return Subfield data of gzip member with subfield `L` `id` of
+//! size `dataSize` or nullptr.
+char const *
+parse_gzip_header (char const * data, std::size_t size, char id,
+    std::size_t dataSize)
+{
+    if (size < gzip_extra_offset + dataSize
+        || static_cast<unsigned char>(data[0]) != 0x1F
+        || static_cast<unsigned char>(data[1]) != 0x8B
+        || data[2] != 8
+        || data[3] != 4
+        || get_le (data + 10, 2) != dataSize + 4
+        || data[12] != 'L'
+        || data[13] != id
+        || get_le (data + 14, 2) != dataSize)
+        return nullptr;
+
+    return data + gzip_extra_offset;
+}
+
+
+//! \return Data of skippable frame with `magic` of size `dataSize` or
+//! nullptr.
+char const *
+parse_skippable_header (char const * data, std::size_t size,
+    std::uint32_t magic, std::size_t dataSize)
+{
+    if (size < skippable_header_size + dataSize
+        || get_le (data, 4) != magic
+        || get_le (data + 4, 4) != dataSize)
+        return nullptr;
+
+    return data + skippable_header_size;
+}
+
+
+//! Appends header of a block with placeholder for its size.
+void
+put_block_header (std::string & out, CompressionCodec codec,
+    std::size_t rawSize, Time const & first, Time const & last)
+{
+    if (codec == CompressionCodec::Gzip)
+        put_gzip_header (out, 'B', block_data_size);
+    else
+    {
+        put_le (out, zstd_block_magic, 4);
+        put_le (out, block_data_size, 4);
+    }
+
+    put_le (out, 0, 4);
+    put_le (out, rawSize, 4);
+    put_time (out, first);
+    put_time (out, last);
+}
+
+
+//! Parses block header at `data` of at least block_header_size() bytes.
+bool
+parse_block_header (CompressionCodec codec, char const * data,
+    CompressedBlockInfo & info)
+{
+    std::size_t const headerSize = block_header_size (codec);
+    char const * p = codec == CompressionCodec::Gzip
+        ? parse_gzip_header (data, headerSize, 'B', block_data_size)
+        : parse_skippable_header (data, headerSize, zstd_block_magic,
+            block_data_size);
+    if (! p)
+        return false;
+
+    info.size = static_cast<std::uint32_t>(get_le (p, 4));
+    info.rawSize = static_cast<std::uint32_t>(get_le (p + 4, 4));
+    info.first = get_time (p + 8);
+    info.last = get_time (p + 16);
+    return info.size >= headerSize + block_trailer_size (codec);
+}
+
+
+void
+put_index_entry (std::string & out, CompressedBlockInfo const & info)
+{
+    put_le (out, info.offset, 8);
+    put_le (out, info.size, 4);
+    put_le (out, info.rawSize, 4);
+    put_time (out, info.first);
+    put_time (out, info.last);
+}
+
+
+CompressedBlockInfo
+get_index_entry (char const * data)
+{
+    CompressedBlockInfo info;
+    info.offset = get_le (data, 8);
+    info.size = static_cast<std::uint32_t>(get_le (data + 8, 4));
+    info.rawSize = static_cast<std::uint32_t>(get_le (data + 12, 4));
+    info.first = get_time (data + 16);
+    info.last = get_time (data + 24);
+    return info;
+}
+
+
+//! \return Footer, index and locator, for `blocks` that end at
+//! `indexOffset`.
+std::string
+make_footer (CompressionCodec codec,
+    std::vector<CompressedBlockInfo> const & blocks,
+    std::uint64_t indexOffset)
+{
+    std::string out;
+    if (codec == CompressionCodec::Gzip)
+    {
+        std::size_t i = 0;
+        do
+        {
+            std::size_t const count
+                = (std::min) (blocks.size () - i, gzip_index_entries);
+            put_gzip_header (out, 'I', count * index_entry_size);
+            for (std::size_t const end = i + count; i != end; ++i)
+                put_index_entry (out, blocks[i]);
+            put_empty_gzip_content (out);
+        }
+        while (i != blocks.size ());
+
+        put_gzip_header (out, 'L', locator_data_size);
+        put_le (out, indexOffset, 8);
+        put_le (out, blocks.size (), 4);
+        put_empty_gzip_content (out);
+    }
+    else
+    {
+        put_le (out, zstd_index_magic, 4);
+        put_le (out, blocks.size () * index_entry_size, 4);
+        for (CompressedBlockInfo const & info : blocks)
+            put_index_entry (out, info);
+
+        put_le (out, zstd_locator_magic, 4);
+        put_le (out, locator_data_size, 4);
+        put_le (out, indexOffset, 8);
+        put_le (out, blocks.size (), 4);
+    }
+
+    return out;
+}
+
+
+//! \return Codec of file starting with 4 bytes at `data`.
+CompressionCodec
+detect_codec (char const * data)
+{
+    if (static_cast<unsigned char>(data[0]) == 0x1F
+        && static_cast<unsigned char>(data[1]) == 0x8B)
+        return CompressionCodec::Gzip;
+    else if (get_le (data, 4) == zstd_block_magic)
+        return CompressionCodec::Zstd;
+    else
+        return CompressionCodec::None;
+}
+
+
+bool
+read_at (std::istream & file, std::uint64_t offset, char * data,
+    std::size_t size)
+{
+    file.clear ();
+    file.seekg (static_cast<std::streamoff>(offset));
+    file.read (data, static_cast<std::streamsize>(size));
+    return static_cast<std::size_t>(file.gcount ()) == size;
+}
+
+
+struct BlockList
+{
+    std::vector<CompressedBlockInfo> blocks;
+    //! End of the last block.
+    std::uint64_t dataEnd = 0;
+    //! True when blocks have been read from the footer.
+    bool indexed = false;
+};
+
+
+//! Reads the list of blocks from the footer.
+//! \return false when the footer is not present or not valid.
+bool
+read_footer (std::istream & file, std::uint64_t fileSize,
+    CompressionCodec codec, BlockList & list)
+{
+    std::size_t const locatorSize = locator_size (codec);
+    if (fileSize < locatorSize)
+        return false;
+
+    std::uint64_t const locatorOffset = fileSize - locatorSize;
+    std::string buffer (locatorSize, '\0');
+    if (! read_at (file, locatorOffset, &buffer[0], locatorSize))
+        return false;
+
+    char const * p = codec == CompressionCodec::Gzip
+        ? parse_gzip_header (buffer.data (), locatorSize, 'L',
+            locator_data_size)
+        : parse_skippable_header (buffer.data (), locatorSize,
+            zstd_locator_magic, locator_data_size);
+    if (! p)
+        return false;
+
+    std::uint64_t const indexOffset = get_le (p, 8);
+    std::uint64_t const count = get_le (p + 8, 4);
+    if (indexOffset > locatorOffset
+        || count * index_entry_size > locatorOffset - indexOffset)
+        return false;
+
+    std::size_t const indexSize
+        = static_cast<std::size_t>(locatorOffset - indexOffset);
+    buffer.assign (indexSize, '\0');
+    if (! read_at (file, indexOffset, &buffer[0], indexSize))
+        return false;
+
+    std::vector<CompressedBlockInfo> blocks;
+    blocks.reserve (static_cast<std::size_t>(count));
+    char const * const end = buffer.data () + indexSize;
+    p = buffer.data ();
+    while (p != end)
+    {
+        std::size_t const left = static_cast<std::size_t>(end - p);
+        std::size_t dataSize;
+        char const * data;
+        if (codec == CompressionCodec::Gzip)
+        {
+            if (left < gzip_extra_offset)
+                return false;
+            dataSize = static_cast<std::size_t>(get_le (p + 14, 2));
+            data = parse_gzip_header (p, left, 'I', dataSize);
+            if (! data || static_cast<std::size_t>(end - data)
+                < dataSize + sizeof (empty_deflate) + gzip_trailer_size)
+                return false;
+            p = data + dataSize + sizeof (empty_deflate) + gzip_trailer_size;
+        }
+        else
+        {
+            if (left < skippable_header_size)
+                return false;
+            dataSize = static_cast<std::size_t>(get_le (p + 4, 4));
+            data = parse_skippable_header (p, left, zstd_index_magic,
+                dataSize);
+            if (! data)
+                return false;
+            p = data + dataSize;
+        }
+
+        if (dataSize % index_entry_size != 0)
+            return false;
+        for (std::size_t i = 0; i != dataSize; i += index_entry_size)
+            blocks.push_back (get_index_entry (data + i));
+    }
+
+    // Blocks must follow each other up to the index.
+    std::uint64_t offset = 0;
+    for (CompressedBlockInfo const & info : blocks)
+    {
+        if (info.offset != offset)
+            return false;
+        offset += info.size;
+    }
+    if (blocks.size () != count || offset != indexOffset)
+        return false;
+
+    list.blocks = std::move (blocks);
+    list.dataEnd = indexOffset;
+    list.indexed = true;
+    return true;
+}
+
+
+//! Reads the list of blocks of `file` from its footer or by walking
+//! from one block to the next one.
+void
+load_blocks (std::istream & file, std::uint64_t fileSize,
+    CompressionCodec codec, BlockList & list)
+{
+    list = BlockList ();
+    if (read_footer (file, fileSize, codec, list))
+        return;
+
+    std::size_t const headerSize = block_header_size (codec);
+    std::string header (headerSize, '\0');
+    std::uint64_t offset = 0;
+    while (offset + headerSize <= fileSize
+        && read_at (file, offset, &header[0], headerSize))
+    {
+        CompressedBlockInfo info;
+        if (! parse_block_header (codec, header.data (), info)
+            || info.size > fileSize - offset)
+            break;
+
+        info.offset = offset;
+        list.blocks.push_back (info);
+        offset += info.size;
+    }
+    list.dataEnd = offset;
+}
+
+
+//! Compression state of BlockCompressedFile. It is used by one
+//! maintenance job at a time.
+class Compressor
+{
+public:
+    Compressor (CompressionCodec codec_, int level_)
+        : codec (codec_)
+        , level (level_)
+    { }
+
+    ~Compressor ()
+    {
+#if defined (LOG4CPLUS_WITH_ZLIB)
+        if (zstream_init)
+            deflateEnd (&zstream);
+#endif
+#if defined (LOG4CPLUS_WITH_ZSTD)
+        ZSTD_freeCCtx (cctx);
+#endif
+    }
+
+    Compressor (Compressor const &) = delete;
+    Compressor & operator = (Compressor const &) = delete;
+
+    //! Appends block with compressed `raw` data to `out`.
+    //! \return false on failure.
+    bool
+    compress (std::string_view raw, Time const & first, Time const & last,
+        std::string & out)
+    {
+        std::size_t const start = out.size ();
+        put_block_header (out, codec, raw.size (), first, last);
+        [[maybe_unused]] std::size_t const dataStart = out.size ();
+        bool ok = false;
+
+        switch (codec)
+        {
+        case CompressionCodec::Gzip:
+#if defined (LOG4CPLUS_WITH_ZLIB)
+        {
+            if (! zstream_init)
+            {
+                std::memset (&zstream, 0, sizeof (zstream));
+                if (deflateInit2 (&zstream, level, Z_DEFLATED, -MAX_WBITS, 8,
+                        Z_DEFAULT_STRATEGY) != Z_OK)
+                    break;
+                zstream_init = true;
+            }
+            else
+                deflateReset (&zstream);
+
+            uLong const bound = deflateBound (&zstream,
+                static_cast<uLong>(raw.size ()));
+            out.resize (dataStart + bound);
+            zstream.next_in = reinterpret_cast<Bytef *>(
+                const_cast<char *>(raw.data ()));
+            zstream.avail_in = static_cast<uInt>(raw.size ());
+            zstream.next_out = reinterpret_cast<Bytef *>(&out[dataStart]);
+            zstream.avail_out = static_cast<uInt>(bound);
+            if (deflate (&zstream, Z_FINISH) != Z_STREAM_END)
+                break;
+
+            out.resize (dataStart + zstream.total_out);
+            uLong const crc = crc32 (crc32 (0, Z_NULL, 0),
+                reinterpret_cast<Bytef const *>(raw.data ()),
+                static_cast<uInt>(raw.size ()));
+            put_le (out, crc, 4);
+            put_le (out, raw.size () & 0xFFFFFFFF, 4);
+            ok = true;
+        }
+#endif
+            break;
+
+        case CompressionCodec::Zstd:
+#if defined (LOG4CPLUS_WITH_ZSTD)
+        {
+            if (! cctx && ! (cctx = ZSTD_createCCtx ()))
+                break;
+
+            std::size_t const bound = ZSTD_compressBound (raw.size ());
+            out.resize (dataStart + bound);
+            // Level 0 selects the default level of the library.
+            std::size_t const size = ZSTD_compressCCtx (cctx,
+                &out[dataStart], bound, raw.data (), raw.size (),
+                level == -1 ? 0 : level);
+            if (ZSTD_isError (size))
+                break;
+
+            out.resize (dataStart + size);
+            ok = true;
+        }
+#endif
+            break;
+
+        case CompressionCodec::None:
+            break;
+        }
+
+        if (! ok)
+        {
+            out.resize (start);
+            return false;
+        }
+
+        store_le (&out[start + block_header_size (codec) - block_data_size],
+            out.size () - start, 4);
+        return true;
+    }
+
+private:
+    CompressionCodec codec;
+    int level;
+#if defined (LOG4CPLUS_WITH_ZLIB)
+    z_stream zstream;
+    bool zstream_init = false;
+#endif
+#if defined (LOG4CPLUS_WITH_ZSTD)
+    ZSTD_CCtx * cctx = nullptr;
+#endif
+};
+
+
+} // namespace
+
+
+bool
+isCompressionSupported (CompressionCodec codec)
+{
+    switch (codec)
+    {
+    case CompressionCodec::None:
+        return true;
+
+    case CompressionCodec::Gzip:
+#if defined (LOG4CPLUS_WITH_ZLIB)
+        return true;
+#else
+        return false;
+#endif
+
+    case CompressionCodec::Zstd:
+#if defined (LOG4CPLUS_WITH_ZSTD)
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    return false;
+}
+
+
+bool
+gzipFile (tstring const & src, tstring const & target, int level)
+{
+    LogLog & loglog = getLogLog ();
+
+#if defined (LOG4CPLUS_WITH_ZLIB)
+    std::ifstream in (std::filesystem::path (src),
+        std::ios_base::in | std::ios_base::binary);
+    if (! in.is_open ())
+    {
+        loglog.error (LOG4CPLUS_TEXT ("gzipFile: Failed to open ") + src);
+        return false;
+    }
+
+    std::ofstream out (std::filesystem::path (target),
+        std::ios_base::out | std::ios_base::trunc | std::ios_base::binary);
+    if (! out.is_open ())
+    {
+        loglog.error (LOG4CPLUS_TEXT ("gzipFile: Failed to open ") + target);
+        return false;
+    }
+
+    z_stream zs;
+    std::memset (&zs, 0, sizeof (zs));
+    // Window bits above 15 select gzip wrapper.
+    if (deflateInit2 (&zs, level, Z_DEFLATED, MAX_WBITS + 16, 8,
+            Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+        loglog.error (LOG4CPLUS_TEXT ("gzipFile: deflateInit2() failed"));
+        return false;
+    }
+
+    std::size_t const chunk = 64 * 1024;
+    std::unique_ptr<char[]> const inBuf (new char[chunk]);
+    std::unique_ptr<char[]> const outBuf (new char[chunk]);
+    int ret = Z_OK;
+    do
+    {
+        in.read (inBuf.get (), chunk);
+        if (in.bad ())
+            break;
+
+        int const flush = in.eof () ? Z_FINISH : Z_NO_FLUSH;
+        zs.next_in = reinterpret_cast<Bytef *>(inBuf.get ());
+        zs.avail_in = static_cast<uInt>(in.gcount ());
+        do
+        {
+            zs.next_out = reinterpret_cast<Bytef *>(outBuf.get ());
+            zs.avail_out = static_cast<uInt>(chunk);
+            ret = deflate (&zs, flush);
+            out.write (outBuf.get (),
+                static_cast<std::streamsize>(chunk - zs.avail_out));
+        }
+        while (zs.avail_out == 0 && out);
+    }
+    while (ret != Z_STREAM_END && out);
+
+    deflateEnd (&zs);
+    out.close ();
+    if (ret != Z_STREAM_END || in.bad () || ! out)
+    {
+        loglog.error (LOG4CPLUS_TEXT ("gzipFile: Failed to compress ") + src
+            + LOG4CPLUS_TEXT (" into ") + target);
+        return false;
+    }
+
+    return true;
+
+#else
+    (void) level;
+    loglog.error (LOG4CPLUS_TEXT ("gzipFile: log4cplus has been built")
+        LOG4CPLUS_TEXT (" without zlib, cannot compress ") + src
+        + LOG4CPLUS_TEXT (" into ") + target);
+    return false;
+
+#endif
+}
+
+
+//
+//
+//
+
+struct BlockCompressedFile::Impl
+{
+    Impl (CompressionCodec codec_, int level, std::size_t blockSize)
+        : codec (codec_)
+        , block_size (blockSize != 0 ? blockSize : default_block_size)
+        , compressor (codec_, level)
+    { }
+
+    //! Compresses `raw` and appends the block to the file. It is
+    //! executed by the maintenance thread.
+    void
+    writeBlock (std::string const & raw, Time const & first,
+        Time const & last)
+    {
+        if (failed)
+            return;
+
+        output.clear ();
+        if (! compressor.compress (raw, first, last, output))
+        {
+            fail (LOG4CPLUS_TEXT ("Failed to compress block of "));
+            return;
+        }
+
+        // Each block is flushed so that readers see whole blocks.
+        file.write (output.data (),
+            static_cast<std::streamsize>(output.size ()));
+        file.flush ();
+        if (! file)
+        {
+            fail (LOG4CPLUS_TEXT ("Failed to write block into "));
+            return;
+        }
+
+        CompressedBlockInfo info;
+        info.offset = data_end;
+        info.size = static_cast<std::uint32_t>(output.size ());
+        info.rawSize = static_cast<std::uint32_t>(raw.size ());
+        info.first = first;
+        info.last = last;
+        blocks.push_back (info);
+
+        data_end += output.size ();
+        written = data_end;
+    }
+
+    void
+    fail (tstring const & msg)
+    {
+        failed = true;
+        getLogLog ().error (LOG4CPLUS_TEXT ("BlockCompressedFile: ") + msg
+            + name);
+    }
+
+    CompressionCodec const codec;
+    std::size_t const block_size;
+    tstring name;
+    std::ofstream file;
+    Compressor compressor;
+    //! Buffer for compressed blocks.
+    std::string output;
+    std::vector<CompressedBlockInfo> blocks;
+    //! End of the last block written into the file.
+    std::uint64_t data_end = 0;
+    //! Copy of `data_end` for size().
+    std::atomic<std::uint64_t> written {0};
+    //! Size of uncompressed data of submitted blocks that have not
+    //! been written yet.
+    std::atomic<std::uint64_t> queued {0};
+    std::atomic<bool> failed {false};
+};
+
+
+BlockCompressedFile::BlockCompressedFile (CompressionCodec codec, int level,
+    std::size_t blockSize)
+    : impl (std::make_unique<Impl> (codec, level, blockSize))
+    , opened (false)
+{ }
+
+
+BlockCompressedFile::~BlockCompressedFile ()
+{
+    close ();
+}
+
+
+bool
+BlockCompressedFile::open (tstring const & name, std::ios_base::openmode mode)
+{
+    close ();
+
+    LogLog & loglog = getLogLog ();
+    impl->name = name;
+    std::filesystem::path const path (name);
+    bool const truncate = (mode & std::ios_base::trunc)
+        && ! (mode & (std::ios_base::app | std::ios_base::ate));
+
+    BlockList list;
+    std::error_code ec;
+    std::uintmax_t const fileSize = truncate
+        ? 0 : std::filesystem::file_size (path, ec);
+    if (! truncate && ! ec && fileSize != 0)
+    {
+        std::ifstream in (path, std::ios_base::in | std::ios_base::binary);
+        char magic[4];
+        if (! read_at (in, 0, magic, sizeof (magic))
+            || detect_codec (magic) != impl->codec)
+        {
+            loglog.error (LOG4CPLUS_TEXT ("BlockCompressedFile: ")
+                LOG4CPLUS_TEXT ("Not a file of the same compression: ")
+                + name);
+            return false;
+        }
+
+        load_blocks (in, fileSize, impl->codec, list);
+        if (list.dataEnd != fileSize)
+        {
+            if (list.blocks.empty () && ! list.indexed)
+            {
+                loglog.error (LOG4CPLUS_TEXT ("BlockCompressedFile: ")
+                    LOG4CPLUS_TEXT ("Not a block compressed file: ") + name);
+                return false;
+            }
+
+            // Remove the footer or an incomplete block.
+            if (! list.indexed)
+                loglog.warn (LOG4CPLUS_TEXT ("BlockCompressedFile: ")
+                    LOG4CPLUS_TEXT ("Removing incomplete block from ")
+                    + name);
+
+            in.close ();
+            std::filesystem::resize_file (path, list.dataEnd, ec);
+            if (ec)
+            {
+                loglog.error (LOG4CPLUS_TEXT ("BlockCompressedFile: ")
+                    LOG4CPLUS_TEXT ("Failed to truncate ") + name
+                    + LOG4CPLUS_TEXT (": ")
+                    + LOG4CPLUS_STRING_TO_TSTRING (ec.message ()));
+                return false;
+            }
+        }
+    }
+
+    impl->file.open (path, std::ios_base::out | std::ios_base::binary
+        | (truncate ? std::ios_base::trunc : std::ios_base::app));
+    if (! impl->file.is_open ())
+    {
+        impl->file.clear ();
+        return false;
+    }
+
+    impl->blocks = std::move (list.blocks);
+    impl->data_end = list.dataEnd;
+    impl->written = list.dataEnd;
+    impl->queued = 0;
+    impl->failed = false;
+    block.clear ();
+    block.reserve (impl->block_size);
+    opened = true;
+    return true;
+}
+
+
+void
+BlockCompressedFile::close ()
+{
+    if (! opened)
+        return;
+
+    wait ();
+    if (! impl->failed)
+    {
+        std::string const footer (
+            make_footer (impl->codec, impl->blocks, impl->data_end));
+        impl->file.write (footer.data (),
+            static_cast<std::streamsize>(footer.size ()));
+        impl->file.flush ();
+        if (! impl->file)
+            impl->fail (LOG4CPLUS_TEXT ("Failed to write footer into "));
+    }
+
+    impl->file.close ();
+    impl->file.clear ();
+    impl->blocks.clear ();
+    impl->data_end = 0;
+    impl->written = 0;
+    impl->failed = false;
+    opened = false;
+}
+
+
+bool
+BlockCompressedFile::is_open () const
+{
+    return opened;
+}
+
+
+bool
+BlockCompressedFile::good () const
+{
+    return opened && ! impl->failed;
+}
+
+
+void
+BlockCompressedFile::write (std::string_view record, Time const & timestamp)
+{
+    if (! good ())
+        return;
+
+    // Records of asynchronous appenders need not be ordered.
+    if (block.empty ())
+        block_first = block_last = timestamp;
+    else
+    {
+        block_first = (std::min) (block_first, timestamp);
+        block_last = (std::max) (block_last, timestamp);
+    }
+
+    block.append (record);
+    if (block.size () >= impl->block_size)
+        submitBlock ();
+}
+
+
+void
+BlockCompressedFile::flush ()
+{
+    if (good ())
+        submitBlock ();
+}
+
+
+bool
+BlockCompressedFile::wait ()
+{
+    flush ();
+    if (! pending.empty ())
+    {
+        waitForMaintenanceJob (pending.back ());
+        pending.clear ();
+    }
+
+    return good ();
+}
+
+
+std::uint64_t
+BlockCompressedFile::size () const
+{
+    return impl->written + impl->queued + block.size ();
+}
+
+
+void
+BlockCompressedFile::submitBlock ()
+{
+    if (block.empty ())
+        return;
+
+    while (pending.size () >= max_pending_blocks)
+    {
+        waitForMaintenanceJob (pending.front ());
+        pending.pop_front ();
+    }
+
+    impl->queued += block.size ();
+    pending.push_back (queueMaintenanceJob (
+        [impl = impl.get (), raw = std::move (block),
+            first = block_first, last = block_last]
+        {
+            impl->writeBlock (raw, first, last);
+            impl->queued -= raw.size ();
+        }));
+
+    block = std::string ();
+    block.reserve (impl->block_size);
+}
+
+
+//
+//
+//
+
+struct BlockCompressedReader::Impl
+{
+    ~Impl ()
+    {
+#if defined (LOG4CPLUS_WITH_ZLIB)
+        if (zstream_init)
+            inflateEnd (&zstream);
+#endif
+    }
+
+    //! Decompresses block in `buffer` described by `info`.
+    bool
+    decompress (CompressedBlockInfo const & info, std::string & out)
+    {
+        std::size_t const headerSize = block_header_size (codec);
+        [[maybe_unused]] char const * const data
+            = buffer.data () + headerSize;
+        [[maybe_unused]] std::size_t const size
+            = info.size - headerSize - block_trailer_size (codec);
+        std::size_t const start = out.size ();
+        out.resize (start + info.rawSize);
+        bool ok = false;
+
+        switch (codec)
+        {
+        case CompressionCodec::Gzip:
+#if defined (LOG4CPLUS_WITH_ZLIB)
+        {
+            if (! zstream_init)
+            {
+                std::memset (&zstream, 0, sizeof (zstream));
+                if (inflateInit2 (&zstream, -MAX_WBITS) != Z_OK)
+                    break;
+                zstream_init = true;
+            }
+            else
+                inflateReset (&zstream);
+
+            zstream.next_in = reinterpret_cast<Bytef *>(
+                const_cast<char *>(data));
+            zstream.avail_in = static_cast<uInt>(size);
+            zstream.next_out = reinterpret_cast<Bytef *>(&out[start]);
+            zstream.avail_out = info.rawSize;
+            if (inflate (&zstream, Z_FINISH) != Z_STREAM_END
+                || zstream.total_out != info.rawSize)
+                break;
+
+            uLong const crc = crc32 (crc32 (0, Z_NULL, 0),
+                reinterpret_cast<Bytef const *>(&out[start]), info.rawSize);
+            ok = get_le (data + size, 4) == crc;
+        }
+#endif
+            break;
+
+        case CompressionCodec::Zstd:
+#if defined (LOG4CPLUS_WITH_ZSTD)
+            ok = ZSTD_decompress (&out[start], info.rawSize, data, size)
+                == info.rawSize;
+#endif
+            break;
+
+        case CompressionCodec::None:
+            break;
+        }
+
+        if (! ok)
+            out.resize (start);
+        return ok;
+    }
+
+    std::ifstream file;
+    CompressionCodec codec = CompressionCodec::None;
+    BlockList list;
+    //! Buffer for compressed blocks.
+    std::string buffer;
+#if defined (LOG4CPLUS_WITH_ZLIB)
+    z_stream zstream;
+    bool zstream_init = false;
+#endif
+};
+
+
+BlockCompressedReader::BlockCompressedReader ()
+    : impl (std::make_unique<Impl> ())
+{ }
+
+
+BlockCompressedReader::~BlockCompressedReader ()
+{ }
+
+
+bool
+BlockCompressedReader::open (tstring const & name)
+{
+    close ();
+
+    std::filesystem::path const path (name);
+    std::error_code ec;
+    std::uintmax_t const fileSize = std::filesystem::file_size (path, ec);
+    if (ec)
+        return false;
+
+    impl->file.open (path, std::ios_base::in | std::ios_base::binary);
+    char magic[4];
+    if (! read_at (impl->file, 0, magic, sizeof (magic)))
+        return false;
+
+    impl->codec = detect_codec (magic);
+    if (impl->codec == CompressionCodec::None
+        || ! isCompressionSupported (impl->codec))
+    {
+        close ();
+        return false;
+    }
+
+    load_blocks (impl->file, fileSize, impl->codec, impl->list);
+    return true;
+}
+
+
+void
+BlockCompressedReader::close ()
+{
+    impl->file.close ();
+    impl->file.clear ();
+    impl->codec = CompressionCodec::None;
+    impl->list = BlockList ();
+}
+
+
+CompressionCodec
+BlockCompressedReader::codec () const
+{
+    return impl->codec;
+}
+
+
+bool
+BlockCompressedReader::indexed () const
+{
+    return impl->list.indexed;
+}
+
+
+std::vector<CompressedBlockInfo> const &
+BlockCompressedReader::blocks () const
+{
+    return impl->list.blocks;
+}
+
+
+bool
+BlockCompressedReader::readBlock (CompressedBlockInfo const & block,
+    std::string & out)
+{
+    if (impl->codec == CompressionCodec::None)
+        return false;
+
+    // Check the block header in case the file has changed.
+    impl->buffer.resize (block.size);
+    CompressedBlockInfo info;
+    if (block.size < block_header_size (impl->codec)
+        || ! read_at (impl->file, block.offset, &impl->buffer[0], block.size)
+        || ! parse_block_header (impl->codec, impl->buffer.data (), info)
+        || info.size != block.size
+        || info.rawSize != block.rawSize)
+        return false;
+
+    return impl->decompress (info, out);
+}
+
+
+bool
+BlockCompressedReader::readRange (Time const & from, Time const & to,
+    std::string & out)
+{
+    for (CompressedBlockInfo const & block : impl->list.blocks)
+        if (block.last >= from && block.first <= to
+            && ! readBlock (block, out))
+            return false;
+
+    return true;
+}
+
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS) && defined (LOG4CPLUS_WITH_ZLIB)
+CATCH_TEST_CASE ("BlockCompressedFile", "[compression]")
+{
+    tstring const fileName (LOG4CPLUS_TEXT ("compressed_file_test.log.gz"));
+    std::filesystem::path const path (fileName);
+    Time const start = from_time_t (1000000);
+    auto record = [] (int i) {
+        return "record " + std::to_string (i) + "\n";
+    };
+    auto write_records = [&] (BlockCompressedFile & file, int first,
+        int count) {
+        for (int i = first; i != first + count; ++i)
+            file.write (record (i), start + chrono::seconds (i));
+    };
+    auto expected = [&] (int first, int count) {
+        std::string str;
+        for (int i = first; i != first + count; ++i)
+            str += record (i);
+        return str;
+    };
+    auto read_all = [] (BlockCompressedReader & reader) {
+        std::string str;
+        for (CompressedBlockInfo const & info : reader.blocks ())
+            CATCH_REQUIRE (reader.readBlock (info, str));
+        return str;
+    };
+
+    std::filesystem::remove (path);
+    int const count = 10000;
+
+    CATCH_SECTION ("round trip")
+    {
+        BlockCompressedFile file (CompressionCodec::Gzip, -1, 4096);
+        CATCH_REQUIRE (file.open (fileName, std::ios_base::trunc));
+        write_records (file, 0, count);
+        file.close ();
+
+        BlockCompressedReader reader;
+        CATCH_REQUIRE (reader.open (fileName));
+        CATCH_REQUIRE (reader.codec () == CompressionCodec::Gzip);
+        CATCH_REQUIRE (reader.indexed ());
+        CATCH_REQUIRE (reader.blocks ().size () > 10);
+        CATCH_REQUIRE (read_all (reader) == expected (0, count));
+
+        // Only blocks of the time range are decompressed.
+        std::string range;
+        CATCH_REQUIRE (reader.readRange (start + chrono::seconds (5000),
+            start + chrono::seconds (5009), range));
+        CATCH_REQUIRE (range.size () < 3 * 4096);
+        CATCH_REQUIRE (range.find (expected (5000, 10)) != std::string::npos);
+        CATCH_REQUIRE (range.find (record (1000)) == std::string::npos);
+    }
+
+    CATCH_SECTION ("append")
+    {
+        {
+            BlockCompressedFile file (CompressionCodec::Gzip, 1, 4096);
+            CATCH_REQUIRE (file.open (fileName, std::ios_base::trunc));
+            write_records (file, 0, count);
+        }
+        {
+            BlockCompressedFile file (CompressionCodec::Gzip, 1, 4096);
+            CATCH_REQUIRE (file.open (fileName, std::ios_base::app));
+            write_records (file, count, count);
+        }
+
+        BlockCompressedReader reader;
+        CATCH_REQUIRE (reader.open (fileName));
+        CATCH_REQUIRE (reader.indexed ());
+        CATCH_REQUIRE (read_all (reader) == expected (0, 2 * count));
+    }
+
+    CATCH_SECTION ("missing footer")
+    {
+        BlockCompressedFile file (CompressionCodec::Gzip, -1, 4096);
+        CATCH_REQUIRE (file.open (fileName, std::ios_base::trunc));
+        write_records (file, 0, count);
+        CATCH_REQUIRE (file.wait ());
+        std::uint64_t const size = file.size ();
+        file.close ();
+
+        // Cut the footer and a part of the last block.
+        std::filesystem::resize_file (path, size - 10);
+        BlockCompressedReader reader;
+        CATCH_REQUIRE (reader.open (fileName));
+        CATCH_REQUIRE (! reader.indexed ());
+        std::size_t const blocks = reader.blocks ().size ();
+        CATCH_REQUIRE (blocks > 10);
+        std::string const data (read_all (reader));
+        CATCH_REQUIRE (expected (0, count).compare (0, data.size (), data)
+            == 0);
+        reader.close ();
+
+        // Appending cuts off the incomplete block.
+        CATCH_REQUIRE (file.open (fileName, std::ios_base::app));
+        write_records (file, count, 1);
+        file.close ();
+        CATCH_REQUIRE (reader.open (fileName));
+        CATCH_REQUIRE (reader.indexed ());
+        CATCH_REQUIRE (reader.blocks ().size () == blocks + 1);
+        CATCH_REQUIRE (read_all (reader) == data + record (count));
+    }
+
+    CATCH_SECTION ("foreign file")
+    {
+        {
+            std::ofstream plain (path);
+            plain << "plain text\n";
+        }
+        BlockCompressedFile file (CompressionCodec::Gzip);
+        CATCH_REQUIRE (! file.open (fileName, std::ios_base::app));
+        CATCH_REQUIRE (std::filesystem::file_size (path) == 11);
+    }
+
+    std::filesystem::remove (path);
+}
+
+
+CATCH_TEST_CASE ("gzipFile", "[compression]")
+{
+    tstring const src (LOG4CPLUS_TEXT ("gzip_file_test.log"));
+    tstring const target (src + LOG4CPLUS_TEXT (".gz"));
+    std::string expected;
+    for (int i = 0; i != 100000; ++i)
+        expected += "line " + std::to_string (i) + "\n";
+    {
+        std::ofstream out (std::filesystem::path (src), std::ios_base::binary);
+        out << expected;
+    }
+
+    CATCH_REQUIRE (gzipFile (src, target));
+    CATCH_REQUIRE (std::filesystem::file_size (target) < expected.size ());
+
+    gzFile gz = gzopen (LOG4CPLUS_TSTRING_TO_STRING (target).c_str (), "rb");
+    CATCH_REQUIRE (gz != nullptr);
+    std::string data (expected.size () + 1, '\0');
+    int const read = gzread (gz, data.data (),
+        static_cast<unsigned>(data.size ()));
+    gzclose (gz);
+    CATCH_REQUIRE (read == static_cast<int>(expected.size ()));
+    data.resize (static_cast<std::size_t>(read));
+    CATCH_REQUIRE (data == expected);
+
+    std::filesystem::remove (std::filesystem::path (src));
+    std::filesystem::remove (std::filesystem::path (target));
+    CATCH_REQUIRE (! gzipFile (src, target));
+}
+#endif
+
+
+} // namespace log4cplus::helpers
@@ -206,6 +206,23 @@ PropertyConfigurator::configure()
     if (properties.getUInt (queue_size_limit, LOG4CPLUS_TEXT ("threadPoolQueueSizeLimit")))
         setThreadPoolQueueSizeLimit ((std::max) (queue_size_limit, 100u));
 
+    tstring event_clock;
+    if (properties.getString (event_clock, LOG4CPLUS_TEXT ("eventClock")))
+    {
+        event_clock = helpers::toUpper (event_clock);
+        if (event_clock == LOG4CPLUS_TEXT ("PRECISE"))
+            helpers::setEventClock (helpers::EventClock::Precise);
+        else if (event_clock == LOG4CPLUS_TEXT ("COARSE"))
+            helpers::setEventClock (helpers::EventClock::Coarse);
+        else if (event_clock == LOG4CPLUS_TEXT ("TSC"))
+            helpers::setEventClock (helpers::EventClock::TSC);
+        else
+            helpers::getLogLog ().warn (
+                LOG4CPLUS_TEXT ("PropertyConfigurator::configure()")
+                LOG4CPLUS_TEXT ("- \"eventClock\" not valid: ")
+                + event_clock);
+    }
+
     configureAppenders();
     configureLoggers();
     configureAdditivity();
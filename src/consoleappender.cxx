@@ -78,6 +78,13 @@ ConsoleAppender::ConsoleAppender(const helpers::Properties & properties)
         // we need to flash immediately if non-default locale is used
         immediateFlush = true;
     }
+
+    unsigned long maxFlushDelay = 0;
+    properties.getULong (maxFlushDelay, LOG4CPLUS_TEXT("MaxFlushDelay"));
+    if (maxFlushDelay != 0 && ! immediateFlush)
+        flusher = std::make_unique<helpers::DelayedFlusher> (
+            static_cast<helpers::IDelayedFlushClient &>(*this),
+            std::chrono::milliseconds (maxFlushDelay));
 }
 
 
@@ -123,10 +130,29 @@ ConsoleAppender::append(const spi::InternalLoggingEvent& event)
     if(immediateFlush) {
         output.flush();
     }
+    else if (flusher)
+        flusher->written ();
     if (locale != nullptr) {
         output.imbue(cur_loc);
     }
 }
 
 
+
+thread::Mutex const &
+ConsoleAppender::dfcGetAccessMutex () const
+{
+    return access_mutex;
+}
+
+
+void
+ConsoleAppender::dfcFlush ()
+{
+    thread::MutexGuard guard (getOutputMutex ());
+
+    (logToStdErr ? tcerr : tcout).flush ();
+}
+
+
 } // namespace log4cplus
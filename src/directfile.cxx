@@ -0,0 +1,859 @@
+// -*- C++ -*-
+//
+//  Copyright (C) 2026, Vaclav Haisman. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_HAVE_SYS_TYPES_H)
+#include <sys/types.h>
+#endif
+#if defined (LOG4CPLUS_HAVE_SYS_STAT_H)
+#include <sys/stat.h>
+#endif
+#if defined (LOG4CPLUS_HAVE_SYS_UIO_H)
+#include <sys/uio.h>
+#endif
+#if defined (LOG4CPLUS_HAVE_UNISTD_H)
+#include <unistd.h>
+#endif
+#if defined (LOG4CPLUS_HAVE_FCNTL_H)
+#include <fcntl.h>
+#endif
+#if defined (LOG4CPLUS_HAVE_IO_H)
+#include <io.h>
+#endif
+#if defined (LOG4CPLUS_ENABLE_IO_URING)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+#include <log4cplus/helpers/directfile.h>
+#include <log4cplus/helpers/loglog.h>
+#include <log4cplus/helpers/stringhelper.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+
+
+namespace log4cplus::helpers {
+
+
+namespace
+{
+
+#if defined (_WIN32)
+int const OPEN_FLAGS = _O_WRONLY | _O_CREAT | _O_APPEND | _O_NOINHERIT;
+int const OPEN_MODE = _S_IREAD | _S_IWRITE;
+
+#else
+int const OPEN_FLAGS = O_WRONLY | O_CREAT | O_APPEND
+#if defined (O_CLOEXEC)
+    | O_CLOEXEC
+#endif
+    ;
+
+// Same permissions as std::ofstream would use, subject to umask.
+mode_t const OPEN_MODE = S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP
+    | S_IROTH | S_IWOTH;
+
+#endif
+
+
+static
+std::uint64_t
+get_file_size (int fd)
+{
+#if defined (_WIN32)
+    struct _stati64 st;
+    if (_fstati64 (fd, &st) == -1)
+        return 0;
+
+#else
+    struct stat st;
+    if (fstat (fd, &st) == -1)
+        return 0;
+
+#endif
+
+    return static_cast<std::uint64_t>(st.st_size);
+}
+
+
+//! Writes at most `size` bytes, retrying on EINTR.
+//! \return Number of bytes written or -1.
+static
+long long
+write_some (int fd, char const * data, std::size_t size)
+{
+    for (;;)
+    {
+#if defined (_WIN32)
+        int ret = _write (fd, data, static_cast<unsigned>(
+            (std::min<std::size_t>) (size, INT_MAX)));
+
+#else
+        ssize_t ret = ::write (fd, data, size);
+
+#endif
+        if (ret == -1 && errno == EINTR)
+            continue;
+
+        return ret;
+    }
+}
+
+
+//! Writes at most `size1` + `size2` bytes from two buffers in one
+//! system call where possible, retrying on EINTR.
+//! \return Number of bytes written or -1.
+static
+long long
+write_some (int fd, char const * data1, std::size_t size1,
+    char const * data2, std::size_t size2)
+{
+#if defined (LOG4CPLUS_HAVE_SYS_UIO_H)
+    struct iovec iov[2];
+    iov[0].iov_base = const_cast<char *>(data1);
+    iov[0].iov_len = size1;
+    iov[1].iov_base = const_cast<char *>(data2);
+    iov[1].iov_len = size2;
+
+    for (;;)
+    {
+        ssize_t ret = ::writev (fd, iov, 2);
+        if (ret == -1 && errno == EINTR)
+            continue;
+
+        return ret;
+    }
+
+#else
+    // Without writev() the first buffer is written alone. The caller
+    // loops until everything is written.
+    return write_some (fd, data1, size1);
+
+#endif
+}
+
+} // namespace
+
+
+#if defined (LOG4CPLUS_ENABLE_IO_URING)
+//! io_uring instance with its rings mapped into the process and the
+//! buffers used for writes. The raw system call interface is used so
+//! that there is no dependency on liburing.
+struct DirectFile::IoUring
+{
+    IoUring () = default;
+    IoUring (IoUring const &) = delete;
+    IoUring & operator = (IoUring const &) = delete;
+
+    ~IoUring ()
+    {
+        if (sqes != MAP_FAILED)
+            munmap (sqes, sqes_size);
+        if (cq_ptr != MAP_FAILED && cq_ptr != sq_ptr)
+            munmap (cq_ptr, cq_size);
+        if (sq_ptr != MAP_FAILED)
+            munmap (sq_ptr, sq_size);
+        if (ring_fd != -1)
+            ::close (ring_fd);
+    }
+
+    //! \return 0 or error code.
+    int setup (std::size_t buffer_size);
+
+    int
+    enter (unsigned to_submit, unsigned min_complete, unsigned flags)
+    {
+        return static_cast<int>(syscall (__NR_io_uring_enter, ring_fd,
+            to_submit, min_complete, flags, nullptr, 0));
+    }
+
+    char *
+    bufferData (unsigned index) const
+    {
+        return memory.get () + index * size;
+    }
+
+    int ring_fd = -1;
+    unsigned features = 0;
+    bool fixed_buffers = false;
+
+    void * sq_ptr = MAP_FAILED;
+    std::size_t sq_size = 0;
+    void * cq_ptr = MAP_FAILED;
+    std::size_t cq_size = 0;
+    io_uring_sqe * sqes = static_cast<io_uring_sqe *>(MAP_FAILED);
+    std::size_t sqes_size = 0;
+
+    unsigned * sq_tail = nullptr;
+    unsigned * sq_mask = nullptr;
+    unsigned * sq_array = nullptr;
+    unsigned * cq_head = nullptr;
+    unsigned * cq_tail = nullptr;
+    unsigned * cq_mask = nullptr;
+    io_uring_cqe * cqes = nullptr;
+
+    std::unique_ptr<char[]> memory;
+    std::size_t size = 0;
+    //! Length of write in flight for each buffer, 0 for free buffers.
+    std::size_t lengths[io_uring_buffers] = { };
+    unsigned in_flight = 0;
+    unsigned current = 0;
+};
+
+
+int
+DirectFile::IoUring::setup (std::size_t buffer_size)
+{
+    io_uring_params params;
+    std::memset (&params, 0, sizeof (params));
+    ring_fd = static_cast<int>(syscall (__NR_io_uring_setup,
+        io_uring_buffers, &params));
+    if (ring_fd == -1)
+        return errno;
+
+    features = params.features;
+
+    sq_size = params.sq_off.array + params.sq_entries * sizeof (unsigned);
+    cq_size = params.cq_off.cqes + params.cq_entries * sizeof (io_uring_cqe);
+    if (features & IORING_FEAT_SINGLE_MMAP)
+        sq_size = cq_size = (std::max) (sq_size, cq_size);
+
+    sq_ptr = mmap (nullptr, sq_size, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+    if (sq_ptr == MAP_FAILED)
+        return errno;
+
+    if (features & IORING_FEAT_SINGLE_MMAP)
+        cq_ptr = sq_ptr;
+    else
+    {
+        cq_ptr = mmap (nullptr, cq_size, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+        if (cq_ptr == MAP_FAILED)
+            return errno;
+    }
+
+    sqes_size = params.sq_entries * sizeof (io_uring_sqe);
+    void * sqes_ptr = mmap (nullptr, sqes_size, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+    if (sqes_ptr == MAP_FAILED)
+        return errno;
+    sqes = static_cast<io_uring_sqe *>(sqes_ptr);
+
+    char * sq = static_cast<char *>(sq_ptr);
+    sq_tail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    sq_mask = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    sq_array = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+
+    char * cq = static_cast<char *>(cq_ptr);
+    cq_head = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    cq_tail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    cq_mask = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+
+    size = buffer_size;
+    memory.reset (new char[io_uring_buffers * size]);
+
+    // Registered buffers save mapping of the pages for each write but
+    // they count against RLIMIT_MEMLOCK on older kernels. Plain writes
+    // from the same buffers are used when the registration fails.
+    iovec iov[io_uring_buffers];
+    for (unsigned i = 0; i != io_uring_buffers; ++i)
+    {
+        iov[i].iov_base = bufferData (i);
+        iov[i].iov_len = size;
+    }
+    fixed_buffers = syscall (__NR_io_uring_register, ring_fd,
+        IORING_REGISTER_BUFFERS, iov, io_uring_buffers) == 0;
+
+    return 0;
+}
+
+#else
+struct DirectFile::IoUring
+{ };
+
+#endif
+
+
+DirectFile::DirectFile ()
+    : file_fd (-1)
+    , last_error (0)
+    , buffer_size (default_buffer_size)
+    , file_size (0)
+    , os (this)
+{ }
+
+
+DirectFile::~DirectFile ()
+{
+    close ();
+}
+
+
+bool
+DirectFile::open (tstring const & name, std::ios_base::openmode mode)
+{
+    close ();
+
+    int flags = OPEN_FLAGS;
+#if defined (LOG4CPLUS_ENABLE_IO_URING)
+    // Writes submitted through io_uring carry their offsets.
+    if (uring)
+        flags &= ~O_APPEND;
+#endif
+    if ((mode & std::ios_base::trunc)
+        && ! (mode & (std::ios_base::app | std::ios_base::ate)))
+#if defined (_WIN32)
+        flags |= _O_TRUNC;
+#else
+        flags |= O_TRUNC;
+#endif
+
+#if defined (_WIN32)
+    text_mode = ! (mode & std::ios_base::binary);
+    added_crs = 0;
+    flags |= text_mode ? _O_TEXT : _O_BINARY;
+#  if defined (UNICODE)
+    file_fd = _wopen (name.c_str (), flags, OPEN_MODE);
+#  else
+    file_fd = _open (name.c_str (), flags, OPEN_MODE);
+#  endif
+
+#else
+    do
+        file_fd = ::open (LOG4CPLUS_TSTRING_TO_STRING (name).c_str (), flags,
+            OPEN_MODE);
+    while (file_fd == -1 && errno == EINTR);
+
+#endif
+
+    if (file_fd == -1)
+    {
+        last_error = errno;
+        return false;
+    }
+
+    if (uring)
+        // io_uring buffer is acquired on first write.
+        setp (nullptr, nullptr);
+    else
+    {
+        if (! buffer)
+            buffer.reset (new char[buffer_size]);
+        setp (buffer.get (), buffer.get () + buffer_size);
+    }
+
+    file_size = get_file_size (file_fd);
+    return true;
+}
+
+
+void
+DirectFile::close ()
+{
+    if (file_fd != -1)
+    {
+        wait ();
+#if defined (_WIN32)
+        _close (file_fd);
+#else
+        ::close (file_fd);
+#endif
+        file_fd = -1;
+    }
+
+    setp (nullptr, nullptr);
+    last_error = 0;
+    file_size = 0;
+#if defined (_WIN32)
+    added_crs = 0;
+#endif
+    os.clear ();
+}
+
+
+bool
+DirectFile::is_open () const
+{
+    return file_fd != -1;
+}
+
+
+bool
+DirectFile::good () const
+{
+    return file_fd != -1 && last_error == 0;
+}
+
+
+int
+DirectFile::error () const
+{
+    return last_error;
+}
+
+
+void
+DirectFile::setBufferSize (std::size_t size)
+{
+    if (size == 0)
+        size = default_buffer_size;
+
+    // Put area offsets are int.
+    size = (std::min<std::size_t>) (size, INT_MAX);
+
+    if (size == buffer_size && (buffer || uring))
+        return;
+
+    wait ();
+    buffer_size = size;
+    if (uring)
+    {
+        // Set up the ring again with new buffers.
+        buffer.reset ();
+        setp (nullptr, nullptr);
+        uring.reset ();
+        setIoUring (true);
+    }
+    else
+    {
+        buffer.reset (new char[size]);
+        if (is_open ())
+            setp (buffer.get (), buffer.get () + buffer_size);
+    }
+}
+
+
+bool
+DirectFile::setIoUring (bool enable)
+{
+    if (enable == usingIoUring ())
+        return enable;
+
+    wait ();
+
+#if defined (LOG4CPLUS_ENABLE_IO_URING)
+    if (enable)
+    {
+        auto new_uring = std::make_unique<IoUring> ();
+        if (int ret = new_uring->setup (buffer_size); ret != 0)
+        {
+            getLogLog ().warn (
+                LOG4CPLUS_TEXT ("io_uring is not available, error ")
+                + convertIntegerToString (ret)
+                + LOG4CPLUS_TEXT ("; using synchronous writes"));
+            return false;
+        }
+
+        if (int const ret = is_open () ? setAppendMode (false) : 0;
+            ret != 0)
+        {
+            getLogLog ().warn (
+                LOG4CPLUS_TEXT ("Failed to clear O_APPEND, error ")
+                + convertIntegerToString (ret)
+                + LOG4CPLUS_TEXT ("; using synchronous writes"));
+            return false;
+        }
+
+        uring = std::move (new_uring);
+        buffer.reset ();
+        setp (nullptr, nullptr);
+        return true;
+    }
+
+#else
+    if (enable)
+    {
+        getLogLog ().warn (
+            LOG4CPLUS_TEXT ("io_uring support is not compiled in;")
+            LOG4CPLUS_TEXT (" using synchronous writes"));
+        return false;
+    }
+
+#endif
+
+    uring.reset ();
+    if (is_open ())
+    {
+#if defined (LOG4CPLUS_ENABLE_IO_URING)
+        // Writes through io_uring have not moved the file position.
+        if (int const ret = setAppendMode (true); ret != 0)
+            last_error = ret;
+#endif
+        buffer.reset (new char[buffer_size]);
+        setp (buffer.get (), buffer.get () + buffer_size);
+    }
+
+    return false;
+}
+
+
+bool
+DirectFile::usingIoUring () const
+{
+    return !! uring;
+}
+
+
+void
+DirectFile::write (char const * data, std::size_t size)
+{
+    if (! good ())
+        return;
+
+#if defined (_WIN32)
+    if (text_mode)
+        added_crs += static_cast<std::uint64_t>(
+            std::count (data, data + size, '\n'));
+#endif
+
+    if (size <= static_cast<std::size_t>(epptr () - pptr ()))
+    {
+        std::memcpy (pptr (), data, size);
+        pbump (static_cast<int>(size));
+        return;
+    }
+
+    drain (data, size);
+}
+
+
+bool
+DirectFile::flush ()
+{
+    if (pptr () != pbase () && good ())
+    {
+#if defined (LOG4CPLUS_ENABLE_IO_URING)
+        if (uring)
+            submitIoUring ();
+        else
+#endif
+            drain (nullptr, 0);
+    }
+
+    return good ();
+}
+
+
+bool
+DirectFile::wait ()
+{
+    flush ();
+
+#if defined (LOG4CPLUS_ENABLE_IO_URING)
+    if (uring)
+        while (uring->in_flight != 0 && reapIoUring (true))
+            ;
+#endif
+
+    return good ();
+}
+
+
+void
+DirectFile::seekToEnd ()
+{
+    if (! wait ())
+        return;
+
+    file_size = get_file_size (file_fd);
+#if defined (_WIN32)
+    added_crs = 0;
+#endif
+}
+
+
+std::uint64_t
+DirectFile::size () const
+{
+    std::uint64_t const size
+        = file_size + static_cast<std::uint64_t>(pptr () - pbase ());
+#if defined (_WIN32)
+    return size + added_crs;
+#else
+    return size;
+#endif
+}
+
+
+int
+DirectFile::fd () const
+{
+    return file_fd;
+}
+
+
+DirectFile::int_type
+DirectFile::overflow (int_type c)
+{
+    if (! good ())
+        return traits_type::eof ();
+
+    if (traits_type::eq_int_type (c, traits_type::eof ()))
+        return flush () ? traits_type::not_eof (c) : traits_type::eof ();
+
+    char const ch = traits_type::to_char_type (c);
+#if defined (_WIN32)
+    if (text_mode && ch == '\n')
+        ++added_crs;
+#endif
+    return drain (&ch, 1) ? c : traits_type::eof ();
+}
+
+
+std::streamsize
+DirectFile::xsputn (char const * s, std::streamsize n)
+{
+    write (s, static_cast<std::size_t>(n));
+    return good () ? n : 0;
+}
+
+
+int
+DirectFile::sync ()
+{
+    return flush () ? 0 : -1;
+}
+
+
+//! Writes out buffered data followed by `size` bytes of `data`.
+bool
+DirectFile::drain (char const * data, std::size_t size)
+{
+#if defined (LOG4CPLUS_ENABLE_IO_URING)
+    if (uring)
+        return drainIoUring (data, size);
+#endif
+
+    char const * head = pbase ();
+    std::size_t head_size = static_cast<std::size_t>(pptr () - pbase ());
+    setp (pbase (), epptr ());
+
+    while (head_size + size != 0)
+    {
+        long long ret;
+        if (head_size != 0 && size != 0)
+            ret = write_some (file_fd, head, head_size, data, size);
+        else if (head_size != 0)
+            ret = write_some (file_fd, head, head_size);
+        else
+            ret = write_some (file_fd, data, size);
+
+        if (ret <= 0)
+        {
+            last_error = ret == 0 ? EIO : errno;
+            return false;
+        }
+
+        std::size_t written = static_cast<std::size_t>(ret);
+        file_size += written;
+        std::size_t const from_head = (std::min) (written, head_size);
+        head += from_head;
+        head_size -= from_head;
+        written -= from_head;
+        data += written;
+        size -= written;
+    }
+
+    return true;
+}
+
+
+#if defined (LOG4CPLUS_ENABLE_IO_URING)
+//! Sets or clears `O_APPEND` of the open file.
+//! \return Zero or `errno` value.
+int
+DirectFile::setAppendMode (bool append)
+{
+    int const flags = fcntl (file_fd, F_GETFL);
+    if (flags == -1
+        || fcntl (file_fd, F_SETFL,
+            append ? flags | O_APPEND : flags & ~O_APPEND) == -1)
+        return errno;
+
+    return 0;
+}
+
+
+//! Submits buffered data and puts `size` bytes of `data` into
+//! following buffers, submitting them as they fill up.
+bool
+DirectFile::drainIoUring (char const * data, std::size_t size)
+{
+    if (pptr () != pbase () && ! submitIoUring ())
+        return false;
+
+    while (size != 0)
+    {
+        if (! pbase () && ! acquireIoUringBuffer ())
+            return false;
+
+        std::size_t const n = (std::min) (size,
+            static_cast<std::size_t>(epptr () - pptr ()));
+        std::memcpy (pptr (), data, n);
+        pbump (static_cast<int>(n));
+        data += n;
+        size -= n;
+
+        if (size != 0 && ! submitIoUring ())
+            return false;
+    }
+
+    return true;
+}
+
+
+//! Submits write of the current buffer. The put area is reset and a
+//! free buffer is acquired by the next write.
+bool
+DirectFile::submitIoUring ()
+{
+    IoUring & ring = *uring;
+    std::size_t const length = static_cast<std::size_t>(pptr () - pbase ());
+    setp (nullptr, nullptr);
+
+    unsigned const tail = *ring.sq_tail;
+    unsigned const index = tail & *ring.sq_mask;
+    io_uring_sqe & sqe = ring.sqes[index];
+    std::memset (&sqe, 0, sizeof (sqe));
+    sqe.opcode = ring.fixed_buffers ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+    sqe.fd = file_fd;
+    sqe.addr = reinterpret_cast<std::uint64_t>(
+        ring.bufferData (ring.current));
+    sqe.len = static_cast<std::uint32_t>(length);
+    // Writes to the same file can complete out of order, e.g., when
+    // an earlier one is punted to a kernel worker and a later one
+    // completes inline. Each write therefore goes to its own offset
+    // past the previous ones, instead of ordering the writes with
+    // IOSQE_IO_DRAIN, which would serialize the ring.
+    sqe.off = file_size;
+    sqe.buf_index = static_cast<std::uint16_t>(ring.current);
+    sqe.user_data = ring.current;
+    ring.sq_array[index] = index;
+    std::atomic_ref<unsigned> (*ring.sq_tail).store (tail + 1,
+        std::memory_order_release);
+
+    int ret;
+    do
+        ret = ring.enter (1, 0, 0);
+    while (ret == -1 && errno == EINTR);
+
+    if (ret != 1)
+    {
+        last_error = ret == -1 ? errno : EIO;
+        return false;
+    }
+
+    ring.lengths[ring.current] = length;
+    ++ring.in_flight;
+    file_size += length;
+
+    reapIoUring (false);
+    return good ();
+}
+
+
+//! Makes a free buffer current, waiting for a completion when all of
+//! them are in flight.
+bool
+DirectFile::acquireIoUringBuffer ()
+{
+    IoUring & ring = *uring;
+    reapIoUring (false);
+    while (ring.in_flight == io_uring_buffers && reapIoUring (true))
+        ;
+
+    if (! good ())
+        return false;
+
+    for (unsigned i = 1; i <= io_uring_buffers; ++i)
+    {
+        unsigned const index = (ring.current + i) % io_uring_buffers;
+        if (ring.lengths[index] == 0)
+        {
+            ring.current = index;
+            char * const data = ring.bufferData (index);
+            setp (data, data + ring.size);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+//! Processes completed writes. When `block` is true, it waits for at
+//! least one of the writes in flight to complete.
+//! \return false when waiting failed.
+bool
+DirectFile::reapIoUring (bool block)
+{
+    IoUring & ring = *uring;
+    for (;;)
+    {
+        unsigned head = *ring.cq_head;
+        unsigned const tail = std::atomic_ref<unsigned> (*ring.cq_tail)
+            .load (std::memory_order_acquire);
+        bool const reaped = head != tail;
+
+        for (; head != tail; ++head)
+        {
+            io_uring_cqe const & cqe = ring.cqes[head & *ring.cq_mask];
+            std::size_t & length = ring.lengths[cqe.user_data];
+            // Short writes to regular files only happen on errors like
+            // full disk. They are treated as failures.
+            if (cqe.res < 0)
+                last_error = -cqe.res;
+            else if (static_cast<std::size_t>(cqe.res) != length)
+                last_error = EIO;
+            length = 0;
+            --ring.in_flight;
+        }
+
+        std::atomic_ref<unsigned> (*ring.cq_head).store (head,
+            std::memory_order_release);
+
+        if (reaped || ! block || ring.in_flight == 0)
+            return true;
+
+        if (ring.enter (0, 1, IORING_ENTER_GETEVENTS) == -1
+            && errno != EINTR)
+        {
+            last_error = errno;
+            return false;
+        }
+    }
+}
+
+#endif
+
+
+} // namespace log4cplus::helpers
@@ -41,6 +41,10 @@
 #include <stdlib.h>
 #endif
 
+#ifdef LOG4CPLUS_HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+
 #ifdef LOG4CPLUS_HAVE_WCHAR_H
 #include <wchar.h>
 #endif
@@ -49,6 +53,11 @@
 #include <direct.h>
 #endif
 
+#if defined (LOG4CPLUS_USE_PTHREADS)
+#include <pthread.h>
+#endif
+
+#include <atomic>
 #include <cassert>
 #include <cstdlib>
 #include <cstring>
@@ -700,4 +709,89 @@ make_dirs (tstring const & file_path)
 }
 
 
+#if ! defined (_WIN32)
+int
+check_file_size (int fd, std::size_t size)
+{
+    struct stat st;
+    if (fstat (fd, &st) != 0)
+        return errno;
+
+    // Pages of shared mapping past end of file are not backed by the
+    // file and access to them raises SIGBUS.
+    return static_cast<std::size_t>(st.st_size) < size ? EIO : 0;
+}
+
+
+int
+preallocate_file (int fd, std::size_t size)
+{
+    int ret = EOPNOTSUPP;
+#if defined (LOG4CPLUS_HAVE_POSIX_FALLOCATE)
+    ret = posix_fallocate (fd, 0, static_cast<off_t>(size));
+#endif
+
+    // Some file systems do not support preallocation. Sparse file is
+    // the next best thing there. Any other error, e.g. ENOSPC, means
+    // the file cannot be backed by storage.
+    if (ret == EOPNOTSUPP || ret == EINVAL)
+        ret = ftruncate (fd, static_cast<off_t>(size)) == 0 ? 0 : errno;
+
+    if (ret != 0)
+        return ret;
+
+    return check_file_size (fd, size);
+}
+
+#endif
+
+
+#if defined (LOG4CPLUS_USE_PTHREADS)
+namespace
+{
+
+using process_id_type = decltype (get_process_id ());
+
+std::atomic<process_id_type> cached_process_id {0};
+
+
+void
+refresh_cached_process_id ()
+{
+    cached_process_id.store (get_process_id (), std::memory_order_relaxed);
+}
+
+} // namespace
+
+
+decltype (get_process_id ())
+get_cached_process_id ()
+{
+    process_id_type pid = cached_process_id.load (std::memory_order_relaxed);
+    if (pid == 0)
+    {
+        static int const registered = []
+        {
+            pthread_atfork (nullptr, nullptr, refresh_cached_process_id);
+            return 0;
+        } ();
+        (void) registered;
+        pid = get_process_id ();
+        cached_process_id.store (pid, std::memory_order_relaxed);
+    }
+
+    return pid;
+}
+
+#else
+decltype (get_process_id ())
+get_cached_process_id ()
+{
+    // Without pthread_atfork() the cache could not be refreshed.
+    return get_process_id ();
+}
+
+#endif
+
+
 } // namespace log4cplus::internal
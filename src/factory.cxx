@@ -165,6 +165,8 @@ void initializeFactoryRegistry()
     LOG4CPLUS_REG_APPENDER (reg, NullAppender);
     LOG4CPLUS_REG_APPENDER (reg, FileAppender);
     LOG4CPLUS_REG_APPENDER (reg, RollingFileAppender);
+    LOG4CPLUS_REG_APPENDER (reg, MappedSegmentAppender);
+    LOG4CPLUS_REG_APPENDER (reg, CircularFileAppender);
     LOG4CPLUS_REG_APPENDER (reg, DailyRollingFileAppender);
     LOG4CPLUS_REG_APPENDER (reg, TimeBasedRollingFileAppender);
     LOG4CPLUS_REG_APPENDER (reg, SocketAppender);
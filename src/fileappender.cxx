@@ -31,12 +31,21 @@
 #include <log4cplus/internal/internal.h>
 #include <log4cplus/internal/env.h>
 #include <algorithm>
+#include <array>
 #include <memory>
 #include <sstream>
 #include <cstdio>
+#include <cstring>
 #include <stdexcept>
+#include <string_view>
 #include <cmath> // std::fmod
 #include <filesystem>
+#include <iomanip>
+#include <limits>
+#include <locale>
+#include <map>
+#include <mutex>
+#include <system_error>
 
 // For _wrename() and _wremove() on Windows.
 #include <stdio.h>
@@ -45,8 +54,20 @@
 #include <errno.h>
 #endif
 
+#if defined (LOG4CPLUS_HAVE_SYS_MMAN_H) && ! defined (_WIN32)
+#define LOG4CPLUS_USE_MMAP
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 #if defined (LOG4CPLUS_WITH_UNIT_TESTS)
 #include <catch_amalgamated.hpp>
+#include <condition_variable>
+#include <thread>
+#include <vector>
 #endif
 
 
@@ -59,6 +80,7 @@ using helpers::Time;
 
 const long DEFAULT_ROLLING_LOG_SIZE = 10 * 1024 * 1024L;
 const long MINIMUM_ROLLING_LOG_SIZE = 200*1024L;
+const long MINIMUM_SEGMENT_SIZE = 64 * 1024L;
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -112,6 +134,24 @@ file_remove (tstring const & src)
 }
 
 
+//! Returns the number of bytes that writing `str` adds to a file opened
+//! with `mode`. Windows text mode streams write CR LF for each LF.
+static
+std::streamoff
+file_bytes (std::basic_string_view<tchar> str, std::ios_base::openmode mode)
+{
+    std::streamoff bytes = static_cast<std::streamoff>(str.size ());
+#if defined (_WIN32)
+    if (! (mode & std::ios_base::binary))
+        bytes += static_cast<std::streamoff>(
+            std::count (str.begin (), str.end (), LOG4CPLUS_TEXT ('\n')));
+#else
+    (void) mode;
+#endif
+    return bytes;
+}
+
+
 static
 void
 loglog_renaming_result (helpers::LogLog & loglog, tstring const & src,
@@ -141,10 +181,10 @@ loglog_renaming_result (helpers::LogLog & loglog, tstring const & src,
 
 static
 void
-loglog_opening_result (helpers::LogLog & loglog,
-    log4cplus::tostream const & os, tstring const & filename)
+loglog_opening_result (helpers::LogLog & loglog, bool good,
+    tstring const & filename)
 {
-    if (! os)
+    if (! good)
     {
         loglog.error (
             LOG4CPLUS_TEXT("Failed to open file ")
@@ -153,16 +193,79 @@ loglog_opening_result (helpers::LogLog & loglog,
 }
 
 
+//! Parses file size property value with optional <tt>MB</tt> or
+//! <tt>KB</tt> suffix.
+static
+long
+parse_file_size (tstring const & value, long defaultSize)
+{
+    tstring const tmp (helpers::toUpper (value));
+    if (tmp.empty ())
+        return defaultSize;
+
+    long size = std::atoi(LOG4CPLUS_TSTRING_TO_STRING(tmp).c_str());
+    if (size != 0)
+    {
+        tstring::size_type const len = tmp.length();
+        if (len > 2
+            && tmp.compare (len - 2, 2, LOG4CPLUS_TEXT("MB")) == 0)
+            size *= (1024 * 1024); // convert to megabytes
+        else if (len > 2
+            && tmp.compare (len - 2, 2, LOG4CPLUS_TEXT("KB")) == 0)
+            size *= 1024; // convert to kilobytes
+    }
+
+    return size;
+}
+
+
+//! \return Name of `filename` compressed by CompressBackups.
+static
+tstring
+compressed_name (tstring const & filename)
+{
+    return filename + LOG4CPLUS_TEXT(".gz");
+}
+
+
+//! Optional files that make up a backup besides the file itself.
+enum backup_parts : unsigned
+{
+    //! The file compressed by CompressBackups.
+    backup_compressed = 1,
+    //! Time index of the file.
+    backup_time_index = 2
+};
+
+
+//! \return Names of files that make up backup `name`: the file
+//! itself and its optional `parts`.
+static
+std::vector<tstring>
+backup_file_names (tstring const & name, unsigned parts)
+{
+    std::vector<tstring> names {name};
+    if (parts & backup_compressed)
+        names.push_back (compressed_name (name));
+    if (parts & backup_time_index)
+        names.push_back (helpers::timeIndexName (name));
+    return names;
+}
+
+
 static
 void
-rolloverFiles(const tstring& filename, unsigned int maxBackupIndex)
+rolloverFiles(const tstring& filename, unsigned int maxBackupIndex,
+    unsigned parts = 0)
 {
     helpers::LogLog * loglog = helpers::LogLog::getLogLog();
 
     // Delete the oldest file
     tostringstream buffer;
     buffer << filename << LOG4CPLUS_TEXT(".") << maxBackupIndex;
-    long ret = file_remove (buffer.str ());
+    long ret;
+    for (tstring const & name : backup_file_names (buffer.str (), parts))
+        ret = file_remove (name);
 
     tostringstream source_oss;
     tostringstream target_oss;
@@ -176,23 +279,483 @@ rolloverFiles(const tstring& filename, unsigned int maxBackupIndex)
         source_oss << filename << LOG4CPLUS_TEXT(".") << i;
         target_oss << filename << LOG4CPLUS_TEXT(".") << (i+1);
 
-        tstring const source (source_oss.str ());
-        tstring const target (target_oss.str ());
+        std::vector<tstring> const sources (
+            backup_file_names (source_oss.str (), parts));
+        std::vector<tstring> const targets (
+            backup_file_names (target_oss.str (), parts));
+        for (std::size_t j = 0; j != sources.size (); ++j)
+        {
+            tstring const & source = sources[j];
+            tstring const & target = targets[j];
 
 #if defined (_WIN32)
-        // Try to remove the target first. It seems it is not
-        // possible to rename over existing file.
-        ret = file_remove (target);
+            // Try to remove the target first. It seems it is not
+            // possible to rename over existing file.
+            ret = file_remove (target);
 #endif
 
-        ret = file_rename (source, target);
-        loglog_renaming_result (*loglog, source, target, ret);
+            ret = file_rename (source, target);
+            loglog_renaming_result (*loglog, source, target, ret);
+        }
     }
 } // end rolloverFiles()
 
+
+//! \return Name under which a rolled over file waits for the
+//! maintenance thread.
+static
+tstring
+rollover_staging_name (tstring const & filename)
+{
+    return filename + LOG4CPLUS_TEXT(".rolling");
+}
+
+
+//! Renames `src` to `target`, replacing `target`.
+static
+void
+rename_replacing (tstring const & src, tstring const & target)
+{
+    helpers::LogLog & loglog = helpers::getLogLog ();
+    long ret;
+
+#if defined (_WIN32)
+    // Try to remove the target first. It seems it is not
+    // possible to rename over existing file.
+    ret = file_remove (target);
+#endif
+
+    ret = file_rename (src, target);
+    loglog_renaming_result (loglog, src, target, ret);
+}
+
+
+//! Removes `name`. Failures other than missing file are reported.
+static
+void
+remove_file_logged (tstring const & name)
+{
+    helpers::LogLog & loglog = helpers::getLogLog ();
+    long const ret = file_remove (name);
+    if (ret == 0)
+        loglog.debug (LOG4CPLUS_TEXT("Removed file ") + name);
+    else if (ret != LOG4CPLUS_FILE_NOT_FOUND)
+        loglog.error (LOG4CPLUS_TEXT("Failed to remove file ") + name
+            + LOG4CPLUS_TEXT("; error ")
+            + helpers::convertIntegerToString (ret));
+}
+
+
+//! \return Name of backup `index` of `base`, i.e., `base` itself for
+//! index 0, otherwise e.g. <tt>base.2</tt>.
+static
+tstring
+backup_name (tstring const & base, unsigned index)
+{
+    return index == 0
+        ? base
+        : base + LOG4CPLUS_TEXT(".") + helpers::convertIntegerToString (index);
+}
+
+
+//! Removes backup `name` and its optional `parts`.
+static
+void
+remove_backup (tstring const & name, unsigned parts)
+{
+    for (tstring const & file : backup_file_names (name, parts))
+        remove_file_logged (file);
+}
+
+
+//! Renames backup `src` and its optional `parts` to `target`.
+static
+void
+rename_backup (tstring const & src, tstring const & target,
+    unsigned parts)
+{
+    std::vector<tstring> const sources (backup_file_names (src, parts));
+    std::vector<tstring> const targets (backup_file_names (target, parts));
+    for (std::size_t i = 0; i != sources.size (); ++i)
+        rename_replacing (sources[i], targets[i]);
+}
+
+
+//! Renames time index of `src` to time index of `target` when `parts`
+//! include time index.
+static
+void
+rename_time_index (tstring const & src, tstring const & target,
+    unsigned parts)
+{
+    if (parts & backup_time_index)
+        rename_replacing (helpers::timeIndexName (src),
+            helpers::timeIndexName (target));
+}
+
+
+//! Minimal number of digits of indices in names of files of
+//! <tt>RollingStrategy=Indexed</tt>.
+static std::size_t const indexed_file_index_width = 6;
+
+
+//! \return Name of file with index `index` for RollingFileAppender
+//! with <tt>RollingStrategy=Indexed</tt>, e.g., <tt>log.000123</tt>.
+static
+tstring
+indexed_file_name (tstring const & base, unsigned long index)
+{
+    tostringstream oss;
+    oss << base << LOG4CPLUS_TEXT(".") << std::setfill (LOG4CPLUS_TEXT('0'))
+        << std::setw (static_cast<int>(indexed_file_index_width)) << index;
+    return oss.str ();
+}
+
+
+//! Parses index part of a name produced by indexed_file_name(). Names
+//! of backups of Rename strategy, e.g. <tt>log.1</tt>, are rejected.
+//! \return true on success.
+static
+bool
+parse_file_index (unsigned long & index, tstring const & digits)
+{
+    if (digits.size () < indexed_file_index_width
+        || (digits.size () > indexed_file_index_width
+            && digits[0] == LOG4CPLUS_TEXT('0')))
+        return false;
+
+    unsigned long value = 0;
+    for (tchar const ch : digits)
+    {
+        if (ch < LOG4CPLUS_TEXT('0') || ch > LOG4CPLUS_TEXT('9'))
+            return false;
+
+        unsigned long const digit
+            = static_cast<unsigned long>(ch - LOG4CPLUS_TEXT('0'));
+        if (value > ((std::numeric_limits<unsigned long>::max) () - digit)
+            / 10)
+            return false;
+
+        value = value * 10 + digit;
+    }
+
+    index = value;
+    return true;
+}
+
+
+//! Scans the directory of `base` for files named like
+//! indexed_file_name() does, possibly compressed by CompressBackups.
+//! \return Sorted indices of the files.
+static
+std::vector<unsigned long>
+scan_indexed_files (tstring const & base)
+{
+    std::filesystem::path const basePath (base);
+    std::filesystem::path dir (basePath.parent_path ());
+    if (dir.empty ())
+        dir = std::filesystem::path (LOG4CPLUS_TEXT("."));
+    tstring const prefix (
+        basePath.filename ().template string<tchar> ()
+        + LOG4CPLUS_TEXT("."));
+
+    std::vector<unsigned long> indices;
+    std::error_code ec;
+    for (std::filesystem::directory_iterator it (dir, ec), end;
+         ! ec && it != end; it.increment (ec))
+    {
+        tstring const name (
+            it->path ().filename ().template string<tchar> ());
+        if (name.size () <= prefix.size ()
+            || name.compare (0, prefix.size (), prefix) != 0)
+            continue;
+
+        tstring digits (name, prefix.size ());
+        tstring const suffix (compressed_name (tstring ()));
+        if (digits.size () > suffix.size ()
+            && digits.compare (digits.size () - suffix.size (),
+                suffix.size (), suffix) == 0)
+            digits.resize (digits.size () - suffix.size ());
+
+        unsigned long index = 0;
+        if (parse_file_index (index, digits))
+            indices.push_back (index);
+    }
+
+    if (ec)
+        helpers::getLogLog ().warn (
+            LOG4CPLUS_TEXT("Failed to scan directory of ") + base
+            + LOG4CPLUS_TEXT(": ")
+            + LOG4CPLUS_C_STR_TO_TSTRING (ec.message ()));
+
+    std::sort (indices.begin (), indices.end ());
+    indices.erase (std::unique (indices.begin (), indices.end ()),
+        indices.end ());
+    return indices;
+}
+
+
+//! \return true when `props` select indexed rolling strategy.
+static
+bool
+is_indexed_rolling (Properties const & props, bool reportInvalid)
+{
+    tstring const strategy (helpers::toUpper (
+        props.getProperty (LOG4CPLUS_TEXT ("RollingStrategy"),
+            LOG4CPLUS_TEXT ("Rename"))));
+    if (strategy == LOG4CPLUS_TEXT ("INDEXED"))
+        return true;
+    else if (strategy != LOG4CPLUS_TEXT ("RENAME") && reportInvalid)
+        helpers::getLogLog ().warn (
+            LOG4CPLUS_TEXT ("RollingFileAppender::ctor()")
+            LOG4CPLUS_TEXT ("- \"RollingStrategy\" not valid: ")
+            + props.getProperty (LOG4CPLUS_TEXT ("RollingStrategy")));
+    return false;
+}
+
+
+//! Replaces <tt>File</tt> with the name of the file to continue
+//! writing with when indexed rolling strategy is selected.
+static
+Properties
+indexed_rolling_properties (Properties const & props)
+{
+    if (! is_indexed_rolling (props, false))
+        return props;
+
+    tstring const base (props.getProperty (LOG4CPLUS_TEXT ("File")));
+    std::vector<unsigned long> const indices (scan_indexed_files (base));
+    unsigned long index = indices.empty () ? 1 : indices.back ();
+
+    // Do not truncate the newest file, start a new one instead. Do not
+    // continue with a file that has been compressed either.
+    bool app = true;
+    props.getBool (app, LOG4CPLUS_TEXT ("Append"));
+    helpers::FileInfo fi;
+    if (! indices.empty ()
+        && (! app || getFileInfo (&fi, indexed_file_name (base, index)) != 0))
+        index += 1;
+
+    Properties result (props);
+    result.setProperty (LOG4CPLUS_TEXT ("File"),
+        indexed_file_name (base, index));
+
+    // Keep one lock file for all the files.
+    if (! props.exists (LOG4CPLUS_TEXT ("LockFile")))
+        result.setProperty (LOG4CPLUS_TEXT ("LockFile"),
+            base + LOG4CPLUS_TEXT (".lock"));
+
+    return result;
+}
+
+
+//! Shifts backups of `filename` and renames `source` to the first
+//! backup.
+static
+void
+shift_backups (tstring const & filename, tstring const & source,
+    unsigned int maxBackupIndex, unsigned parts)
+{
+    rolloverFiles (filename, maxBackupIndex, parts);
+    rename_backup (source, filename + LOG4CPLUS_TEXT(".1"), parts);
+}
+
+
+//! Formats `event` into the per thread scratch pad string.
+//! \return View of the formatted event valid until the next use of
+//! the scratch pad.
+static
+std::basic_string_view<tchar>
+format_into_scratch_pad (Layout & layout,
+    spi::InternalLoggingEvent const & event)
+{
+    tstring & str = internal::get_appender_sp ().str;
+    str.clear ();
+    layout.formatAndAppend (str, event);
+    return str;
+}
+
 } // namespace
 
 
+///////////////////////////////////////////////////////////////////////////////
+// FileAppenderBase::BackupCompressor
+///////////////////////////////////////////////////////////////////////////////
+
+//! Compresses backups for CompressBackups on the background thread. A
+//! backup is moved to a private name before its compression is queued,
+//! so that rollovers can go on shifting backups instead of waiting for
+//! the compression. Shifts of backups of each base name are counted and
+//! the compressed file is placed where its backup has been shifted to
+//! meanwhile.
+struct FileAppenderBase::BackupCompressor
+{
+    //! Runs `shift`, which moves backup `i` of `base` to `i + 1` for all
+    //! `i`, and counts it.
+    void
+    shift (tstring const & base, std::function<void ()> const & shift)
+    {
+        std::lock_guard<std::mutex> lock (mtx);
+        shift ();
+        if (auto it = bases.find (base); it != bases.end ())
+            ++it->second.shifts;
+    }
+
+    static void compress (std::shared_ptr<BackupCompressor> const & self,
+        tstring const & base, unsigned index, unsigned maxIndex);
+
+    //! Removes backup `name`, which has fallen out of the history, and
+    //! makes its compression still in progress discard its output.
+    void expire (tstring const & name, unsigned parts);
+
+    //! Waits for compression of all backups queued so far.
+    void wait ();
+
+private:
+    void finish (tstring const & base, unsigned index, unsigned maxIndex,
+        std::uint64_t shifts, tstring const & pending, bool compressed);
+
+    struct Base
+    {
+        //! Count of shifts done while compression is in progress.
+        std::uint64_t shifts = 0;
+        //! Count of backups being compressed.
+        std::size_t jobs = 0;
+        //! Set by expire() when index 0 of the base has fallen out of
+        //! the history.
+        bool expired = false;
+    };
+
+    std::mutex mtx;
+    std::map<tstring, Base, std::less<>> bases;
+    std::uint64_t sequence = 0;
+    //! Last compression job queued into the background queue.
+    std::uint64_t lastJob = 0;
+    //! Last finish() job queued into the maintenance queue.
+    std::uint64_t lastFinishJob = 0;
+};
+
+
+void
+FileAppenderBase::BackupCompressor::compress (
+    std::shared_ptr<BackupCompressor> const & self, tstring const & base,
+    unsigned index, unsigned maxIndex)
+{
+    tstring const name = backup_name (base, index);
+    tstring pending;
+    std::uint64_t shifts;
+    {
+        std::lock_guard<std::mutex> lock (self->mtx);
+        pending = name + LOG4CPLUS_TEXT(".compressing.")
+            + helpers::convertIntegerToString (++self->sequence);
+        long const ret = file_rename (name, pending);
+        if (ret != 0)
+        {
+            loglog_renaming_result (helpers::getLogLog (), name, pending,
+                ret);
+            return;
+        }
+
+        Base & b = self->bases[base];
+        ++b.jobs;
+        shifts = b.shifts;
+    }
+
+    // Compression runs on the low priority background thread. The
+    // final renames run on the maintenance thread, at normal priority,
+    // because they hold `mtx`, which rollovers wait for in shift().
+    std::uint64_t const id = helpers::queueBackgroundJob (
+        [self, base, index, maxIndex, shifts, pending] {
+            tstring const temporary = compressed_name (pending);
+            bool const compressed = helpers::gzipFile (pending, temporary);
+            std::uint64_t const finishId = helpers::queueMaintenanceJob (
+                [self, base, index, maxIndex, shifts, pending, compressed] {
+                    self->finish (base, index, maxIndex, shifts, pending,
+                        compressed);
+                });
+
+            std::lock_guard<std::mutex> lock (self->mtx);
+            self->lastFinishJob = (std::max) (self->lastFinishJob,
+                finishId);
+        });
+
+    std::lock_guard<std::mutex> lock (self->mtx);
+    self->lastJob = (std::max) (self->lastJob, id);
+}
+
+
+void
+FileAppenderBase::BackupCompressor::finish (tstring const & base,
+    unsigned index, unsigned maxIndex, std::uint64_t shifts,
+    tstring const & pending, bool compressed)
+{
+    tstring const temporary = compressed_name (pending);
+
+    // Renames below must not interleave with shifts.
+    std::lock_guard<std::mutex> lock (mtx);
+    auto const it = bases.find (base);
+    std::uint64_t const target_index = index + (it->second.shifts - shifts);
+    bool const expired = it->second.expired;
+    if (--it->second.jobs == 0)
+        bases.erase (it);
+
+    if (expired || target_index > maxIndex)
+    {
+        // The backup has fallen out of the history meanwhile.
+        remove_file_logged (temporary);
+        remove_file_logged (pending);
+    }
+    else if (tstring const target = backup_name (base,
+            static_cast<unsigned>(target_index)); compressed)
+    {
+        rename_replacing (temporary, compressed_name (target));
+        remove_file_logged (pending);
+    }
+    else
+    {
+        remove_file_logged (temporary);
+        rename_replacing (pending, target);
+    }
+}
+
+
+void
+FileAppenderBase::BackupCompressor::expire (tstring const & name,
+    unsigned parts)
+{
+    {
+        // finish() either has placed the compressed backup already, so
+        // that it is removed below, or it sees the flag.
+        std::lock_guard<std::mutex> lock (mtx);
+        if (auto it = bases.find (name); it != bases.end ())
+            it->second.expired = true;
+    }
+
+    remove_backup (name, parts);
+}
+
+
+void
+FileAppenderBase::BackupCompressor::wait ()
+{
+    std::uint64_t id;
+    {
+        std::lock_guard<std::mutex> lock (mtx);
+        id = lastJob;
+    }
+
+    helpers::waitForBackgroundJob (id);
+
+    // Finished compression jobs have queued their renames.
+    {
+        std::lock_guard<std::mutex> lock (mtx);
+        id = lastFinishJob;
+    }
+
+    helpers::waitForMaintenanceJob (id);
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // FileAppenderBase ctors and dtor
 ///////////////////////////////////////////////////////////////////////////////
@@ -204,6 +767,7 @@ FileAppenderBase::FileAppenderBase(const tstring& filename_,
     , reopenDelay(1)
     , bufferSize (0)
     , buffer (nullptr)
+    , backend (FileBackend::Stream)
     , filename(filename_)
     , localeName (LOG4CPLUS_TEXT ("DEFAULT"))
     , fileOpenMode(mode_)
@@ -218,6 +782,7 @@ FileAppenderBase::FileAppenderBase(const Properties& props,
     , reopenDelay(1)
     , bufferSize (0)
     , buffer (nullptr)
+    , backend (FileBackend::Stream)
 {
     filename = props.getProperty(LOG4CPLUS_TEXT("File"));
     lockFileName = props.getProperty (LOG4CPLUS_TEXT ("LockFile"));
@@ -227,6 +792,20 @@ FileAppenderBase::FileAppenderBase(const Properties& props,
     props.getBool (createDirs, LOG4CPLUS_TEXT("CreateDirs"));
     props.getInt (reopenDelay, LOG4CPLUS_TEXT("ReopenDelay"));
     props.getULong (bufferSize, LOG4CPLUS_TEXT("BufferSize"));
+    props.getULong (maxFlushDelay, LOG4CPLUS_TEXT("MaxFlushDelay"));
+    props.getBool (asyncRollover, LOG4CPLUS_TEXT("AsyncRollover"));
+    props.getBool (compressBackups, LOG4CPLUS_TEXT("CompressBackups"));
+
+    bool useTimeIndex = false;
+    props.getBool (useTimeIndex, LOG4CPLUS_TEXT("TimeIndex"));
+    if (useTimeIndex)
+    {
+        unsigned long timeIndexInterval = 1;
+        props.getULong (timeIndexInterval,
+            LOG4CPLUS_TEXT("TimeIndexInterval"));
+        timeIndex = std::make_unique<helpers::TimeIndexWriter> (
+            timeIndexInterval);
+    }
 
     bool app = (mode_ & (std::ios_base::app | std::ios_base::ate)) != 0;
     props.getBool (app, LOG4CPLUS_TEXT("Append"));
@@ -235,6 +814,70 @@ FileAppenderBase::FileAppenderBase(const Properties& props,
     if (props.getProperty(LOG4CPLUS_TEXT("TextMode"), LOG4CPLUS_TEXT("Text"))
         == LOG4CPLUS_TEXT("Binary"))
         fileOpenMode |= std::ios_base::binary;
+
+    tstring const backendStr (helpers::toUpper (
+        props.getProperty (LOG4CPLUS_TEXT ("Backend"),
+            LOG4CPLUS_TEXT ("Stream"))));
+    if (backendStr == LOG4CPLUS_TEXT ("DIRECT"))
+        backend = FileBackend::Direct;
+    else if (backendStr == LOG4CPLUS_TEXT ("IOURING"))
+        backend = FileBackend::IoUring;
+    else if (backendStr != LOG4CPLUS_TEXT ("STREAM"))
+        helpers::getLogLog ().warn (
+            LOG4CPLUS_TEXT ("FileAppenderBase::ctor()")
+            LOG4CPLUS_TEXT ("- \"Backend\" not valid: ")
+            + props.getProperty (LOG4CPLUS_TEXT ("Backend")));
+
+    tstring const compressionStr (helpers::toUpper (
+        props.getProperty (LOG4CPLUS_TEXT ("Compression"),
+            LOG4CPLUS_TEXT ("None"))));
+    if (compressionStr == LOG4CPLUS_TEXT ("GZIP"))
+        compression = helpers::CompressionCodec::Gzip;
+    else if (compressionStr == LOG4CPLUS_TEXT ("ZSTD"))
+        compression = helpers::CompressionCodec::Zstd;
+    else if (compressionStr != LOG4CPLUS_TEXT ("NONE"))
+        helpers::getLogLog ().warn (
+            LOG4CPLUS_TEXT ("FileAppenderBase::ctor()")
+            LOG4CPLUS_TEXT ("- \"Compression\" not valid: ")
+            + props.getProperty (LOG4CPLUS_TEXT ("Compression")));
+
+    props.getInt (compressionLevel, LOG4CPLUS_TEXT ("CompressionLevel"));
+    long const blockSize = parse_file_size (
+        props.getProperty (LOG4CPLUS_TEXT ("CompressionBlockSize")), 0);
+    if (blockSize > 0)
+        compressionBlockSize = static_cast<unsigned long>(blockSize);
+
+    unsigned long syncInterval = 0;
+    props.getULong (syncInterval, LOG4CPLUS_TEXT ("SyncInterval"));
+    syncPolicy.interval = std::chrono::milliseconds (syncInterval);
+
+    long const syncSize = parse_file_size (
+        props.getProperty (LOG4CPLUS_TEXT ("SyncSize")), 0);
+    if (syncSize > 0)
+        syncPolicy.bytes = static_cast<std::uint64_t>(syncSize);
+
+    if (props.exists (LOG4CPLUS_TEXT ("SyncLevel")))
+    {
+        tstring const levelStr (helpers::toUpper (
+            props.getProperty (LOG4CPLUS_TEXT ("SyncLevel"))));
+        syncPolicy.level = getLogLevelManager ().fromString (levelStr);
+        if (syncPolicy.level == NOT_SET_LOG_LEVEL)
+            helpers::getLogLog ().warn (
+                LOG4CPLUS_TEXT ("FileAppenderBase::ctor()")
+                LOG4CPLUS_TEXT ("- \"SyncLevel\" not valid: ")
+                + props.getProperty (LOG4CPLUS_TEXT ("SyncLevel")));
+    }
+
+    tstring const syncMethodStr (helpers::toUpper (
+        props.getProperty (LOG4CPLUS_TEXT ("SyncMethod"),
+            LOG4CPLUS_TEXT ("FDataSync"))));
+    if (syncMethodStr == LOG4CPLUS_TEXT ("FSYNC"))
+        syncPolicy.dataOnly = false;
+    else if (syncMethodStr != LOG4CPLUS_TEXT ("FDATASYNC"))
+        helpers::getLogLog ().warn (
+            LOG4CPLUS_TEXT ("FileAppenderBase::ctor()")
+            LOG4CPLUS_TEXT ("- \"SyncMethod\" not valid: ")
+            + props.getProperty (LOG4CPLUS_TEXT ("SyncMethod")));
 }
 
 
@@ -254,12 +897,91 @@ FileAppenderBase::init()
         lockFileName += LOG4CPLUS_TEXT(".lock");
     }
 
-    if (bufferSize != 0)
+    if (compression != helpers::CompressionCodec::None)
+    {
+        if (! helpers::isCompressionSupported (compression))
+        {
+            helpers::getLogLog ().error (
+                LOG4CPLUS_TEXT ("FileAppenderBase::init()")
+                LOG4CPLUS_TEXT ("- log4cplus has been built without support")
+                LOG4CPLUS_TEXT (" for selected Compression, writing ")
+                LOG4CPLUS_TEXT ("uncompressed file: ") + filename);
+            compression = helpers::CompressionCodec::None;
+        }
+        else if (useLockFile)
+        {
+            helpers::getLogLog ().warn (
+                LOG4CPLUS_TEXT ("FileAppenderBase::init()")
+                LOG4CPLUS_TEXT ("- Compression cannot be used together")
+                LOG4CPLUS_TEXT (" with UseLockFile, writing uncompressed")
+                LOG4CPLUS_TEXT (" file: ") + filename);
+            compression = helpers::CompressionCodec::None;
+        }
+    }
+
+    if (compressBackups)
+    {
+        if (! helpers::isCompressionSupported (
+                helpers::CompressionCodec::Gzip))
+        {
+            helpers::getLogLog ().error (
+                LOG4CPLUS_TEXT ("FileAppenderBase::init()")
+                LOG4CPLUS_TEXT ("- log4cplus has been built without zlib,")
+                LOG4CPLUS_TEXT (" CompressBackups is ignored"));
+            compressBackups = false;
+        }
+        else if (compression != helpers::CompressionCodec::None)
+            // The file is compressed already.
+            compressBackups = false;
+        else
+            backupCompressor = std::make_shared<BackupCompressor> ();
+    }
+
+    if (timeIndex)
+    {
+        if (compression != helpers::CompressionCodec::None || useLockFile)
+        {
+            helpers::getLogLog ().warn (
+                LOG4CPLUS_TEXT ("FileAppenderBase::init()")
+                LOG4CPLUS_TEXT ("- TimeIndex cannot be used together")
+                LOG4CPLUS_TEXT (" with Compression or UseLockFile: ")
+                + filename);
+            timeIndex.reset ();
+        }
+        else
+            // Offsets of records are taken from the tracked size.
+            trackFileSize = true;
+    }
+
+    if (compression != helpers::CompressionCodec::None)
+    {
+        compressedOut = std::make_unique<helpers::BlockCompressedFile> (
+            compression, compressionLevel, compressionBlockSize);
+        // Flushing after each event would make a block of each event.
+        immediateFlush = false;
+    }
+    else if (backend != FileBackend::Stream)
+    {
+        directOut = std::make_unique<helpers::DirectFile> ();
+        directOut->setBufferSize (bufferSize);
+        if (backend == FileBackend::IoUring)
+            directOut->setIoUring (true);
+    }
+    else if (bufferSize != 0)
     {
         buffer.reset (new tchar[bufferSize]);
         out.rdbuf ()->pubsetbuf (buffer.get (), bufferSize);
     }
 
+    if (syncPolicy.enabled () && ! fileSync)
+        fileSync = std::make_unique<helpers::FileSync> (
+            static_cast<helpers::IFileSyncClient &>(*this), syncPolicy);
+
+    if (maxFlushDelay != 0 && ! immediateFlush && ! useLockFile && ! flusher)
+        flusher = std::make_unique<helpers::DelayedFlusher> (
+            static_cast<helpers::IDelayedFlushClient &>(*this),
+            std::chrono::milliseconds (maxFlushDelay));
+
     helpers::LockFileGuard guard;
     if (useLockFile && ! lockFile)
     {
@@ -290,17 +1012,38 @@ FileAppenderBase::init()
 void
 FileAppenderBase::close()
 {
-    thread::MutexGuard guard (access_mutex);
+    std::uint64_t maintenanceJob;
+    BackupCompressorPtr compressor;
+    {
+        thread::MutexGuard guard (access_mutex);
 
-    out.close();
-    buffer.reset ();
-    closed = true;
+        closeFile ();
+        buffer.reset ();
+        closed = true;
+        maintenanceJob = lastMaintenanceJob;
+        compressor = backupCompressor;
+    }
+
+    // Leave the files in their final state. Maintenance jobs can queue
+    // compression of backups, so wait for them first. Threads logging
+    // into this appender are not blocked by the waiting.
+    helpers::waitForMaintenanceJob (maintenanceJob);
+    if (compressor)
+        compressor->wait ();
 }
 
 
 std::locale
 FileAppenderBase::imbue(std::locale const& loc)
 {
+    if (directOut)
+        directOut->stream ().imbue (loc);
+
+    // Characters can be counted instead of bytes only when the stream
+    // writes them into the file unchanged.
+    countChars = std::use_facet<
+        std::codecvt<tchar, char, std::mbstate_t> > (loc).always_noconv ();
+
     return out.imbue (loc);
 }
 
@@ -321,7 +1064,7 @@ FileAppenderBase::getloc () const
 void
 FileAppenderBase::append(const spi::InternalLoggingEvent& event)
 {
-    if(!out.good()) {
+    if(!isFileGood()) {
         if(!reopen()) {
             getErrorHandler()->error(  LOG4CPLUS_TEXT("file is not open: ")
                                      + filename);
@@ -333,24 +1076,238 @@ FileAppenderBase::append(const spi::InternalLoggingEvent& event)
             getErrorHandler()->reset();
     }
 
+    // Other processes might have appended to the file.
     if (useLockFile)
-        out.seekp (0, std::ios_base::end);
+        resyncFileSize ();
 
-    layout->formatAndAppend(out, event);
+    if (timeIndex)
+        timeIndex->add (event.getTimestamp (),
+            static_cast<std::uint64_t>(fileSize));
 
-    if(immediateFlush || useLockFile)
-        out.flush();
-}
+    if (batching)
+    {
+        // appendBatch() writes the batch and flushes the file.
+        std::size_t const start = batchBuffer.size ();
+        layout->formatAndAppend (batchBuffer, event);
+        fileSize += file_bytes (
+            std::basic_string_view<tchar> (batchBuffer).substr (start),
+            fileOpenMode);
+        return;
+    }
 
-void
-FileAppenderBase::open(std::ios_base::openmode mode)
-{
-    if (createDirs)
-        internal::make_dirs (filename);
+    if (compressedOut)
+    {
+#if defined (UNICODE)
+        compressedOut->write (
+            LOG4CPLUS_TSTRING_TO_STRING (formatEvent (event)),
+            event.getTimestamp ());
+#else
+        compressedOut->write (format_into_scratch_pad (*layout, event),
+            event.getTimestamp ());
+#endif
+        fileSize = static_cast<std::streamoff>(compressedOut->size ());
+    }
+    else if (directOut)
+    {
+#if defined (UNICODE)
+        directOut->write (LOG4CPLUS_TSTRING_TO_STRING (formatEvent (event)));
+#else
+        directOut->write (format_into_scratch_pad (*layout, event));
+#endif
+        fileSize = static_cast<std::streamoff>(directOut->size ());
+    }
+    else if (trackFileSize && countChars)
+    {
+        // Format into the scratch pad first to learn the length of the
+        // record.
+        std::basic_string_view<tchar> const str
+            = format_into_scratch_pad (*layout, event);
+        out.write (str.data (), static_cast<std::streamsize>(str.size ()));
+        fileSize += file_bytes (str, fileOpenMode);
+    }
+    else
+    {
+        layout->formatAndAppend(out, event);
+        if (trackFileSize)
+            fileSize = out.tellp ();
+    }
+
+    if((immediateFlush || useLockFile) && ! deferFlush)
+        flushFile();
+    else if (flusher)
+        flusher->written ();
+
+    if (fileSync)
+        syncAppended ();
+}
+
+
+void
+FileAppenderBase::syncAppended()
+{
+    std::uint64_t size = 0;
+    if (syncPolicy.bytes != 0)
+    {
+        if (! trackFileSize)
+            fileSize = getFilePosition ();
+        if (fileSize > syncPosition)
+            size = static_cast<std::uint64_t>(fileSize - syncPosition);
+        syncPosition = fileSize;
+    }
+    fileSync->appended (size);
+}
+
+
+void
+FileAppenderBase::writeBatchBuffer()
+{
+    if (batchBuffer.empty ())
+        return;
+
+    if (directOut)
+    {
+#if defined (UNICODE)
+        directOut->write (LOG4CPLUS_TSTRING_TO_STRING (batchBuffer));
+#else
+        directOut->write (batchBuffer);
+#endif
+        fileSize = static_cast<std::streamoff>(directOut->size ());
+    }
+    else
+    {
+        out.write (batchBuffer.data (),
+            static_cast<std::streamsize>(batchBuffer.size ()));
+        if (trackFileSize && ! countChars)
+            fileSize = out.tellp ();
+    }
+
+    batchBuffer.clear ();
+}
+
+
+// This method does not need to be locked since it is called by
+// syncDoAppendBatch() which performs the locking
+void
+FileAppenderBase::appendBatch(
+    std::span<spi::InternalLoggingEvent const * const> events)
+{
+    struct defer_flush_guard
+    {
+        bool & flag;
+
+        explicit defer_flush_guard (bool & f)
+            : flag (f)
+        {
+            flag = true;
+        }
+
+        ~defer_flush_guard ()
+        {
+            flag = false;
+        }
+    };
+
+    // Events are formatted into one buffer and written at once unless
+    // the position of each event in the file has to be known while the
+    // batch is formatted and it cannot be computed from the length of
+    // the formatted events. Other processes can write into the file in
+    // lock file mode and compressed files index each event.
+#if defined (UNICODE)
+    bool const lengthIsSize = ! directOut && countChars;
+#else
+    bool const lengthIsSize = directOut || countChars;
+#endif
+    if (useLockFile || compressedOut
+        || ((trackFileSize || timeIndex) && ! lengthIsSize))
+    {
+        defer_flush_guard guard (deferFlush);
+        for (spi::InternalLoggingEvent const * event : events)
+            append(*event);
+    }
+    else
+    {
+        // append() formats into `batchBuffer` while `batching` is set.
+        // Overrides of append() that roll the file over close it, which
+        // writes the buffer first.
+        batching = true;
+        try
+        {
+            for (spi::InternalLoggingEvent const * event : events)
+                append(*event);
+        }
+        catch (...)
+        {
+            batching = false;
+            writeBatchBuffer ();
+            throw;
+        }
+        batching = false;
+        writeBatchBuffer ();
 
-    out.open(std::filesystem::path (filename), mode);
+        if (! immediateFlush && flusher)
+            flusher->written ();
+        if (fileSync)
+            syncAppended ();
+    }
+
+    if(immediateFlush || useLockFile)
+        flushFile();
+}
+
+void
+FileAppenderBase::afterAppend(LogLevel maxLevel)
+{
+    if (fileSync
+        && syncPolicy.level != NOT_SET_LOG_LEVEL
+        && maxLevel >= syncPolicy.level)
+        fileSync->wait ();
+}
+
+
+thread::Mutex const &
+FileAppenderBase::fscGetAccessMutex () const
+{
+    return access_mutex;
+}
+
+
+void
+FileAppenderBase::fscFlush ()
+{
+    // Writes must be complete before the file is synchronized.
+    if (compressedOut)
+        compressedOut->wait ();
+    else if (directOut)
+        directOut->wait ();
+    else
+        out.flush ();
+
+    if (flusher)
+        flusher->flushed ();
+}
+
+
+thread::Mutex const &
+FileAppenderBase::dfcGetAccessMutex () const
+{
+    return access_mutex;
+}
+
+
+void
+FileAppenderBase::dfcFlush ()
+{
+    flushFile ();
+}
+
+
+void
+FileAppenderBase::open(std::ios_base::openmode mode)
+{
+    if (createDirs)
+        internal::make_dirs (filename);
 
-    if(!out.good()) {
+    if(!openFile(filename, mode)) {
         getErrorHandler()->error(LOG4CPLUS_TEXT("Unable to open file: ") + filename);
         return;
     }
@@ -373,10 +1330,7 @@ FileAppenderBase::reopen()
             || reopenDelay == 0)
         {
             // Close the current file
-            out.close();
-            // reset flags since the C++ standard specified that all
-            // the flags should remain unchanged on a close
-            out.clear();
+            closeFile();
 
             // Re-open the file.
             open(std::ios_base::out | std::ios_base::ate | std::ios_base::app);
@@ -385,13 +1339,238 @@ FileAppenderBase::reopen()
             reopen_time = log4cplus::helpers::Time ();
 
             // Succeed if no errors are found.
-            if(out.good())
+            if(isFileGood())
                 return true;
         }
     }
     return false;
 }
 
+
+bool
+FileAppenderBase::openFile(const tstring& name, std::ios_base::openmode mode)
+{
+    bool good;
+    if (compressedOut)
+        good = compressedOut->open (name, mode);
+    else if (directOut)
+        good = directOut->open (name, mode);
+    else
+    {
+        out.open(std::filesystem::path (name), mode);
+        good = out.good ();
+    }
+
+    if (good)
+    {
+        resyncFileSize ();
+        if (timeIndex)
+            timeIndex->open (helpers::timeIndexName (name),
+                (mode & (std::ios_base::app | std::ios_base::ate)) != 0,
+                static_cast<std::uint64_t>(fileSize));
+        if (fileSync)
+        {
+            fileSync->attach (name);
+            syncPosition = fileSize;
+        }
+    }
+
+    return good;
+}
+
+
+void
+FileAppenderBase::closeFile()
+{
+    writeBatchBuffer ();
+
+    if (fileSync)
+        fileSync->detach ();
+
+    if (flusher)
+        flusher->flushed ();
+
+    if (timeIndex)
+        timeIndex->close ();
+
+    if (compressedOut)
+        compressedOut->close ();
+    else if (directOut)
+        directOut->close ();
+    else
+    {
+        out.close();
+        // reset flags since the C++ standard specified that all
+        // the flags should remain unchanged on a close
+        out.clear();
+    }
+}
+
+
+bool
+FileAppenderBase::isFileGood() const
+{
+    if (compressedOut)
+        return compressedOut->good ();
+    else if (directOut)
+        return directOut->good ();
+    else
+        return out.good ();
+}
+
+
+void
+FileAppenderBase::flushFile()
+{
+    if (compressedOut)
+        // The incomplete block is compressed and written in background.
+        compressedOut->flush ();
+    else if (directOut)
+    {
+        // Writes must reach the file before the lock file is unlocked.
+        if (useLockFile)
+            directOut->wait ();
+        else
+            directOut->flush ();
+    }
+    else
+        out.flush ();
+
+    if (flusher)
+        flusher->flushed ();
+}
+
+
+void
+FileAppenderBase::seekFileEnd()
+{
+    // Compressed files are never shared with other processes.
+    if (compressedOut)
+        return;
+    else if (directOut)
+        directOut->seekToEnd ();
+    else
+        out.seekp (0, std::ios_base::end);
+}
+
+
+std::streamoff
+FileAppenderBase::getFilePosition()
+{
+    if (compressedOut)
+        return static_cast<std::streamoff>(compressedOut->size ());
+    else if (directOut)
+        return static_cast<std::streamoff>(directOut->size ());
+    else
+        return out.tellp ();
+}
+
+
+void
+FileAppenderBase::resyncFileSize()
+{
+    seekFileEnd ();
+    fileSize = getFilePosition ();
+}
+
+
+bool
+FileAppenderBase::useAsyncRollover() const
+{
+    // Other processes sharing the file expect it to be rolled over
+    // while the lock file is locked.
+    return asyncRollover && ! useLockFile;
+}
+
+
+unsigned
+FileAppenderBase::backupParts() const
+{
+    return (compressBackups ? backup_compressed : 0u)
+        | (timeIndex ? backup_time_index : 0u);
+}
+
+
+void
+FileAppenderBase::queueMaintenance(std::function<void ()> job)
+{
+    lastMaintenanceJob = helpers::queueMaintenanceJob (std::move (job));
+}
+
+
+void
+FileAppenderBase::waitForMaintenance()
+{
+    helpers::waitForMaintenanceJob (lastMaintenanceJob);
+}
+
+
+void
+FileAppenderBase::compressBackup(const tstring& base, unsigned index,
+    unsigned maxIndex)
+{
+    compressBackup (backupCompressor, base, index, maxIndex);
+}
+
+
+void
+FileAppenderBase::compressBackup(BackupCompressorPtr const & compressor,
+    const tstring& base, unsigned index, unsigned maxIndex)
+{
+    if (compressor)
+        BackupCompressor::compress (compressor, base, index, maxIndex);
+}
+
+
+void
+FileAppenderBase::removeExpiredBackup(BackupCompressorPtr const & compressor,
+    const tstring& name, unsigned parts)
+{
+    if (compressor)
+        compressor->expire (name, parts);
+    else
+        remove_backup (name, parts);
+}
+
+
+void
+FileAppenderBase::shiftBackups(BackupCompressorPtr const & compressor,
+    const tstring& base, std::function<void ()> const & shift)
+{
+    if (compressor)
+        compressor->shift (base, shift);
+    else
+        shift ();
+}
+
+
+tstring
+FileAppenderBase::stageForRollover(const tstring& name)
+{
+    // The staging name of the previous rollover must be free.
+    waitForMaintenance ();
+
+    tstring const staging = rollover_staging_name (name);
+    helpers::LogLog & loglog = helpers::getLogLog ();
+
+    // Do not overwrite a file left behind by an interrupted rollover.
+    helpers::FileInfo fi;
+    if (getFileInfo (&fi, staging) == 0)
+    {
+        loglog.warn (LOG4CPLUS_TEXT("Rollover staging file ") + staging
+            + LOG4CPLUS_TEXT(" exists; rolling over synchronously"));
+        return tstring ();
+    }
+
+    long const ret = file_rename (name, staging);
+    loglog_renaming_result (loglog, name, staging, ret);
+    if (ret != 0)
+        return tstring ();
+
+    rename_time_index (name, staging, backupParts ());
+    return staging;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // FileAppender ctors and dtor
 ///////////////////////////////////////////////////////////////////////////////
@@ -450,28 +1629,19 @@ RollingFileAppender::RollingFileAppender(const tstring& filename_,
 
 
 RollingFileAppender::RollingFileAppender(const Properties& properties)
-    : FileAppender(properties, std::ios_base::app)
+    : FileAppender(indexed_rolling_properties (properties), std::ios_base::app)
 {
-    long tmpMaxFileSize = DEFAULT_ROLLING_LOG_SIZE;
-    int tmpMaxBackupIndex = 1;
-    tstring tmp (
-        helpers::toUpper (
-            properties.getProperty (LOG4CPLUS_TEXT ("MaxFileSize"))));
-    if (! tmp.empty ())
+    if (is_indexed_rolling (properties, true))
     {
-        tmpMaxFileSize = std::atoi(LOG4CPLUS_TSTRING_TO_STRING(tmp).c_str());
-        if (tmpMaxFileSize != 0)
-        {
-            tstring::size_type const len = tmp.length();
-            if (len > 2
-                && tmp.compare (len - 2, 2, LOG4CPLUS_TEXT("MB")) == 0)
-                tmpMaxFileSize *= (1024 * 1024); // convert to megabytes
-            else if (len > 2
-                && tmp.compare (len - 2, 2, LOG4CPLUS_TEXT("KB")) == 0)
-                tmpMaxFileSize *= 1024; // convert to kilobytes
-        }
+        indexedRolling = true;
+        baseFilename = properties.getProperty (LOG4CPLUS_TEXT ("File"));
     }
 
+    long tmpMaxFileSize = parse_file_size (
+        properties.getProperty (LOG4CPLUS_TEXT ("MaxFileSize")),
+        DEFAULT_ROLLING_LOG_SIZE);
+    int tmpMaxBackupIndex = 1;
+
     properties.getInt (tmpMaxBackupIndex, LOG4CPLUS_TEXT("MaxBackupIndex"));
 
     init(tmpMaxFileSize, tmpMaxBackupIndex);
@@ -493,6 +1663,46 @@ RollingFileAppender::init(long maxFileSize_, int maxBackupIndex_)
 
     maxFileSize = maxFileSize_;
     maxBackupIndex = (std::max)(maxBackupIndex_, 1);
+    // The file has been opened by FileAppender constructor already and
+    // openFile() has set fileSize.
+    trackFileSize = true;
+
+    if (indexedRolling)
+    {
+        std::vector<unsigned long> const indices (
+            scan_indexed_files (baseFilename));
+        fileIndex = indices.empty () ? 1 : indices.back ();
+
+        // Remove files that have fallen out of the history while the
+        // appender was not running.
+        std::vector<tstring> obsolete;
+        for (unsigned long index : indices)
+            if (index + maxBackupIndex < fileIndex)
+                obsolete.push_back (indexed_file_name (baseFilename, index));
+
+        auto removeFiles = [obsolete = std::move (obsolete),
+            parts = backupParts (), compressor = backupCompressor] {
+            for (tstring const & name : obsolete)
+                removeExpiredBackup (compressor, name, parts);
+        };
+        if (useAsyncRollover ())
+            queueMaintenance (std::move (removeFiles));
+        else
+            removeFiles ();
+
+        return;
+    }
+
+    // Finish a rollover that has been interrupted before the file left
+    // at the staging name was moved to its place.
+    tstring const staging = rollover_staging_name (filename);
+    helpers::FileInfo fi;
+    if (useAsyncRollover () && getFileInfo (&fi, staging) == 0)
+        queueMaintenance (
+            [base = filename, staging, maxBackupIndex = maxBackupIndex,
+                parts = backupParts ()] {
+                shift_backups (base, staging, maxBackupIndex, parts);
+            });
 }
 
 
@@ -511,19 +1721,19 @@ RollingFileAppender::~RollingFileAppender()
 void
 RollingFileAppender::append(const spi::InternalLoggingEvent& event)
 {
-    // Seek to the end of log file so that tellp() below returns the
-    // right size.
+    // Other processes might have appended to the file, look at its
+    // real size.
     if (useLockFile)
-        out.seekp (0, std::ios_base::end);
+        resyncFileSize ();
 
     // Rotate log file if needed before appending to it.
-    if (out.tellp() > maxFileSize)
+    if (fileSize > maxFileSize)
         rollover(true);
 
     FileAppender::append(event);
 
     // Rotate log file if needed after appending to it.
-    if (out.tellp() > maxFileSize)
+    if (fileSize > maxFileSize)
         rollover(true);
 }
 
@@ -535,10 +1745,7 @@ RollingFileAppender::rollover(bool alreadyLocked)
     helpers::LockFileGuard guard;
 
     // Close the current file
-    out.close();
-    // Reset flags since the C++ standard specified that all the flags
-    // should remain unchanged on a close.
-    out.clear();
+    closeFile();
 
     if (useLockFile)
     {
@@ -558,6 +1765,25 @@ RollingFileAppender::rollover(bool alreadyLocked)
         // process can rollover the file before us.
 
         helpers::FileInfo fi;
+        if (indexedRolling)
+        {
+            // Another process has switched to a newer file already.
+            unsigned long newest = fileIndex;
+            while (getFileInfo (&fi,
+                    indexed_file_name (baseFilename, newest + 1)) == 0)
+                ++newest;
+
+            if (newest != fileIndex)
+            {
+                fileIndex = newest;
+                filename = indexed_file_name (baseFilename, fileIndex);
+                open (std::ios_base::out | std::ios_base::ate
+                    | std::ios_base::app);
+                loglog_opening_result (loglog, isFileGood (), filename);
+                return;
+            }
+        }
+
         if (getFileInfo (&fi, filename) == -1
             || fi.size < maxFileSize)
         {
@@ -566,35 +1792,84 @@ RollingFileAppender::rollover(bool alreadyLocked)
 
             // Open it up again.
             open (std::ios_base::out | std::ios_base::ate | std::ios_base::app);
-            loglog_opening_result (loglog, out, filename);
+            loglog_opening_result (loglog, isFileGood (), filename);
 
             return;
         }
     }
 
+    if (indexedRolling)
+    {
+        // Switch to the next file and remove only the file that falls
+        // out of the history. Existing files are not renamed.
+        compressBackup (filename);
+        ++fileIndex;
+        filename = indexed_file_name (baseFilename, fileIndex);
+        if (fileIndex > static_cast<unsigned long>(maxBackupIndex) + 1)
+        {
+            tstring const oldest = indexed_file_name (baseFilename,
+                fileIndex - maxBackupIndex - 1);
+            unsigned const parts = backupParts ();
+            if (useAsyncRollover ())
+                queueMaintenance ([oldest, parts,
+                    compressor = backupCompressor] {
+                    removeExpiredBackup (compressor, oldest, parts);
+                });
+            else
+                removeExpiredBackup (backupCompressor, oldest, parts);
+        }
+
+        open(std::ios::out | std::ios::trunc);
+        loglog_opening_result (loglog, isFileGood (), filename);
+        return;
+    }
+
+    tstring staging;
+    if (maxBackupIndex > 0 && useAsyncRollover ())
+        staging = stageForRollover (filename);
+
+    if (! staging.empty ())
+    {
+        // The file is out of the way. Shifting of the backups is left
+        // to the maintenance thread.
+        queueMaintenance (
+            [base = filename, staging, maxBackupIndex = maxBackupIndex,
+                compressor = backupCompressor, parts = backupParts ()] {
+                shiftBackups (compressor, base, [&] {
+                    shift_backups (base, staging, maxBackupIndex, parts);
+                });
+                compressBackup (compressor, base, 1, maxBackupIndex);
+            });
+    }
     // If maxBackups <= 0, then there is no file renaming to be done.
-    if (maxBackupIndex > 0)
+    else if (maxBackupIndex > 0)
     {
-        rolloverFiles(filename, maxBackupIndex);
+        // Backups being compressed are out of the way, they are placed
+        // where the shifts below move their backups.
+        shiftBackups (backupCompressor, filename, [&] {
+            rolloverFiles(filename, maxBackupIndex, backupParts ());
 
-        // Rename fileName to fileName.1
-        tstring target = filename + LOG4CPLUS_TEXT(".1");
+            // Rename fileName to fileName.1
+            tstring target = filename + LOG4CPLUS_TEXT(".1");
 
-        long ret;
+            long ret;
 
 #if defined (_WIN32)
-        // Try to remove the target first. It seems it is not
-        // possible to rename over existing file.
-        ret = file_remove (target);
+            // Try to remove the target first. It seems it is not
+            // possible to rename over existing file.
+            ret = file_remove (target);
 #endif
 
-        loglog.debug (
-            LOG4CPLUS_TEXT("Renaming file ")
-            + filename
-            + LOG4CPLUS_TEXT(" to ")
-            + target);
-        ret = file_rename (filename, target);
-        loglog_renaming_result (loglog, filename, target, ret);
+            loglog.debug (
+                LOG4CPLUS_TEXT("Renaming file ")
+                + filename
+                + LOG4CPLUS_TEXT(" to ")
+                + target);
+            ret = file_rename (filename, target);
+            loglog_renaming_result (loglog, filename, target, ret);
+            rename_time_index (filename, target, backupParts ());
+        });
+        compressBackup (filename, 1, maxBackupIndex);
     }
     else
     {
@@ -603,17 +1878,384 @@ RollingFileAppender::rollover(bool alreadyLocked)
 
     // Open it up again in truncation mode
     open(std::ios::out | std::ios::trunc);
-    loglog_opening_result (loglog, out, filename);
+    loglog_opening_result (loglog, isFileGood (), filename);
 }
 
 
 ///////////////////////////////////////////////////////////////////////////////
-// DailyRollingFileAppender ctors and dtor
+// MappedSegmentAppender ctors and dtor
 ///////////////////////////////////////////////////////////////////////////////
 
-DailyRollingFileAppender::DailyRollingFileAppender(
-    const tstring& filename_, DailyRollingFileSchedule schedule_,
-    bool immediateFlush_, int maxBackupIndex_, bool createDirs_,
+MappedSegmentAppender::MappedSegmentAppender(const tstring& filename_,
+    long segmentSize_, int maxBackupIndex_, bool createDirs_)
+    : filename (filename_)
+    , segmentSize (segmentSize_)
+    , maxBackupIndex (maxBackupIndex_)
+    , appendToFile (true)
+    , createDirs (createDirs_)
+    , fd (-1)
+    , mapping (nullptr)
+    , mappingSize (0)
+    , offset (0)
+{
+    init();
+}
+
+
+MappedSegmentAppender::MappedSegmentAppender(const Properties& properties)
+    : Appender (properties)
+    , maxBackupIndex (1)
+    , appendToFile (true)
+    , createDirs (false)
+    , fd (-1)
+    , mapping (nullptr)
+    , mappingSize (0)
+    , offset (0)
+{
+    filename = properties.getProperty (LOG4CPLUS_TEXT ("File"));
+    segmentSize = parse_file_size (
+        properties.getProperty (LOG4CPLUS_TEXT ("SegmentSize")),
+        DEFAULT_ROLLING_LOG_SIZE);
+    properties.getInt (maxBackupIndex, LOG4CPLUS_TEXT ("MaxBackupIndex"));
+    properties.getBool (appendToFile, LOG4CPLUS_TEXT ("Append"));
+    properties.getBool (createDirs, LOG4CPLUS_TEXT ("CreateDirs"));
+
+    init();
+}
+
+
+void
+MappedSegmentAppender::init()
+{
+    if (segmentSize < MINIMUM_SEGMENT_SIZE)
+    {
+        tostringstream oss;
+        oss << LOG4CPLUS_TEXT ("MappedSegmentAppender: SegmentSize property")
+            LOG4CPLUS_TEXT (" value is too small. Resetting to ")
+            << MINIMUM_SEGMENT_SIZE << ".";
+        helpers::getLogLog ().warn (oss.str ());
+        segmentSize = MINIMUM_SEGMENT_SIZE;
+    }
+
+    maxBackupIndex = (std::max)(maxBackupIndex, 1);
+
+    if (filename.empty())
+    {
+        getErrorHandler()->error( LOG4CPLUS_TEXT("Invalid filename") );
+        return;
+    }
+
+#if ! defined (LOG4CPLUS_USE_MMAP)
+    getErrorHandler()->error (
+        LOG4CPLUS_TEXT ("MappedSegmentAppender is not supported")
+        LOG4CPLUS_TEXT (" on this platform"));
+
+#else
+    if (createDirs)
+        internal::make_dirs (filename);
+
+    openSegment (appendToFile, 0);
+
+#endif
+}
+
+
+MappedSegmentAppender::~MappedSegmentAppender()
+{
+    destructorImpl();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// MappedSegmentAppender public methods
+///////////////////////////////////////////////////////////////////////////////
+
+void
+MappedSegmentAppender::close()
+{
+    thread::MutexGuard guard (access_mutex);
+
+    closeSegment ();
+    closed = true;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// MappedSegmentAppender protected methods
+///////////////////////////////////////////////////////////////////////////////
+
+// This method does not need to be locked since it is called by
+// doAppend() which performs the locking
+void
+MappedSegmentAppender::append(const spi::InternalLoggingEvent& event)
+{
+    if (! mapping)
+    {
+        getErrorHandler()->error(  LOG4CPLUS_TEXT("file is not open: ")
+                                 + filename);
+        return;
+    }
+
+#if defined (UNICODE)
+    std::string const str (LOG4CPLUS_TSTRING_TO_STRING (formatEvent (event)));
+    std::string_view const data (str);
+#else
+    std::string_view const data (formatEvent (event));
+#endif
+
+    if (data.size () > mappingSize - offset)
+    {
+        rollover (data.size ());
+        if (! mapping)
+            return;
+    }
+
+    std::memcpy (mapping + offset, data.data (), data.size ());
+    offset += data.size ();
+}
+
+
+bool
+MappedSegmentAppender::openSegment(bool appendToFile_, std::size_t minSize)
+{
+#if defined (LOG4CPLUS_USE_MMAP)
+    int flags = O_RDWR | O_CREAT;
+#if defined (O_CLOEXEC)
+    flags |= O_CLOEXEC;
+#endif
+    if (! appendToFile_)
+        flags |= O_TRUNC;
+
+    fd = ::open (LOG4CPLUS_TSTRING_TO_STRING (filename).c_str (), flags,
+        S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH);
+    if (fd == -1)
+    {
+        getErrorHandler()->error(LOG4CPLUS_TEXT("Unable to open file: ")
+            + filename);
+        return false;
+    }
+
+    struct stat st;
+    std::size_t const existing = fstat (fd, &st) == 0
+        ? static_cast<std::size_t>(st.st_size) : 0;
+    std::size_t const size = (std::max) ({
+        static_cast<std::size_t>(segmentSize), minSize, existing});
+
+    // Never map past end of file, e.g., after a failed preallocation
+    // or after the file has been truncated by somebody else. Writes
+    // into such pages would raise SIGBUS.
+    int ret = existing < size
+        ? internal::preallocate_file (fd, size)
+        : internal::check_file_size (fd, size);
+
+    void * ptr = MAP_FAILED;
+    if (ret == 0)
+    {
+        ptr = mmap (nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (ptr == MAP_FAILED)
+            ret = errno;
+    }
+
+    if (ret != 0)
+    {
+        getErrorHandler()->error(LOG4CPLUS_TEXT("Unable to map file: ")
+            + filename + LOG4CPLUS_TEXT("; error ")
+            + helpers::convertIntegerToString (ret));
+        ::close (fd);
+        fd = -1;
+        return false;
+    }
+
+    mapping = static_cast<char *>(ptr);
+    mappingSize = size;
+
+    // Continue after existing data. Tail of segment that has not been
+    // closed properly is filled with zero bytes.
+    offset = existing;
+    while (offset != 0 && mapping[offset - 1] == 0)
+        --offset;
+
+    helpers::getLogLog().debug(LOG4CPLUS_TEXT("Just opened file: ") + filename);
+    return true;
+
+#else
+    (void) appendToFile_;
+    (void) minSize;
+    return false;
+
+#endif
+}
+
+
+void
+MappedSegmentAppender::closeSegment()
+{
+#if defined (LOG4CPLUS_USE_MMAP)
+    if (mapping)
+    {
+        munmap (mapping, mappingSize);
+        mapping = nullptr;
+        mappingSize = 0;
+    }
+
+    if (fd != -1)
+    {
+        if (ftruncate (fd, static_cast<off_t>(offset)) == -1)
+            helpers::getLogLog ().error (
+                LOG4CPLUS_TEXT ("Failed to truncate file ") + filename
+                + LOG4CPLUS_TEXT ("; error ")
+                + helpers::convertIntegerToString (errno));
+
+        ::close (fd);
+        fd = -1;
+    }
+
+    offset = 0;
+
+#endif
+}
+
+
+void
+MappedSegmentAppender::rollover(std::size_t minSize)
+{
+    helpers::LogLog & loglog = helpers::getLogLog();
+
+    closeSegment ();
+
+    rolloverFiles (filename, maxBackupIndex);
+
+    // Rename fileName to fileName.1
+    tstring const target = filename + LOG4CPLUS_TEXT(".1");
+    loglog.debug (
+        LOG4CPLUS_TEXT("Renaming file ")
+        + filename
+        + LOG4CPLUS_TEXT(" to ")
+        + target);
+    long const ret = file_rename (filename, target);
+    loglog_renaming_result (loglog, filename, target, ret);
+
+    openSegment (false, minSize);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// CircularFileAppender ctors and dtor
+///////////////////////////////////////////////////////////////////////////////
+
+CircularFileAppender::CircularFileAppender(const tstring& filename_,
+    long fileSize_, bool createDirs_)
+    : filename (filename_)
+    , fileSize (fileSize_)
+    , appendToFile (true)
+    , createDirs (createDirs_)
+{
+    init();
+}
+
+
+CircularFileAppender::CircularFileAppender(const Properties& properties)
+    : Appender (properties)
+    , appendToFile (true)
+    , createDirs (false)
+{
+    filename = properties.getProperty (LOG4CPLUS_TEXT ("File"));
+    fileSize = parse_file_size (
+        properties.getProperty (LOG4CPLUS_TEXT ("FileSize")),
+        DEFAULT_ROLLING_LOG_SIZE);
+    properties.getBool (appendToFile, LOG4CPLUS_TEXT ("Append"));
+    properties.getBool (createDirs, LOG4CPLUS_TEXT ("CreateDirs"));
+
+    init();
+}
+
+
+void
+CircularFileAppender::init()
+{
+    if (fileSize < MINIMUM_SEGMENT_SIZE)
+    {
+        tostringstream oss;
+        oss << LOG4CPLUS_TEXT ("CircularFileAppender: FileSize property")
+            LOG4CPLUS_TEXT (" value is too small. Resetting to ")
+            << MINIMUM_SEGMENT_SIZE << ".";
+        helpers::getLogLog ().warn (oss.str ());
+        fileSize = MINIMUM_SEGMENT_SIZE;
+    }
+
+    if (filename.empty())
+    {
+        getErrorHandler()->error( LOG4CPLUS_TEXT("Invalid filename") );
+        return;
+    }
+
+    if (createDirs)
+        internal::make_dirs (filename);
+
+    if (! file.open (filename, static_cast<std::size_t>(fileSize),
+            appendToFile))
+    {
+        getErrorHandler()->error(LOG4CPLUS_TEXT("Unable to open file: ")
+            + filename);
+        return;
+    }
+
+    helpers::getLogLog().debug(LOG4CPLUS_TEXT("Just opened file: ") + filename);
+}
+
+
+CircularFileAppender::~CircularFileAppender()
+{
+    destructorImpl();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// CircularFileAppender public methods
+///////////////////////////////////////////////////////////////////////////////
+
+void
+CircularFileAppender::close()
+{
+    thread::MutexGuard guard (access_mutex);
+
+    file.close ();
+    closed = true;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// CircularFileAppender protected methods
+///////////////////////////////////////////////////////////////////////////////
+
+// This method does not need to be locked since it is called by
+// doAppend() which performs the locking
+void
+CircularFileAppender::append(const spi::InternalLoggingEvent& event)
+{
+    if (! file.is_open ())
+    {
+        getErrorHandler()->error(  LOG4CPLUS_TEXT("file is not open: ")
+                                 + filename);
+        return;
+    }
+
+#if defined (UNICODE)
+    file.write (LOG4CPLUS_TSTRING_TO_STRING (formatEvent (event)),
+        event.getTimestamp ());
+#else
+    file.write (formatEvent (event), event.getTimestamp ());
+#endif
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// DailyRollingFileAppender ctors and dtor
+///////////////////////////////////////////////////////////////////////////////
+
+DailyRollingFileAppender::DailyRollingFileAppender(
+    const tstring& filename_, DailyRollingFileSchedule schedule_,
+    bool immediateFlush_, int maxBackupIndex_, bool createDirs_,
     bool rollOnClose_, const tstring& datePattern_)
     : FileAppender(filename_, std::ios_base::app, immediateFlush_, createDirs_)
     , maxBackupIndex(maxBackupIndex_)
@@ -691,15 +2333,7 @@ static
 std::chrono::seconds
 local_time_offset (Time const & t)
 {
-    tm time_local, time_gmt;
-
-    helpers::localTime (&time_local, t);
-    helpers::gmTime (&time_gmt, t);
-
-    Time t2 = helpers::from_struct_tm (&time_local);
-    Time t3 = helpers::from_struct_tm (&time_gmt);
-
-    return std::chrono::duration_cast<std::chrono::seconds> (t2 - t3);
+    return helpers::localTimeOffset (t);
 }
 
 
@@ -711,6 +2345,31 @@ adjust_for_time_zone (Time const & t, std::chrono::seconds const & tzoffset)
 }
 
 
+//! \return Start of the next period of local time of length `period`
+//! that divides a day, computed from cached UTC offsets instead of
+//! <code>mktime()</code>. Like <code>mktime()</code> with
+//! <code>tm_isdst</code> of -1, a start that falls into a gap of a DST
+//! transition is moved to the end of the gap.
+static
+Time
+next_local_period_start (Time const & t, std::chrono::seconds period)
+{
+    std::chrono::seconds const offset = local_time_offset (t);
+    Time const nextLocal = round_time_and_add (
+        helpers::time_cast (t + offset), period);
+    Time const start = adjust_for_time_zone (nextLocal, offset);
+
+    // The offset changes when there is a DST transition before the
+    // start.
+    std::chrono::seconds const nextOffset = local_time_offset (start);
+    if (nextOffset == offset)
+        return start;
+
+    Time const other = adjust_for_time_zone (nextLocal, nextOffset);
+    return local_time_offset (other) == nextOffset ? other : start;
+}
+
+
 } // namespace
 
 
@@ -783,55 +2442,73 @@ DailyRollingFileAppender::rollover(bool alreadyLocked)
     }
 
     // Close the current file
-    out.close();
-    // reset flags since the C++ standard specified that all the flags
-    // should remain unchanged on a close
-    out.clear();
-
-    // If we've already rolled over this time period, we'll make sure that we
-    // don't overwrite any of those previous files.
-    // E.g. if "log.2009-11-07.1" already exists we rename it
-    // to "log.2009-11-07.2", etc.
-    rolloverFiles(scheduledFilename, maxBackupIndex);
-
-    // Do not overwriet the newest file either, e.g. if "log.2009-11-07"
-    // already exists rename it to "log.2009-11-07.1"
-    tostringstream backup_target_oss;
-    backup_target_oss << scheduledFilename << LOG4CPLUS_TEXT(".") << 1;
-    tstring backupTarget = backup_target_oss.str();
+    closeFile();
 
     helpers::LogLog & loglog = helpers::getLogLog();
-    long ret;
 
-#if defined (_WIN32)
-    // Try to remove the target first. It seems it is not
-    // possible to rename over existing file, e.g. "log.2009-11-07.1".
-    ret = file_remove (backupTarget);
-#endif
+    tstring const staging
+        = useAsyncRollover () ? stageForRollover (filename) : tstring ();
+    if (! staging.empty ())
+    {
+        // The file is out of the way. Renaming of the backups and of
+        // the file itself is left to the maintenance thread.
+        queueMaintenance (
+            [scheduled = scheduledFilename, staging,
+                maxBackupIndex = maxBackupIndex,
+                compressor = backupCompressor, parts = backupParts ()] {
+                shiftBackups (compressor, scheduled, [&] {
+                    shift_backups (scheduled, scheduled, maxBackupIndex,
+                        parts);
+                });
+                rename_replacing (staging, scheduled);
+                rename_time_index (staging, scheduled, parts);
+                compressBackup (compressor, scheduled, 0, maxBackupIndex);
+            });
+    }
+    else
+    {
+        // Backups being compressed are out of the way, they are placed
+        // where the shift below moves their backups.
+        shiftBackups (backupCompressor, scheduledFilename, [&] {
+            // If we've already rolled over this time period, we'll make
+            // sure that we don't overwrite any of those previous files.
+            // E.g. if "log.2009-11-07.1" already exists we rename it
+            // to "log.2009-11-07.2", etc.
+            rolloverFiles(scheduledFilename, maxBackupIndex,
+                backupParts ());
+
+            // Do not overwriet the newest file either, e.g. if
+            // "log.2009-11-07" already exists rename it to
+            // "log.2009-11-07.1"
+            tstring const backupTarget = backup_name (scheduledFilename, 1);
+            rename_backup (scheduledFilename, backupTarget,
+                backupParts ());
+        });
 
-    // Rename e.g. "log.2009-11-07" to "log.2009-11-07.1".
-    ret = file_rename (scheduledFilename, backupTarget);
-    loglog_renaming_result (loglog, scheduledFilename, backupTarget, ret);
+        long ret;
 
 #if defined (_WIN32)
-    // Try to remove the target first. It seems it is not
-    // possible to rename over existing file, e.g. "log.2009-11-07".
-    ret = file_remove (scheduledFilename);
+        // Try to remove the target first. It seems it is not
+        // possible to rename over existing file, e.g. "log.2009-11-07".
+        ret = file_remove (scheduledFilename);
 #endif
 
-    // Rename filename to scheduledFilename,
-    // e.g. rename "log" to "log.2009-11-07".
-    loglog.debug(
-        LOG4CPLUS_TEXT("Renaming file ")
-        + filename
-        + LOG4CPLUS_TEXT(" to ")
-        + scheduledFilename);
-    ret = file_rename (filename, scheduledFilename);
-    loglog_renaming_result (loglog, filename, scheduledFilename, ret);
+        // Rename filename to scheduledFilename,
+        // e.g. rename "log" to "log.2009-11-07".
+        loglog.debug(
+            LOG4CPLUS_TEXT("Renaming file ")
+            + filename
+            + LOG4CPLUS_TEXT(" to ")
+            + scheduledFilename);
+        ret = file_rename (filename, scheduledFilename);
+        loglog_renaming_result (loglog, filename, scheduledFilename, ret);
+        rename_time_index (filename, scheduledFilename, backupParts ());
+        compressBackup (scheduledFilename, 0, maxBackupIndex);
+    }
 
     // Open a new file, e.g. "log".
     open(std::ios::out | std::ios::trunc);
-    loglog_opening_result (loglog, out, filename);
+    loglog_opening_result (loglog, isFileGood (), filename);
 
     // Calculate the next rollover time
     log4cplus::helpers::Time now = helpers::now ();
@@ -915,89 +2592,13 @@ calculateNextRolloverTime(const Time& t, DailyRollingFileSchedule schedule)
         [[fallthrough]];
 
     case DailyRollingFileSchedule::DAILY:
-    {
-        helpers::localTime(&next, t);
-        next.tm_mday += 1;
-        next.tm_hour = 0;
-        next.tm_min = 0;
-        next.tm_sec = 0;
-        next.tm_isdst = -1;
-
-        Time ret;
-        try
-        {
-            ret = helpers::from_struct_tm (&next);
-        }
-        catch (std::runtime_error const & e)
-        {
-            helpers::getLogLog().error(
-                LOG4CPLUS_TEXT("calculateNextRolloverTime()-")
-                LOG4CPLUS_TEXT(" from_struct_tm() returned error: ")
-                + LOG4CPLUS_C_STR_TO_TSTRING (e.what ()));
-            // Set next rollover to 24 hours in future.
-            ret = round_time (t, chrono::seconds (60 * 60))
-                + chrono::seconds (24 * 60 * 60);
-        }
-
-        return ret;
-    }
+        return next_local_period_start (t, chrono::seconds (24 * 60 * 60));
 
     case DailyRollingFileSchedule::TWICE_DAILY:
-    {
-        helpers::localTime(&next, t);
-        if (next.tm_hour < 12)
-            next.tm_hour = 12;
-        else
-            next.tm_hour = 24;
-        next.tm_min = 0;
-        next.tm_sec = 0;
-        next.tm_isdst = -1;
-
-        Time ret;
-        try
-        {
-            ret = helpers::from_struct_tm (&next);
-        }
-        catch (std::runtime_error const & e)
-        {
-            helpers::getLogLog().error(
-                LOG4CPLUS_TEXT("calculateNextRolloverTime()-")
-                LOG4CPLUS_TEXT(" from_struct_tm() returned error: ")
-                + LOG4CPLUS_C_STR_TO_TSTRING (e.what ()));
-            // Set next rollover to 12 hours in future.
-            ret = round_time (t, chrono::seconds (60 * 60))
-                + chrono::seconds (12 * 60 * 60);
-        }
-
-        return ret;
-    }
+        return next_local_period_start (t, chrono::seconds (12 * 60 * 60));
 
     case DailyRollingFileSchedule::HOURLY:
-    {
-        helpers::localTime(&next, t);
-        next.tm_hour += 1;
-        next.tm_min = 0;
-        next.tm_sec = 0;
-        next.tm_isdst = -1;
-
-        Time ret;
-        try
-        {
-            ret = helpers::from_struct_tm (&next);
-        }
-        catch (std::runtime_error const & e)
-        {
-            helpers::getLogLog().error(
-                LOG4CPLUS_TEXT("calculateNextRolloverTime()-")
-                LOG4CPLUS_TEXT(" from_struct_tm() returned error: ")
-                + LOG4CPLUS_C_STR_TO_TSTRING (e.what ()));
-            // Set next rollover to 60 minutes in future.
-            ret = round_time (t, chrono::seconds (60 * 60))
-                + chrono::seconds (60 * 60);
-        }
-
-        return ret;
-    }
+        return next_local_period_start (t, chrono::seconds (60 * 60));
 
     case DailyRollingFileSchedule::MINUTELY:
         return round_time_and_add (t, chrono::seconds (60));
@@ -1359,8 +2960,7 @@ TimeBasedRollingFileAppender::open(std::ios_base::openmode mode)
     if (createDirs)
         internal::make_dirs (currentFilename);
 
-    out.open(std::filesystem::path (currentFilename), mode);
-    if(!out.good())
+    if(!openFile(currentFilename, mode))
     {
         getErrorHandler()->error(LOG4CPLUS_TEXT("Unable to open file: ") + currentFilename);
         return;
@@ -1394,10 +2994,7 @@ TimeBasedRollingFileAppender::rollover(bool alreadyLocked)
     }
 
     // Close the current file
-    out.close();
-    // reset flags since the C++ standard specified that all the flags
-    // should remain unchanged on a close
-    out.clear();
+    closeFile();
 
     if (filename != scheduledFilename)
     {
@@ -1417,6 +3014,8 @@ TimeBasedRollingFileAppender::rollover(bool alreadyLocked)
             + scheduledFilename);
         ret = file_rename (filename, scheduledFilename);
         loglog_renaming_result (loglog, filename, scheduledFilename, ret);
+        rename_time_index (filename, scheduledFilename, backupParts ());
+        compressBackup (scheduledFilename);
     }
 
     Time now = helpers::now();
@@ -1439,15 +3038,26 @@ TimeBasedRollingFileAppender::clean(Time time)
     Time::duration period = getRolloverPeriodDuration();
     long periods = long(interval.count () / period.count ());
 
-    helpers::LogLog & loglog = helpers::getLogLog();
-    for (long i = 0; i < periods; i++)
+    auto removeFiles = [pattern = filenamePattern, time, period, periods,
+        maxHistory = maxHistory, parts = backupParts ()]
     {
-        long periodToRemove = (-maxHistory - 1) - i;
-        Time timeToRemove = time + periodToRemove * period;
-        tstring filenameToRemove = helpers::getFormattedTime(filenamePattern, timeToRemove, false);
-        loglog.debug(LOG4CPLUS_TEXT("Removing file ") + filenameToRemove);
-        file_remove(filenameToRemove);
-    }
+        helpers::LogLog & loglog = helpers::getLogLog();
+        for (long i = 0; i < periods; i++)
+        {
+            long periodToRemove = (-maxHistory - 1) - i;
+            Time timeToRemove = time + periodToRemove * period;
+            tstring filenameToRemove = helpers::getFormattedTime(pattern, timeToRemove, false);
+            loglog.debug(LOG4CPLUS_TEXT("Removing file ") + filenameToRemove);
+            for (tstring const & name
+                    : backup_file_names (filenameToRemove, parts))
+                file_remove(name);
+        }
+    };
+
+    if (periods > 0 && useAsyncRollover ())
+        queueMaintenance (std::move (removeFiles));
+    else
+        removeFiles ();
 
     lastHeartBeat = time;
 }
@@ -1506,6 +3116,1261 @@ CATCH_TEST_CASE ("TimeBasedRollingFileAppender", "[appender]")
     }
 
 }
+
+
+#if ! defined (_WIN32)
+CATCH_TEST_CASE ("DailyRollingFileAppender rollover times", "[appender]")
+{
+    char const * const old_tz = std::getenv ("TZ");
+    std::string const saved_tz (old_tz ? old_tz : "");
+
+    // Start of the next period computed using mktime().
+    auto expected_next = [] (Time const & t, DailyRollingFileSchedule sch) {
+        tm next;
+        helpers::localTime (&next, t);
+        if (sch == DailyRollingFileSchedule::DAILY)
+            next.tm_mday += 1, next.tm_hour = 0;
+        else if (sch == DailyRollingFileSchedule::TWICE_DAILY)
+            next.tm_hour = next.tm_hour < 12 ? 12 : 24;
+        else
+            next.tm_hour += 1;
+        next.tm_min = 0;
+        next.tm_sec = 0;
+        next.tm_isdst = -1;
+        return helpers::from_struct_tm (&next);
+    };
+
+    struct Zone
+    {
+        char const * tz;
+        std::vector<time_t> transitions;
+    };
+    std::vector<Zone> const zones {
+        // Transitions at 2023-03-12 07:00:00 and 2023-11-05 06:00:00 UTC.
+        {"EST5EDT,M3.2.0,M11.1.0", {1678604400, 1699164000}},
+        {"<+0530>-5:30", {1700000000}},
+        // Summer time starting at midnight skips the start of the day,
+        // at 2023-10-01 03:00:00 and 2024-02-18 02:00:00 UTC.
+        {"<-03>3<-02>,M10.1.0/0,M2.3.0/0", {1696129200, 1708221600}}};
+
+    for (Zone const & zone : zones)
+    {
+        ::setenv ("TZ", zone.tz, 1);
+        helpers::refreshTimeZone ();
+        for (time_t const transition : zone.transitions)
+            for (time_t clock = transition - 2 * 24 * 60 * 60;
+                 clock < transition + 2 * 24 * 60 * 60; clock += 277)
+                for (DailyRollingFileSchedule sch : {
+                        DailyRollingFileSchedule::DAILY,
+                        DailyRollingFileSchedule::TWICE_DAILY,
+                        DailyRollingFileSchedule::HOURLY})
+                {
+                    Time const t = helpers::from_time_t (clock);
+                    Time const next = calculateNextRolloverTime (t, sch);
+                    CATCH_REQUIRE (next > t);
+                    Time const expected = expected_next (t, sch);
+                    if (next == expected)
+                        continue;
+
+                    // mktime() can choose the later one of ambiguous
+                    // local times after a transition to standard time.
+                    tm local;
+                    helpers::localTime (&local, next);
+                    CATCH_REQUIRE (next < expected);
+                    CATCH_REQUIRE (local.tm_min == 0);
+                    CATCH_REQUIRE (local.tm_sec == 0);
+                    CATCH_REQUIRE (next >= helpers::from_time_t (
+                        transition) - std::chrono::hours (1));
+                }
+    }
+
+    if (old_tz)
+        ::setenv ("TZ", saved_tz.c_str (), 1);
+    else
+        ::unsetenv ("TZ");
+    helpers::refreshTimeZone ();
+}
+#endif
+
+
+CATCH_TEST_CASE ("FileAppender batch append", "[appender]")
+{
+    tstring const fileName (LOG4CPLUS_TEXT ("file_appender_batch_test.log"));
+    file_remove (fileName);
+    file_remove (fileName + LOG4CPLUS_TEXT (".1"));
+
+    auto read_lines = [] (tstring const & name) {
+        tifstream file (LOG4CPLUS_TSTRING_TO_STRING (name).c_str ());
+        std::vector<tstring> lines;
+        for (tstring line; std::getline (file, line); )
+            lines.push_back (line);
+        return lines;
+    };
+
+    auto make_event = [] (int i, LogLevel ll = INFO_LOG_LEVEL) {
+        return spi::InternalLoggingEvent (LOG4CPLUS_TEXT ("batch"), ll,
+            LOG4CPLUS_TEXT ("event ") + helpers::convertIntegerToString (i),
+            __FILE__, __LINE__);
+    };
+
+    CATCH_SECTION ("threshold")
+    {
+        {
+            SharedAppenderPtr appender (new FileAppender (fileName));
+            appender->setLayout (std::unique_ptr<Layout> (
+                new PatternLayout (LOG4CPLUS_TEXT ("%m%n"))));
+            appender->setThreshold (INFO_LOG_LEVEL);
+
+            std::vector<spi::InternalLoggingEvent> events;
+            for (int i = 0; i != 4; ++i)
+                events.push_back (make_event (i,
+                    i % 2 == 0 ? INFO_LOG_LEVEL : DEBUG_LOG_LEVEL));
+
+            appender->syncDoAppendBatch (events);
+            appender->close ();
+        }
+
+        // Events below threshold are filtered out of the batch.
+        std::vector<tstring> const lines = read_lines (fileName);
+        CATCH_REQUIRE (lines.size () == 2);
+        CATCH_REQUIRE (lines[0] == LOG4CPLUS_TEXT ("event 0"));
+        CATCH_REQUIRE (lines[1] == LOG4CPLUS_TEXT ("event 2"));
+    }
+
+    CATCH_SECTION ("one write per batch")
+    {
+        // Records the size of the file whenever an event is formatted.
+        struct FileSizeLayout : PatternLayout
+        {
+            FileSizeLayout (tstring const & name_)
+                : PatternLayout (LOG4CPLUS_TEXT ("%m%n"))
+                , name (name_)
+            { }
+
+            using PatternLayout::formatAndAppend;
+
+            virtual void formatAndAppend (tstring & buf,
+                spi::InternalLoggingEvent const & event) override
+            {
+                helpers::FileInfo fi;
+                if (getFileInfo (&fi, name) == 0)
+                    sizes.push_back (fi.size);
+                PatternLayout::formatAndAppend (buf, event);
+            }
+
+            tstring name;
+            std::vector<off_t> sizes;
+        };
+
+        std::vector<spi::InternalLoggingEvent> events;
+        for (int i = 0; i != 10; ++i)
+            events.push_back (make_event (i));
+
+        {
+            // With small buffer, appending one by one would make earlier
+            // events of the batch visible.
+            Properties props;
+            props.setProperty (LOG4CPLUS_TEXT ("File"), fileName);
+            props.setProperty (LOG4CPLUS_TEXT ("BufferSize"),
+                LOG4CPLUS_TEXT ("4"));
+            SharedAppenderPtr appender (new FileAppender (props));
+            auto layout = std::make_unique<FileSizeLayout> (fileName);
+            FileSizeLayout & l = *layout;
+            appender->setLayout (std::move (layout));
+
+            appender->syncDoAppendBatch (events);
+            CATCH_REQUIRE (l.sizes.size () == events.size ());
+            for (auto size : l.sizes)
+                CATCH_REQUIRE (size == 0);
+            CATCH_REQUIRE (read_lines (fileName).size () == events.size ());
+
+            appender->syncDoAppendBatch (events);
+            CATCH_REQUIRE (l.sizes.back () == l.sizes[events.size ()]);
+            appender->close ();
+        }
+
+        CATCH_REQUIRE (read_lines (fileName).size () == 2 * events.size ());
+    }
+
+    CATCH_SECTION ("rollover inside of batch")
+    {
+        long const maxFileSize = 200 * 1024;
+        int const count = 30000;
+        {
+            SharedAppenderPtr appender (new RollingFileAppender (fileName,
+                maxFileSize, 1, false));
+            appender->setLayout (std::unique_ptr<Layout> (
+                new PatternLayout (LOG4CPLUS_TEXT ("%m%n"))));
+
+            std::vector<spi::InternalLoggingEvent> events;
+            for (int i = 0; i != count; ++i)
+            {
+                events.push_back (make_event (i));
+                if (events.size () == 1000)
+                {
+                    appender->syncDoAppendBatch (events);
+                    events.clear ();
+                }
+            }
+            appender->close ();
+        }
+
+        // The file is rolled over after the event that makes it exceed
+        // MaxFileSize, like when the events are appended one by one.
+        helpers::FileInfo fi;
+        CATCH_REQUIRE (getFileInfo (&fi, fileName + LOG4CPLUS_TEXT (".1"))
+            == 0);
+        CATCH_REQUIRE (fi.size > maxFileSize);
+        CATCH_REQUIRE (fi.size <= maxFileSize + 12);
+
+        std::vector<tstring> lines = read_lines (fileName
+            + LOG4CPLUS_TEXT (".1"));
+        std::vector<tstring> const current = read_lines (fileName);
+        lines.insert (lines.end (), current.begin (), current.end ());
+        int const first = count - static_cast<int>(lines.size ());
+        for (std::size_t i = 0; i != lines.size (); ++i)
+            CATCH_REQUIRE (lines[i] == LOG4CPLUS_TEXT ("event ")
+                + helpers::convertIntegerToString (
+                    first + static_cast<int>(i)));
+    }
+
+    file_remove (fileName);
+    file_remove (fileName + LOG4CPLUS_TEXT (".1"));
+}
+
+
+static
+void
+test_direct_file_backend (tstring const & backend)
+{
+    tstring const fileName (LOG4CPLUS_TEXT ("file_appender_direct_test.log"));
+    file_remove (fileName);
+    file_remove (fileName + LOG4CPLUS_TEXT (".1"));
+
+    Properties props;
+    props.setProperty (LOG4CPLUS_TEXT ("File"), fileName);
+    props.setProperty (LOG4CPLUS_TEXT ("Backend"), backend);
+
+    auto read_lines = [] (tstring const & name) {
+        tifstream file (LOG4CPLUS_TSTRING_TO_STRING (name).c_str ());
+        std::vector<tstring> lines;
+        for (tstring line; std::getline (file, line); )
+            lines.push_back (line);
+        return lines;
+    };
+
+    auto make_event = [] (int i) {
+        return spi::InternalLoggingEvent (LOG4CPLUS_TEXT ("direct"),
+            INFO_LOG_LEVEL,
+            LOG4CPLUS_TEXT ("event ") + helpers::convertIntegerToString (i),
+            __FILE__, __LINE__);
+    };
+
+    CATCH_SECTION ("buffered output larger than buffer")
+    {
+        // Small buffer forces drains both with and without pending
+        // buffered data.
+        props.setProperty (LOG4CPLUS_TEXT ("ImmediateFlush"),
+            LOG4CPLUS_TEXT ("false"));
+        props.setProperty (LOG4CPLUS_TEXT ("BufferSize"),
+            LOG4CPLUS_TEXT ("16"));
+        {
+            SharedAppenderPtr appender (new FileAppender (props));
+            appender->setLayout (std::unique_ptr<Layout> (
+                new PatternLayout (LOG4CPLUS_TEXT ("%m%n"))));
+            for (int i = 0; i != 100; ++i)
+                appender->doAppend (make_event (i));
+            appender->close ();
+        }
+
+        std::vector<tstring> const lines = read_lines (fileName);
+        CATCH_REQUIRE (lines.size () == 100);
+        for (int i = 0; i != 100; ++i)
+            CATCH_REQUIRE (lines[i] == LOG4CPLUS_TEXT ("event ")
+                + helpers::convertIntegerToString (i));
+    }
+
+    CATCH_SECTION ("immediate flush")
+    {
+        // Lock file makes io_uring writes complete before the append
+        // returns as well.
+        props.setProperty (LOG4CPLUS_TEXT ("UseLockFile"),
+            LOG4CPLUS_TEXT ("true"));
+        SharedAppenderPtr appender (new FileAppender (props));
+        appender->setLayout (std::unique_ptr<Layout> (
+            new PatternLayout (LOG4CPLUS_TEXT ("%m%n"))));
+        appender->doAppend (make_event (0));
+
+        // Visible without closing the appender.
+        CATCH_REQUIRE (read_lines (fileName).size () == 1);
+        appender->close ();
+        file_remove (fileName + LOG4CPLUS_TEXT (".lock"));
+    }
+
+    CATCH_SECTION ("rollover")
+    {
+        props.setProperty (LOG4CPLUS_TEXT ("MaxFileSize"),
+            LOG4CPLUS_TEXT ("200KB"));
+        props.setProperty (LOG4CPLUS_TEXT ("ImmediateFlush"),
+            LOG4CPLUS_TEXT ("false"));
+        {
+            SharedAppenderPtr appender (new RollingFileAppender (props));
+            appender->setLayout (std::unique_ptr<Layout> (
+                new PatternLayout (LOG4CPLUS_TEXT ("%m%n"))));
+            for (int i = 0; i != 30000; ++i)
+                appender->doAppend (make_event (i));
+            appender->close ();
+        }
+
+        helpers::FileInfo fi;
+        CATCH_REQUIRE (getFileInfo (&fi, fileName + LOG4CPLUS_TEXT (".1"))
+            == 0);
+        CATCH_REQUIRE (fi.size <= 200 * 1024 + 32);
+        std::vector<tstring> const lines = read_lines (fileName);
+        CATCH_REQUIRE (! lines.empty ());
+        CATCH_REQUIRE (lines.back () == LOG4CPLUS_TEXT ("event 29999"));
+    }
+
+    file_remove (fileName);
+    file_remove (fileName + LOG4CPLUS_TEXT (".1"));
+}
+
+
+CATCH_TEST_CASE ("FileAppender Direct backend", "[appender]")
+{
+    test_direct_file_backend (LOG4CPLUS_TEXT ("Direct"));
+}
+
+
+CATCH_TEST_CASE ("FileAppender IoUring backend", "[appender]")
+{
+    // Without io_uring support in the build or kernel, this exercises
+    // the fallback to Direct backend.
+    test_direct_file_backend (LOG4CPLUS_TEXT ("IoUring"));
+
+    helpers::DirectFile file;
+    file.setIoUring (true);
+#if defined (LOG4CPLUS_ENABLE_IO_URING)
+    if (file.usingIoUring ())
+    {
+        tstring const fileName (LOG4CPLUS_TEXT ("direct_file_io_uring.log"));
+        file.setBufferSize (16);
+        CATCH_REQUIRE (file.open (fileName, std::ios_base::trunc));
+        std::string expected;
+        for (int i = 0; i != 1000; ++i)
+        {
+            std::string const line = "line " + std::to_string (i) + "\n";
+            file.write (line);
+            expected += line;
+        }
+        CATCH_REQUIRE (file.size () == expected.size ());
+        CATCH_REQUIRE (file.wait ());
+        file.close ();
+
+        std::ifstream in (LOG4CPLUS_TSTRING_TO_STRING (fileName).c_str (),
+            std::ios_base::binary);
+        std::string const contents ((std::istreambuf_iterator<char> (in)),
+            std::istreambuf_iterator<char> ());
+        in.close ();
+        CATCH_REQUIRE (contents == expected);
+
+        // Switching an open file between synchronous and io_uring
+        // writes, appending to existing contents.
+        helpers::DirectFile file2;
+        file2.setBufferSize (16);
+        CATCH_REQUIRE (file2.open (fileName, std::ios_base::app));
+        for (int i = 0; i != 300; ++i)
+        {
+            if (i % 100 == 0)
+                CATCH_REQUIRE (file2.setIoUring (i / 100 % 2 == 0)
+                    == (i / 100 % 2 == 0));
+            std::string const line = "more " + std::to_string (i) + "\n";
+            file2.write (line);
+            expected += line;
+        }
+        file2.close ();
+
+        std::ifstream in2 (LOG4CPLUS_TSTRING_TO_STRING (fileName).c_str (),
+            std::ios_base::binary);
+        std::string const contents2 ((std::istreambuf_iterator<char> (in2)),
+            std::istreambuf_iterator<char> ());
+        in2.close ();
+        file_remove (fileName);
+        CATCH_REQUIRE (contents2 == expected);
+    }
+#else
+    CATCH_REQUIRE (! file.usingIoUring ());
+#endif
+}
+
+
+#if defined (LOG4CPLUS_USE_MMAP)
+CATCH_TEST_CASE ("MappedSegmentAppender", "[appender]")
+{
+    tstring const fileName (LOG4CPLUS_TEXT ("mapped_segment_test.log"));
+    tstring const backupName (fileName + LOG4CPLUS_TEXT (".1"));
+    file_remove (fileName);
+    file_remove (backupName);
+
+    auto read_file = [] (tstring const & name) {
+        std::ifstream in (LOG4CPLUS_TSTRING_TO_STRING (name).c_str (),
+            std::ios_base::binary);
+        return std::string ((std::istreambuf_iterator<char> (in)),
+            std::istreambuf_iterator<char> ());
+    };
+
+    auto make_event = [] (int i) {
+        return spi::InternalLoggingEvent (LOG4CPLUS_TEXT ("mapped"),
+            INFO_LOG_LEVEL,
+            LOG4CPLUS_TEXT ("event ") + helpers::convertIntegerToString (i),
+            __FILE__, __LINE__);
+    };
+
+    Properties props;
+    props.setProperty (LOG4CPLUS_TEXT ("File"), fileName);
+    props.setProperty (LOG4CPLUS_TEXT ("SegmentSize"),
+        LOG4CPLUS_TEXT ("64KB"));
+    props.setProperty (LOG4CPLUS_TEXT ("Append"), LOG4CPLUS_TEXT ("false"));
+
+    CATCH_SECTION ("segments are truncated to used length")
+    {
+        std::string expected;
+        {
+            SharedAppenderPtr appender (new MappedSegmentAppender (props));
+            appender->setLayout (std::unique_ptr<Layout> (
+                new PatternLayout (LOG4CPLUS_TEXT ("%m%n"))));
+            for (int i = 0; i != 20000; ++i)
+            {
+                appender->doAppend (make_event (i));
+                expected += "event " + std::to_string (i) + "\n";
+            }
+
+            // Preallocated while open.
+            helpers::FileInfo fi;
+            CATCH_REQUIRE (getFileInfo (&fi, fileName) == 0);
+            CATCH_REQUIRE (fi.size == 64 * 1024);
+
+            appender->close ();
+        }
+
+        std::string const backup = read_file (backupName);
+        std::string const current = read_file (fileName);
+        CATCH_REQUIRE (! backup.empty ());
+        CATCH_REQUIRE (backup.size () <= 64 * 1024);
+        CATCH_REQUIRE (backup.back () == '\n');
+        CATCH_REQUIRE (current.back () == '\n');
+        // With 20000 events there are more segments than backups, so
+        // only the tail of the output is kept.
+        CATCH_REQUIRE (expected.size () > backup.size () + current.size ());
+        CATCH_REQUIRE (expected.compare (
+            expected.size () - backup.size () - current.size (),
+            std::string::npos, backup + current) == 0);
+    }
+
+    CATCH_SECTION ("appending continues after last record")
+    {
+        {
+            // Segment that has not been truncated, as after a crash.
+            std::ofstream out (LOG4CPLUS_TSTRING_TO_STRING (fileName).c_str (),
+                std::ios_base::binary);
+            out << "existing\n" << std::string (100, '\0');
+        }
+
+        props.setProperty (LOG4CPLUS_TEXT ("Append"),
+            LOG4CPLUS_TEXT ("true"));
+        {
+            SharedAppenderPtr appender (new MappedSegmentAppender (props));
+            appender->setLayout (std::unique_ptr<Layout> (
+                new PatternLayout (LOG4CPLUS_TEXT ("%m%n"))));
+            appender->doAppend (make_event (1));
+            appender->close ();
+        }
+
+        CATCH_REQUIRE (read_file (fileName) == "existing\nevent 1\n");
+    }
+
+    file_remove (fileName);
+    file_remove (backupName);
+}
+
+
+CATCH_TEST_CASE ("CircularFileAppender", "[appender]")
+{
+    tstring const fileName (LOG4CPLUS_TEXT ("circular_appender_test.log"));
+    file_remove (fileName);
+
+    Properties props;
+    props.setProperty (LOG4CPLUS_TEXT ("File"), fileName);
+    props.setProperty (LOG4CPLUS_TEXT ("FileSize"), LOG4CPLUS_TEXT ("64KB"));
+
+    int const count = 20000;
+    for (int run = 0; run != 2; ++run)
+    {
+        SharedAppenderPtr appender (new CircularFileAppender (props));
+        appender->setLayout (std::unique_ptr<Layout> (
+            new PatternLayout (LOG4CPLUS_TEXT ("%m"))));
+        for (int i = run * count; i != (run + 1) * count; ++i)
+            appender->doAppend (spi::InternalLoggingEvent (
+                LOG4CPLUS_TEXT ("circular"), INFO_LOG_LEVEL,
+                helpers::convertIntegerToString (i), __FILE__, __LINE__));
+        appender->close ();
+    }
+
+    // The file has kept its size and holds the newest events, including
+    // those appended by the second run.
+    helpers::FileInfo fi;
+    CATCH_REQUIRE (getFileInfo (&fi, fileName) == 0);
+    CATCH_REQUIRE (fi.size == 64 * 1024);
+
+    helpers::CircularFileReader reader;
+    CATCH_REQUIRE (reader.open (fileName));
+    std::vector<helpers::CircularFileRecord> const & records
+        = reader.records ();
+    CATCH_REQUIRE (records.size () > 1000);
+    CATCH_REQUIRE (records.size () < static_cast<std::size_t>(count));
+    int i = 2 * count - static_cast<int>(records.size ());
+    for (helpers::CircularFileRecord const & record : records)
+    {
+        CATCH_REQUIRE (record.data == std::to_string (i));
+        CATCH_REQUIRE (record.sequence == static_cast<std::uint64_t>(i));
+        ++i;
+    }
+
+    file_remove (fileName);
+}
+#endif
+
+
+CATCH_TEST_CASE ("FileAppender sync policies", "[appender]")
+{
+    tstring const fileName (LOG4CPLUS_TEXT ("file_appender_sync_test.log"));
+    file_remove (fileName);
+
+    auto file_size = [&] {
+        helpers::FileInfo fi;
+        return getFileInfo (&fi, fileName) == 0 ? fi.size : 0;
+    };
+
+    auto make_event = [] (LogLevel ll, int i) {
+        return spi::InternalLoggingEvent (LOG4CPLUS_TEXT ("sync"), ll,
+            LOG4CPLUS_TEXT ("event ") + helpers::convertIntegerToString (i),
+            __FILE__, __LINE__);
+    };
+
+    // Buffered output is only visible in the file after it has been
+    // flushed for synchronization.
+    Properties props;
+    props.setProperty (LOG4CPLUS_TEXT ("File"), fileName);
+    props.setProperty (LOG4CPLUS_TEXT ("ImmediateFlush"),
+        LOG4CPLUS_TEXT ("false"));
+    props.setProperty (LOG4CPLUS_TEXT ("BufferSize"),
+        LOG4CPLUS_TEXT ("65536"));
+
+    auto make_appender = [&] {
+        SharedAppenderPtr appender (new FileAppender (props));
+        appender->setLayout (std::unique_ptr<Layout> (
+            new PatternLayout (LOG4CPLUS_TEXT ("%m%n"))));
+        return appender;
+    };
+
+    CATCH_SECTION ("level")
+    {
+        props.setProperty (LOG4CPLUS_TEXT ("SyncLevel"),
+            LOG4CPLUS_TEXT ("error"));
+        SharedAppenderPtr appender (make_appender ());
+        appender->doAppend (make_event (INFO_LOG_LEVEL, 0));
+        CATCH_REQUIRE (file_size () == 0);
+        appender->doAppend (make_event (ERROR_LOG_LEVEL, 1));
+        CATCH_REQUIRE (file_size () == 16);
+        appender->close ();
+    }
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    CATCH_SECTION ("level with concurrent writers")
+    {
+        props.setProperty (LOG4CPLUS_TEXT ("SyncLevel"),
+            LOG4CPLUS_TEXT ("ERROR"));
+        props.setProperty (LOG4CPLUS_TEXT ("Backend"),
+            LOG4CPLUS_TEXT ("Direct"));
+        SharedAppenderPtr appender (make_appender ());
+        std::vector<std::thread> threads;
+        for (int t = 0; t != 4; ++t)
+            threads.emplace_back ([&, t] {
+                for (int i = 0; i != 50; ++i)
+                    appender->doAppend (make_event (ERROR_LOG_LEVEL,
+                        t * 100 + i));
+            });
+        for (auto & th : threads)
+            th.join ();
+
+        // Every append returned after its event was synchronized.
+        CATCH_REQUIRE (file_size () > 200 * 8);
+        appender->close ();
+    }
+
+    CATCH_SECTION ("interval")
+    {
+        props.setProperty (LOG4CPLUS_TEXT ("SyncInterval"),
+            LOG4CPLUS_TEXT ("10"));
+        SharedAppenderPtr appender (make_appender ());
+        appender->doAppend (make_event (INFO_LOG_LEVEL, 0));
+        for (int i = 0; i != 500 && file_size () == 0; ++i)
+            std::this_thread::sleep_for (std::chrono::milliseconds (10));
+        CATCH_REQUIRE (file_size () == 8);
+        appender->close ();
+    }
+
+    CATCH_SECTION ("size")
+    {
+        props.setProperty (LOG4CPLUS_TEXT ("SyncSize"),
+            LOG4CPLUS_TEXT ("1KB"));
+        props.setProperty (LOG4CPLUS_TEXT ("SyncMethod"),
+            LOG4CPLUS_TEXT ("FSync"));
+        SharedAppenderPtr appender (make_appender ());
+        appender->doAppend (make_event (INFO_LOG_LEVEL, 0));
+        std::this_thread::sleep_for (std::chrono::milliseconds (50));
+        CATCH_REQUIRE (file_size () == 0);
+
+        for (int i = 1; i != 200; ++i)
+            appender->doAppend (make_event (INFO_LOG_LEVEL, i));
+        for (int i = 0; i != 500 && file_size () < 1024; ++i)
+            std::this_thread::sleep_for (std::chrono::milliseconds (10));
+        CATCH_REQUIRE (file_size () >= 1024);
+        appender->close ();
+    }
+#endif
+
+    file_remove (fileName);
+}
+
+
+CATCH_TEST_CASE ("RollingFileAppender AsyncRollover", "[appender]")
+{
+    tstring const fileName (LOG4CPLUS_TEXT ("rolling_async_test.log"));
+    auto backup_name = [&] (int i) {
+        return fileName + LOG4CPLUS_TEXT (".")
+            + helpers::convertIntegerToString (i);
+    };
+    auto remove_files = [&] {
+        file_remove (fileName);
+        file_remove (rollover_staging_name (fileName));
+        for (int i = 1; i <= 3; ++i)
+            file_remove (backup_name (i));
+    };
+    remove_files ();
+
+    auto read_numbers = [] (tstring const & name) {
+        tifstream file (LOG4CPLUS_TSTRING_TO_STRING (name).c_str ());
+        std::vector<int> numbers;
+        for (tstring line; std::getline (file, line); )
+            numbers.push_back (std::stoi (line));
+        return numbers;
+    };
+
+    Properties props;
+    props.setProperty (LOG4CPLUS_TEXT ("File"), fileName);
+    props.setProperty (LOG4CPLUS_TEXT ("MaxFileSize"),
+        LOG4CPLUS_TEXT ("200KB"));
+    props.setProperty (LOG4CPLUS_TEXT ("MaxBackupIndex"),
+        LOG4CPLUS_TEXT ("3"));
+    props.setProperty (LOG4CPLUS_TEXT ("ImmediateFlush"),
+        LOG4CPLUS_TEXT ("false"));
+    props.setProperty (LOG4CPLUS_TEXT ("AsyncRollover"),
+        LOG4CPLUS_TEXT ("true"));
+
+    int const count = 150000;
+    {
+        SharedAppenderPtr appender (new RollingFileAppender (props));
+        appender->setLayout (std::unique_ptr<Layout> (
+            new PatternLayout (LOG4CPLUS_TEXT ("%m%n"))));
+        for (int i = 0; i != count; ++i)
+            appender->doAppend (spi::InternalLoggingEvent (
+                LOG4CPLUS_TEXT ("rolling"), INFO_LOG_LEVEL,
+                helpers::convertIntegerToString (i), __FILE__, __LINE__));
+
+        // Closing waits for the maintenance thread.
+        appender->close ();
+    }
+
+    helpers::FileInfo fi;
+    CATCH_REQUIRE (getFileInfo (&fi, rollover_staging_name (fileName)) != 0);
+
+    // Backups and the current file hold a contiguous tail of events.
+    std::vector<int> numbers;
+    for (int i = 3; i >= 1; --i)
+    {
+        std::vector<int> const backup = read_numbers (backup_name (i));
+        CATCH_REQUIRE (! backup.empty ());
+        numbers.insert (numbers.end (), backup.begin (), backup.end ());
+    }
+    std::vector<int> const current = read_numbers (fileName);
+    numbers.insert (numbers.end (), current.begin (), current.end ());
+    CATCH_REQUIRE (numbers.back () == count - 1);
+    CATCH_REQUIRE (std::adjacent_find (numbers.begin (), numbers.end (),
+        [] (int a, int b) { return b != a + 1; }) == numbers.end ());
+
+    remove_files ();
+}
+
+
+CATCH_TEST_CASE ("RollingFileAppender indexed strategy", "[appender]")
+{
+    tstring const fileName (LOG4CPLUS_TEXT ("rolling_indexed_test.log"));
+    auto remove_files = [&] {
+        for (unsigned long index : scan_indexed_files (fileName))
+            file_remove (indexed_file_name (fileName, index));
+    };
+    remove_files ();
+
+    auto read_numbers = [] (tstring const & name) {
+        tifstream file (LOG4CPLUS_TSTRING_TO_STRING (name).c_str ());
+        std::vector<int> numbers;
+        for (tstring line; std::getline (file, line); )
+            numbers.push_back (std::stoi (line));
+        return numbers;
+    };
+
+    auto log_events = [] (Properties const & props, int first, int count) {
+        SharedAppenderPtr appender (new RollingFileAppender (props));
+        appender->setLayout (std::unique_ptr<Layout> (
+            new PatternLayout (LOG4CPLUS_TEXT ("%m%n"))));
+        for (int i = first; i != first + count; ++i)
+            appender->doAppend (spi::InternalLoggingEvent (
+                LOG4CPLUS_TEXT ("rolling"), INFO_LOG_LEVEL,
+                helpers::convertIntegerToString (i), __FILE__, __LINE__));
+        appender->close ();
+    };
+
+    Properties props;
+    props.setProperty (LOG4CPLUS_TEXT ("File"), fileName);
+    props.setProperty (LOG4CPLUS_TEXT ("MaxFileSize"),
+        LOG4CPLUS_TEXT ("200KB"));
+    props.setProperty (LOG4CPLUS_TEXT ("MaxBackupIndex"),
+        LOG4CPLUS_TEXT ("2"));
+    props.setProperty (LOG4CPLUS_TEXT ("ImmediateFlush"),
+        LOG4CPLUS_TEXT ("false"));
+    props.setProperty (LOG4CPLUS_TEXT ("RollingStrategy"),
+        LOG4CPLUS_TEXT ("Indexed"));
+
+    // Files that do not look like names made by indexed_file_name()
+    // are ignored, e.g. backups of Rename strategy.
+    std::vector<tstring> const foreign {
+        fileName + LOG4CPLUS_TEXT (".1"),
+        fileName + LOG4CPLUS_TEXT (".0000002"),
+        fileName + LOG4CPLUS_TEXT (".") + tstring (40, LOG4CPLUS_TEXT ('9'))};
+    for (tstring const & name : foreign)
+        tofstream (LOG4CPLUS_TSTRING_TO_STRING (name).c_str ()) << 1;
+    CATCH_REQUIRE (scan_indexed_files (fileName).empty ());
+
+    unsigned long index = 0;
+    CATCH_REQUIRE (parse_file_index (index, LOG4CPLUS_TEXT ("000123")));
+    CATCH_REQUIRE (index == 123);
+    CATCH_REQUIRE (parse_file_index (index, LOG4CPLUS_TEXT ("1234567")));
+    CATCH_REQUIRE (index == 1234567);
+    CATCH_REQUIRE (! parse_file_index (index, LOG4CPLUS_TEXT ("12345")));
+    CATCH_REQUIRE (! parse_file_index (index, LOG4CPLUS_TEXT ("00001x")));
+
+    int const count = 150000;
+    log_events (props, 0, count);
+
+    // The base name itself is never written.
+    helpers::FileInfo fi;
+    CATCH_REQUIRE (getFileInfo (&fi, fileName) != 0);
+
+    std::vector<unsigned long> indices (scan_indexed_files (fileName));
+    CATCH_REQUIRE (indices.size () == 3);
+    CATCH_REQUIRE (indices.front () > 1);
+    CATCH_REQUIRE (indices.back () == indices.front () + 2);
+
+    std::vector<int> numbers;
+    for (unsigned long index : indices)
+    {
+        std::vector<int> const part (
+            read_numbers (indexed_file_name (fileName, index)));
+        numbers.insert (numbers.end (), part.begin (), part.end ());
+    }
+    CATCH_REQUIRE (numbers.back () == count - 1);
+    CATCH_REQUIRE (std::adjacent_find (numbers.begin (), numbers.end (),
+        [] (int a, int b) { return b != a + 1; }) == numbers.end ());
+
+    // Restart continues with the newest file.
+    log_events (props, count, 1);
+    CATCH_REQUIRE (scan_indexed_files (fileName) == indices);
+    CATCH_REQUIRE (read_numbers (indexed_file_name (fileName,
+        indices.back ())).back () == count);
+
+    // Restart without Append starts the next file.
+    props.setProperty (LOG4CPLUS_TEXT ("Append"), LOG4CPLUS_TEXT ("false"));
+    log_events (props, count + 1, 1);
+    indices = scan_indexed_files (fileName);
+    CATCH_REQUIRE (indices.size () == 3);
+    CATCH_REQUIRE (read_numbers (indexed_file_name (fileName,
+        indices.back ())) == std::vector<int> { count + 1 });
+
+    remove_files ();
+    file_remove (fileName + LOG4CPLUS_TEXT (".lock"));
+    for (tstring const & name : foreign)
+        CATCH_REQUIRE (file_remove (name) == 0);
+}
+
+
+#if defined (LOG4CPLUS_WITH_ZLIB)
+CATCH_TEST_CASE ("RollingFileAppender Compression", "[appender]")
+{
+    tstring const fileName (LOG4CPLUS_TEXT ("rolling_compressed_test.log.gz"));
+    int const maxBackupIndex = 3;
+    auto remove_files = [&] {
+        file_remove (fileName);
+        for (int i = 1; i <= maxBackupIndex; ++i)
+            file_remove (fileName + LOG4CPLUS_TEXT (".")
+                + helpers::convertIntegerToString (i));
+    };
+    remove_files ();
+
+    Properties props;
+    props.setProperty (LOG4CPLUS_TEXT ("File"), fileName);
+    props.setProperty (LOG4CPLUS_TEXT ("MaxFileSize"),
+        LOG4CPLUS_TEXT ("200KB"));
+    props.setProperty (LOG4CPLUS_TEXT ("MaxBackupIndex"),
+        helpers::convertIntegerToString (maxBackupIndex));
+    props.setProperty (LOG4CPLUS_TEXT ("Compression"), LOG4CPLUS_TEXT ("Gzip"));
+    props.setProperty (LOG4CPLUS_TEXT ("CompressionBlockSize"),
+        LOG4CPLUS_TEXT ("16KB"));
+
+    SharedAppenderPtr appender (new RollingFileAppender (props));
+    appender->setLayout (std::unique_ptr<Layout> (
+        new PatternLayout (LOG4CPLUS_TEXT ("%m%n"))));
+    int const count = 200000;
+    for (int i = 0; i != count; ++i)
+        appender->doAppend (spi::InternalLoggingEvent (
+            LOG4CPLUS_TEXT ("compressed"), INFO_LOG_LEVEL,
+            helpers::convertIntegerToString (i), __FILE__, __LINE__));
+    appender->close ();
+
+    // Records of all files, from the oldest one, follow each other.
+    std::string data;
+    helpers::BlockCompressedReader reader;
+    int files = 0;
+    for (int i = maxBackupIndex; i >= 0; --i)
+    {
+        tstring const name = i == 0 ? fileName : fileName + LOG4CPLUS_TEXT (".")
+            + helpers::convertIntegerToString (i);
+        if (! reader.open (name))
+            continue;
+
+        ++files;
+        CATCH_REQUIRE (reader.indexed ());
+        helpers::FileInfo fi;
+        CATCH_REQUIRE (getFileInfo (&fi, name) == 0);
+        CATCH_REQUIRE (fi.size <= 200 * 1024 + 16 * 1024);
+        for (helpers::CompressedBlockInfo const & info : reader.blocks ())
+            CATCH_REQUIRE (reader.readBlock (info, data));
+        reader.close ();
+    }
+
+    CATCH_REQUIRE (files >= 3);
+
+    std::vector<int> numbers;
+    std::istringstream iss (data);
+    for (std::string line; std::getline (iss, line); )
+        numbers.push_back (std::stoi (line));
+    CATCH_REQUIRE (numbers.back () == count - 1);
+    CATCH_REQUIRE (std::adjacent_find (numbers.begin (), numbers.end (),
+        [] (int a, int b) { return b != a + 1; }) == numbers.end ());
+
+    remove_files ();
+}
+
+
+CATCH_TEST_CASE ("RollingFileAppender CompressBackups", "[appender]")
+{
+    tstring const fileName (LOG4CPLUS_TEXT ("rolling_gzip_test.log"));
+    int const maxBackupIndex = 3;
+    auto backup_name = [&] (int i) {
+        return fileName + LOG4CPLUS_TEXT (".")
+            + helpers::convertIntegerToString (i);
+    };
+    auto remove_files = [&] {
+        file_remove (fileName);
+        for (int i = 1; i <= maxBackupIndex + 1; ++i)
+        {
+            file_remove (backup_name (i));
+            file_remove (backup_name (i) + LOG4CPLUS_TEXT (".gz"));
+        }
+    };
+
+    for (bool const asyncRollover : {false, true})
+    {
+        CATCH_SECTION (asyncRollover ? "AsyncRollover" : "sync rollover")
+        {
+            remove_files ();
+
+            Properties props;
+            props.setProperty (LOG4CPLUS_TEXT ("File"), fileName);
+            props.setProperty (LOG4CPLUS_TEXT ("MaxFileSize"),
+                LOG4CPLUS_TEXT ("200KB"));
+            props.setProperty (LOG4CPLUS_TEXT ("MaxBackupIndex"),
+                helpers::convertIntegerToString (maxBackupIndex));
+            props.setProperty (LOG4CPLUS_TEXT ("CompressBackups"),
+                LOG4CPLUS_TEXT ("true"));
+            props.setProperty (LOG4CPLUS_TEXT ("AsyncRollover"),
+                asyncRollover ? LOG4CPLUS_TEXT ("true")
+                : LOG4CPLUS_TEXT ("false"));
+
+            SharedAppenderPtr appender (new RollingFileAppender (props));
+            appender->setLayout (std::unique_ptr<Layout> (
+                new PatternLayout (LOG4CPLUS_TEXT ("%m%n"))));
+            for (int i = 0; i != 200000; ++i)
+                appender->doAppend (spi::InternalLoggingEvent (
+                    LOG4CPLUS_TEXT ("gzip"), INFO_LOG_LEVEL,
+                    helpers::convertIntegerToString (i), __FILE__,
+                    __LINE__));
+            appender->close ();
+
+            // All backups are compressed and none falls out of
+            // MaxBackupIndex as a left over.
+            helpers::FileInfo fi;
+            CATCH_REQUIRE (getFileInfo (&fi, fileName) == 0);
+            for (int i = 1; i <= maxBackupIndex; ++i)
+            {
+                CATCH_REQUIRE (getFileInfo (&fi, backup_name (i)) != 0);
+                CATCH_REQUIRE (getFileInfo (&fi,
+                        backup_name (i) + LOG4CPLUS_TEXT (".gz")) == 0);
+                CATCH_REQUIRE (fi.size < 200 * 1024 / 2);
+
+                std::ifstream gz (std::filesystem::path (
+                        backup_name (i) + LOG4CPLUS_TEXT (".gz")),
+                    std::ios_base::binary);
+                unsigned char magic[2] = { };
+                gz.read (reinterpret_cast<char *>(magic), 2);
+                CATCH_REQUIRE (magic[0] == 0x1f);
+                CATCH_REQUIRE (magic[1] == 0x8b);
+            }
+            CATCH_REQUIRE (getFileInfo (&fi, backup_name (maxBackupIndex + 1)
+                    + LOG4CPLUS_TEXT (".gz")) != 0);
+
+            // Backups have been placed where rollovers shifted them while
+            // they were being compressed. Records of the backups, from
+            // the oldest one, and of the file follow each other.
+            std::string data;
+            helpers::BlockCompressedReader reader;
+            for (int i = maxBackupIndex; i >= 1; --i)
+            {
+                CATCH_REQUIRE (reader.open (
+                    backup_name (i) + LOG4CPLUS_TEXT (".gz")));
+                for (helpers::CompressedBlockInfo const & info
+                        : reader.blocks ())
+                    CATCH_REQUIRE (reader.readBlock (info, data));
+                reader.close ();
+            }
+            {
+                std::ifstream file (std::filesystem::path (fileName),
+                    std::ios_base::binary);
+                data.append (std::istreambuf_iterator<char> (file),
+                    std::istreambuf_iterator<char> ());
+            }
+
+            std::vector<int> numbers;
+            std::istringstream iss (data);
+            for (std::string line; std::getline (iss, line); )
+                numbers.push_back (std::stoi (line));
+            CATCH_REQUIRE (numbers.back () == 200000 - 1);
+            CATCH_REQUIRE (std::adjacent_find (numbers.begin (),
+                    numbers.end (),
+                    [] (int a, int b) { return b != a + 1; })
+                == numbers.end ());
+
+            remove_files ();
+        }
+    }
+}
+
+
+CATCH_TEST_CASE ("RollingFileAppender indexed strategy CompressBackups",
+    "[appender]")
+{
+    tstring const fileName (
+        LOG4CPLUS_TEXT ("rolling_indexed_gzip_test.log"));
+    tstring const prefix (fileName + LOG4CPLUS_TEXT ("."));
+    auto list_files = [&] {
+        std::vector<tstring> names;
+        for (auto const & entry
+                : std::filesystem::directory_iterator (
+                    std::filesystem::path (LOG4CPLUS_TEXT ("."))))
+        {
+            tstring name (entry.path ().filename ().string<tchar> ());
+            if (name.compare (0, prefix.size (), prefix) == 0)
+                names.push_back (std::move (name));
+        }
+        return names;
+    };
+    auto remove_files = [&] {
+        for (tstring const & name : list_files ())
+            file_remove (name);
+    };
+    remove_files ();
+
+    Properties props;
+    props.setProperty (LOG4CPLUS_TEXT ("File"), fileName);
+    props.setProperty (LOG4CPLUS_TEXT ("MaxFileSize"),
+        LOG4CPLUS_TEXT ("200KB"));
+    props.setProperty (LOG4CPLUS_TEXT ("MaxBackupIndex"),
+        LOG4CPLUS_TEXT ("1"));
+    props.setProperty (LOG4CPLUS_TEXT ("RollingStrategy"),
+        LOG4CPLUS_TEXT ("Indexed"));
+    props.setProperty (LOG4CPLUS_TEXT ("CompressBackups"),
+        LOG4CPLUS_TEXT ("true"));
+
+    // Hold the background thread, so that backups are still being
+    // compressed when they fall out of the history.
+    std::mutex mtx;
+    std::condition_variable cv;
+    bool released = false;
+    helpers::queueBackgroundJob ([&] {
+        std::unique_lock<std::mutex> lock (mtx);
+        cv.wait (lock, [&] { return released; });
+    });
+
+    SharedAppenderPtr appender (new RollingFileAppender (props));
+    appender->setLayout (std::unique_ptr<Layout> (
+        new PatternLayout (LOG4CPLUS_TEXT ("%m%n"))));
+    for (int i = 0; i != 150000; ++i)
+        appender->doAppend (spi::InternalLoggingEvent (
+            LOG4CPLUS_TEXT ("gzip"), INFO_LOG_LEVEL,
+            helpers::convertIntegerToString (i), __FILE__, __LINE__));
+
+    {
+        std::lock_guard<std::mutex> lock (mtx);
+        released = true;
+    }
+    cv.notify_all ();
+    appender->close ();
+
+    // Only the current file and the compressed newest backup are left.
+    std::vector<unsigned long> const indices (scan_indexed_files (fileName));
+    CATCH_REQUIRE (indices.size () == 2);
+    CATCH_REQUIRE (indices.front () > 1);
+    std::vector<tstring> names (list_files ());
+    std::sort (names.begin (), names.end ());
+    CATCH_REQUIRE (names == std::vector<tstring> {
+        indexed_file_name (fileName, indices.front ())
+            + LOG4CPLUS_TEXT (".gz"),
+        indexed_file_name (fileName, indices.back ()) });
+
+    remove_files ();
+}
+#endif
+
+
+CATCH_TEST_CASE ("RollingFileAppender TimeIndex", "[appender]")
+{
+    tstring const fileName (LOG4CPLUS_TEXT ("rolling_time_index_test.log"));
+    int const maxBackupIndex = 2;
+    auto file_name = [&] (int i) {
+        return i == 0 ? fileName : fileName + LOG4CPLUS_TEXT (".")
+            + helpers::convertIntegerToString (i);
+    };
+    auto remove_files = [&] {
+        for (int i = 0; i <= maxBackupIndex + 1; ++i)
+        {
+            file_remove (file_name (i));
+            file_remove (helpers::timeIndexName (file_name (i)));
+            file_remove (compressed_name (file_name (i)));
+        }
+    };
+    remove_files ();
+
+    // Without CompressBackups compressed names are not touched.
+    std::ofstream (std::filesystem::path (compressed_name (file_name (1))))
+        << "foreign";
+
+    Properties props;
+    props.setProperty (LOG4CPLUS_TEXT ("File"), fileName);
+    props.setProperty (LOG4CPLUS_TEXT ("MaxFileSize"),
+        LOG4CPLUS_TEXT ("200KB"));
+    props.setProperty (LOG4CPLUS_TEXT ("MaxBackupIndex"),
+        helpers::convertIntegerToString (maxBackupIndex));
+    props.setProperty (LOG4CPLUS_TEXT ("TimeIndex"), LOG4CPLUS_TEXT ("true"));
+
+    // Ten events per second.
+    helpers::Time const start = helpers::from_time_t (1000000);
+    auto event_time = [&] (int i) {
+        return start + std::chrono::milliseconds (i * 100);
+    };
+
+    SharedAppenderPtr appender (new RollingFileAppender (props));
+    appender->setLayout (std::unique_ptr<Layout> (
+        new PatternLayout (LOG4CPLUS_TEXT ("%m%n"))));
+    for (int i = 0; i != 100000; ++i)
+        appender->doAppend (spi::InternalLoggingEvent (
+            LOG4CPLUS_TEXT ("index"), INFO_LOG_LEVEL, tstring (),
+            MappedDiagnosticContextMap (),
+            helpers::convertIntegerToString (i), LOG4CPLUS_TEXT ("thread"),
+            LOG4CPLUS_TEXT ("thread"), event_time (i), LOG4CPLUS_TEXT (""),
+            0));
+    appender->close ();
+
+    // Each entry points to the first record of its second in the file
+    // it has been renamed with.
+    for (int i = 0; i <= maxBackupIndex; ++i)
+    {
+        std::ifstream in (std::filesystem::path (file_name (i)),
+            std::ios_base::binary);
+        std::string const data {std::istreambuf_iterator<char> (in),
+            std::istreambuf_iterator<char> ()};
+
+        helpers::TimeIndexReader reader;
+        CATCH_REQUIRE (reader.open (helpers::timeIndexName (file_name (i))));
+        CATCH_REQUIRE (! reader.entries ().empty ());
+        CATCH_REQUIRE (reader.entries ().front ().offset == 0);
+        for (helpers::TimeIndexEntry const & entry : reader.entries ())
+        {
+            CATCH_REQUIRE (entry.offset < data.size ());
+            int const record = std::stoi (data.substr (entry.offset));
+            CATCH_REQUIRE (event_time (record) >= entry.time);
+            CATCH_REQUIRE (event_time (record)
+                < entry.time + std::chrono::seconds (1));
+            if (entry.offset != 0)
+            {
+                std::size_t const prev = data.rfind ('\n',
+                    entry.offset - 2);
+                int const prevRecord = std::stoi (data.substr (
+                    prev == std::string::npos ? 0 : prev + 1));
+                CATCH_REQUIRE (event_time (prevRecord) < entry.time);
+            }
+        }
+    }
+
+    // Index of the backup that fell out of MaxBackupIndex is removed.
+    helpers::FileInfo fi;
+    CATCH_REQUIRE (getFileInfo (&fi, helpers::timeIndexName (
+                file_name (maxBackupIndex + 1))) != 0);
+
+    CATCH_REQUIRE (getFileInfo (&fi, compressed_name (file_name (1))) == 0);
+    CATCH_REQUIRE (getFileInfo (&fi, compressed_name (file_name (2))) != 0);
+
+    remove_files ();
+}
+
+
+CATCH_TEST_CASE ("RollingFileAppender file size tracking", "[appender]")
+{
+    tstring const fileName (LOG4CPLUS_TEXT ("rolling_size_test.log"));
+    tstring const backupName (fileName + LOG4CPLUS_TEXT (".1"));
+    auto file_size = [] (tstring const & name) {
+        helpers::FileInfo fi;
+        CATCH_REQUIRE (getFileInfo (&fi, name) == 0);
+        return static_cast<long>(fi.size);
+    };
+
+    long const maxFileSize = 200 * 1024;
+    // Line of the existing file and one formatted event are 16 bytes.
+    std::string const line ("existing record\n");
+    long const existingSize = maxFileSize + 1024;
+    // The appender opens the file in text mode, which turns the event's
+    // LF into CR LF on Windows.
+#if defined (_WIN32)
+    long const recordSize = 17;
+#else
+    long const recordSize = 16;
+#endif
+
+    for (tchar const * backend : {LOG4CPLUS_TEXT ("Stream"),
+            LOG4CPLUS_TEXT ("Direct")})
+    {
+        CATCH_SECTION (LOG4CPLUS_TSTRING_TO_STRING (tstring (backend)))
+        {
+            file_remove (fileName);
+            file_remove (backupName);
+            {
+                std::ofstream existing (
+                    LOG4CPLUS_TSTRING_TO_STRING (fileName).c_str (),
+                    std::ios_base::binary);
+                for (long i = 0; i != existingSize / 16; ++i)
+                    existing << line;
+            }
+
+            Properties props;
+            props.setProperty (LOG4CPLUS_TEXT ("File"), fileName);
+            props.setProperty (LOG4CPLUS_TEXT ("Backend"), backend);
+            props.setProperty (LOG4CPLUS_TEXT ("MaxFileSize"),
+                helpers::convertIntegerToString (maxFileSize));
+            props.setProperty (LOG4CPLUS_TEXT ("MaxBackupIndex"),
+                LOG4CPLUS_TEXT ("1"));
+            props.setProperty (LOG4CPLUS_TEXT ("ImmediateFlush"),
+                LOG4CPLUS_TEXT ("false"));
+
+            SharedAppenderPtr appender (new RollingFileAppender (props));
+            appender->setLayout (std::unique_ptr<Layout> (
+                new PatternLayout (LOG4CPLUS_TEXT ("%m%n"))));
+            auto log_event = [&] {
+                appender->doAppend (spi::InternalLoggingEvent (
+                    LOG4CPLUS_TEXT ("rolling"), INFO_LOG_LEVEL,
+                    LOG4CPLUS_TEXT ("logged record 1"), __FILE__, __LINE__));
+            };
+
+            // Size of the existing file is taken into account.
+            log_event ();
+            CATCH_REQUIRE (file_size (backupName) == existingSize);
+
+            // The counter rolls the file over exactly after the first
+            // event which makes the file larger than MaxFileSize.
+            long const events = maxFileSize / recordSize + 1;
+            for (long i = 0; i != events; ++i)
+                log_event ();
+            appender->close ();
+
+            CATCH_REQUIRE (file_size (backupName) == events * recordSize);
+            CATCH_REQUIRE (file_size (fileName) == recordSize);
+
+            file_remove (fileName);
+            file_remove (backupName);
+        }
+    }
+}
+
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+CATCH_TEST_CASE ("FileAppender MaxFlushDelay", "[appender]")
+{
+    tstring const fileName (LOG4CPLUS_TEXT ("file_appender_flush_test.log"));
+    file_remove (fileName);
+
+    auto file_size = [&] {
+        helpers::FileInfo fi;
+        return getFileInfo (&fi, fileName) == 0 ? fi.size : 0;
+    };
+
+    Properties props;
+    props.setProperty (LOG4CPLUS_TEXT ("File"), fileName);
+    props.setProperty (LOG4CPLUS_TEXT ("ImmediateFlush"),
+        LOG4CPLUS_TEXT ("false"));
+    props.setProperty (LOG4CPLUS_TEXT ("BufferSize"),
+        LOG4CPLUS_TEXT ("65536"));
+    props.setProperty (LOG4CPLUS_TEXT ("MaxFlushDelay"),
+        LOG4CPLUS_TEXT ("20"));
+
+    SharedAppenderPtr appender (new FileAppender (props));
+    appender->setLayout (std::unique_ptr<Layout> (
+        new PatternLayout (LOG4CPLUS_TEXT ("%m%n"))));
+
+    // Each event is written out by the housekeeping thread, also when
+    // the buffer has been flushed and filled again.
+    for (int i = 1; i <= 2; ++i)
+    {
+        appender->doAppend (spi::InternalLoggingEvent (
+            LOG4CPLUS_TEXT ("flush"), INFO_LOG_LEVEL,
+            LOG4CPLUS_TEXT ("event ") + helpers::convertIntegerToString (i),
+            __FILE__, __LINE__));
+        for (int j = 0; j != 500 && file_size () != i * 8; ++j)
+            std::this_thread::sleep_for (std::chrono::milliseconds (10));
+        CATCH_REQUIRE (file_size () == i * 8);
+    }
+
+    appender->close ();
+    file_remove (fileName);
+}
+#endif
 #endif
 
 
@@ -0,0 +1,358 @@
+// -*- C++ -*-
+//
+//  Copyright (C) 2026, Vaclav Haisman. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_HAVE_SYS_TYPES_H)
+#include <sys/types.h>
+#endif
+#if defined (LOG4CPLUS_HAVE_UNISTD_H)
+#include <unistd.h>
+#endif
+#if defined (LOG4CPLUS_HAVE_FCNTL_H)
+#include <fcntl.h>
+#endif
+#if defined (LOG4CPLUS_HAVE_IO_H)
+#include <io.h>
+#endif
+
+#include <log4cplus/helpers/filesync.h>
+#include <log4cplus/helpers/housekeeping.h>
+#include <log4cplus/helpers/loglog.h>
+#include <log4cplus/helpers/stringhelper.h>
+#include <log4cplus/thread/syncprims-pub-impl.h>
+#include <algorithm>
+#include <cerrno>
+
+
+namespace log4cplus::helpers {
+
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+
+static
+int
+open_sync_fd (tstring const & name)
+{
+#if defined (_WIN32)
+#  if defined (UNICODE)
+    return _wopen (name.c_str (), _O_WRONLY | _O_APPEND | _O_NOINHERIT);
+#  else
+    return _open (name.c_str (), _O_WRONLY | _O_APPEND | _O_NOINHERIT);
+#  endif
+
+#else
+    int flags = O_WRONLY | O_APPEND;
+#if defined (O_CLOEXEC)
+    flags |= O_CLOEXEC;
+#endif
+    int fd;
+    do
+        fd = ::open (LOG4CPLUS_TSTRING_TO_STRING (name).c_str (), flags);
+    while (fd == -1 && errno == EINTR);
+    return fd;
+
+#endif
+}
+
+
+static
+int
+dup_fd (int fd)
+{
+#if defined (_WIN32)
+    return _dup (fd);
+#else
+    return ::dup (fd);
+#endif
+}
+
+
+static
+void
+close_fd (int fd)
+{
+#if defined (_WIN32)
+    _close (fd);
+#else
+    ::close (fd);
+#endif
+}
+
+} // namespace
+
+
+//
+//
+//
+
+IFileSyncClient::~IFileSyncClient () = default;
+
+
+bool
+FileSyncPolicy::enabled () const
+{
+    return interval.count () > 0
+        || bytes != 0
+        || level != NOT_SET_LOG_LEVEL;
+}
+
+
+//
+//
+//
+
+FileSync::FileSync (IFileSyncClient & client, FileSyncPolicy const & policy_)
+    : fsc (client)
+    , policy (policy_)
+    , sync_fd (-1)
+    , dirty (false)
+    , unsynced_bytes (0)
+    , append_seq (0)
+    , synced_seq (0)
+    , dirty_pending (false)
+    , requested (false)
+{
+    registerHousekeepingTask (this);
+}
+
+
+FileSync::~FileSync ()
+{
+    unregisterHousekeepingTask (this);
+
+    if (sync_fd != -1)
+        close_fd (sync_fd);
+}
+
+
+void
+FileSync::attach (tstring const & name)
+{
+    detach ();
+
+    sync_fd = open_sync_fd (name);
+    if (sync_fd == -1)
+    {
+        int const eno = errno;
+        getLogLog ().error (
+            LOG4CPLUS_TEXT ("FileSync::attach()- cannot open ") + name
+            + LOG4CPLUS_TEXT (" for synchronization, error ")
+            + convertIntegerToString (eno));
+    }
+}
+
+
+void
+FileSync::detach ()
+{
+    if (dirty && sync_fd != -1)
+    {
+        fsc.fscFlush ();
+        syncFile (sync_fd);
+    }
+
+    if (sync_fd != -1)
+    {
+        close_fd (sync_fd);
+        sync_fd = -1;
+    }
+
+    dirty = false;
+    unsynced_bytes = 0;
+    {
+        std::lock_guard<std::mutex> lock (mtx);
+        dirty_pending = false;
+        requested = false;
+    }
+    notifySynced (append_seq.load (std::memory_order_relaxed));
+}
+
+
+void
+FileSync::appended (std::uint64_t size)
+{
+    append_seq.store (append_seq.load (std::memory_order_relaxed) + 1,
+        std::memory_order_release);
+
+    bool wake = false;
+    if (! dirty)
+    {
+        dirty = true;
+        if (policy.interval.count () > 0)
+        {
+            std::lock_guard<std::mutex> lock (mtx);
+            dirty_since = Clock::now ();
+            dirty_pending = true;
+            wake = true;
+        }
+    }
+
+    unsynced_bytes += size;
+    if (policy.bytes != 0
+        && unsynced_bytes >= policy.bytes
+        && unsynced_bytes - size < policy.bytes)
+    {
+        std::lock_guard<std::mutex> lock (mtx);
+        requested = true;
+        wake = true;
+    }
+
+#if defined (LOG4CPLUS_SINGLE_THREADED)
+    (void) wake;
+    if (hkNextRunTime () <= Clock::now ())
+        sync ();
+#else
+    if (wake)
+        wakeHousekeepingThread ();
+#endif
+}
+
+
+void
+FileSync::wait ()
+{
+    std::uint64_t const target = append_seq.load (std::memory_order_acquire);
+
+#if defined (LOG4CPLUS_SINGLE_THREADED)
+    if (synced_seq < target)
+        sync ();
+
+#else
+    {
+        std::lock_guard<std::mutex> lock (mtx);
+        if (synced_seq >= target)
+            return;
+
+        requested = true;
+    }
+
+    wakeHousekeepingThread ();
+
+    // All threads waiting at this point are released by a single
+    // sync() of the background thread.
+    std::unique_lock<std::mutex> lock (mtx);
+    synced_cv.wait (lock, [&] { return synced_seq >= target; });
+
+#endif
+}
+
+
+void
+FileSync::sync ()
+{
+    std::uint64_t seq;
+    int fd = -1;
+    {
+        thread::MutexGuard guard (fsc.fscGetAccessMutex ());
+        {
+            std::lock_guard<std::mutex> lock (mtx);
+            requested = false;
+            dirty_pending = false;
+        }
+
+        seq = append_seq.load (std::memory_order_relaxed);
+        if (dirty)
+        {
+            fsc.fscFlush ();
+            dirty = false;
+            unsynced_bytes = 0;
+            if (sync_fd != -1)
+                fd = dup_fd (sync_fd);
+        }
+    }
+
+    // The file is synchronized with the client's mutex unlocked, using
+    // a duplicate descriptor, so that the client can log and even
+    // close the file meanwhile.
+    if (fd != -1)
+    {
+        syncFile (fd);
+        close_fd (fd);
+    }
+
+    notifySynced (seq);
+}
+
+
+Clock::time_point
+FileSync::hkNextRunTime ()
+{
+    std::lock_guard<std::mutex> lock (mtx);
+    if (requested)
+        return Clock::time_point::min ();
+    else if (dirty_pending)
+        return dirty_since + policy.interval;
+    else
+        return Clock::time_point::max ();
+}
+
+
+void
+FileSync::hkRun ()
+{
+    sync ();
+}
+
+
+int
+FileSync::syncFile (int fd) const
+{
+#if defined (_WIN32)
+    int ret = _commit (fd);
+#elif defined (LOG4CPLUS_HAVE_FDATASYNC)
+    int ret = policy.dataOnly ? ::fdatasync (fd) : ::fsync (fd);
+#else
+    int ret = ::fsync (fd);
+#endif
+
+    if (ret != 0)
+    {
+        ret = errno;
+        getLogLog ().error (
+            LOG4CPLUS_TEXT ("FileSync::syncFile()- synchronization failed, error ")
+            + convertIntegerToString (ret));
+    }
+
+    return ret;
+}
+
+
+void
+FileSync::notifySynced (std::uint64_t seq)
+{
+    {
+        std::lock_guard<std::mutex> lock (mtx);
+        synced_seq = (std::max) (synced_seq, seq);
+    }
+    synced_cv.notify_all ();
+}
+
+
+} // namespace log4cplus::helpers
@@ -44,6 +44,7 @@
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
 #include "ThreadPool.h"
 #endif
+#include <algorithm>
 #include <cstdio>
 #include <iostream>
 #include <stdexcept>
@@ -188,6 +189,9 @@ struct DefaultContext
     Hierarchy hierarchy;
     ThreadPoolHolder thread_pool;
     std::atomic<bool> block_on_full {true};
+    //! Mirrors the thread pool queue size limit. Asynchronous appenders
+    //! use it to limit number of events waiting in their batch.
+    std::atomic<std::size_t> queue_size_limit {100000};
 
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
     progschj::ThreadPool *
@@ -368,15 +372,43 @@ getMDC ()
 #if ! defined (LOG4CPLUS_SINGLE_THREADED) \
     && defined (LOG4CPLUS_ENABLE_THREAD_POOL)
 void
-enqueueAsyncDoAppend (SharedAppenderPtr const & appender,
-    spi::InternalLoggingEvent const & event)
+reportDroppedAsyncEvents (std::size_t count)
 {
     static helpers::SteadyClockGate gate (helpers::SteadyClockGate::Duration {std::chrono::minutes (5)});
 
+    for (; count != 0; --count)
+        gate.record_event ();
+    helpers::SteadyClockGate::Info info;
+    if (gate.latch_open (info))
+    {
+        helpers::LogLog & loglog = helpers::getLogLog ();
+        log4cplus::tostringstream oss;
+        oss << LOG4CPLUS_TEXT ("Asynchronous logging queue is full. Dropped ")
+            << info.count << LOG4CPLUS_TEXT (" events in last ")
+            << std::chrono::duration_cast<std::chrono::seconds> (info.time_span).count ()
+            << LOG4CPLUS_TEXT (" seconds");
+        loglog.warn (oss.str ());
+    }
+}
+
+
+void
+getAsyncAppendLimits (std::size_t & limit, bool & block)
+{
+    DefaultContext * dc = get_dc ();
+    limit = (std::max) (dc->queue_size_limit.load (
+            std::memory_order_relaxed), std::size_t (1));
+    block = dc->block_on_full.load (std::memory_order_relaxed);
+}
+
+
+void
+enqueueAsyncDoAppend (SharedAppenderPtr const & appender)
+{
     DefaultContext * dc = get_dc ();
     progschj::ThreadPool * tp = dc->get_thread_pool (true);
     auto func = [=] () {
-        appender->asyncDoAppend (event);
+        appender->asyncDoAppendBatch ();
     };
     if (dc->block_on_full)
         tp->enqueue_block (std::move (func));
@@ -391,18 +423,7 @@ enqueueAsyncDoAppend (SharedAppenderPtr const & appender,
             }
             catch (const progschj::would_block &)
             {
-                gate.record_event ();
-                helpers::SteadyClockGate::Info info;
-                if (gate.latch_open (info))
-                {
-                    helpers::LogLog & loglog = helpers::getLogLog ();
-                    log4cplus::tostringstream oss;
-                    oss << LOG4CPLUS_TEXT ("Asynchronous logging queue is full. Dropped ")
-                        << info.count << LOG4CPLUS_TEXT (" events in last ")
-                        << std::chrono::duration_cast<std::chrono::seconds> (info.time_span).count ()
-                        << LOG4CPLUS_TEXT (" seconds");
-                    loglog.warn (oss.str ());
-                }
+                reportDroppedAsyncEvents (appender->discardAsyncBatch ());
             }
         }
     }
@@ -493,6 +514,32 @@ appender_sratch_pad::appender_sratch_pad () = default;
 appender_sratch_pad::~appender_sratch_pad () = default;
 
 
+string_append_buf::int_type
+string_append_buf::overflow (int_type ch)
+{
+    if (! traits_type::eq_int_type (ch, traits_type::eof ()))
+        target->push_back (traits_type::to_char_type (ch));
+
+    return traits_type::not_eof (ch);
+}
+
+
+std::streamsize
+string_append_buf::xsputn (tchar const * s, std::streamsize n)
+{
+    target->append (s, static_cast<std::size_t>(n));
+    return n;
+}
+
+
+layout_scratch_pad::layout_scratch_pad ()
+    : os (&buf)
+{ }
+
+
+layout_scratch_pad::~layout_scratch_pad () = default;
+
+
 per_thread_data::per_thread_data ()
     : fnull (nullptr)
 { }
@@ -500,6 +547,7 @@ per_thread_data::per_thread_data ()
 
 per_thread_data::~per_thread_data ()
 {
+    rcu::release_reader (rcu);
     if (fnull)
         std::fclose (fnull);
 }
@@ -699,7 +747,9 @@ void
 setThreadPoolQueueSizeLimit (std::size_t LOG4CPLUS_THREADED (queue_size_limit))
 {
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
-    auto const thread_pool = get_dc ()->get_thread_pool (true);
+    DefaultContext * dc = get_dc ();
+    dc->queue_size_limit.store (queue_size_limit);
+    auto const thread_pool = dc->get_thread_pool (true);
     if (thread_pool)
         thread_pool->set_queue_size_limit (queue_size_limit);
 
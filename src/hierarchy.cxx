@@ -18,14 +18,22 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <log4cplus/internal/internal.h>
 #include <log4cplus/hierarchy.h>
 #include <log4cplus/helpers/loglog.h>
 #include <log4cplus/spi/loggerimpl.h>
 #include <log4cplus/spi/rootlogger.h>
 #include <log4cplus/thread/syncprims-pub-impl.h>
+#include <cassert>
+#include <functional>
 #include <utility>
 #include <limits>
 
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <log4cplus/helpers/stringhelper.h>
+#include <catch_amalgamated.hpp>
+#endif
+
 
 namespace log4cplus
 {
@@ -49,9 +57,98 @@ bool startsWith(tstring_view const & teststr, tstring_view const & substr)
     return val;
 }
 
+//! Initial number of buckets of Hierarchy::LoggerIndex.
+static std::size_t const initial_index_buckets = 64;
+
+
+static
+std::size_t
+hashLoggerName (tstring_view const & name)
+{
+    return std::hash<tstring_view> () (name);
+}
+
 } // namespace
 
 
+//////////////////////////////////////////////////////////////////////////////
+// Hierarchy::LoggerIndex
+//////////////////////////////////////////////////////////////////////////////
+
+//! Insert-only hash table with chained buckets. Writers are serialized
+//! by Hierarchy::hashtable_mutex, readers do not lock. Nodes are
+//! prepended to bucket chains and never modified after they are
+//! published, so readers can walk the chains without synchronization
+//! beyond the acquire load of the bucket head.
+struct Hierarchy::LoggerIndex
+{
+    struct Node
+    {
+        Node (std::size_t h, Logger const & l, Node * n)
+            : hash (h)
+            , logger (l)
+            , next (n)
+        { }
+
+        std::size_t const hash;
+        Logger const logger;
+        Node * const next;
+    };
+
+    explicit LoggerIndex (std::size_t bucket_count)
+        : mask (bucket_count - 1)
+        , buckets (new std::atomic<Node *>[bucket_count])
+        , size (0)
+    {
+        assert ((bucket_count & mask) == 0);
+        for (std::size_t i = 0; i != bucket_count; ++i)
+            buckets[i].store (nullptr, std::memory_order_relaxed);
+    }
+
+    ~LoggerIndex ()
+    {
+        for (std::size_t i = 0; i != mask + 1; ++i)
+        {
+            Node * node = buckets[i].load (std::memory_order_relaxed);
+            while (node)
+            {
+                Node * next = node->next;
+                delete node;
+                node = next;
+            }
+        }
+    }
+
+    Logger const *
+    find (tstring_view const & name, std::size_t hash) const
+    {
+        for (Node const * node
+                 = buckets[hash & mask].load (std::memory_order_acquire);
+             node; node = node->next)
+            if (node->hash == hash && node->logger.value->getName () == name)
+                return &node->logger;
+
+        return nullptr;
+    }
+
+    void
+    insert (Logger const & logger, std::size_t hash)
+    {
+        std::atomic<Node *> & bucket = buckets[hash & mask];
+        bucket.store (
+            new Node (hash, logger, bucket.load (std::memory_order_relaxed)),
+            std::memory_order_release);
+        ++size;
+    }
+
+    std::size_t const mask;
+    std::unique_ptr<std::atomic<Node *>[]> buckets;
+
+    //! Number of nodes. Accessed only by writers.
+    std::size_t size;
+};
+
+
 //////////////////////////////////////////////////////////////////////////////
 // Hierarchy static declarations
 //////////////////////////////////////////////////////////////////////////////
@@ -69,16 +166,19 @@ Hierarchy::Hierarchy()
   : defaultFactory(new DefaultLoggerFactory())
   , root(nullptr)
   // Don't disable any LogLevel level by default.
+  , loggerIndex(nullptr)
   , disableValue(DISABLE_OFF)
   , emittedNoAppenderWarning(false)
 {
     root = Logger( new spi::RootLogger(*this, DEBUG_LOG_LEVEL) );
+    resetLoggerIndex (initial_index_buckets);
 }
 
 
 Hierarchy::~Hierarchy()
 {
     shutdown();
+    internal::rcu::retire (loggerIndex.load (std::memory_order_relaxed));
 }
 
 
@@ -94,6 +194,9 @@ Hierarchy::clear()
 
     provisionNodes.erase(provisionNodes.begin(), provisionNodes.end());
     loggerPtrs.erase(loggerPtrs.begin(), loggerPtrs.end());
+    resetLoggerIndex (initial_index_buckets);
+    spi::bumpLoggerRegistryGeneration ();
+    spi::bumpLoggerConfigurationEpoch ();
 }
 
 
@@ -104,27 +207,24 @@ Hierarchy::exists(const tstring_view& name)
     if (name.empty ())
         return true;
 
-    thread::MutexGuard guard (hashtable_mutex);
-
-    auto it = loggerPtrs.find(name);
-    return it != loggerPtrs.end();
+    internal::rcu::read_guard const guard;
+    return findLogger (name) != nullptr;
 }
 
 
 void
 Hierarchy::disable(const tstring_view& loglevelStr)
 {
-    if(disableValue != DISABLE_OVERRIDE) {
-        disableValue = getLogLevelManager().fromString(loglevelStr);
-    }
+    disable (getLogLevelManager().fromString(loglevelStr));
 }
 
 
 void
 Hierarchy::disable(LogLevel ll)
 {
-    if(disableValue != DISABLE_OVERRIDE) {
-        disableValue = ll;
+    if(disableValue.load (std::memory_order_relaxed) != DISABLE_OVERRIDE) {
+        disableValue.store (ll, std::memory_order_relaxed);
+        spi::bumpLoggerConfigurationEpoch ();
     }
 }
 
@@ -153,7 +253,8 @@ Hierarchy::disableInfo()
 void
 Hierarchy::enableAll()
 {
-    disableValue = DISABLE_OFF;
+    disableValue.store (DISABLE_OFF, std::memory_order_relaxed);
+    spi::bumpLoggerConfigurationEpoch ();
 }
 
 
@@ -167,6 +268,15 @@ Hierarchy::getInstance(const tstring_view& name)
 Logger
 Hierarchy::getInstance(const tstring_view& name, spi::LoggerFactory& factory)
 {
+    if (name.empty ())
+        return root;
+
+    {
+        internal::rcu::read_guard const guard;
+        if (Logger const * logger = findLogger (name))
+            return *logger;
+    }
+
     thread::MutexGuard guard (hashtable_mutex);
 
     return getInstanceImpl(name, factory);
@@ -190,7 +300,7 @@ Hierarchy::getCurrentLoggers()
 bool
 Hierarchy::isDisabled(LogLevel level)
 {
-    return disableValue >= level;
+    return disableValue.load (std::memory_order_relaxed) >= level;
 }
 
 
@@ -205,7 +315,7 @@ void
 Hierarchy::resetConfiguration()
 {
     getRoot().setLogLevel(DEBUG_LOG_LEVEL);
-    disableValue = DISABLE_OFF;
+    enableAll ();
 
     shutdown();
 
@@ -303,6 +413,10 @@ Hierarchy::getInstanceImpl(const tstring_view& name,
             provisionNodes.erase(pnm_it);
         }
         updateParents(logger);
+        indexLogger(logger);
+
+        // Parent links of this and possibly other loggers have changed.
+        spi::bumpLoggerConfigurationEpoch ();
     }
 
     return logger;
@@ -318,6 +432,47 @@ Hierarchy::initializeLoggerList(LoggerList& list) const
 }
 
 
+Logger const *
+Hierarchy::findLogger(const tstring_view& name) const
+{
+    return loggerIndex.load (std::memory_order_acquire)->find (name,
+        hashLoggerName (name));
+}
+
+
+void
+Hierarchy::indexLogger(Logger const & logger)
+{
+    LoggerIndex * index = loggerIndex.load (std::memory_order_relaxed);
+    if (index->size >= index->mask + 1)
+    {
+        // Grow. Nodes of the current index cannot be relinked because
+        // readers might be walking them, so the new index gets its own
+        // copies.
+        std::unique_ptr<LoggerIndex> bigger (
+            new LoggerIndex ((index->mask + 1) * 2));
+        for (auto const & kv : loggerPtrs)
+            if (kv.second.value != logger.value)
+                bigger->insert (kv.second, hashLoggerName (kv.first));
+
+        index = bigger.release ();
+        internal::rcu::retire (
+            loggerIndex.exchange (index, std::memory_order_acq_rel));
+    }
+
+    index->insert (logger, hashLoggerName (logger.getName ()));
+}
+
+
+void
+Hierarchy::resetLoggerIndex(std::size_t buckets)
+{
+    if (LoggerIndex * const old = loggerIndex.exchange (
+            new LoggerIndex (buckets), std::memory_order_acq_rel))
+        internal::rcu::retire (old);
+}
+
+
 void
 Hierarchy::updateParents(Logger const & logger)
 {
@@ -336,7 +491,7 @@ Hierarchy::updateParents(Logger const & logger)
         if (auto it = loggerPtrs.find(substr); it != loggerPtrs.end())
         {
             parentFound = true;
-            logger.value->parent = it->second.value;
+            logger.value->setParent (it->second.value);
             break;  // no need to update the ancestors of the closest ancestor
         }
         else
@@ -360,7 +515,7 @@ Hierarchy::updateParents(Logger const & logger)
     } // end for loop
 
     if(!parentFound) {
-        logger.value->parent = root.value;
+        logger.value->setParent (root.value);
     }
 }
 
@@ -373,11 +528,103 @@ Hierarchy::updateChildren(ProvisionNode& pn, Logger const & logger)
         // Unless this child already points to a correct (lower) parent,
         // make logger.parent point to c.parent and c.parent to logger.
         if( !startsWith(c.value->parent->getName(), logger.getName()) ) {
-            logger.value->parent = c.value->parent;
-            c.value->parent = logger.value;
+            logger.value->setParent (c.value->parent.get ());
+            c.value->setParent (logger.value);
+        }
+    }
+}
+
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+CATCH_TEST_CASE ("Hierarchy logger index", "[hierarchy]")
+{
+    Hierarchy h;
+    std::size_t const count = initial_index_buckets * 4 + 1;
+    std::vector<Logger> loggers;
+    for (std::size_t i = 0; i != count; ++i)
+        loggers.push_back (h.getInstance (LOG4CPLUS_TEXT ("index.")
+            + helpers::convertIntegerToString (i)));
+
+    // Lookups after growth of the index find the same loggers.
+    for (std::size_t i = 0; i != count; ++i)
+    {
+        tstring const name = LOG4CPLUS_TEXT ("index.")
+            + helpers::convertIntegerToString (i);
+        CATCH_REQUIRE (h.exists (name));
+        Logger logger = h.getInstance (name);
+        CATCH_REQUIRE (logger.getName () == name);
+        CATCH_REQUIRE (logger.getParent ().getName ()
+            == h.getInstance (LOG4CPLUS_TEXT ("index")).getName ());
+    }
+    CATCH_REQUIRE (! h.exists (LOG4CPLUS_TEXT ("index.x")));
+    CATCH_REQUIRE (h.getCurrentLoggers ().size () == count + 1);
+
+    h.clear ();
+    CATCH_REQUIRE (! h.exists (LOG4CPLUS_TEXT ("index.0")));
+    CATCH_REQUIRE (h.getCurrentLoggers ().empty ());
+}
+
+
+namespace
+{
+
+struct CountingLoggerFactory
+    : DefaultLoggerFactory
+{
+    struct CountingLoggerImpl
+        : spi::LoggerImpl
+    {
+        CountingLoggerImpl (tstring_view const & name, Hierarchy & h,
+            std::size_t & destroyed_)
+            : spi::LoggerImpl (name, h)
+            , destroyed (destroyed_)
+        { }
+
+        ~CountingLoggerImpl () override
+        {
+            ++destroyed;
         }
+
+        std::size_t & destroyed;
+    };
+
+    spi::LoggerImpl *
+    makeNewLoggerImplInstance (tstring_view const & name, Hierarchy & h)
+        override
+    {
+        return new CountingLoggerImpl (name, h, destroyed);
+    }
+
+    std::size_t destroyed = 0;
+};
+
+} // namespace
+
+
+CATCH_TEST_CASE ("Hierarchy logger index reclamation", "[hierarchy]")
+{
+    CountingLoggerFactory factory;
+    std::size_t const rounds = 100;
+
+    {
+        Hierarchy h;
+        for (std::size_t i = 0; i != rounds; ++i)
+        {
+            // Each round grows the index once and clear() replaces it.
+            for (std::size_t j = 0; j != initial_index_buckets + 1; ++j)
+                h.getInstance (LOG4CPLUS_TEXT ("reclaim.")
+                    + helpers::convertIntegerToString (j), factory);
+            h.clear ();
+        }
+
+        // Replaced indexes and the loggers they referenced are released
+        // without waiting for destruction of the hierarchy.
+        internal::rcu::reclaim ();
+        CATCH_REQUIRE (factory.destroyed
+            == rounds * (initial_index_buckets + 1));
     }
 }
+#endif // defined (LOG4CPLUS_WITH_UNIT_TESTS)
 
 
 } // namespace log4cplus
@@ -0,0 +1,549 @@
+// -*- C++ -*-
+//
+//  Copyright (C) 2026, Vaclav Haisman. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <log4cplus/helpers/housekeeping.h>
+#include <log4cplus/helpers/loglog.h>
+#include <log4cplus/helpers/stringhelper.h>
+#include <log4cplus/thread/threads.h>
+#include <log4cplus/thread/syncprims-pub-impl.h>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <vector>
+
+#if defined (_WIN32)
+#include <log4cplus/config/windowsh-inc.h>
+#elif defined (LOG4CPLUS_USE_PTHREADS)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+
+namespace log4cplus::helpers {
+
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+
+//! Thread shared by all housekeeping tasks.
+class HousekeepingThread
+    : public thread::AbstractThread
+{
+public:
+    void add (IHousekeepingTask * task)
+    {
+        std::lock_guard<std::mutex> lock (mtx);
+        tasks.push_back (task);
+        cv.notify_all ();
+    }
+
+    //! Removes `task`, waiting for its hkRun() to finish, if necessary.
+    void remove (IHousekeepingTask * task)
+    {
+        std::unique_lock<std::mutex> lock (mtx);
+        tasks.erase (std::remove (tasks.begin (), tasks.end (), task),
+            tasks.end ());
+        cv.wait (lock, [&] { return busy != task; });
+    }
+
+    void wake ()
+    {
+        std::lock_guard<std::mutex> lock (mtx);
+        cv.notify_all ();
+    }
+
+    void terminate ()
+    {
+        std::lock_guard<std::mutex> lock (mtx);
+        exit_flag = true;
+        cv.notify_all ();
+    }
+
+    virtual void run () override
+    {
+        std::unique_lock<std::mutex> lock (mtx);
+        while (! exit_flag)
+        {
+            Clock::time_point const now = Clock::now ();
+            Clock::time_point next = Clock::time_point::max ();
+            auto due = tasks.end ();
+            for (auto it = tasks.begin (); it != tasks.end (); ++it)
+            {
+                Clock::time_point const t = (*it)->hkNextRunTime ();
+                if (t <= now)
+                {
+                    due = it;
+                    break;
+                }
+                next = (std::min) (next, t);
+            }
+
+            if (due != tasks.end ())
+            {
+                // Move the task to the end so that other due tasks
+                // get their turn first next time.
+                busy = *due;
+                std::rotate (due, due + 1, tasks.end ());
+
+                lock.unlock ();
+                busy->hkRun ();
+                lock.lock ();
+
+                busy = nullptr;
+                cv.notify_all ();
+            }
+            else if (next == Clock::time_point::max ())
+                cv.wait (lock);
+            else
+                cv.wait_until (lock, next);
+        }
+    }
+
+private:
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::vector<IHousekeepingTask *> tasks;
+    //! Task whose hkRun() is in progress.
+    IHousekeepingTask * busy = nullptr;
+    bool exit_flag = false;
+};
+
+
+using HousekeepingThreadPtr = SharedObjectPtr<HousekeepingThread>;
+
+
+struct HousekeepingRegistry
+{
+    std::mutex mtx;
+    HousekeepingThreadPtr thread;
+    std::size_t users = 0;
+};
+
+
+static
+HousekeepingRegistry &
+get_registry ()
+{
+    // The registry is intentionally leaked so that appenders destroyed
+    // during static destruction can still unregister.
+    static HousekeepingRegistry * const registry = new HousekeepingRegistry;
+    return *registry;
+}
+
+
+struct MaintenanceQueue;
+
+
+//! Thread executing queued maintenance jobs.
+class MaintenanceThread
+    : public thread::AbstractThread
+{
+public:
+    explicit MaintenanceThread (MaintenanceQueue & queue_)
+        : queue (queue_)
+    { }
+
+    virtual void run () override;
+
+private:
+    MaintenanceQueue & queue;
+};
+
+
+using MaintenanceThreadPtr = SharedObjectPtr<MaintenanceThread>;
+
+
+struct MaintenanceQueue
+{
+    explicit MaintenanceQueue (bool lowPriority_)
+        : lowPriority (lowPriority_)
+    { }
+
+    //! Threads of this queue run with lowered priority.
+    bool const lowPriority;
+    std::mutex mtx;
+    std::condition_variable done_cv;
+    std::deque<std::function<void ()>> jobs;
+    //! Count of queued jobs. It is also the identifier of the last one.
+    std::uint64_t queued = 0;
+    //! Count of executed jobs.
+    std::uint64_t done = 0;
+    MaintenanceThreadPtr thread;
+    bool running = false;
+};
+
+
+static
+MaintenanceQueue &
+get_maintenance_queue ()
+{
+    // Leaked for the same reason as the housekeeping registry.
+    static MaintenanceQueue * const queue = new MaintenanceQueue (false);
+    return *queue;
+}
+
+
+static
+MaintenanceQueue &
+get_background_queue ()
+{
+    static MaintenanceQueue * const queue = new MaintenanceQueue (true);
+    return *queue;
+}
+
+
+//! Lowers scheduling priority of the calling thread, so that it yields
+//! to logging threads.
+static
+void
+lower_thread_priority ()
+{
+#if defined (_WIN32)
+    SetThreadPriority (GetCurrentThread (), THREAD_PRIORITY_LOWEST);
+
+#elif defined (LOG4CPLUS_USE_PTHREADS) && defined (SCHED_IDLE)
+    sched_param param {};
+    param.sched_priority = 0;
+    if (int const ret = pthread_setschedparam (pthread_self (), SCHED_IDLE,
+            &param); ret != 0)
+        getLogLog ().debug (
+            LOG4CPLUS_TEXT ("Failed to lower priority of background thread; error ")
+            + convertIntegerToString (ret));
+
+#endif
+}
+
+#endif // ! defined (LOG4CPLUS_SINGLE_THREADED)
+
+
+static
+void
+run_maintenance_job (std::function<void ()> const & job)
+{
+    try
+    {
+        job ();
+    }
+    catch (std::exception const & e)
+    {
+        getLogLog ().error (
+            LOG4CPLUS_TEXT ("Maintenance job failed: ")
+            + LOG4CPLUS_C_STR_TO_TSTRING (e.what ()));
+    }
+    catch (...)
+    {
+        getLogLog ().error (LOG4CPLUS_TEXT ("Maintenance job failed."));
+    }
+}
+
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+
+void
+MaintenanceThread::run ()
+{
+    if (queue.lowPriority)
+        lower_thread_priority ();
+
+    std::unique_lock<std::mutex> lock (queue.mtx);
+    while (! queue.jobs.empty ())
+    {
+        std::function<void ()> job (std::move (queue.jobs.front ()));
+        queue.jobs.pop_front ();
+
+        lock.unlock ();
+        run_maintenance_job (job);
+        lock.lock ();
+
+        ++queue.done;
+        queue.done_cv.notify_all ();
+    }
+    queue.running = false;
+}
+
+#endif // ! defined (LOG4CPLUS_SINGLE_THREADED)
+
+} // namespace
+
+
+//
+//
+//
+
+IHousekeepingTask::~IHousekeepingTask () = default;
+
+
+void
+registerHousekeepingTask (IHousekeepingTask * task)
+{
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    HousekeepingRegistry & registry = get_registry ();
+    std::lock_guard<std::mutex> lock (registry.mtx);
+    if (! registry.thread)
+    {
+        registry.thread = HousekeepingThreadPtr (new HousekeepingThread);
+        registry.thread->start ();
+    }
+    registry.thread->add (task);
+    ++registry.users;
+
+#else
+    (void) task;
+
+#endif
+}
+
+
+void
+unregisterHousekeepingTask (IHousekeepingTask * task)
+{
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    HousekeepingRegistry & registry = get_registry ();
+    HousekeepingThreadPtr thread;
+    {
+        std::lock_guard<std::mutex> lock (registry.mtx);
+        thread = registry.thread;
+    }
+
+    // This waits for hkRun() of the task to finish. The registry is
+    // not locked here because hkRun() usually takes a client's mutex
+    // and its holder might be waiting for the registry.
+    thread->remove (task);
+
+    HousekeepingThreadPtr stopped;
+    {
+        std::lock_guard<std::mutex> lock (registry.mtx);
+        if (--registry.users == 0)
+            stopped = std::move (registry.thread);
+    }
+
+    if (stopped)
+    {
+        stopped->terminate ();
+        stopped->join ();
+    }
+
+#else
+    (void) task;
+
+#endif
+}
+
+
+void
+wakeHousekeepingThread ()
+{
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    HousekeepingRegistry & registry = get_registry ();
+    HousekeepingThreadPtr thread;
+    {
+        std::lock_guard<std::mutex> lock (registry.mtx);
+        thread = registry.thread;
+    }
+    if (thread)
+        thread->wake ();
+#endif
+}
+
+
+namespace
+{
+
+static
+std::uint64_t
+queue_job (
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    MaintenanceQueue & queue,
+#endif
+    std::function<void ()> job)
+{
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    MaintenanceThreadPtr finished;
+    std::uint64_t id;
+    {
+        std::lock_guard<std::mutex> lock (queue.mtx);
+        queue.jobs.push_back (std::move (job));
+        id = ++queue.queued;
+        if (! queue.running)
+        {
+            finished = std::move (queue.thread);
+            queue.thread = MaintenanceThreadPtr (new MaintenanceThread (queue));
+            queue.running = true;
+            queue.thread->start ();
+        }
+    }
+
+    // The previous thread has left its loop already, so this does not
+    // block for long.
+    if (finished)
+        finished->join ();
+
+    return id;
+
+#else
+    run_maintenance_job (job);
+    return 0;
+
+#endif
+}
+
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+static
+void
+wait_for_job (MaintenanceQueue & queue, std::uint64_t id)
+{
+    if (id == 0)
+        return;
+
+    std::unique_lock<std::mutex> lock (queue.mtx);
+    queue.done_cv.wait (lock, [&] { return queue.done >= id; });
+}
+#endif
+
+} // namespace
+
+
+std::uint64_t
+queueMaintenanceJob (std::function<void ()> job)
+{
+    return queue_job (
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+        get_maintenance_queue (),
+#endif
+        std::move (job));
+}
+
+
+void
+waitForMaintenanceJob (std::uint64_t id)
+{
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    wait_for_job (get_maintenance_queue (), id);
+
+#else
+    (void) id;
+
+#endif
+}
+
+
+std::uint64_t
+queueBackgroundJob (std::function<void ()> job)
+{
+    return queue_job (
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+        get_background_queue (),
+#endif
+        std::move (job));
+}
+
+
+void
+waitForBackgroundJob (std::uint64_t id)
+{
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    wait_for_job (get_background_queue (), id);
+
+#else
+    (void) id;
+
+#endif
+}
+
+
+//
+//
+//
+
+IDelayedFlushClient::~IDelayedFlushClient () = default;
+
+
+DelayedFlusher::DelayedFlusher (IDelayedFlushClient & client,
+    std::chrono::milliseconds maxDelay)
+    : dfc (client)
+    , max_delay (maxDelay)
+    , dirty (false)
+    , dirty_pending (false)
+{
+    registerHousekeepingTask (this);
+}
+
+
+DelayedFlusher::~DelayedFlusher ()
+{
+    unregisterHousekeepingTask (this);
+}
+
+
+void
+DelayedFlusher::becameDirty ()
+{
+    dirty = true;
+    {
+        std::lock_guard<std::mutex> lock (mtx);
+        dirty_since = Clock::now ();
+        dirty_pending = true;
+    }
+    wakeHousekeepingThread ();
+}
+
+
+Clock::time_point
+DelayedFlusher::hkNextRunTime ()
+{
+    std::lock_guard<std::mutex> lock (mtx);
+    if (dirty_pending)
+        return dirty_since + max_delay;
+    else
+        return Clock::time_point::max ();
+}
+
+
+void
+DelayedFlusher::hkRun ()
+{
+    thread::MutexGuard guard (dfc.dfcGetAccessMutex ());
+    {
+        std::lock_guard<std::mutex> lock (mtx);
+        dirty_pending = false;
+    }
+
+    // The client might have flushed its output meanwhile.
+    if (dirty)
+    {
+        dfc.dfcFlush ();
+        dirty = false;
+    }
+}
+
+
+} // namespace log4cplus::helpers
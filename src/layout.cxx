@@ -31,15 +31,31 @@
 namespace log4cplus
 {
 
+static
+long long
+relative_timestamp (log4cplus::spi::InternalLoggingEvent const & event)
+{
+    auto const duration
+        = event.getTimestamp () - getTTCCLayoutTimeBase ();
+    return helpers::chrono::duration_cast<
+        helpers::chrono::duration<long long, std::milli>>(
+            duration).count ();
+}
+
+
 void
 formatRelativeTimestamp (log4cplus::tostream & output,
     log4cplus::spi::InternalLoggingEvent const & event)
 {
-    auto const duration
-        = event.getTimestamp () - getTTCCLayoutTimeBase ();
-    output << helpers::chrono::duration_cast<
-                  helpers::chrono::duration<long long, std::milli>>(
-                      duration).count ();
+    output << relative_timestamp (event);
+}
+
+
+void
+formatRelativeTimestamp (log4cplus::tstring & buffer,
+    log4cplus::spi::InternalLoggingEvent const & event)
+{
+    helpers::appendIntegerToString (buffer, relative_timestamp (event));
 }
 
 //
@@ -60,6 +76,95 @@ Layout::Layout (const log4cplus::helpers::Properties&)
 Layout::~Layout() = default;
 
 
+void
+Layout::formatAndAppend (log4cplus::tstring & buffer,
+    const log4cplus::spi::InternalLoggingEvent& event)
+{
+    tostringstream & oss = internal::get_ptd ()->layout_oss;
+    detail::clear_tostringstream (oss);
+    formatAndAppend (oss, event);
+    buffer += oss.str ();
+}
+
+
+void
+Layout::formatAndAppendToStream (log4cplus::tostream & output,
+    const log4cplus::spi::InternalLoggingEvent& event)
+{
+    internal::per_thread_data * ptd = internal::get_ptd ();
+    tstring & buffer = ptd->faa_str;
+    buffer.clear ();
+    Layout const * const outer = ptd->layout_sp.in_stream_overload;
+    ptd->layout_sp.in_stream_overload = this;
+    try
+    {
+        formatAndAppend (buffer, event);
+    }
+    catch (...)
+    {
+        ptd->layout_sp.in_stream_overload = outer;
+        throw;
+    }
+    ptd->layout_sp.in_stream_overload = outer;
+    output.write (buffer.data (),
+        static_cast<std::streamsize>(buffer.size ()));
+}
+
+
+bool
+Layout::formatAndAppendThroughStream (log4cplus::tstring & buffer,
+    const log4cplus::spi::InternalLoggingEvent& event)
+{
+    internal::layout_scratch_pad & sp = internal::get_ptd ()->layout_sp;
+    if (sp.in_stream_overload == this)
+        return false;
+
+    // The ostream overload might be overridden by a derived class, which
+    // might leave formatting flags behind.
+    tostream & os = sp.os;
+    os.clear ();
+    os.flags (std::ios_base::dec | std::ios_base::skipws);
+    os.width (0);
+    os.precision (6);
+    os.fill (os.widen (' '));
+
+    tstring * const outer = sp.buf.target;
+    sp.buf.target = &buffer;
+    try
+    {
+        formatAndAppend (os, event);
+    }
+    catch (...)
+    {
+        sp.buf.target = outer;
+        throw;
+    }
+    sp.buf.target = outer;
+    return true;
+}
+
+
+log4cplus::tstring *
+Layout::appendingStreamTarget (log4cplus::tostream & output)
+{
+    internal::layout_scratch_pad & sp = internal::get_ptd ()->layout_sp;
+    return &output == &sp.os ? sp.buf.target : nullptr;
+}
+
+
+bool
+Layout::isDerivedLayout (std::type_info const & type) const
+{
+    signed char derived = derivedLayout.load (std::memory_order_relaxed);
+    if (derived < 0) [[unlikely]]
+    {
+        derived = typeid (*this) != type;
+        derivedLayout.store (derived, std::memory_order_relaxed);
+    }
+    return derived != 0;
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // log4cplus::SimpleLayout public methods
 ///////////////////////////////////////////////////////////////////////////////
@@ -79,10 +184,31 @@ void
 SimpleLayout::formatAndAppend(log4cplus::tostream& output,
                               const log4cplus::spi::InternalLoggingEvent& event)
 {
-    output << llmCache.toString(event.getLogLevel())
-           << LOG4CPLUS_TEXT(" - ")
-           << event.getMessage()
-           << LOG4CPLUS_TEXT("\n");
+    if (tstring * const target = appendingStreamTarget (output))
+        formatInto (*target, event);
+    else
+        formatAndAppendToStream (output, event);
+}
+
+
+void
+SimpleLayout::formatAndAppend(log4cplus::tstring& buffer,
+                              const log4cplus::spi::InternalLoggingEvent& event)
+{
+    if (! isDerivedLayout (typeid (SimpleLayout))
+        || ! formatAndAppendThroughStream (buffer, event))
+        formatInto (buffer, event);
+}
+
+
+void
+SimpleLayout::formatInto(log4cplus::tstring& buffer,
+                         const log4cplus::spi::InternalLoggingEvent& event)
+{
+    buffer += llmCache.toString(event.getLogLevel());
+    buffer += LOG4CPLUS_TEXT(" - ");
+    buffer += event.getMessage();
+    buffer += LOG4CPLUS_TEXT('\n');
 }
 
 
@@ -124,35 +250,70 @@ TTCCLayout::~TTCCLayout() = default;
 void
 TTCCLayout::formatAndAppend(log4cplus::tostream& output,
                             const log4cplus::spi::InternalLoggingEvent& event)
+{
+    if (tstring * const target = appendingStreamTarget (output))
+        formatInto (*target, event);
+    else
+        formatAndAppendToStream (output, event);
+}
+
+
+void
+TTCCLayout::formatAndAppend(log4cplus::tstring& buffer,
+                            const log4cplus::spi::InternalLoggingEvent& event)
+{
+    if (! isDerivedLayout (typeid (TTCCLayout))
+        || ! formatAndAppendThroughStream (buffer, event))
+        formatInto (buffer, event);
+}
+
+
+void
+TTCCLayout::formatInto(log4cplus::tstring& buffer,
+                       const log4cplus::spi::InternalLoggingEvent& event)
 {
      if (dateFormat.empty ())
-         formatRelativeTimestamp (output, event);
+         formatRelativeTimestamp (buffer, event);
      else
-         output << helpers::getFormattedTime(dateFormat, event.getTimestamp(),
-             use_gmtime);
+     {
+         if (dateFormat != cachedDateFormat || use_gmtime != cachedUseGmtime)
+         {
+             dateFormatCache.setFormat (dateFormat, use_gmtime);
+             cachedDateFormat = dateFormat;
+             cachedUseGmtime = use_gmtime;
+         }
+
+         dateFormatCache.append (buffer, event.getTimestamp ());
+     }
 
      if (getThreadPrinting ())
-         output << LOG4CPLUS_TEXT(" [")
-                << event.getThread()
-                << LOG4CPLUS_TEXT("] ");
+     {
+         buffer += LOG4CPLUS_TEXT(" [");
+         buffer += event.getThread();
+         buffer += LOG4CPLUS_TEXT("] ");
+     }
      else
-         output << LOG4CPLUS_TEXT(' ');
+         buffer += LOG4CPLUS_TEXT(' ');
 
-     output << llmCache.toString(event.getLogLevel())
-            << LOG4CPLUS_TEXT(' ');
+     buffer += llmCache.toString(event.getLogLevel());
+     buffer += LOG4CPLUS_TEXT(' ');
 
      if (getCategoryPrefixing ())
-         output << event.getLoggerName()
-                << LOG4CPLUS_TEXT(' ');
+     {
+         buffer += event.getLoggerName();
+         buffer += LOG4CPLUS_TEXT(' ');
+     }
 
      if (getContextPrinting ())
-         output << LOG4CPLUS_TEXT("<")
-                << event.getNDC()
-                << LOG4CPLUS_TEXT("> ");
-
-     output << LOG4CPLUS_TEXT("- ")
-            << event.getMessage()
-            << LOG4CPLUS_TEXT("\n");
+     {
+         buffer += LOG4CPLUS_TEXT('<');
+         buffer += event.getNDC();
+         buffer += LOG4CPLUS_TEXT("> ");
+     }
+
+     buffer += LOG4CPLUS_TEXT("- ");
+     buffer += event.getMessage();
+     buffer += LOG4CPLUS_TEXT('\n');
 }
 
 
@@ -220,8 +220,7 @@ Log4jUdpAppender::append(const spi::InternalLoggingEvent& event)
            << outputXMLEscaped (getLogLevelManager()
                .toString(event.getLogLevel()))
            << LOG4CPLUS_TEXT("\" timestamp=\"")
-           << helpers::getFormattedTime(LOG4CPLUS_TEXT("%s%q"),
-               event.getTimestamp())
+           << timestampCache.format (event.getTimestamp())
            << LOG4CPLUS_TEXT("\" thread=\"") << event.getThread()
            << LOG4CPLUS_TEXT("\">")
 
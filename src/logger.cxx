@@ -18,6 +18,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <log4cplus/internal/internal.h>
 #include <log4cplus/logger.h>
 #include <log4cplus/appender.h>
 #include <log4cplus/hierarchy.h>
@@ -169,8 +170,10 @@ Logger::swap (Logger & other) LOG4CPLUS_NOEXCEPT
 Logger
 Logger::getParent () const
 {
-    if (value->parent)
-        return Logger (value->parent.get ());
+    internal::rcu::read_guard const guard;
+    if (spi::LoggerImpl * const parent
+        = value->parentLink.load (std::memory_order_acquire))
+        return Logger (parent);
     else
     {
         helpers::getLogLog().error(
@@ -331,4 +334,52 @@ Logger::setAdditivity (bool additive)
 }
 
 
+//////////////////////////////////////////////////////////////////////////////
+// LoggerRef Methods
+//////////////////////////////////////////////////////////////////////////////
+
+bool
+LoggerRef::isEnabledFor (LogLevel ll) const
+{
+    return value->isEnabledFor (ll);
+}
+
+
+void
+LoggerRef::log (LogLevel ll, const log4cplus::tstring_view& message,
+    const char* file, int line, const char* function) const
+{
+    value->log (ll, message, file, line, function ? function : "");
+}
+
+
+void
+LoggerRef::forcedLog (LogLevel ll, const log4cplus::tstring_view& message,
+    const char* file, int line, const char* function) const
+{
+    value->forcedLog (ll, message, file, line, function ? function : "");
+}
+
+
+void
+LoggerRef::forcedLog (spi::InternalLoggingEvent const & ev) const
+{
+    value->forcedLog (ev);
+}
+
+
+log4cplus::tstring const &
+LoggerRef::getName () const
+{
+    return value->getName ();
+}
+
+
+Logger
+LoggerRef::getLogger () const
+{
+    return Logger (value);
+}
+
+
 } // namespace log4cplus
@@ -26,10 +26,51 @@
 #include <log4cplus/spi/loggingevent.h>
 #include <log4cplus/spi/rootlogger.h>
 #include <log4cplus/thread/syncprims-pub-impl.h>
+#include <limits>
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <log4cplus/helpers/stringhelper.h>
+#include <catch_amalgamated.hpp>
+#include <thread>
+#endif
 
 
 namespace log4cplus::spi {
 
+
+// Start at 1 so that zero initialized thresholdCache is never valid.
+std::atomic<std::uint64_t> loggerConfigurationEpoch {1};
+
+
+namespace
+{
+
+//! Number of bits of LoggerImpl::thresholdCache holding the threshold.
+//! The rest holds lower bits of the epoch.
+int const threshold_bits = 24;
+
+LogLevel const min_cached_threshold = -(1 << (threshold_bits - 1));
+LogLevel const max_cached_threshold = (1 << (threshold_bits - 1)) - 1;
+
+} // namespace
+
+
+void
+bumpLoggerConfigurationEpoch ()
+{
+    loggerConfigurationEpoch.fetch_add (1, std::memory_order_acq_rel);
+}
+
+
+std::atomic<std::uint64_t> loggerRegistryGeneration {0};
+
+
+void
+bumpLoggerRegistryGeneration ()
+{
+    loggerRegistryGeneration.fetch_add (1, std::memory_order_acq_rel);
+}
+
 //////////////////////////////////////////////////////////////////////////////
 // Logger Constructors and Destructor
 //////////////////////////////////////////////////////////////////////////////
@@ -37,8 +78,10 @@ LoggerImpl::LoggerImpl(const log4cplus::tstring_view& name_, Hierarchy& h)
   : name(name_),
     ll(NOT_SET_LOG_LEVEL),
     parent(nullptr),
+    parentLink(nullptr),
     additive(true),
-    hierarchy(h)
+    hierarchy(h),
+    thresholdCache(0)
 {
 }
 
@@ -54,7 +97,11 @@ void
 LoggerImpl::callAppenders(const InternalLoggingEvent& event)
 {
     int writes = 0;
-    for(const LoggerImpl* c = this; c != nullptr; c=c->parent.get()) {
+    // One read-side critical section covers both the parent chain and
+    // the appender lists of all the loggers on it.
+    internal::rcu::read_guard const guard;
+    for(const LoggerImpl* c = this; c != nullptr;
+        c = c->parentLink.load (std::memory_order_acquire)) {
         writes += c->appendLoopOnAppenders(event);
         if(!c->additive) {
             break;
@@ -90,10 +137,52 @@ LoggerImpl::closeNestedAppenders()
 bool
 LoggerImpl::isEnabledFor(LogLevel loglevel) const
 {
-    if(hierarchy.disableValue >= loglevel) {
-        return false;
-    }
-    return loglevel >= getChainedLogLevel();
+    return loglevel >= getEffectiveThreshold();
+}
+
+
+LogLevel
+LoggerImpl::getEffectiveThreshold() const
+{
+    std::uint64_t const epoch
+        = loggerConfigurationEpoch.load (std::memory_order_acquire);
+    std::uint64_t const cached
+        = thresholdCache.load (std::memory_order_relaxed);
+    // Compare the epoch part of the cache with the same bits of the
+    // current epoch.
+    if (((cached ^ (epoch << threshold_bits)) >> threshold_bits) == 0)
+        // Sign extend the threshold part.
+        return static_cast<std::int32_t>(
+            static_cast<std::uint32_t>(cached) << (32 - threshold_bits))
+            >> (32 - threshold_bits);
+    else
+        return updateThresholdCache (epoch);
+}
+
+
+LogLevel
+LoggerImpl::updateThresholdCache(std::uint64_t epoch) const
+{
+    // The epoch has been read before any of the values below. If any of
+    // them changes while we are computing the threshold, the epoch will
+    // not match on next check and the value will be recomputed.
+    LogLevel threshold = getChainedLogLevel();
+    int const disabled = hierarchy.disableValue.load (
+        std::memory_order_relaxed);
+    if (disabled >= threshold)
+        threshold = disabled < (std::numeric_limits<LogLevel>::max) ()
+            ? disabled + 1
+            : disabled;
+
+    // Thresholds that do not fit the cache, e.g., after disableAll(),
+    // are recomputed each time.
+    if (threshold >= min_cached_threshold
+        && threshold <= max_cached_threshold)
+        thresholdCache.store ((epoch << threshold_bits)
+            | (static_cast<std::uint32_t>(threshold)
+                & ((std::uint32_t (1) << threshold_bits) - 1)),
+            std::memory_order_relaxed);
+    return threshold;
 }
 
 
@@ -121,9 +210,12 @@ LoggerImpl::log(spi::InternalLoggingEvent const & ev)
 LogLevel
 LoggerImpl::getChainedLogLevel() const
 {
-    for(const LoggerImpl *c=this; c != nullptr; c=c->parent.get()) {
-        if(c->ll != NOT_SET_LOG_LEVEL) {
-            return c->ll;
+    internal::rcu::read_guard const guard;
+    for(const LoggerImpl *c=this; c != nullptr;
+        c = c->parentLink.load (std::memory_order_acquire)) {
+        LogLevel const level = c->ll.load (std::memory_order_relaxed);
+        if(level != NOT_SET_LOG_LEVEL) {
+            return level;
         }
     }
 
@@ -134,6 +226,28 @@ LoggerImpl::getChainedLogLevel() const
 }
 
 
+void
+LoggerImpl::setLogLevel(LogLevel _ll)
+{
+    ll.store (_ll, std::memory_order_relaxed);
+    bumpLoggerConfigurationEpoch ();
+}
+
+
+void
+LoggerImpl::setParent(LoggerImpl * newParent)
+{
+    SharedLoggerImplPtr oldParent (newParent);
+    parentLink.store (newParent, std::memory_order_release);
+    parent.swap (oldParent);
+
+    // Lock-free walks of the parent chain may still be on the old
+    // parent. Release the reference only after they end.
+    if (oldParent)
+        internal::rcu::retire (new SharedLoggerImplPtr (std::move (oldParent)));
+}
+
+
 Hierarchy&
 LoggerImpl::getHierarchy() const
 {
@@ -178,3 +292,140 @@ LoggerImpl::forcedLog(spi::InternalLoggingEvent const & ev)
 
 
 } // namespace log4cplus::spi
+
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+CATCH_TEST_CASE ("Cached effective log level", "[logger]")
+{
+    using namespace log4cplus;
+
+    Hierarchy h;
+    Logger a = h.getInstance (LOG4CPLUS_TEXT ("a"));
+    Logger abc = h.getInstance (LOG4CPLUS_TEXT ("a.b.c"));
+
+    CATCH_REQUIRE (abc.isEnabledFor (DEBUG_LOG_LEVEL));
+    CATCH_REQUIRE (! abc.isEnabledFor (TRACE_LOG_LEVEL));
+
+    CATCH_SECTION ("ancestor log level change is observed")
+    {
+        a.setLogLevel (WARN_LOG_LEVEL);
+        CATCH_REQUIRE (! abc.isEnabledFor (INFO_LOG_LEVEL));
+        CATCH_REQUIRE (abc.isEnabledFor (WARN_LOG_LEVEL));
+
+        abc.setLogLevel (TRACE_LOG_LEVEL);
+        CATCH_REQUIRE (abc.isEnabledFor (TRACE_LOG_LEVEL));
+        CATCH_REQUIRE (! a.isEnabledFor (INFO_LOG_LEVEL));
+    }
+
+    CATCH_SECTION ("new intermediate logger is observed")
+    {
+        CATCH_REQUIRE (abc.isEnabledFor (INFO_LOG_LEVEL));
+        Logger ab = h.getInstance (LOG4CPLUS_TEXT ("a.b"));
+        ab.setLogLevel (ERROR_LOG_LEVEL);
+        CATCH_REQUIRE (! abc.isEnabledFor (WARN_LOG_LEVEL));
+        CATCH_REQUIRE (abc.isEnabledFor (ERROR_LOG_LEVEL));
+    }
+
+    CATCH_SECTION ("hierarchy disable value is observed")
+    {
+        h.disableInfo ();
+        CATCH_REQUIRE (! abc.isEnabledFor (INFO_LOG_LEVEL));
+        CATCH_REQUIRE (abc.isEnabledFor (WARN_LOG_LEVEL));
+
+        h.disableAll ();
+        CATCH_REQUIRE (! abc.isEnabledFor (FATAL_LOG_LEVEL));
+
+        h.enableAll ();
+        CATCH_REQUIRE (abc.isEnabledFor (DEBUG_LOG_LEVEL));
+    }
+
+    CATCH_SECTION ("reset configuration is observed")
+    {
+        a.setLogLevel (OFF_LOG_LEVEL);
+        h.getRoot ().setLogLevel (FATAL_LOG_LEVEL);
+        CATCH_REQUIRE (! abc.isEnabledFor (FATAL_LOG_LEVEL));
+
+        h.resetConfiguration ();
+        CATCH_REQUIRE (abc.isEnabledFor (DEBUG_LOG_LEVEL));
+    }
+
+    CATCH_SECTION ("cache does not survive epoch wrap around")
+    {
+        std::uint64_t const epoch = spi::loggerConfigurationEpoch.load ();
+        a.setLogLevel (ERROR_LOG_LEVEL);
+        // Lower 32 bits of the epoch match those in the cache again.
+        spi::loggerConfigurationEpoch.store (
+            epoch + (std::uint64_t (1) << 32));
+        CATCH_REQUIRE (! abc.isEnabledFor (WARN_LOG_LEVEL));
+        CATCH_REQUIRE (abc.isEnabledFor (ERROR_LOG_LEVEL));
+    }
+
+    CATCH_SECTION ("thresholds outside of cached range")
+    {
+        LogLevel const high = 1 << 24;
+        a.setLogLevel (high);
+        for (int i = 0; i != 2; ++i)
+        {
+            CATCH_REQUIRE (! abc.isEnabledFor (high - 1));
+            CATCH_REQUIRE (abc.isEnabledFor (high));
+        }
+
+        h.disableAll ();
+        CATCH_REQUIRE (! abc.isEnabledFor (FATAL_LOG_LEVEL));
+        CATCH_REQUIRE (! abc.isEnabledFor (high));
+        h.enableAll ();
+        CATCH_REQUIRE (abc.isEnabledFor (high));
+    }
+}
+
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+CATCH_TEST_CASE ("Parent links change while logging", "[logger]")
+{
+    using namespace log4cplus;
+
+    Hierarchy h;
+    std::size_t const count = 200;
+    std::vector<Logger> leaves;
+    for (std::size_t i = 0; i != count; ++i)
+        leaves.push_back (h.getInstance (LOG4CPLUS_TEXT ("n")
+            + helpers::convertIntegerToString (i)
+            + LOG4CPLUS_TEXT (".a.b.c")));
+
+    std::atomic<bool> done {false};
+    std::atomic<std::size_t> wrong {0};
+
+    // Intermediate loggers are inserted between the leaves and the root
+    // while the other thread walks their parent chains.
+    std::thread walker ([&] {
+        while (! done.load ())
+            for (Logger const & leaf : leaves)
+            {
+                if (! leaf.isEnabledFor (WARN_LOG_LEVEL))
+                    ++wrong;
+                leaf.log (TRACE_LOG_LEVEL, LOG4CPLUS_TEXT ("ignored"));
+            }
+    });
+
+    for (std::size_t i = 0; i != count; ++i)
+    {
+        tstring const name (LOG4CPLUS_TEXT ("n")
+            + helpers::convertIntegerToString (i));
+        h.getInstance (name + LOG4CPLUS_TEXT (".a"));
+        h.getInstance (name).setLogLevel (WARN_LOG_LEVEL);
+        h.getInstance (name + LOG4CPLUS_TEXT (".a.b"));
+    }
+
+    done = true;
+    walker.join ();
+
+    CATCH_REQUIRE (wrong == 0);
+    for (Logger const & leaf : leaves)
+    {
+        CATCH_REQUIRE (leaf.getParent ().getName ()
+            == leaf.getName ().substr (0, leaf.getName ().size () - 2));
+        CATCH_REQUIRE (! leaf.isEnabledFor (INFO_LOG_LEVEL));
+    }
+}
+#endif
+#endif // defined (LOG4CPLUS_WITH_UNIT_TESTS)
@@ -40,7 +40,7 @@ InternalLoggingEvent::InternalLoggingEvent(
     : message(message_)
     , loggerName(logger)
     , ll(loglevel)
-    , timestamp(log4cplus::helpers::now ())
+    , timestamp(log4cplus::helpers::eventNow ())
     , file(filename
         ? LOG4CPLUS_C_STR_TO_TSTRING(filename)
         : log4cplus::tstring())
@@ -153,7 +153,7 @@ InternalLoggingEvent::setLoggingEvent (const log4cplus::tstring_view & logger,
     loggerName = logger;
     ll = loglevel;
     message = msg;
-    timestamp = helpers::now ();
+    timestamp = helpers::eventNow ();
 
     if (filename)
         file = LOG4CPLUS_C_STR_TO_TSTRING (filename);
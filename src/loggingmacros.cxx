@@ -23,9 +23,12 @@
 
 #include <log4cplus/internal/internal.h>
 #include <log4cplus/loggingmacros.h>
+#include <log4cplus/hierarchy.h>
 
 #if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <log4cplus/nullappender.h>
 #include <catch_amalgamated.hpp>
+#include <thread>
 #endif
 
 
@@ -62,6 +65,80 @@ clear_tostringstream (tostringstream & os)
 }
 
 
+bool
+MacroCallSite::revalidate (LoggerRef const & logger, LogLevel ll)
+{
+    // Read the epoch before evaluating the logger so that any
+    // configuration change that happens concurrently invalidates the
+    // value we are about to store.
+    std::uint64_t const epoch = spi::loggerConfigurationEpoch.load (
+        std::memory_order_acquire);
+    bool const enabled = logger.isEnabledFor (ll);
+
+    void const * expected = nullptr;
+    if (! owner.compare_exchange_strong (expected, logger.value,
+            std::memory_order_relaxed)
+        && expected != logger.value)
+    {
+        // This call site is used with more than one logger.
+        if (expected != this)
+            owner.store (this, std::memory_order_relaxed);
+        return enabled;
+    }
+
+    state.store ((static_cast<std::uint64_t>(epoch) << 1)
+        | static_cast<std::uint64_t>(enabled), std::memory_order_relaxed);
+    return enabled;
+}
+
+
+struct MacroCallSite::NamedLogger
+{
+    //! Value of spi::loggerRegistryGeneration the logger has been looked
+    //! up in.
+    std::uint64_t const generation;
+
+    //! Name the logger has been looked up by.
+    tchar const * const name;
+
+    //! Owning reference, it keeps the logger alive at least as long as
+    //! this record.
+    Logger const logger;
+};
+
+
+MacroCallSite::NamedLoggerRef
+MacroCallSite::getLogger (tchar const * name)
+{
+    internal::rcu::reader_state & section = internal::rcu::read_lock ();
+    std::uint64_t const generation = spi::loggerRegistryGeneration.load (
+        std::memory_order_acquire);
+    NamedLogger const * record = named.load (std::memory_order_acquire);
+    if (! record || record->generation != generation || record->name != name)
+        [[unlikely]]
+    {
+        // The generation is read before the lookup so that concurrent
+        // Hierarchy::clear() invalidates the new record.
+        record = new NamedLogger {generation, name,
+            Logger::getInstance (name)};
+        if (NamedLogger const * const old
+            = named.exchange (record, std::memory_order_acq_rel))
+            internal::rcu::retire (const_cast<NamedLogger *>(old));
+    }
+
+    // The record cannot be released before the read-side critical
+    // section ends, even if another thread has replaced it already.
+    return NamedLoggerRef (LoggerRef (record->logger), &section);
+}
+
+
+MacroCallSite::NamedLoggerRef::~NamedLoggerRef ()
+{
+    internal::rcu::read_unlock (
+        *static_cast<internal::rcu::reader_state *>(section));
+}
+
+
 log4cplus::tostringstream &
 get_macro_body_oss ()
 {
@@ -79,7 +156,7 @@ get_macro_body_snprintf_buf ()
 
 
 void
-macro_forced_log (log4cplus::Logger const & logger,
+macro_forced_log (log4cplus::LoggerRef const & logger,
     log4cplus::LogLevel log_level, log4cplus::tchar const * msg,
     char const * filename, int line, char const * func)
 {
@@ -89,7 +166,7 @@ macro_forced_log (log4cplus::Logger const & logger,
 
 
 void
-macro_forced_log (log4cplus::Logger const & logger,
+macro_forced_log (log4cplus::LoggerRef const & logger,
     log4cplus::LogLevel log_level, log4cplus::tstring_view const & msg,
     char const * filename, int line, char const * func)
 {
@@ -112,6 +189,105 @@ CATCH_TEST_CASE ("Macros", "[macros]")
         CATCH_REQUIRE_THAT (loc.file_name (), Catch::Matchers::Equals (file));
         CATCH_REQUIRE (loc.line () == line);
     }
+
+    CATCH_SECTION ("MacroCallSite")
+    {
+        Hierarchy h;
+        Logger a = h.getInstance (LOG4CPLUS_TEXT ("a"));
+        Logger b = h.getInstance (LOG4CPLUS_TEXT ("b"));
+        a.setLogLevel (INFO_LOG_LEVEL);
+
+        MacroCallSite site;
+        CATCH_REQUIRE (! site.isEnabledFor (a, DEBUG_LOG_LEVEL));
+        CATCH_REQUIRE (! site.isEnabledFor (a, DEBUG_LOG_LEVEL));
+
+        // Configuration change is observed.
+        a.setLogLevel (DEBUG_LOG_LEVEL);
+        CATCH_REQUIRE (site.isEnabledFor (a, DEBUG_LOG_LEVEL));
+        h.disableDebug ();
+        CATCH_REQUIRE (! site.isEnabledFor (a, DEBUG_LOG_LEVEL));
+        h.enableAll ();
+        CATCH_REQUIRE (site.isEnabledFor (a, DEBUG_LOG_LEVEL));
+
+        // Different logger at the same call site is not confused with
+        // the first one.
+        b.setLogLevel (WARN_LOG_LEVEL);
+        CATCH_REQUIRE (! site.isEnabledFor (b, DEBUG_LOG_LEVEL));
+        CATCH_REQUIRE (site.isEnabledFor (a, DEBUG_LOG_LEVEL));
+        CATCH_REQUIRE (! site.isEnabledFor (b, DEBUG_LOG_LEVEL));
+    }
+
+    CATCH_SECTION ("LoggerRef")
+    {
+        Hierarchy h;
+        Logger a = h.getInstance (LOG4CPLUS_TEXT ("a"));
+        a.addAppender (SharedAppenderPtr (new NullAppender));
+        LoggerRef ref (a);
+        CATCH_REQUIRE (ref.getName () == a.getName ());
+        CATCH_REQUIRE (ref.getLogger ().getName () == a.getName ());
+
+        a.setLogLevel (WARN_LOG_LEVEL);
+        CATCH_REQUIRE (! ref.isEnabledFor (INFO_LOG_LEVEL));
+        CATCH_REQUIRE (ref.isEnabledFor (WARN_LOG_LEVEL));
+
+        // Macros accept LoggerRef as well as Logger.
+        LOG4CPLUS_INFO (ref, LOG4CPLUS_TEXT ("LoggerRef"));
+        LOG4CPLUS_WARN_STR (ref, LOG4CPLUS_TEXT ("LoggerRef"));
+        LOG4CPLUS_INFO_FMT (ref, LOG4CPLUS_TEXT ("%s"), LOG4CPLUS_TEXT ("LoggerRef"));
+    }
+
+    CATCH_SECTION ("named logger cache")
+    {
+        tchar const name[] = LOG4CPLUS_TEXT ("macros.named");
+        MacroCallSite site;
+        LoggerRef ref = site.getLogger (name);
+        CATCH_REQUIRE (ref.getName () == name);
+        CATCH_REQUIRE (site.getLogger (name).getLogger ().getName () == name);
+
+        // Other name at the same call site is not confused with the
+        // cached one.
+        tchar const other[] = LOG4CPLUS_TEXT ("macros.other");
+        CATCH_REQUIRE (site.getLogger (other).getName () == other);
+        CATCH_REQUIRE (site.getLogger (name).getName () == name);
+
+        // Removal of loggers by Hierarchy::clear() drops the cached
+        // logger.
+        Logger::getInstance (name).setLogLevel (FATAL_LOG_LEVEL);
+        CATCH_REQUIRE (site.getLogger (name).getLogger ().getLogLevel ()
+            == FATAL_LOG_LEVEL);
+        Logger::getDefaultHierarchy ().clear ();
+        CATCH_REQUIRE (site.getLogger (name).getLogger ().getLogLevel ()
+            == NOT_SET_LOG_LEVEL);
+
+        // Overload selection.
+        tchar buffer[] = LOG4CPLUS_TEXT ("macros.buffer");
+        tchar const * ptr = name;
+        CATCH_REQUIRE (macros_get_logger (site, name).getName () == name);
+        CATCH_REQUIRE (macros_get_logger (site, ptr).getName () == name);
+        CATCH_REQUIRE (macros_get_logger (site, buffer).getName () == buffer);
+        CATCH_REQUIRE (macros_get_logger (site, tstring (name)).getName ()
+            == name);
+    }
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    CATCH_SECTION ("named logger cache with concurrent names")
+    {
+        // Threads using different names at one call site keep replacing
+        // the cache. Each of them must always get its own logger.
+        MacroCallSite site;
+        std::atomic<std::size_t> wrong {0};
+        auto const worker = [&site, &wrong] (tchar const * name) {
+            for (int i = 0; i != 20000; ++i)
+                if (site.getLogger (name).getName () != name)
+                    ++wrong;
+        };
+        std::thread first (worker, LOG4CPLUS_TEXT ("macros.first"));
+        std::thread second (worker, LOG4CPLUS_TEXT ("macros.second"));
+        first.join ();
+        second.join ();
+        CATCH_REQUIRE (wrong == 0);
+    }
+#endif
 } // CATCH_TEST_CASE
 
 #endif // defined (LOG4CPLUS_WITH_UNIT_TESTS)
@@ -19,6 +19,7 @@
 // limitations under the License.
 
 #include <log4cplus/layout.h>
+#include <log4cplus/staticpatternlayout.h>
 #include <log4cplus/helpers/loglog.h>
 #include <log4cplus/helpers/timehelper.h>
 #include <log4cplus/helpers/stringhelper.h>
@@ -30,44 +31,152 @@
 #include <limits>
 #include <cstdlib>
 #include <memory>
+#include <vector>
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <catch_amalgamated.hpp>
+#if defined (LOG4CPLUS_HAVE_GETPID) && ! defined (_WIN32)
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+#endif
 
 
-namespace
+namespace log4cplus
 {
 
+static tchar const ESCAPE_CHAR = LOG4CPLUS_TEXT('%');
 
-static
-log4cplus::tstring
-get_basename (const log4cplus::tstring& filename)
+extern void formatRelativeTimestamp (log4cplus::tstring & buffer,
+    log4cplus::spi::InternalLoggingEvent const & event);
+
+
+namespace pattern
+{
+
+
+void
+appendBasename (tstring & buffer, tstring const & filename)
 {
 #if defined(_WIN32)
-    log4cplus::tchar const dir_sep(LOG4CPLUS_TEXT('\\'));
+    tchar const dir_sep(LOG4CPLUS_TEXT('\\'));
 #else
-    log4cplus::tchar const dir_sep(LOG4CPLUS_TEXT('/'));
+    tchar const dir_sep(LOG4CPLUS_TEXT('/'));
 #endif
 
-    log4cplus::tstring::size_type pos = filename.rfind(dir_sep);
-    if (pos != log4cplus::tstring::npos)
-        return filename.substr(pos+1);
+    tstring::size_type pos = filename.rfind(dir_sep);
+    if (pos != tstring::npos)
+        buffer.append(filename, pos + 1, tstring::npos);
     else
-        return filename;
+        buffer += filename;
 }
 
 
-} // namespace
+void
+appendProcessId (tstring & buffer)
+{
+    helpers::appendIntegerToString(buffer,
+        internal::get_cached_process_id ());
+}
 
 
-namespace log4cplus
+void
+appendFullLocation (tstring & buffer, spi::InternalLoggingEvent const & event)
 {
+    tstring const & file = event.getFile();
+    if (! file.empty ())
+    {
+        buffer += file;
+        buffer += LOG4CPLUS_TEXT(':');
+        helpers::appendIntegerToString(buffer, event.getLine());
+    }
+    else
+        buffer += LOG4CPLUS_TEXT(':');
+}
 
-static tchar const ESCAPE_CHAR = LOG4CPLUS_TEXT('%');
 
-extern void formatRelativeTimestamp (log4cplus::tostream & output,
-    log4cplus::spi::InternalLoggingEvent const & event);
+void
+appendLoggerName (tstring & buffer, tstring const & name, int precision)
+{
+    if (precision <= 0) {
+        buffer += name;
+    }
+    else {
+        auto len = name.length();
+
+        // We subtract 1 from 'len' when assigning to 'end' to avoid out of
+        // bounds exception in return r.substring(end+1, len). This can happen
+        // if precision is 1 and the logger name ends with a dot.
+        auto end = len - 1;
+        for (int i = precision; i > 0; --i)
+        {
+            end = name.rfind(LOG4CPLUS_TEXT('.'), end - 1);
+            if(end == tstring::npos) {
+                buffer += name;
+                return;
+            }
+        }
+        buffer.append (name, end + 1, tstring::npos);
+    }
+}
 
 
-namespace pattern
+void
+appendEnvVar (tstring & buffer, tstring const & name)
+{
+    tstring value;
+    if (internal::get_env_var (value, name))
+        buffer += value;
+    // Variable doesn't exist, append nothing.
+}
+
+
+void
+appendRelativeTimestamp (tstring & buffer,
+    spi::InternalLoggingEvent const & event)
+{
+    log4cplus::formatRelativeTimestamp (buffer, event);
+}
+
+
+void
+appendMDC (tstring & buffer, spi::InternalLoggingEvent const & event,
+    tstring const & key)
+{
+    if (!key.empty())
+    {
+        buffer += event.getMDC (key);
+    }
+    else
+    {
+        MappedDiagnosticContextMap const & mdcMap = event.getMDCCopy();
+        for (auto const & [name, value] : mdcMap)
+        {
+            buffer += LOG4CPLUS_TEXT("{");
+            buffer += name;
+            buffer += LOG4CPLUS_TEXT(", ");
+            buffer += value;
+            buffer += LOG4CPLUS_TEXT("}");
+
+        }
+    }
+}
+
+
+void
+appendNDC (tstring & buffer, tstring const & text, int precision)
 {
+    if (precision <= 0)
+        buffer += text;
+    else
+    {
+        tstring::size_type p = text.find(LOG4CPLUS_TEXT(' '));
+        for (int i = 1; i < precision && p != tstring::npos; ++i)
+            p = text.find(LOG4CPLUS_TEXT(' '), p + 1);
+
+        buffer.append (text, 0, p);
+    }
+}
 
 
 /**
@@ -98,10 +207,14 @@ class PatternConverter
 public:
     explicit PatternConverter(const FormattingInfo& info);
     virtual ~PatternConverter() = default;
-    void formatAndAppend(tostream& output,
+
+    //! Appends converted field to buffer and pads or truncates it in
+    //! place according to FormattingInfo.
+    void formatAndAppend(tstring & buffer,
         const spi::InternalLoggingEvent& event);
 
-    virtual void convert(tstring & result,
+    //! Appends the unformatted field to buffer.
+    virtual void append(tstring & buffer,
         const spi::InternalLoggingEvent& event) = 0;
 
 private:
@@ -123,10 +236,10 @@ class LiteralPatternConverter : public PatternConverter
 public:
     LiteralPatternConverter();
     explicit LiteralPatternConverter(const tstring& str);
-    void convert(tstring & result,
+    void append(tstring & buffer,
         const spi::InternalLoggingEvent&) override
     {
-        result = str;
+        buffer += str;
     }
 
 private:
@@ -155,7 +268,7 @@ public:
                 FULL_LOCATION_CONVERTER,
                 FUNCTION_CONVERTER };
     BasicPatternConverter(const FormattingInfo& info, Type type);
-    void convert(tstring & result,
+    void append(tstring & buffer,
         const spi::InternalLoggingEvent& event) override;
 
 private:
@@ -176,7 +289,7 @@ private:
 class LoggerPatternConverter : public PatternConverter {
 public:
     LoggerPatternConverter(const FormattingInfo& info, int precision);
-    void convert(tstring & result,
+    void append(tstring & buffer,
         const spi::InternalLoggingEvent& event) override;
 
 private:
@@ -195,12 +308,11 @@ public:
     DatePatternConverter(const FormattingInfo& info,
                          const tstring& pattern,
                          bool use_gmtime);
-    void convert(tstring & result,
+    void append(tstring & buffer,
         const spi::InternalLoggingEvent& event) override;
 
 private:
-    bool use_gmtime;
-    tstring format;
+    helpers::FormattedTimeCache cache;
 };
 
 
@@ -211,7 +323,7 @@ class EnvPatternConverter : public PatternConverter {
 public:
     EnvPatternConverter(const FormattingInfo& info,
                         const log4cplus::tstring& env);
-    void convert(tstring & result,
+    void append(tstring & buffer,
         const spi::InternalLoggingEvent& event) override;
 
 private:
@@ -223,22 +335,8 @@ private:
 class RelativeTimestampConverter: public PatternConverter {
 public:
     explicit RelativeTimestampConverter(const FormattingInfo& info);
-    void convert(tstring & result,
-        const spi::InternalLoggingEvent& event) override;
-};
-
-
-/**
- * This PatternConverter is used to format the hostname field.
- */
-class HostnamePatternConverter : public PatternConverter {
-public:
-    HostnamePatternConverter(const FormattingInfo& info, bool fqdn);
-    void convert(tstring & result,
+    void append(tstring & buffer,
         const spi::InternalLoggingEvent& event) override;
-
-private:
-    tstring hostname_;
 };
 
 
@@ -252,7 +350,7 @@ class MDCPatternConverter
 {
 public:
     MDCPatternConverter(const FormattingInfo& info, tstring const & k);
-    void convert(tstring & result,
+    void append(tstring & buffer,
         const spi::InternalLoggingEvent& event) override;
 
 private:
@@ -268,7 +366,7 @@ private:
 class NDCPatternConverter : public PatternConverter {
 public:
     NDCPatternConverter(const FormattingInfo& info, int precision);
-    void convert(tstring & result,
+    void append(tstring & buffer,
         const spi::InternalLoggingEvent& event) override;
 
 private:
@@ -280,13 +378,19 @@ private:
 /**
  * This class parses a "pattern" string into an array of
  * PatternConverter objects.
+ *
+ * Conversions whose output cannot change during the process lifetime
+ * (<b>%%h</b>, <b>%%H</b>, <b>%%i</b> and, when snapshotting is
+ * enabled, <b>%%E</b>) are formatted once here and merged together
+ * with adjacent literal text into a single LiteralPatternConverter.
  * <p>
  * @see PatternLayout for the formatting of the "pattern" string.
  */
 class PatternParser
 {
 public:
-    PatternParser(const tstring& pattern, unsigned ndcMaxDepth);
+    PatternParser(const tstring& pattern, unsigned ndcMaxDepth,
+        bool snapshotEnv = true);
     PatternConverterList parse();
 
 private:
@@ -301,6 +405,8 @@ private:
     tstring extractOption();
     int extractPrecisionOption();
     void finalizeConverter(tchar c);
+    void appendConstant(tstring value);
+    void flushLiteral();
 
   // Data
     tstring pattern;
@@ -309,7 +415,10 @@ private:
     ParserState state;
     tstring::size_type pos;
     tstring currentLiteral;
+    //! Literal text and constant conversions not yet emitted.
+    tstring literal;
     unsigned ndcMaxDepth;
+    bool snapshotEnv;
 };
 
 
@@ -355,32 +464,11 @@ PatternConverter::PatternConverter(const FormattingInfo& i)
 
 void
 PatternConverter::formatAndAppend(
-    tostream& output, const spi::InternalLoggingEvent& event)
+    tstring & buffer, const spi::InternalLoggingEvent& event)
 {
-    tstring & s = internal::get_ptd ()->faa_str;
-    convert (s, event);
-    std::size_t len = s.length();
-
-    if (len > maxLen)
-    {
-        if (trimStart)
-            output << s.substr(len - maxLen);
-        else
-            output << s.substr(0, maxLen);
-    }
-    else if (static_cast<int>(len) < minLen)
-    {
-        std::ios_base::fmtflags const original_flags = output.flags ();
-        tchar const fill = output.fill (LOG4CPLUS_TEXT(' '));
-        output.setf (leftAlign ? std::ios_base::left : std::ios_base::right,
-            std::ios_base::adjustfield);
-        output.width (minLen);
-        output << s;
-        output.fill (fill);
-        output.flags (original_flags);
-    }
-    else
-        output << s;
+    std::size_t const start = buffer.size ();
+    append (buffer, event);
+    padField (buffer, start, minLen, maxLen, leftAlign, trimStart);
 }
 
 
@@ -418,76 +506,64 @@ BasicPatternConverter::BasicPatternConverter(
 
 
 void
-BasicPatternConverter::convert(tstring & result,
+BasicPatternConverter::append(tstring & buffer,
     const spi::InternalLoggingEvent& event)
 {
     switch(type)
     {
     case LOGLEVEL_CONVERTER:
-        result = llmCache.toString(event.getLogLevel());
+        buffer += llmCache.toString(event.getLogLevel());
         return;
 
     case BASENAME_CONVERTER:
-        result = get_basename(event.getFile());
+        appendBasename(buffer, event.getFile());
         return;
 
     case PROCESS_CONVERTER:
-        helpers::convertIntegerToString(result, internal::get_process_id ());
+        appendProcessId(buffer);
         return;
 
     case NDC_CONVERTER:
-        result = event.getNDC();
+        buffer += event.getNDC();
         return;
 
     case MESSAGE_CONVERTER:
-        result = event.getMessage();
+        buffer += event.getMessage();
         return;
 
     case NEWLINE_CONVERTER:
-        result = LOG4CPLUS_TEXT("\n");
+        buffer += LOG4CPLUS_TEXT('\n');
         return;
 
     case FILE_CONVERTER:
-        result = event.getFile();
+        buffer += event.getFile();
         return;
 
     case THREAD_CONVERTER:
-        result = event.getThread();
+        buffer += event.getThread();
         return;
 
     case THREAD2_CONVERTER:
-        result = event.getThread2();
+        buffer += event.getThread2();
         return;
 
     case LINE_CONVERTER:
         {
             if(event.getLine() != -1)
-                helpers::convertIntegerToString(result, event.getLine());
-            else
-                result.clear ();
+                helpers::appendIntegerToString(buffer, event.getLine());
             return;
         }
 
     case FULL_LOCATION_CONVERTER:
-        {
-            tstring const & file = event.getFile();
-            if (! file.empty ())
-            {
-                result = file;
-                result += LOG4CPLUS_TEXT(":");
-                result += helpers::convertIntegerToString(event.getLine());
-            }
-            else
-                result = LOG4CPLUS_TEXT(":");
-            return;
-        }
+        appendFullLocation(buffer, event);
+        return;
 
     case FUNCTION_CONVERTER:
-        result = event.getFunction ();
+        buffer += event.getFunction ();
         return;
     }
 
-    result = LOG4CPLUS_TEXT("INTERNAL LOG4CPLUS ERROR");
+    buffer += LOG4CPLUS_TEXT("INTERNAL LOG4CPLUS ERROR");
 }
 
 
@@ -506,30 +582,10 @@ LoggerPatternConverter::LoggerPatternConverter(
 
 
 void
-LoggerPatternConverter::convert(tstring & result,
+LoggerPatternConverter::append(tstring & buffer,
     const spi::InternalLoggingEvent& event)
 {
-    const tstring& name = event.getLoggerName();
-    if (precision <= 0) {
-        result = name;
-    }
-    else {
-        auto len = name.length();
-
-        // We subtract 1 from 'len' when assigning to 'end' to avoid out of
-        // bounds exception in return r.substring(end+1, len). This can happen
-        // if precision is 1 and the logger name ends with a dot.
-        auto end = len - 1;
-        for (int i = precision; i > 0; --i)
-        {
-            end = name.rfind(LOG4CPLUS_TEXT('.'), end - 1);
-            if(end == tstring::npos) {
-                result = name;
-                return;
-            }
-        }
-        result.assign (name, end + 1, tstring::npos);
-    }
+    appendLoggerName(buffer, event.getLoggerName(), precision);
 }
 
 
@@ -543,19 +599,17 @@ DatePatternConverter::DatePatternConverter(
     const FormattingInfo& info, const tstring& pattern,
     bool use_gmtime_)
     : PatternConverter(info)
-    , use_gmtime(use_gmtime_)
-    , format(pattern)
+    , cache(pattern, use_gmtime_)
 {
 }
 
 
 
 void
-DatePatternConverter::convert(tstring & result,
+DatePatternConverter::append(tstring & buffer,
     const spi::InternalLoggingEvent& event)
 {
-    result = helpers::getFormattedTime(format, event.getTimestamp(),
-        use_gmtime);
+    cache.append(buffer, event.getTimestamp());
 }
 
 
@@ -572,14 +626,10 @@ EnvPatternConverter::EnvPatternConverter(
 
 
 void
-EnvPatternConverter::convert(tstring & result,
+EnvPatternConverter::append(tstring & buffer,
     const spi::InternalLoggingEvent&)
 {
-    if (! internal::get_env_var (result, envKey))
-    {
-        // Variable doesn't exist, return empty string.
-        result.clear ();
-    }
+    appendEnvVar (buffer, envKey);
 }
 
 
@@ -593,36 +643,13 @@ RelativeTimestampConverter::RelativeTimestampConverter (FormattingInfo const & i
 
 
 void
-RelativeTimestampConverter::convert (tstring & result,
+RelativeTimestampConverter::append (tstring & buffer,
     spi::InternalLoggingEvent const & event)
 {
-    tostringstream & oss = internal::get_ptd ()->layout_oss;
-    detail::clear_tostringstream (oss);
-    log4cplus::formatRelativeTimestamp (oss, event);
-    result = oss.str ();
-}
-
-
-////////////////////////////////////////////////
-// HostnamePatternConverter methods:
-////////////////////////////////////////////////
-
-HostnamePatternConverter::HostnamePatternConverter (
-    const FormattingInfo& info, bool fqdn)
-    : PatternConverter(info)
-    , hostname_ (helpers::getHostname (fqdn).value_or (LOG4CPLUS_C_STR_TO_TSTRING ("-")))
-{ }
-
-
-void
-HostnamePatternConverter::convert (
-    tstring & result, const spi::InternalLoggingEvent&)
-{
-    result = hostname_;
+    appendRelativeTimestamp (buffer, event);
 }
 
 
-
 ////////////////////////////////////////////////
 // MDCPatternConverter methods:
 ////////////////////////////////////////////////
@@ -635,28 +662,10 @@ log4cplus::pattern::MDCPatternConverter::MDCPatternConverter (
 
 
 void
-log4cplus::pattern::MDCPatternConverter::convert (tstring & result,
+log4cplus::pattern::MDCPatternConverter::append (tstring & buffer,
     const spi::InternalLoggingEvent& event)
 {
-    if (!key.empty())
-    {
-        result = event.getMDC (key);
-    }
-    else
-    {
-        result.clear ();
-
-        MappedDiagnosticContextMap const & mdcMap = event.getMDCCopy();
-        for (auto const & [name, value] : mdcMap)
-        {
-            result += LOG4CPLUS_TEXT("{");
-            result += name;
-            result += LOG4CPLUS_TEXT(", ");
-            result += value;
-            result += LOG4CPLUS_TEXT("}");
-
-        }
-    }
+    appendMDC (buffer, event, key);
 }
 
 
@@ -672,20 +681,10 @@ log4cplus::pattern::NDCPatternConverter::NDCPatternConverter (
 
 
 void
-log4cplus::pattern::NDCPatternConverter::convert (tstring & result,
+log4cplus::pattern::NDCPatternConverter::append (tstring & buffer,
     const spi::InternalLoggingEvent& event)
 {
-    const log4cplus::tstring& text = event.getNDC();
-    if (precision <= 0)
-        result = text;
-    else
-    {
-        tstring::size_type p = text.find(LOG4CPLUS_TEXT(' '));
-        for (int i = 1; i < precision && p != tstring::npos; ++i)
-            p = text.find(LOG4CPLUS_TEXT(' '), p + 1);
-
-        result.assign (text, 0, p);
-    }
+    appendNDC (buffer, event.getNDC(), precision);
 }
 
 
@@ -695,11 +694,12 @@ log4cplus::pattern::NDCPatternConverter::convert (tstring & result,
 ////////////////////////////////////////////////
 
 PatternParser::PatternParser(
-    const tstring& pattern_, unsigned ndcMaxDepth_)
+    const tstring& pattern_, unsigned ndcMaxDepth_, bool snapshotEnv_)
     : pattern(pattern_)
     , state(LITERAL_STATE)
     , pos(0)
     , ndcMaxDepth (ndcMaxDepth_)
+    , snapshotEnv (snapshotEnv_)
 {
 }
 
@@ -766,12 +766,7 @@ PatternParser::parse()
                     pos++; // move pointer
                     break;
                 default:
-                    if(! currentLiteral.empty ()) {
-                        list.emplace_back (
-                            new LiteralPatternConverter(currentLiteral));
-                        //getLogLog().debug("Parsed LITERAL converter: \""
-                        //                  +currentLiteral+"\".");
-                    }
+                    literal += currentLiteral;
                     currentLiteral.resize(0);
                     currentLiteral += c; // append %
                     state = CONVERTER_STATE;
@@ -848,15 +843,34 @@ PatternParser::parse()
         } // end switch
     } // end while
 
-    if(! currentLiteral.empty ()) {
-        list.emplace_back(new LiteralPatternConverter(currentLiteral));
-      //getLogLog().debug("Parsed LITERAL converter: \""+currentLiteral+"\".");
-    }
+    literal += currentLiteral;
+    currentLiteral.resize(0);
+    flushLiteral();
 
     return std::move (list);
 }
 
 
+void
+PatternParser::appendConstant(tstring value)
+{
+    padField (value, 0, formattingInfo.minLen, formattingInfo.maxLen,
+        formattingInfo.leftAlign, formattingInfo.trimStart);
+    literal += value;
+}
+
+
+void
+PatternParser::flushLiteral()
+{
+    if(! literal.empty ()) {
+        list.emplace_back(new LiteralPatternConverter(literal));
+        //getLogLog().debug("Parsed LITERAL converter: \""+literal+"\".");
+        literal.resize(0);
+    }
+}
+
+
 
 void
 PatternParser::finalizeConverter(tchar c)
@@ -898,7 +912,14 @@ PatternParser::finalizeConverter(tchar c)
             break;
 
         case LOG4CPLUS_TEXT('E'):
-            pc = new EnvPatternConverter(formattingInfo, extractOption());
+            if (snapshotEnv)
+            {
+                tstring value;
+                appendEnvVar(value, extractOption());
+                appendConstant(std::move(value));
+            }
+            else
+                pc = new EnvPatternConverter(formattingInfo, extractOption());
             //getLogLog().debug("Environment converter.");
             //formattingInfo.dump(getLogLog());
             break;
@@ -915,13 +936,16 @@ PatternParser::finalizeConverter(tchar c)
         case LOG4CPLUS_TEXT('H'):
             {
                 bool fqdn = (c == LOG4CPLUS_TEXT('H'));
-                pc = new HostnamePatternConverter(formattingInfo, fqdn);
+                appendConstant(helpers::getHostname (fqdn).value_or (
+                    LOG4CPLUS_C_STR_TO_TSTRING ("-")));
                 // getLogLog().debug( LOG4CPLUS_TEXT("HOSTNAME converter.") );
                 // formattingInfo.dump(getLogLog());
             }
             break;
 
         case LOG4CPLUS_TEXT('i'):
+            // Not folded into a constant, child processes created by
+            // fork(2) have different process ID.
             pc = new BasicPatternConverter
                           (formattingInfo,
                            BasicPatternConverter::PROCESS_CONVERTER);
@@ -1016,10 +1040,14 @@ PatternParser::finalizeConverter(tchar c)
                 << pos
                 << LOG4CPLUS_TEXT(" in conversion patterrn.");
             helpers::getLogLog().error(buf.str());
-            pc = new LiteralPatternConverter(currentLiteral);
+            literal += currentLiteral;
     }
 
-    list.emplace_back(pc);
+    if (pc)
+    {
+        flushLiteral();
+        list.emplace_back(pc);
+    }
     currentLiteral.resize(0);
     state = LITERAL_STATE;
     formattingInfo.reset();
@@ -1036,9 +1064,9 @@ using PatternConverterList = pattern::PatternConverterList;
 // PatternLayout methods:
 ////////////////////////////////////////////////
 
-PatternLayout::PatternLayout(const tstring& pattern_)
+PatternLayout::PatternLayout(const tstring& pattern_, bool snapshotEnv)
 {
-    init(pattern_, 0);
+    init(pattern_, 0, snapshotEnv);
 }
 
 
@@ -1046,6 +1074,8 @@ PatternLayout::PatternLayout(const helpers::Properties& properties)
 {
     unsigned ndcMaxDepth = 0;
     properties.getUInt (ndcMaxDepth, LOG4CPLUS_TEXT ("NDCMaxDepth"));
+    bool snapshotEnv = true;
+    properties.getBool (snapshotEnv, LOG4CPLUS_TEXT ("SnapshotEnvironment"));
 
     bool hasPattern = properties.exists( LOG4CPLUS_TEXT("Pattern") );
     bool hasConversionPattern = properties.exists( LOG4CPLUS_TEXT("ConversionPattern") );
@@ -1058,10 +1088,11 @@ PatternLayout::PatternLayout(const helpers::Properties& properties)
 
     if(hasConversionPattern) {
         init(properties.getProperty( LOG4CPLUS_TEXT("ConversionPattern") ),
-            ndcMaxDepth);
+            ndcMaxDepth, snapshotEnv);
     }
     else if(hasPattern) {
-        init(properties.getProperty( LOG4CPLUS_TEXT("Pattern") ), ndcMaxDepth);
+        init(properties.getProperty( LOG4CPLUS_TEXT("Pattern") ), ndcMaxDepth,
+            snapshotEnv);
     }
     else {
         helpers::getLogLog().error(
@@ -1073,10 +1104,12 @@ PatternLayout::PatternLayout(const helpers::Properties& properties)
 
 
 void
-PatternLayout::init(const tstring& pattern_, unsigned ndcMaxDepth)
+PatternLayout::init(const tstring& pattern_, unsigned ndcMaxDepth,
+    bool snapshotEnv)
 {
     pattern = pattern_;
-    parsedPattern = pattern::PatternParser(pattern, ndcMaxDepth).parse();
+    parsedPattern = pattern::PatternParser(pattern, ndcMaxDepth,
+        snapshotEnv).parse();
 
     // Let's validate that our parser didn't give us any NULLs.  If it did,
     // we will convert them to a valid PatternConverter that does nothing so
@@ -1110,12 +1143,342 @@ PatternLayout::~PatternLayout() = default;
 void
 PatternLayout::formatAndAppend(tostream& output,
                                const spi::InternalLoggingEvent& event)
+{
+    if (tstring * const target = appendingStreamTarget(output))
+        formatInto(*target, event);
+    else
+        formatAndAppendToStream(output, event);
+}
+
+
+void
+PatternLayout::formatAndAppend(tstring& buffer,
+                               const spi::InternalLoggingEvent& event)
+{
+    if (! isDerivedLayout(typeid(PatternLayout))
+        || ! formatAndAppendThroughStream(buffer, event))
+        formatInto(buffer, event);
+}
+
+
+void
+PatternLayout::formatInto(tstring& buffer,
+                          const spi::InternalLoggingEvent& event)
 {
     for (auto const & pc : parsedPattern)
     {
-        pc->formatAndAppend(output, event);
+        pc->formatAndAppend(buffer, event);
+    }
+}
+
+
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+CATCH_TEST_CASE ("PatternLayout", "[layout]")
+{
+    spi::InternalLoggingEvent const event (
+        LOG4CPLUS_TEXT ("a.b.logger"), WARN_LOG_LEVEL,
+        LOG4CPLUS_TEXT ("message text"), "/src/dir/file.cxx", 42, "func");
+
+    auto format = [&event] (tstring const & pattern)
+    {
+        PatternLayout layout (pattern);
+        tstring buffer (LOG4CPLUS_TEXT ("prefix:"));
+        layout.formatAndAppend (buffer, event);
+
+        // The ostream overload must produce the same output.
+        tostringstream oss;
+        oss << LOG4CPLUS_TEXT ("prefix:");
+        layout.formatAndAppend (oss, event);
+        CATCH_REQUIRE (oss.str () == buffer);
+
+        return buffer.substr (7);
+    };
+
+    CATCH_SECTION ("fields")
+    {
+        CATCH_REQUIRE (format (LOG4CPLUS_TEXT ("%p %c{2} %b:%L %M - %m%n"))
+            == LOG4CPLUS_TEXT ("WARN b.logger file.cxx:42 func - message text\n"));
+        CATCH_REQUIRE (format (LOG4CPLUS_TEXT ("%l|%F|%%"))
+            == LOG4CPLUS_TEXT ("/src/dir/file.cxx:42|/src/dir/file.cxx|%"));
+    }
+
+    CATCH_SECTION ("padding and truncation")
+    {
+        CATCH_REQUIRE (format (LOG4CPLUS_TEXT ("[%-7p][%7p]"))
+            == LOG4CPLUS_TEXT ("[WARN   ][   WARN]"));
+        CATCH_REQUIRE (format (LOG4CPLUS_TEXT ("[%.4m][%.-4m]"))
+            == LOG4CPLUS_TEXT ("[text][mess]"));
+        CATCH_REQUIRE (format (LOG4CPLUS_TEXT ("[%3.5c][%-12.5L]"))
+            == LOG4CPLUS_TEXT ("[ogger][42          ]"));
+    }
+
+    CATCH_SECTION ("constant folding")
+    {
+        struct TestPatternLayout : PatternLayout
+        {
+            using PatternLayout::PatternLayout;
+            using PatternLayout::parsedPattern;
+        };
+
+        tstring pid;
+        helpers::appendIntegerToString (pid, internal::get_process_id ());
+        tstring const hostname = helpers::getHostname (false).value_or (
+            LOG4CPLUS_C_STR_TO_TSTRING ("-"));
+
+        TestPatternLayout layout (
+            LOG4CPLUS_TEXT ("a%%b [%h] %-12i|%.2i|%E{LOG4CPLUS_UNSET_VAR} %m"));
+        // Process ID is not folded.
+        CATCH_REQUIRE (layout.parsedPattern.size () == 6);
+
+        tstring buffer;
+        layout.formatAndAppend (buffer, event);
+        tstring expected (LOG4CPLUS_TEXT ("a%b ["));
+        expected += hostname;
+        expected += LOG4CPLUS_TEXT ("] ");
+        expected += pid;
+        expected.append (12 - pid.size (), LOG4CPLUS_TEXT (' '));
+        expected += LOG4CPLUS_TEXT ("|");
+        expected.append (pid, pid.size () > 2 ? pid.size () - 2 : 0);
+        expected += LOG4CPLUS_TEXT ("| message text");
+        CATCH_REQUIRE (buffer == expected);
+    }
+
+    CATCH_SECTION ("derived layouts")
+    {
+        // Overrides only the ostream overload, as layouts written for
+        // earlier versions do.
+        struct StreamPatternLayout : PatternLayout
+        {
+            using PatternLayout::PatternLayout;
+            using PatternLayout::formatAndAppend;
+
+            virtual void formatAndAppend (tostream & output,
+                spi::InternalLoggingEvent const & ev) override
+            {
+                output << std::hex << 255 << LOG4CPLUS_TEXT ("> ");
+                PatternLayout::formatAndAppend (output, ev);
+            }
+        };
+
+        // Overrides only the buffer overload.
+        struct BufferPatternLayout : PatternLayout
+        {
+            using PatternLayout::PatternLayout;
+            using PatternLayout::formatAndAppend;
+
+            virtual void formatAndAppend (tstring & buffer,
+                spi::InternalLoggingEvent const & ev) override
+            {
+                buffer += LOG4CPLUS_TEXT ("> ");
+                PatternLayout::formatAndAppend (buffer, ev);
+            }
+        };
+
+        StreamPatternLayout streamLayout (LOG4CPLUS_TEXT ("%p %i %m"));
+        BufferPatternLayout bufferLayout (LOG4CPLUS_TEXT ("%p %i %m"));
+        tstring expected;
+        helpers::appendIntegerToString (expected,
+            internal::get_process_id ());
+        expected = LOG4CPLUS_TEXT ("WARN ") + expected
+            + LOG4CPLUS_TEXT (" message text");
+
+        for (int i = 0; i != 2; ++i)
+        {
+            tstring buffer (LOG4CPLUS_TEXT ("prefix:"));
+            streamLayout.formatAndAppend (buffer, event);
+            CATCH_REQUIRE (buffer == LOG4CPLUS_TEXT ("prefix:ff> ")
+                + expected);
+
+            tostringstream oss;
+            streamLayout.formatAndAppend (oss, event);
+            CATCH_REQUIRE (oss.str () == LOG4CPLUS_TEXT ("ff> ") + expected);
+
+            buffer = LOG4CPLUS_TEXT ("prefix:");
+            bufferLayout.formatAndAppend (buffer, event);
+            CATCH_REQUIRE (buffer == LOG4CPLUS_TEXT ("prefix:> ")
+                + expected);
+
+            tostringstream oss2;
+            bufferLayout.formatAndAppend (oss2, event);
+            CATCH_REQUIRE (oss2.str () == LOG4CPLUS_TEXT ("> ") + expected);
+        }
+
+        struct StreamSimpleLayout : SimpleLayout
+        {
+            using SimpleLayout::formatAndAppend;
+
+            virtual void formatAndAppend (tostream & output,
+                spi::InternalLoggingEvent const & ev) override
+            {
+                output << LOG4CPLUS_TEXT ("> ");
+                SimpleLayout::formatAndAppend (output, ev);
+            }
+        };
+
+        StreamSimpleLayout simpleLayout;
+        tstring buffer;
+        simpleLayout.formatAndAppend (buffer, event);
+        CATCH_REQUIRE (buffer == LOG4CPLUS_TEXT ("> WARN - message text\n"));
+    }
+
+#if defined (LOG4CPLUS_HAVE_GETPID) && ! defined (_WIN32)
+    CATCH_SECTION ("process ID in child process")
+    {
+        PatternLayout layout (LOG4CPLUS_TEXT ("%i"));
+        StaticPatternLayout<LOG4CPLUS_TEXT ("%i")> staticLayout;
+        tstring buffer;
+        layout.formatAndAppend (buffer, event);
+
+        pid_t const child = fork ();
+        CATCH_REQUIRE (child != -1);
+        if (child == 0)
+        {
+            tstring expected;
+            helpers::appendIntegerToString (expected, getpid ());
+            tstring actual;
+            layout.formatAndAppend (actual, event);
+            tstring staticActual;
+            staticLayout.formatAndAppend (staticActual, event);
+            _exit (actual == expected && staticActual == expected ? 0 : 1);
+        }
+
+        int status = 0;
+        CATCH_REQUIRE (waitpid (child, &status, 0) == child);
+        CATCH_REQUIRE (WIFEXITED (status));
+        CATCH_REQUIRE (WEXITSTATUS (status) == 0);
+    }
+#endif
+
+#if ! defined (_WIN32)
+    CATCH_SECTION ("environment snapshot")
+    {
+        setenv ("LOG4CPLUS_TEST_ENV_VAR", "before", 1);
+        PatternLayout snapshot (LOG4CPLUS_TEXT ("[%E{LOG4CPLUS_TEST_ENV_VAR}]"));
+        PatternLayout perEvent (LOG4CPLUS_TEXT ("[%E{LOG4CPLUS_TEST_ENV_VAR}]"),
+            false);
+        setenv ("LOG4CPLUS_TEST_ENV_VAR", "after", 1);
+
+        tstring buffer;
+        snapshot.formatAndAppend (buffer, event);
+        CATCH_REQUIRE (buffer == LOG4CPLUS_TEXT ("[before]"));
+        buffer.clear ();
+        perEvent.formatAndAppend (buffer, event);
+        CATCH_REQUIRE (buffer == LOG4CPLUS_TEXT ("[after]"));
+        unsetenv ("LOG4CPLUS_TEST_ENV_VAR");
+    }
+#endif
+}
+
+
+template <pattern::StaticPattern Pattern>
+static
+void
+checkStaticPatternLayout (
+    std::vector<spi::InternalLoggingEvent> const & events,
+    helpers::Properties props)
+{
+    StaticPatternLayout<Pattern> staticLayout (props);
+    props.setProperty (LOG4CPLUS_TEXT ("ConversionPattern"),
+        tstring (Pattern.text));
+    PatternLayout layout (props);
+
+    for (auto const & event : events)
+    {
+        tstring expected;
+        layout.formatAndAppend (expected, event);
+        tstring actual;
+        staticLayout.formatAndAppend (actual, event);
+        CATCH_REQUIRE (actual == expected);
+
+        tostringstream oss;
+        staticLayout.formatAndAppend (oss, event);
+        CATCH_REQUIRE (oss.str () == expected);
+    }
+}
+
+
+CATCH_TEST_CASE ("StaticPatternLayout", "[layout]")
+{
+    MappedDiagnosticContextMap mdc;
+    mdc[LOG4CPLUS_TEXT ("key")] = LOG4CPLUS_TEXT ("value");
+    mdc[LOG4CPLUS_TEXT ("other")] = LOG4CPLUS_TEXT ("x");
+
+    auto const time = helpers::from_time_t (1700000000);
+    std::vector<spi::InternalLoggingEvent> events;
+    events.emplace_back (
+        LOG4CPLUS_TEXT ("a.b.logger"), WARN_LOG_LEVEL,
+        LOG4CPLUS_TEXT ("outer inner innermost"), mdc,
+        LOG4CPLUS_TEXT ("message text"), LOG4CPLUS_TEXT ("thread"),
+        LOG4CPLUS_TEXT ("thread2"), time + std::chrono::microseconds (123456),
+        LOG4CPLUS_TEXT ("/src/dir/file.cxx"), 42, LOG4CPLUS_TEXT ("func"));
+    events.emplace_back (
+        LOG4CPLUS_TEXT ("root"), DEBUG_LOG_LEVEL, LOG4CPLUS_TEXT (""),
+        MappedDiagnosticContextMap (), LOG4CPLUS_TEXT ("longer message text"),
+        LOG4CPLUS_TEXT ("t"), LOG4CPLUS_TEXT (""),
+        time + std::chrono::seconds (61), LOG4CPLUS_TEXT (""), -1);
+
+    helpers::Properties props;
+    props.setProperty (LOG4CPLUS_TEXT ("NDCMaxDepth"), LOG4CPLUS_TEXT ("2"));
+
+    static_assert (pattern::parseStaticPattern (pattern::StaticPattern (
+        LOG4CPLUS_TEXT ("%d{%H:%M:%S.%q} %-5p [%t] %c - %m%n"))).count == 10);
+    static_assert (pattern::parseStaticPattern (pattern::StaticPattern (
+        LOG4CPLUS_TEXT ("a%%b"))).textLength == 3);
+
+    CATCH_SECTION ("common patterns")
+    {
+        checkStaticPatternLayout<
+            LOG4CPLUS_TEXT ("%d{%H:%M:%S.%q} %-5p [%t] %c - %m%n")> (
+                events, props);
+        checkStaticPatternLayout<LOG4CPLUS_TEXT ("%D %d{%s.%Q} %r %i %h %H %n")> (
+            events, props);
+        checkStaticPatternLayout<LOG4CPLUS_TEXT ("")> (events, props);
+    }
+
+    CATCH_SECTION ("fields")
+    {
+        checkStaticPatternLayout<
+            LOG4CPLUS_TEXT ("%p %c{2} %c{1} %b:%L %M %l|%F|%T - %m%n")> (
+                events, props);
+        checkStaticPatternLayout<
+            LOG4CPLUS_TEXT ("%x|%X|%X{key}|%E{PATH}|%E{LOG4CPLUS_UNSET_VAR}")> (
+                events, props);
+    }
+
+    CATCH_SECTION ("padding and truncation")
+    {
+        checkStaticPatternLayout<
+            LOG4CPLUS_TEXT ("[%-7p][%7p][%.4m][%.-4m][%3.5c][%-12.5L]")> (
+                events, props);
+        checkStaticPatternLayout<
+            LOG4CPLUS_TEXT ("%%[%20.-10d{%H:%M:%S,%q}][%-10x][%.3X{key}]%%")> (
+                events, props);
+    }
+
+    CATCH_SECTION ("per event environment variables")
+    {
+        props.setProperty (LOG4CPLUS_TEXT ("SnapshotEnvironment"),
+            LOG4CPLUS_TEXT ("false"));
+        checkStaticPatternLayout<
+            LOG4CPLUS_TEXT ("%E{PATH}|%-30.5E{PATH}|%5E{LOG4CPLUS_UNSET_VAR}")> (
+                events, props);
+    }
+
+    CATCH_SECTION ("constants")
+    {
+        checkStaticPatternLayout<
+            LOG4CPLUS_TEXT ("%-12i|%.2i|%20h|%.-3H|%-30.5E{PATH}")> (
+                events, props);
+    }
+
+    CATCH_SECTION ("incomplete conversion")
+    {
+        checkStaticPatternLayout<LOG4CPLUS_TEXT ("%m %-1")> (events, props);
+        checkStaticPatternLayout<LOG4CPLUS_TEXT ("%")> (events, props);
     }
 }
+#endif
 
 
 } // namespace log4cplus
@@ -30,11 +30,33 @@
 #include <stdexcept>
 #include <algorithm>
 #include <iterator>
+#include <thread>
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <catch_amalgamated.hpp>
+#include <log4cplus/asyncappender.h>
+#include <log4cplus/helpers/property.h>
+#include <log4cplus/helpers/stringhelper.h>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+#endif
 
 
 namespace log4cplus::thread {
 
 
+QueueBase::QueueBase () = default;
+
+
+QueueBase::~QueueBase () = default;
+
+
+//
+//
+//
+
 Queue::Queue (unsigned len)
     : ev_consumer (false)
     , sem (len, len)
@@ -186,6 +208,464 @@ Queue::get_events (queue_storage_type * buf)
 }
 
 
+//
+//
+//
+
+namespace
+{
+
+//! Smallest power of two that is greater or equal to `len` and at
+//! least 2.
+static
+std::size_t
+ring_buffer_capacity (unsigned len)
+{
+    std::size_t capacity = 2;
+    while (capacity < len)
+        capacity <<= 1;
+    return capacity;
+}
+
+//! How long producers sleep on a full queue before they recheck it.
+static unsigned long const full_queue_wait_msec = 10;
+
+} // namespace
+
+
+RingBufferQueue::RingBufferQueue (unsigned len)
+    : capacity (ring_buffer_capacity (len))
+    , slots (new Slot[capacity])
+    , enqueue_pos (0)
+    , dequeue_pos (0)
+    , state (DRAIN)
+    , producers_waiting (0)
+    , ev_consumer (false)
+    , ev_producers (false)
+{
+    for (std::size_t i = 0; i != capacity; ++i)
+    {
+        slots[i].sequence.store (i, std::memory_order_relaxed);
+        slots[i].valid = false;
+    }
+}
+
+
+RingBufferQueue::~RingBufferQueue () = default;
+
+
+bool
+RingBufferQueue::wait_for_space (std::size_t pos)
+{
+    Slot const & slot = slots[pos & (capacity - 1)];
+
+    while (true)
+    {
+        // Reset the event before announcing the waiting producer. The
+        // consumer either frees the slot before its read-modify-write
+        // of `producers_waiting`, then the check below sees the slot
+        // free, or it sees this producer and signals the event after
+        // the reset. Other producers can still reset it, the timeout
+        // bounds that case.
+        ev_producers.reset ();
+        producers_waiting.fetch_add (1, std::memory_order_acq_rel);
+
+        std::size_t const seq = slot.sequence.load (std::memory_order_acquire);
+        bool const done = static_cast<std::ptrdiff_t>(seq - pos) >= 0
+            || (state.load (std::memory_order_acquire) & EXIT);
+        if (! done)
+            ev_producers.timed_wait (full_queue_wait_msec);
+
+        producers_waiting.fetch_sub (1, std::memory_order_relaxed);
+        if (done)
+            break;
+    }
+
+    return ! (state.load (std::memory_order_acquire) & EXIT);
+}
+
+
+RingBufferQueue::flags_type
+RingBufferQueue::put_event (spi::InternalLoggingEvent const & ev)
+{
+    flags_type ret_flags = ERROR_BIT;
+    try
+    {
+        ev.gatherThreadSpecificData ();
+
+        std::size_t const mask = capacity - 1;
+        std::size_t word = enqueue_pos.load (std::memory_order_relaxed);
+        std::size_t pos;
+        Slot * slot;
+        while (true)
+        {
+            flags_type const st = state.load (std::memory_order_acquire);
+            if (st & EXIT)
+                return st;
+
+            pos = word >> 1;
+            slot = &slots[pos & mask];
+            std::size_t const seq
+                = slot->sequence.load (std::memory_order_acquire);
+            auto const diff = static_cast<std::ptrdiff_t>(seq - pos);
+            if (diff == 0)
+            {
+                // The slot is free, try to claim it. This is the only
+                // read-modify-write operation on the fast path. It also
+                // clears `consumer_sleeping`; the acquire pairs with the
+                // release of the consumer setting it.
+                if (enqueue_pos.compare_exchange_weak (word, (pos + 1) << 1,
+                        std::memory_order_acquire, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+            {
+                // The queue is full. Wait for the consumer to free the
+                // slot.
+                if (! wait_for_space (pos))
+                    return state.load (std::memory_order_acquire);
+                word = enqueue_pos.load (std::memory_order_relaxed);
+            }
+            else
+                // Another producer has claimed the slot.
+                word = enqueue_pos.load (std::memory_order_relaxed);
+        }
+
+        // This producer has cleared the flag, so it has to wake up the
+        // consumer once the event is published.
+        bool const wake_consumer = (word & consumer_sleeping) != 0;
+        ret_flags |= ERROR_AFTER;
+
+        // The slot is ours now. It has to be published even if copying of
+        // the event fails, otherwise the consumer would wait for it
+        // forever.
+        try
+        {
+            slot->event = ev;
+            slot->valid = true;
+        }
+        catch (...)
+        {
+            slot->valid = false;
+            slot->sequence.store (pos + 1, std::memory_order_release);
+            if (wake_consumer)
+                ev_consumer.signal ();
+            throw;
+        }
+        slot->sequence.store (pos + 1, std::memory_order_release);
+
+        if (wake_consumer)
+            ev_consumer.signal ();
+
+        ret_flags = state.load (std::memory_order_relaxed) | QUEUE;
+    }
+    catch (std::runtime_error const & e)
+    {
+        log4cplus::helpers::getLogLog().error(
+            LOG4CPLUS_TEXT("put_event() exception: ")
+            + LOG4CPLUS_C_STR_TO_TSTRING(e.what()));
+        return ret_flags;
+    }
+
+    return ret_flags;
+}
+
+
+RingBufferQueue::flags_type
+RingBufferQueue::signal_exit (bool drain)
+{
+    flags_type ret_flags = 0;
+
+    try
+    {
+        flags_type st = state.load (std::memory_order_relaxed);
+        flags_type new_st;
+        do
+        {
+            ret_flags = st;
+            if (st & EXIT)
+                return ret_flags;
+
+            new_st = (drain ? (st | DRAIN) : (st & ~DRAIN)) | EXIT;
+        }
+        while (! state.compare_exchange_weak (st, new_st,
+                std::memory_order_acq_rel, std::memory_order_relaxed));
+
+        ret_flags = new_st;
+        ev_consumer.signal ();
+        ev_producers.signal ();
+    }
+    catch (std::runtime_error const & e)
+    {
+        log4cplus::helpers::getLogLog().error(
+            LOG4CPLUS_TEXT("signal_exit() exception: ")
+            + LOG4CPLUS_C_STR_TO_TSTRING(e.what()));
+        ret_flags |= ERROR_BIT;
+        return ret_flags;
+    }
+
+    return ret_flags;
+}
+
+
+std::size_t
+RingBufferQueue::consume (queue_storage_type * buf)
+{
+    std::size_t const mask = capacity - 1;
+    std::size_t count = 0;
+
+    while (true)
+    {
+        Slot & slot = slots[dequeue_pos & mask];
+        std::size_t const seq = slot.sequence.load (std::memory_order_acquire);
+        if (seq != dequeue_pos + 1)
+            break;
+
+        if (buf && slot.valid)
+        {
+            buf->emplace_back ();
+            buf->back ().swap (slot.event);
+        }
+        slot.valid = false;
+
+        // Hand the slot over to producers for the next lap.
+        slot.sequence.store (dequeue_pos + capacity,
+            std::memory_order_release);
+        ++dequeue_pos;
+        ++count;
+    }
+
+    // The read-modify-write, unlike a plain load, cannot miss a
+    // producer that has started waiting before the slots above have
+    // been freed. See wait_for_space().
+    if (count != 0
+        && producers_waiting.fetch_add (0, std::memory_order_acq_rel) != 0)
+        ev_producers.signal ();
+
+    return count;
+}
+
+
+RingBufferQueue::flags_type
+RingBufferQueue::get_events (queue_storage_type * buf)
+{
+    flags_type ret_flags = 0;
+
+    try
+    {
+        buf->clear ();
+
+        while (true)
+        {
+            ret_flags = state.load (std::memory_order_acquire);
+
+            if ((ret_flags & (EXIT | DRAIN)) == EXIT)
+            {
+                // Exit without draining, throw away what is queued.
+                consume (nullptr);
+                break;
+            }
+
+            consume (buf);
+            if (! buf->empty ())
+            {
+                ret_flags |= EVENT;
+                break;
+            }
+
+            if (ret_flags & EXIT)
+            {
+                // Producers that have claimed a slot before EXIT was set
+                // might still be copying their events. Wait for them so
+                // that draining does not lose anything.
+                if ((enqueue_pos.load (std::memory_order_acquire) >> 1)
+                    != dequeue_pos)
+                {
+                    std::this_thread::yield ();
+                    continue;
+                }
+                break;
+            }
+
+            // The queue is empty. Unless a producer has claimed a slot
+            // and it is still copying its event, announce that we are
+            // going to sleep by setting `consumer_sleeping`. The next
+            // producer clears it and signals the event. The release
+            // makes the reset of the event happen before the signal.
+            ev_consumer.reset ();
+            std::size_t word = enqueue_pos.load (std::memory_order_relaxed);
+            if ((word >> 1) != dequeue_pos)
+            {
+                std::this_thread::yield ();
+                continue;
+            }
+
+            if (! enqueue_pos.compare_exchange_strong (word,
+                    word | consumer_sleeping, std::memory_order_release,
+                    std::memory_order_relaxed))
+                continue;
+
+            if (! (state.load (std::memory_order_acquire) & EXIT))
+                ev_consumer.wait ();
+        }
+    }
+    catch (std::runtime_error const & e)
+    {
+        log4cplus::helpers::getLogLog().error(
+            LOG4CPLUS_TEXT("get_events() exception: ")
+            + LOG4CPLUS_C_STR_TO_TSTRING(e.what()));
+        ret_flags |= ERROR_BIT;
+    }
+
+    return ret_flags;
+}
+
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+CATCH_TEST_CASE ("RingBufferQueue", "[queue]")
+{
+    using EventBuffer = Queue::queue_storage_type;
+
+    CATCH_SECTION ("single producer, drain on exit")
+    {
+        RingBufferQueue queue (4);
+        for (int i = 0; i != 3; ++i)
+        {
+            spi::InternalLoggingEvent ev (LOG4CPLUS_TEXT ("test"),
+                INFO_LOG_LEVEL, LOG4CPLUS_TEXT ("message"), __FILE__, i);
+            CATCH_REQUIRE (! (queue.put_event (ev)
+                    & (Queue::ERROR_BIT | Queue::ERROR_AFTER)));
+        }
+
+        queue.signal_exit (true);
+
+        EventBuffer buf;
+        Queue::flags_type flags = queue.get_events (&buf);
+        CATCH_REQUIRE ((flags & (Queue::EVENT | Queue::EXIT | Queue::DRAIN))
+            == (Queue::EVENT | Queue::EXIT | Queue::DRAIN));
+        CATCH_REQUIRE (buf.size () == 3);
+        for (int i = 0; i != 3; ++i)
+            CATCH_REQUIRE (buf[i].getLine () == i);
+
+        flags = queue.get_events (&buf);
+        CATCH_REQUIRE (! (flags & Queue::EVENT));
+        CATCH_REQUIRE ((flags & Queue::EXIT));
+
+        // Events put into queue after exit are ignored.
+        spi::InternalLoggingEvent ev (LOG4CPLUS_TEXT ("test"),
+            INFO_LOG_LEVEL, LOG4CPLUS_TEXT ("message"), __FILE__, 0);
+        CATCH_REQUIRE ((queue.put_event (ev) & Queue::EXIT));
+    }
+
+    CATCH_SECTION ("exit without draining")
+    {
+        RingBufferQueue queue (4);
+        spi::InternalLoggingEvent ev (LOG4CPLUS_TEXT ("test"),
+            INFO_LOG_LEVEL, LOG4CPLUS_TEXT ("message"), __FILE__, 0);
+        queue.put_event (ev);
+        queue.signal_exit (false);
+
+        EventBuffer buf;
+        Queue::flags_type flags = queue.get_events (&buf);
+        CATCH_REQUIRE (! (flags & Queue::EVENT));
+        CATCH_REQUIRE (buf.empty ());
+    }
+
+    CATCH_SECTION ("multiple producers")
+    {
+        int const producers_count = 4;
+        int const events_per_producer = 1000;
+        RingBufferQueue queue (8);
+
+        std::vector<std::thread> producers;
+        for (int p = 0; p != producers_count; ++p)
+            producers.emplace_back ([&queue, p] {
+                spi::InternalLoggingEvent ev (LOG4CPLUS_TEXT ("test"),
+                    INFO_LOG_LEVEL, LOG4CPLUS_TEXT ("message"), __FILE__, p);
+                for (int i = 0; i != events_per_producer; ++i)
+                    queue.put_event (ev);
+            });
+
+        std::vector<int> received (producers_count, 0);
+        std::size_t total = 0;
+        EventBuffer buf;
+        while (total != producers_count * events_per_producer)
+        {
+            Queue::flags_type flags = queue.get_events (&buf);
+            CATCH_REQUIRE ((flags & Queue::EVENT));
+            for (auto const & ev : buf)
+                received[ev.getLine ()] += 1;
+            total += buf.size ();
+        }
+
+        for (auto & th : producers)
+            th.join ();
+
+        for (int count : received)
+            CATCH_REQUIRE (count == events_per_producer);
+
+        queue.signal_exit (true);
+        CATCH_REQUIRE (! (queue.get_events (&buf) & Queue::EVENT));
+    }
+}
+
+
+CATCH_TEST_CASE ("AsyncAppender with RingBufferQueue", "[queue]")
+{
+    int const producers_count = 4;
+    int const events_per_producer = 1000;
+    char const log_file_name[] = "async_ring_buffer_test.log";
+    std::remove (log_file_name);
+
+    helpers::Properties props;
+    props.setProperty (LOG4CPLUS_TEXT ("Appender"),
+        LOG4CPLUS_TEXT ("log4cplus::FileAppender"));
+    props.setProperty (LOG4CPLUS_TEXT ("Appender.File"),
+        LOG4CPLUS_C_STR_TO_TSTRING (log_file_name));
+    props.setProperty (LOG4CPLUS_TEXT ("Appender.ImmediateFlush"),
+        LOG4CPLUS_TEXT ("false"));
+    props.setProperty (LOG4CPLUS_TEXT ("QueueLimit"), LOG4CPLUS_TEXT ("8"));
+    props.setProperty (LOG4CPLUS_TEXT ("QueueType"),
+        LOG4CPLUS_TEXT ("RingBuffer"));
+
+    SharedAppenderPtr appender (new AsyncAppender (props));
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p != producers_count; ++p)
+        producers.emplace_back ([&appender, p] {
+            spi::InternalLoggingEvent ev (LOG4CPLUS_TEXT ("test"),
+                INFO_LOG_LEVEL, helpers::convertIntegerToString (p),
+                __FILE__, __LINE__);
+            for (int i = 0; i != events_per_producer; ++i)
+                appender->doAppend (ev);
+        });
+
+    for (auto & th : producers)
+        th.join ();
+
+    // Closing drains the queue into the file.
+    appender->close ();
+
+    std::vector<int> received (producers_count, 0);
+    std::ifstream log_file (log_file_name);
+    std::string line;
+    while (std::getline (log_file, line))
+    {
+        CATCH_REQUIRE (line.size () > 1);
+        int const p = line.back () - '0';
+        CATCH_REQUIRE ((p >= 0 && p < producers_count));
+        received[p] += 1;
+    }
+    log_file.close ();
+    std::remove (log_file_name);
+
+    for (int count : received)
+        CATCH_REQUIRE (count == events_per_producer);
+}
+
+#endif // defined (LOG4CPLUS_WITH_UNIT_TESTS)
+
+
 } // namespace log4cplus::thread
 
 
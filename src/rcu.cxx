@@ -0,0 +1,241 @@
+// -*- C++ -*-
+//
+//  Copyright (C) 2026, Vaclav Haisman. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <log4cplus/internal/rcu.h>
+#include <log4cplus/internal/internal.h>
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+
+namespace log4cplus { namespace internal { namespace rcu {
+
+
+//! Reader record of a thread. Records are never freed. Records of
+//! exited threads are reused by new threads.
+struct alignas (64) reader_record
+{
+    //! Value of global_epoch read on entry into the outermost read-side
+    //! critical section, zero outside of it.
+    std::atomic<std::uint64_t> active {0};
+    std::atomic<bool> in_use {true};
+    reader_record * next = nullptr;
+};
+
+
+namespace
+{
+
+struct retired_object
+{
+    void * ptr;
+    void (* deleter) (void *);
+
+    //! Value of global_epoch before the object has been retired.
+    std::uint64_t epoch;
+};
+
+
+struct retired_list
+{
+    std::mutex mutex;
+    std::vector<retired_object> objects;
+};
+
+
+//! Advanced by every retire(). Starts at 1 because zero marks readers
+//! outside of critical sections.
+std::atomic<std::uint64_t> global_epoch {1};
+
+//! List of all reader records.
+std::atomic<reader_record *> readers {nullptr};
+
+//! Epoch of the newest object in the retired list, zero when the list
+//! is empty. Readers that could have seen it check it on exit from
+//! critical sections, so the last of them reclaims the object.
+std::atomic<std::uint64_t> newest_retired {0};
+
+
+retired_list &
+get_retired_list ()
+{
+    // Leaked on purpose, objects can be retired during destruction of
+    // static objects.
+    static retired_list * const list = new retired_list;
+    return *list;
+}
+
+
+reader_record *
+acquire_record ()
+{
+    for (reader_record * record = readers.load (std::memory_order_acquire);
+         record; record = record->next)
+    {
+        bool expected = false;
+        if (! record->in_use.load (std::memory_order_relaxed)
+            && record->in_use.compare_exchange_strong (expected, true,
+                std::memory_order_acquire, std::memory_order_relaxed))
+            return record;
+    }
+
+    auto * const record = new reader_record;
+    reader_record * head = readers.load (std::memory_order_relaxed);
+    do
+        record->next = head;
+    while (! readers.compare_exchange_weak (head, record,
+            std::memory_order_release, std::memory_order_relaxed));
+
+    return record;
+}
+
+
+//! \return Lowest epoch of readers inside critical sections.
+std::uint64_t
+oldest_reader_epoch ()
+{
+    // Pairs with the fence in read_lock(). Either the reader's entry is
+    // visible here, or the reader sees the object already unpublished.
+    std::atomic_thread_fence (std::memory_order_seq_cst);
+
+    std::uint64_t oldest = (std::numeric_limits<std::uint64_t>::max) ();
+    for (reader_record * record = readers.load (std::memory_order_acquire);
+         record; record = record->next)
+    {
+        std::uint64_t const epoch
+            = record->active.load (std::memory_order_acquire);
+        if (epoch != 0 && epoch < oldest)
+            oldest = epoch;
+    }
+
+    return oldest;
+}
+
+} // namespace
+
+
+reader_state &
+read_lock ()
+{
+    reader_state & state = get_ptd ()->rcu;
+    if (state.nesting++ != 0)
+        return state;
+
+    if (! state.record) [[unlikely]]
+        state.record = acquire_record ();
+
+    // The acquire load pairs with the increment in retire(). A reader
+    // that sees the new epoch also sees the object unpublished.
+    state.record->active.store (
+        global_epoch.load (std::memory_order_acquire),
+        std::memory_order_relaxed);
+    std::atomic_thread_fence (std::memory_order_seq_cst);
+    return state;
+}
+
+
+void
+read_unlock (reader_state & state)
+{
+    if (--state.nesting != 0)
+        return;
+
+    std::atomic<std::uint64_t> & active = state.record->active;
+    std::uint64_t const epoch = active.load (std::memory_order_relaxed);
+
+    // Sequentially consistent store and load pair with those in
+    // retire(). Either this reader sees the retired object in the list,
+    // or the writer sees this reader already outside.
+    active.store (0, std::memory_order_seq_cst);
+    if (epoch <= newest_retired.load (std::memory_order_seq_cst)) [[unlikely]]
+        reclaim ();
+}
+
+
+void
+retire (void * ptr, void (* deleter) (void *))
+{
+    retired_list & list = get_retired_list ();
+    {
+        std::lock_guard guard (list.mutex);
+        // Readers that enter after this increment cannot see the
+        // object. It has been unpublished before.
+        std::uint64_t const epoch = global_epoch.fetch_add (1,
+            std::memory_order_seq_cst);
+        list.objects.push_back (retired_object {ptr, deleter, epoch});
+        newest_retired.store (epoch, std::memory_order_seq_cst);
+    }
+
+    reclaim ();
+}
+
+
+void
+reclaim ()
+{
+    retired_list & list = get_retired_list ();
+    std::vector<retired_object> ready;
+    {
+        std::lock_guard guard (list.mutex);
+        if (list.objects.empty ())
+            return;
+
+        // Objects retired in epoch E cannot be accessed by readers
+        // that entered their critical sections in epoch E + 1 or later.
+        std::uint64_t const oldest = oldest_reader_epoch ();
+        auto it = list.objects.begin ();
+        while (it != list.objects.end () && it->epoch < oldest)
+            ++it;
+
+        ready.assign (list.objects.begin (), it);
+        list.objects.erase (list.objects.begin (), it);
+        if (list.objects.empty ())
+            newest_retired.store (0, std::memory_order_relaxed);
+    }
+
+    // Deleters run without the lock, they can retire more objects.
+    for (retired_object const & object : ready)
+        object.deleter (object.ptr);
+}
+
+
+void
+release_reader (reader_state & state)
+{
+    if (! state.record)
+        return;
+
+    state.record->active.store (0, std::memory_order_release);
+    state.record->in_use.store (false, std::memory_order_release);
+    state.record = nullptr;
+    state.nesting = 0;
+}
+
+
+} } } // namespace log4cplus { namespace internal { namespace rcu {
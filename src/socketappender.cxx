@@ -19,15 +19,23 @@
 // limitations under the License.
 
 #include <cstdlib>
+#include <memory>
 #include <stdexcept>
 #include <log4cplus/socketappender.h>
 #include <log4cplus/layout.h>
 #include <log4cplus/spi/loggingevent.h>
 #include <log4cplus/helpers/loglog.h>
 #include <log4cplus/helpers/property.h>
+#include <log4cplus/helpers/stringhelper.h>
 #include <log4cplus/thread/syncprims-pub-impl.h>
 #include <log4cplus/internal/internal.h>
 
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <catch_amalgamated.hpp>
+#include <thread>
+#include <vector>
+#endif
+
 
 namespace log4cplus {
 
@@ -120,24 +128,8 @@ SocketAppender::initConnector ()
 void
 SocketAppender::append(const spi::InternalLoggingEvent& event)
 {
-#if ! defined (LOG4CPLUS_SINGLE_THREADED)
-    if (! connected)
-    {
-        connector->trigger ();
+    if (! ensureConnected ())
         return;
-    }
-
-#else
-    if(!socket.isOpen()) {
-        openSocket();
-        if(!socket.isOpen()) {
-            helpers::getLogLog().error(
-                LOG4CPLUS_TEXT(
-                    "SocketAppender::append()- Cannot connect to server"));
-            return;
-        }
-    }
-#endif
 
     helpers::SocketBuffer msgBuffer(LOG4CPLUS_MAX_MESSAGE_SIZE
         - sizeof (unsigned int));
@@ -156,16 +148,95 @@ SocketAppender::append(const spi::InternalLoggingEvent& event)
 
     bool ret = helpers::Socket::write(socket, buffer, msgBuffer);
     if (! ret)
+        writeFailed ();
+}
+
+
+void
+SocketAppender::appendBatch(
+    std::span<spi::InternalLoggingEvent const * const> events)
+{
+    if (! ensureConnected ())
+        return;
+
+    // Size of the buffer collecting serialized events. It is big enough
+    // for several events of maximal size.
+    std::size_t const batchBufferSize = 8 * LOG4CPLUS_MAX_MESSAGE_SIZE;
+    std::unique_ptr<helpers::SocketBuffer> batch (
+        new helpers::SocketBuffer (batchBufferSize));
+
+    for (spi::InternalLoggingEvent const * event : events)
     {
-        helpers::getLogLog().error(
-            LOG4CPLUS_TEXT(
-                "SocketAppender::append()- Write failed"));
+        helpers::SocketBuffer msgBuffer(LOG4CPLUS_MAX_MESSAGE_SIZE
+            - sizeof (unsigned int));
+
+        try
+        {
+            convertToBuffer (msgBuffer, *event, serverName);
+        }
+        catch (std::runtime_error const &)
+        {
+            continue;
+        }
+
+        if (batch->getSize () + sizeof (unsigned int) + msgBuffer.getSize ()
+            > batch->getMaxSize ())
+        {
+            if (! socket.write (*batch))
+            {
+                writeFailed ();
+                return;
+            }
+
+            batch.reset (new helpers::SocketBuffer (batchBufferSize));
+        }
+
+        batch->appendInt (static_cast<unsigned>(msgBuffer.getSize ()));
+        batch->appendBuffer (msgBuffer);
+    }
+
+    if (batch->getSize () != 0 && ! socket.write (*batch))
+        writeFailed ();
+}
 
+
+bool
+SocketAppender::ensureConnected()
+{
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
-        connected = false;
+    if (! connected)
+    {
         connector->trigger ();
-#endif
+        return false;
+    }
+
+#else
+    if(!socket.isOpen()) {
+        openSocket();
+        if(!socket.isOpen()) {
+            helpers::getLogLog().error(
+                LOG4CPLUS_TEXT(
+                    "SocketAppender::append()- Cannot connect to server"));
+            return false;
+        }
     }
+#endif
+
+    return true;
+}
+
+
+void
+SocketAppender::writeFailed()
+{
+    helpers::getLogLog().error(
+        LOG4CPLUS_TEXT(
+            "SocketAppender::append()- Write failed"));
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    connected = false;
+    connector->trigger ();
+#endif
 }
 
 
@@ -278,4 +349,59 @@ readFromBuffer(SocketBuffer& buffer)
 } // namespace helpers
 
 
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS) \
+    && ! defined (LOG4CPLUS_SINGLE_THREADED)
+CATCH_TEST_CASE ("SocketAppender batch append", "[appender][sockets]")
+{
+    std::unique_ptr<helpers::ServerSocket> server;
+    unsigned short port = 37311;
+    for (; port != 37411; ++port)
+    {
+        server.reset (new helpers::ServerSocket (port));
+        if (server->isOpen ())
+            break;
+    }
+    CATCH_REQUIRE (server->isOpen ());
+
+    SharedAppenderPtr appender (new SocketAppender (
+        LOG4CPLUS_TEXT ("localhost"), port, LOG4CPLUS_TEXT ("server")));
+    helpers::Socket client = server->accept ();
+    CATCH_REQUIRE (client.isOpen ());
+
+    // Long messages make the batch span several writes.
+    std::vector<spi::InternalLoggingEvent> events;
+    for (int i = 0; i != 40; ++i)
+        events.emplace_back (LOG4CPLUS_TEXT ("batch"), INFO_LOG_LEVEL,
+            helpers::convertIntegerToString (i)
+            + tstring (i % 2 == 0 ? 5000 : 10, LOG4CPLUS_TEXT ('x')),
+            __FILE__, __LINE__);
+
+    std::vector<tstring> received;
+    std::thread reader ([&] {
+        for (std::size_t i = 0; i != events.size (); ++i)
+        {
+            helpers::SocketBuffer msgSizeBuffer (sizeof (unsigned int));
+            if (! client.read (msgSizeBuffer))
+                return;
+
+            helpers::SocketBuffer buffer (msgSizeBuffer.readInt ());
+            if (! client.read (buffer))
+                return;
+
+            received.push_back (helpers::readFromBuffer (buffer)
+                .getMessage ());
+        }
+    });
+
+    appender->syncDoAppendBatch (events);
+    reader.join ();
+    appender->close ();
+
+    CATCH_REQUIRE (received.size () == events.size ());
+    for (std::size_t i = 0; i != events.size (); ++i)
+        CATCH_REQUIRE (received[i] == events[i].getMessage ());
+}
+#endif
+
+
 } // namespace log4cplus
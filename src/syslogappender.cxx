@@ -28,6 +28,12 @@
 #include <log4cplus/thread/syncprims-pub-impl.h>
 #include <cstring>
 
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <catch_amalgamated.hpp>
+#include <log4cplus/layout.h>
+#include <vector>
+#endif
+
 #if defined (LOG4CPLUS_HAVE_SYSLOG_H)
 #include <syslog.h>
 
@@ -399,9 +405,8 @@ SysLogAppender::appendLocal(const spi::InternalLoggingEvent& event)
 {
     int const level = getSysLogLevel(event.getLogLevel());
     internal::appender_sratch_pad & appender_sp = internal::get_appender_sp ();
-    detail::clear_tostringstream (appender_sp.oss);
-    layout->formatAndAppend(appender_sp.oss, event);
-    appender_sp.str = appender_sp.oss.str ();
+    appender_sp.str.clear ();
+    layout->formatAndAppend(appender_sp.str, event);
     ::syslog(facility | level, "%s",
         LOG4CPLUS_TSTRING_TO_STRING(appender_sp.str).c_str());
 }
@@ -416,12 +421,48 @@ tstring const SysLogAppender::remoteTimeFormat (
 void
 SysLogAppender::appendRemote(const spi::InternalLoggingEvent& event)
 {
+    if (! ensureRemoteConnected ())
+        return;
+
+    internal::appender_sratch_pad & appender_sp = internal::get_appender_sp ();
+    appender_sp.chstr.clear ();
+    formatRemote (appender_sp.chstr, event);
+    writeRemote (appender_sp.chstr);
+}
+
+
+void
+SysLogAppender::appendBatch(
+    std::span<spi::InternalLoggingEvent const * const> events)
+{
+    if (appendFunc != &SysLogAppender::appendRemote
+        || remoteSyslogType == RSTUdp)
+    {
+        // Each syslog() call and each UDP datagram carries exactly one
+        // message.
+        Appender::appendBatch (events);
+        return;
+    }
+
+    if (! ensureRemoteConnected ())
+        return;
+
+    std::string batch;
+    for (spi::InternalLoggingEvent const * event : events)
+        formatRemote (batch, *event);
+
+    writeRemote (batch);
+}
+
 
+bool
+SysLogAppender::ensureRemoteConnected()
+{
     if (! connected)
     {
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
         connector->trigger ();
-        return;
+        return false;
 
 #else
         openSocket ();
@@ -432,11 +473,19 @@ SysLogAppender::appendRemote(const spi::InternalLoggingEvent& event)
                 LOG4CPLUS_TEXT ("- failed to connect to ")
                 + host + LOG4CPLUS_TEXT (":")
                 + helpers::convertIntegerToString (port));
-            return;
+            return false;
         }
 #endif
     }
 
+    return true;
+}
+
+
+void
+SysLogAppender::formatRemote(std::string & msg,
+    const spi::InternalLoggingEvent& event)
+{
     int const level = getSysLogLevel(event.getLogLevel());
     internal::appender_sratch_pad & appender_sp = internal::get_appender_sp ();
     detail::clear_tostringstream (appender_sp.oss);
@@ -448,8 +497,7 @@ SysLogAppender::appendRemote(const spi::InternalLoggingEvent& event)
         << 1
         // TIMESTAMP
         << LOG4CPLUS_TEXT (' ')
-        << helpers::getFormattedTime (remoteTimeFormat, event.getTimestamp (),
-            true)
+        << remoteTimeCache.format (event.getTimestamp ())
         // HOSTNAME
         << LOG4CPLUS_TEXT (' ') << substrOrNil (hostname, 255)
         // APP-NAME
@@ -465,20 +513,25 @@ SysLogAppender::appendRemote(const spi::InternalLoggingEvent& event)
     // MSG
     layout->formatAndAppend (appender_sp.oss, event);
 
-    appender_sp.chstr = LOG4CPLUS_TSTRING_TO_STRING (appender_sp.oss.str ());
+    std::string const body = LOG4CPLUS_TSTRING_TO_STRING (
+        appender_sp.oss.str ());
 
     if (remoteSyslogType != RSTUdp)
     {
         // see (RFC6587, 3.4.1 Octet
         // Counting)[http://tools.ietf.org/html/rfc6587#section-3.4.1]
-        std::string syslogFrameHeader (
-            helpers::convertIntegerToNarrowString (appender_sp.chstr.size ()));
-        syslogFrameHeader += ' ';
-        appender_sp.chstr.insert (appender_sp.chstr.begin (),
-            syslogFrameHeader.begin (), syslogFrameHeader.end ());
+        msg += helpers::convertIntegerToNarrowString (body.size ());
+        msg += ' ';
     }
 
-    bool ret = syslogSocket.write (appender_sp.chstr);
+    msg += body;
+}
+
+
+void
+SysLogAppender::writeRemote(std::string const & msg)
+{
+    bool ret = syslogSocket.write (msg);
     if (! ret)
     {
         helpers::getLogLog ().warn (
@@ -552,4 +605,71 @@ SysLogAppender::openSocket ()
 }
 
 
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS) \
+    && ! defined (LOG4CPLUS_SINGLE_THREADED)
+CATCH_TEST_CASE ("SysLogAppender batch append", "[appender][sockets]")
+{
+    std::unique_ptr<helpers::ServerSocket> server;
+    unsigned short port = 37411;
+    for (; port != 37511; ++port)
+    {
+        server.reset (new helpers::ServerSocket (port));
+        if (server->isOpen ())
+            break;
+    }
+    CATCH_REQUIRE (server->isOpen ());
+
+    SharedAppenderPtr appender (new SysLogAppender (LOG4CPLUS_TEXT ("test"),
+        LOG4CPLUS_TEXT ("localhost"), port, tstring (),
+        SysLogAppender::RSTTcp));
+    appender->setLayout (std::unique_ptr<Layout> (
+        new PatternLayout (LOG4CPLUS_TEXT ("%m"))));
+    helpers::Socket client = server->accept ();
+    CATCH_REQUIRE (client.isOpen ());
+
+    std::vector<spi::InternalLoggingEvent> events;
+    for (int i = 0; i != 5; ++i)
+        events.emplace_back (LOG4CPLUS_TEXT ("batch"), INFO_LOG_LEVEL,
+            LOG4CPLUS_TEXT ("event ") + helpers::convertIntegerToString (i),
+            __FILE__, __LINE__);
+
+    appender->syncDoAppendBatch (events);
+    appender->close ();
+
+    std::string data;
+    for (;;)
+    {
+        helpers::SocketBuffer byte (1);
+        if (! client.read (byte))
+            break;
+        data += byte.getBuffer ()[0];
+    }
+
+    // Frames use octet counting, RFC 6587, 3.4.1.
+    std::vector<std::string> frames;
+    for (std::size_t pos = 0; pos != data.size (); )
+    {
+        std::size_t const space = data.find (' ', pos);
+        CATCH_REQUIRE (space != std::string::npos);
+        std::size_t const length = static_cast<std::size_t>(
+            std::stoul (data.substr (pos, space - pos)));
+        CATCH_REQUIRE (space + 1 + length <= data.size ());
+        frames.push_back (data.substr (space + 1, length));
+        pos = space + 1 + length;
+    }
+
+    CATCH_REQUIRE (frames.size () == events.size ());
+    for (std::size_t i = 0; i != frames.size (); ++i)
+    {
+        std::string const suffix = " batch - event "
+            + helpers::convertIntegerToNarrowString (i);
+        CATCH_REQUIRE (frames[i].size () > suffix.size ());
+        CATCH_REQUIRE (frames[i].compare (frames[i].size () - suffix.size (),
+            suffix.size (), suffix) == 0);
+    }
+}
+#endif
+
+
 } // namespace log4cplus
@@ -23,6 +23,7 @@
 #include <log4cplus/streams.h>
 #include <log4cplus/helpers/stringhelper.h>
 #include <log4cplus/internal/internal.h>
+#include <log4cplus/thread/syncprims-pub-impl.h>
 
 #include <algorithm>
 #include <vector>
@@ -30,6 +31,11 @@
 #include <utility>
 #include <cassert>
 #include <cerrno>
+#include <cstdlib>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <memory>
 #if defined (UNICODE)
 #include <cwchar>
 #endif
@@ -56,6 +62,20 @@
 
 #include <log4cplus/config/windowsh-inc.h>
 
+#if (defined (__x86_64__) || defined (__i386__)) \
+    && (defined (__GNUC__) || defined (__clang__))
+#include <x86intrin.h>
+#include <cpuid.h>
+#define LOG4CPLUS_HAVE_TSC_CLOCK
+#elif defined (_MSC_VER) && (defined (_M_X64) || defined (_M_IX86))
+#include <intrin.h>
+#define LOG4CPLUS_HAVE_TSC_CLOCK
+#endif
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <catch_amalgamated.hpp>
+#endif
+
 
 namespace log4cplus::helpers {
 
@@ -103,10 +123,15 @@ gmTime (tm* t, Time const & the_time)
 }
 
 
+namespace
+{
+
+
+//! Calls the system localtime() function, bypassing the cache.
+static
 void
-localTime (tm* t, Time const & the_time)
+system_local_time (tm * t, time_t clock)
 {
-    time_t clock = to_time_t (the_time);
 #ifdef LOG4CPLUS_NEED_LOCALTIME_R
     ::localtime_r(&clock, t);
 #elif defined (LOG4CPLUS_HAVE_LOCALTIME_S)
@@ -121,6 +146,552 @@ localTime (tm* t, Time const & the_time)
 }
 
 
+constexpr time_t seconds_per_day = 24 * 60 * 60;
+
+
+//! \return Number of days since 1970-01-01 of the given proleptic
+//! Gregorian calendar date. Month is 1 based. See
+//! <http://howardhinnant.github.io/date_algorithms.html>.
+static
+time_t
+days_from_civil (time_t y, unsigned m, unsigned d)
+{
+    y -= m <= 2;
+    time_t const era = (y >= 0 ? y : y - 399) / 400;
+    unsigned const yoe = static_cast<unsigned>(y - era * 400);
+    unsigned const doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    unsigned const doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<time_t>(doe) - 719468;
+}
+
+
+//! Inverse of days_from_civil().
+static
+void
+civil_from_days (time_t z, time_t & y, unsigned & m, unsigned & d)
+{
+    z += 719468;
+    time_t const era = (z >= 0 ? z : z - 146096) / 146097;
+    unsigned const doe = static_cast<unsigned>(z - era * 146097);
+    unsigned const yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096)
+        / 365;
+    unsigned const doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    unsigned const mp = (5 * doy + 2) / 153;
+    d = doy - (153 * mp + 2) / 5 + 1;
+    m = mp < 10 ? mp + 3 : mp - 9;
+    y = static_cast<time_t>(yoe) + era * 400 + (m <= 2);
+}
+
+
+//! \return Local time minus UTC for local time t of UTC time clock.
+static
+long
+utc_offset (tm const & t, time_t clock)
+{
+    time_t const local
+        = days_from_civil (t.tm_year + 1900,
+            static_cast<unsigned>(t.tm_mon + 1),
+            static_cast<unsigned>(t.tm_mday)) * seconds_per_day
+        + t.tm_hour * 3600 + t.tm_min * 60 + t.tm_sec;
+    return static_cast<long>(local - clock);
+}
+
+
+//! Fills t with local time of UTC time clock arithmetically.
+static
+void
+local_time_from_span (tm & t, internal::time_zone_span const & span,
+    time_t clock)
+{
+    time_t const local = clock + span.offset;
+    time_t days = local / seconds_per_day;
+    time_t secs = local % seconds_per_day;
+    if (secs < 0)
+    {
+        secs += seconds_per_day;
+        --days;
+    }
+
+    time_t year;
+    unsigned month, day;
+    civil_from_days (days, year, month, day);
+
+    t = span.local;
+    t.tm_sec = static_cast<int>(secs % 60);
+    t.tm_min = static_cast<int>(secs / 60 % 60);
+    t.tm_hour = static_cast<int>(secs / 3600);
+    t.tm_mday = static_cast<int>(day);
+    t.tm_mon = static_cast<int>(month - 1);
+    t.tm_year = static_cast<int>(year - 1900);
+    // 1970-01-01 was Thursday.
+    t.tm_wday = static_cast<int>(((days + 4) % 7 + 7) % 7);
+    t.tm_yday = static_cast<int>(days - days_from_civil (year, 1, 1));
+}
+
+
+//! Process wide cache of the most recent time_zone_span. Threads keep
+//! their own reference to it in per_thread_data and consult this
+//! structure only when the time they convert falls outside of it.
+struct time_zone_cache
+{
+    using SpanPtr = std::shared_ptr<internal::time_zone_span const>;
+
+    //! Incremented by refreshTimeZone(). Spans of other generations
+    //! are stale.
+    std::atomic<unsigned> generation {0};
+
+    thread::Mutex mutex;
+    //! Guarded by mutex.
+    SpanPtr span;
+};
+
+
+static
+time_zone_cache &
+get_time_zone_cache ()
+{
+    // Never destroyed so that it can be used by logging during process
+    // exit.
+    static time_zone_cache * const cache = new time_zone_cache;
+    return *cache;
+}
+
+
+//! Computes span of time around clock during which the UTC offset
+//! and DST flag stay the same. It looks one day back and one day
+//! ahead, assuming that there is at most one transition in a day.
+static
+time_zone_cache::SpanPtr
+compute_time_zone_span (time_t clock, unsigned generation)
+{
+    auto span = std::make_shared<internal::time_zone_span> ();
+    system_local_time (&span->local, clock);
+    span->offset = utc_offset (span->local, clock);
+    span->generation = generation;
+
+    auto same_offset = [&span] (time_t c)
+    {
+        tm t;
+        system_local_time (&t, c);
+        return t.tm_isdst == span->local.tm_isdst
+            && utc_offset (t, c) == span->offset;
+    };
+
+    // Find the first second with different offset in (lo, hi], where
+    // lo has the same offset as clock and hi does not.
+    auto bisect = [&same_offset] (time_t lo, time_t hi, bool lo_same)
+    {
+        while (hi - lo > 1)
+        {
+            time_t const mid = lo + (hi - lo) / 2;
+            if (same_offset (mid) == lo_same)
+                lo = mid;
+            else
+                hi = mid;
+        }
+        return hi;
+    };
+
+    time_t const ahead = clock + seconds_per_day;
+    span->end = same_offset (ahead)
+        ? ahead + 1 : bisect (clock, ahead, true);
+
+    time_t const behind = clock - seconds_per_day;
+    span->begin = same_offset (behind)
+        ? behind : bisect (behind, clock, false);
+
+    return span;
+}
+
+
+static
+bool
+span_contains (time_zone_cache::SpanPtr const & span, time_t clock,
+    unsigned generation)
+{
+    return span && span->generation == generation
+        && span->begin <= clock && clock < span->end;
+}
+
+
+//! \return Span containing clock or null when the system localtime()
+//! should be used instead.
+static
+internal::time_zone_span const *
+find_time_zone_span (time_t clock)
+{
+    time_zone_cache & cache = get_time_zone_cache ();
+    unsigned const generation
+        = cache.generation.load (std::memory_order_acquire);
+    time_zone_cache::SpanPtr & thread_span = internal::get_tz_span ();
+    if (span_contains (thread_span, clock, generation)) [[likely]]
+        return thread_span.get ();
+
+    thread::MutexGuard guard (cache.mutex);
+    if (! span_contains (cache.span, clock, generation))
+    {
+        // Times before the current span, e.g., of old files being
+        // cleaned up, do not replace it.
+        if (cache.span && cache.span->generation == generation
+            && clock < cache.span->begin)
+            return nullptr;
+
+        cache.span = compute_time_zone_span (clock, generation);
+    }
+
+    thread_span = cache.span;
+    return thread_span.get ();
+}
+
+
+} // namespace
+
+
+void
+localTime (tm* t, Time const & the_time)
+{
+    time_t const clock = to_time_t (the_time);
+    if (internal::time_zone_span const * span = find_time_zone_span (clock))
+        local_time_from_span (*t, *span, clock);
+    else
+        system_local_time (t, clock);
+}
+
+
+chrono::seconds
+localTimeOffset (Time const & the_time)
+{
+    time_t const clock = to_time_t (the_time);
+    if (internal::time_zone_span const * span = find_time_zone_span (clock))
+        return chrono::seconds (span->offset);
+
+    tm t;
+    system_local_time (&t, clock);
+    return chrono::seconds (utc_offset (t, clock));
+}
+
+
+void
+refreshTimeZone ()
+{
+    time_zone_cache & cache = get_time_zone_cache ();
+    thread::MutexGuard guard (cache.mutex);
+#if defined (LOG4CPLUS_HAVE_TIME_H) && ! defined (_WIN32)
+    tzset ();
+#elif defined (_WIN32)
+    _tzset ();
+#endif
+    cache.span.reset ();
+    cache.generation.fetch_add (1, std::memory_order_release);
+}
+
+
+//
+//
+//
+
+namespace
+{
+
+
+//! Event clock selected by setEventClock().
+static std::atomic<EventClock> event_clock {EventClock::Precise};
+
+
+#if defined (CLOCK_REALTIME_COARSE)
+static
+Time
+coarse_now ()
+{
+    timespec ts;
+    ::clock_gettime (CLOCK_REALTIME_COARSE, &ts);
+    return time_from_parts (ts.tv_sec, ts.tv_nsec / 1000);
+}
+#endif
+
+
+#if defined (LOG4CPLUS_HAVE_TSC_CLOCK)
+static
+std::uint64_t
+read_tsc ()
+{
+    return __rdtsc ();
+}
+
+
+static
+bool
+has_invariant_tsc ()
+{
+#if defined (_MSC_VER)
+    int regs[4];
+    __cpuid (regs, 0x80000000);
+    if (static_cast<unsigned>(regs[0]) < 0x80000007u)
+        return false;
+
+    __cpuid (regs, 0x80000007);
+    return (regs[3] & (1 << 8)) != 0;
+#else
+    unsigned eax, ebx, ecx, edx;
+    if (! __get_cpuid (0x80000007u, &eax, &ebx, &ecx, &edx))
+        return false;
+
+    return (edx & (1u << 8)) != 0;
+#endif
+}
+
+
+//! Time stamp counter anchored to now(). Readers use the seq member
+//! as a sequence lock, so that they never block.
+struct tsc_clock_state
+{
+    //! Odd while the anchor is being written.
+    std::atomic<unsigned> seq {0};
+    //! Time stamp counter at the anchor.
+    std::atomic<std::uint64_t> tsc {0};
+    //! now() at the anchor, in microseconds since epoch.
+    std::atomic<long long> usec {0};
+    //! Microseconds per tick as 32.32 fixed point number.
+    std::atomic<std::uint64_t> usec_per_tick {0};
+    //! Number of ticks after which the anchor is renewed.
+    std::atomic<std::uint64_t> reanchor_after {0};
+    //! Serializes writers.
+    std::atomic<bool> anchoring {false};
+};
+
+
+constexpr unsigned tsc_fraction_bits = 32;
+constexpr long long tsc_reanchor_usec = 1000000;
+
+
+static tsc_clock_state tsc_state;
+
+
+static
+void
+store_tsc_anchor (std::uint64_t tsc, long long usec,
+    std::uint64_t usec_per_tick)
+{
+    unsigned const seq = tsc_state.seq.load (std::memory_order_relaxed);
+    tsc_state.seq.store (seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence (std::memory_order_release);
+    tsc_state.tsc.store (tsc, std::memory_order_relaxed);
+    tsc_state.usec.store (usec, std::memory_order_relaxed);
+    tsc_state.usec_per_tick.store (usec_per_tick, std::memory_order_relaxed);
+    tsc_state.reanchor_after.store (
+        (static_cast<std::uint64_t>(tsc_reanchor_usec) << tsc_fraction_bits)
+        / usec_per_tick, std::memory_order_relaxed);
+    tsc_state.seq.store (seq + 2, std::memory_order_release);
+}
+
+
+static
+void
+lock_tsc_anchor ()
+{
+    while (tsc_state.anchoring.exchange (true, std::memory_order_acquire))
+        std::this_thread::yield ();
+}
+
+
+static
+void
+unlock_tsc_anchor ()
+{
+    tsc_state.anchoring.store (false, std::memory_order_release);
+}
+
+
+//! Measures TSC frequency against now() for about 10 ms and anchors
+//! the counter.
+static
+bool
+calibrate_tsc ()
+{
+    long long const calibration_usec = 10000;
+
+    Time const start = now ();
+    std::uint64_t const start_tsc = read_tsc ();
+    Time end;
+    do
+        end = now ();
+    while ((end - start).count () < calibration_usec
+        && end >= start);
+    std::uint64_t const end_tsc = read_tsc ();
+
+    long long const elapsed = (end - start).count ();
+    if (elapsed <= 0 || end_tsc <= start_tsc)
+        return false;
+
+    std::uint64_t const usec_per_tick
+        = (static_cast<std::uint64_t>(elapsed) << tsc_fraction_bits)
+        / (end_tsc - start_tsc);
+    if (usec_per_tick == 0)
+        return false;
+
+    lock_tsc_anchor ();
+    store_tsc_anchor (end_tsc, end.time_since_epoch ().count (),
+        usec_per_tick);
+    unlock_tsc_anchor ();
+    return true;
+}
+
+
+//! Anchors the counter to now() again and refines its frequency using
+//! the time elapsed since the previous anchor.
+static
+Time
+reanchor_tsc ()
+{
+    Time const t = now ();
+    std::uint64_t const tsc = read_tsc ();
+    long long const usec = t.time_since_epoch ().count ();
+
+    std::uint64_t const old_tsc
+        = tsc_state.tsc.load (std::memory_order_relaxed);
+    long long const old_usec
+        = tsc_state.usec.load (std::memory_order_relaxed);
+    std::uint64_t usec_per_tick
+        = tsc_state.usec_per_tick.load (std::memory_order_relaxed);
+
+    // The shift must not overflow; after long idle periods the old
+    // frequency is kept.
+    long long const elapsed = usec - old_usec;
+    if (tsc > old_tsc && elapsed > 0
+        && elapsed < (1LL << (63 - tsc_fraction_bits)))
+    {
+        std::uint64_t const refined
+            = (static_cast<std::uint64_t>(elapsed) << tsc_fraction_bits)
+            / (tsc - old_tsc);
+        if (refined != 0)
+            usec_per_tick = refined;
+    }
+
+    store_tsc_anchor (tsc, usec, usec_per_tick);
+    return t;
+}
+
+
+static
+Time
+tsc_now ()
+{
+    for (;;)
+    {
+        unsigned const seq = tsc_state.seq.load (std::memory_order_acquire);
+        std::uint64_t const anchor_tsc
+            = tsc_state.tsc.load (std::memory_order_relaxed);
+        long long const anchor_usec
+            = tsc_state.usec.load (std::memory_order_relaxed);
+        std::uint64_t const usec_per_tick
+            = tsc_state.usec_per_tick.load (std::memory_order_relaxed);
+        std::uint64_t const reanchor_after
+            = tsc_state.reanchor_after.load (std::memory_order_relaxed);
+        std::atomic_thread_fence (std::memory_order_acquire);
+        if ((seq & 1) != 0
+            || tsc_state.seq.load (std::memory_order_relaxed) != seq)
+            [[unlikely]]
+            continue;
+
+        std::uint64_t const tsc = read_tsc ();
+        // Counters of different cores can differ slightly.
+        std::uint64_t const ticks = tsc > anchor_tsc ? tsc - anchor_tsc : 0;
+        if (ticks >= reanchor_after) [[unlikely]]
+        {
+            // Only one thread re-anchors, the others use now() for
+            // the moment.
+            if (tsc_state.anchoring.exchange (true,
+                    std::memory_order_acquire))
+                return now ();
+
+            Time const t = reanchor_tsc ();
+            unlock_tsc_anchor ();
+            return t;
+        }
+
+        return Time (Duration (anchor_usec + static_cast<long long>(
+            (ticks * usec_per_tick) >> tsc_fraction_bits)));
+    }
+}
+#endif
+
+
+} // namespace
+
+
+bool
+setEventClock (EventClock clock)
+{
+    tchar const * unavailable = nullptr;
+    switch (clock)
+    {
+    case EventClock::Precise:
+        break;
+
+    case EventClock::Coarse:
+#if ! defined (CLOCK_REALTIME_COARSE)
+        unavailable = LOG4CPLUS_TEXT ("CLOCK_REALTIME_COARSE is not")
+            LOG4CPLUS_TEXT (" available");
+#endif
+        break;
+
+    case EventClock::TSC:
+#if defined (LOG4CPLUS_HAVE_TSC_CLOCK)
+        if (! has_invariant_tsc ())
+            unavailable = LOG4CPLUS_TEXT ("CPU does not have invariant TSC");
+        else if (! calibrate_tsc ())
+            unavailable = LOG4CPLUS_TEXT ("TSC calibration failed");
+#else
+        unavailable = LOG4CPLUS_TEXT ("TSC is not supported on this")
+            LOG4CPLUS_TEXT (" platform");
+#endif
+        break;
+
+    default:
+        unavailable = LOG4CPLUS_TEXT ("invalid clock");
+    }
+
+    if (unavailable)
+    {
+        getLogLog ().warn (
+            LOG4CPLUS_TEXT ("setEventClock()- ") + tstring (unavailable)
+            + LOG4CPLUS_TEXT (", using precise clock"));
+        clock = EventClock::Precise;
+    }
+
+    event_clock.store (clock, std::memory_order_release);
+    return ! unavailable;
+}
+
+
+EventClock
+getEventClock ()
+{
+    return event_clock.load (std::memory_order_relaxed);
+}
+
+
+Time
+eventNow ()
+{
+    switch (event_clock.load (std::memory_order_acquire))
+    {
+#if defined (CLOCK_REALTIME_COARSE)
+    case EventClock::Coarse:
+        return coarse_now ();
+#endif
+
+#if defined (LOG4CPLUS_HAVE_TSC_CLOCK)
+    case EventClock::TSC:
+        return tsc_now ();
+#endif
+
+    default:
+        return now ();
+    }
+}
+
+
 namespace
 {
 
@@ -270,6 +841,14 @@ getFormattedTime(const log4cplus::tstring& fmt_orig,
         }
     }
 
+    // Trailing percent sign has no conversion character following it,
+    // emit it literally.
+    if (state == PERCENT_SIGN)
+    {
+        gft_sp.ret.push_back (LOG4CPLUS_TEXT ('%'));
+        gft_sp.ret.push_back (LOG4CPLUS_TEXT ('%'));
+    }
+
     // Finally call strftime/wcsftime to format the rest of the string.
 
     gft_sp.fmt.swap (gft_sp.ret);
@@ -315,4 +894,346 @@ getFormattedTime(const log4cplus::tstring& fmt_orig,
 }
 
 
+//
+//
+//
+
+namespace
+{
+
+
+static
+void
+append_three_digits (log4cplus::tstring & str, long value)
+{
+    tchar const digits[3] = {
+        static_cast<tchar>(LOG4CPLUS_TEXT ('0') + value / 100),
+        static_cast<tchar>(LOG4CPLUS_TEXT ('0') + value / 10 % 10),
+        static_cast<tchar>(LOG4CPLUS_TEXT ('0') + value % 10) };
+    str.append (digits, 3);
+}
+
+
+} // namespace
+
+
+FormattedTimeCache::FormattedTimeCache ()
+    : separator (0)
+    , second (0)
+    , use_gmtime (false)
+    , valid (false)
+{ }
+
+
+FormattedTimeCache::FormattedTimeCache (log4cplus::tstring const & fmt,
+    bool gmtime)
+    : FormattedTimeCache ()
+{
+    setFormat (fmt, gmtime);
+}
+
+
+void
+FormattedTimeCache::setFormat (log4cplus::tstring const & fmt, bool gmtime)
+{
+    segments.clear ();
+    joined_fmt.clear ();
+    separator = 0;
+    use_gmtime = gmtime;
+    valid = false;
+
+    // Split the format the same way getFormattedTime() walks it, so
+    // that, e.g., "%%q" stays literal text.
+
+    Segment segment;
+    segment.sub_second = NONE;
+    bool percent_sign = false;
+    for (auto fmt_ch : fmt)
+    {
+        if (! percent_sign)
+        {
+            if (fmt_ch == LOG4CPLUS_TEXT ('%'))
+                percent_sign = true;
+            else
+                segment.fmt.push_back (fmt_ch);
+            continue;
+        }
+
+        percent_sign = false;
+        if (fmt_ch == LOG4CPLUS_TEXT ('q') || fmt_ch == LOG4CPLUS_TEXT ('Q'))
+        {
+            segment.sub_second
+                = fmt_ch == LOG4CPLUS_TEXT ('q') ? MILLIS : MICROS;
+            segments.push_back (std::move (segment));
+            segment = Segment ();
+            segment.sub_second = NONE;
+        }
+        else
+        {
+            segment.fmt.push_back (LOG4CPLUS_TEXT ('%'));
+            segment.fmt.push_back (fmt_ch);
+        }
+    }
+
+    // Trailing percent sign is literal text, see getFormattedTime().
+    if (percent_sign)
+    {
+        segment.fmt.push_back (LOG4CPLUS_TEXT ('%'));
+        segment.fmt.push_back (LOG4CPLUS_TEXT ('%'));
+    }
+
+    if (! segment.fmt.empty ())
+        segments.push_back (std::move (segment));
+
+    if (segments.size () < 2)
+        return;
+
+    // Pick a control character that is not in the format as the
+    // separator. Conversion specifiers do not produce control
+    // characters, so it also does not occur in the formatted text
+    // other than where it has been put.
+    for (tchar ch = 1; ch != 0x20; ++ch)
+        if (fmt.find (ch) == tstring::npos)
+        {
+            separator = ch;
+            break;
+        }
+
+    if (! separator)
+        return;
+
+    for (auto const & seg : segments)
+    {
+        if (&seg != &segments.front ())
+            joined_fmt.push_back (separator);
+        joined_fmt.append (seg.fmt);
+    }
+}
+
+
+void
+FormattedTimeCache::formatSegments (Time const & the_time)
+{
+    if (segments.size () == 1)
+    {
+        segments.front ().text = getFormattedTime (segments.front ().fmt,
+            the_time, use_gmtime);
+        return;
+    }
+
+    if (separator)
+    {
+        tstring const joined = getFormattedTime (joined_fmt, the_time,
+            use_gmtime);
+        tstring::size_type pos = 0;
+        std::size_t i = 0;
+        for (; i != segments.size (); ++i)
+        {
+            tstring::size_type const end = joined.find (separator, pos);
+            if ((end == tstring::npos) != (i + 1 == segments.size ()))
+                break;
+
+            segments[i].text.assign (joined, pos,
+                end == tstring::npos ? tstring::npos : end - pos);
+            pos = end + 1;
+        }
+
+        if (i == segments.size ())
+            return;
+    }
+
+    // Fall back to formatting segments one by one if the separator
+    // could not be used.
+    for (auto & segment : segments)
+        segment.text = getFormattedTime (segment.fmt, the_time,
+            use_gmtime);
+}
+
+
+log4cplus::tstring const &
+FormattedTimeCache::format (Time const & the_time)
+{
+    result.clear ();
+    append (result, the_time);
+    return result;
+}
+
+
+void
+FormattedTimeCache::append (log4cplus::tstring & buffer,
+    Time const & the_time)
+{
+    time_t const tv_sec = to_time_t (the_time);
+    if (! valid || tv_sec != second)
+    {
+        formatSegments (the_time);
+        second = tv_sec;
+        valid = true;
+    }
+
+    long const tv_usec = microseconds_part (the_time);
+    for (auto const & segment : segments)
+    {
+        buffer.append (segment.text);
+        switch (segment.sub_second)
+        {
+        case MILLIS:
+            append_three_digits (buffer, tv_usec / 1000);
+            break;
+
+        case MICROS:
+            append_three_digits (buffer, tv_usec / 1000);
+            buffer.push_back (LOG4CPLUS_TEXT ('.'));
+            append_three_digits (buffer, tv_usec % 1000);
+            break;
+
+        case NONE:
+            break;
+        }
+    }
+}
+
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#if ! defined (_WIN32)
+CATCH_TEST_CASE ("localTime", "[timehelper]")
+{
+    char const * const old_tz = std::getenv ("TZ");
+    std::string const saved_tz = old_tz ? old_tz : "";
+
+    auto check = [] (time_t clock)
+    {
+        tm expected, actual;
+        system_local_time (&expected, clock);
+        localTime (&actual, from_time_t (clock));
+        CATCH_REQUIRE (actual.tm_sec == expected.tm_sec);
+        CATCH_REQUIRE (actual.tm_min == expected.tm_min);
+        CATCH_REQUIRE (actual.tm_hour == expected.tm_hour);
+        CATCH_REQUIRE (actual.tm_mday == expected.tm_mday);
+        CATCH_REQUIRE (actual.tm_mon == expected.tm_mon);
+        CATCH_REQUIRE (actual.tm_year == expected.tm_year);
+        CATCH_REQUIRE (actual.tm_wday == expected.tm_wday);
+        CATCH_REQUIRE (actual.tm_yday == expected.tm_yday);
+        CATCH_REQUIRE (actual.tm_isdst == expected.tm_isdst);
+        CATCH_REQUIRE (localTimeOffset (from_time_t (clock)).count ()
+            == utc_offset (expected, clock));
+    };
+
+    // Central European time switches to summer time at
+    // 2023-03-26 01:00:00 UTC and back at 2023-10-29 01:00:00 UTC.
+    ::setenv ("TZ", "CET-1CEST,M3.5.0,M10.5.0/3", 1);
+    refreshTimeZone ();
+    for (time_t transition : { time_t (1679792400), time_t (1698541200) })
+    {
+        for (time_t clock = transition - 2 * seconds_per_day;
+             clock < transition + 2 * seconds_per_day; clock += 599)
+            check (clock);
+
+        check (transition - 1);
+        check (transition);
+    }
+
+    // Times before the cached span and far from it.
+    check (0);
+    check (951782400); // 2000-02-29
+    check (4102444799); // 2099-12-31 23:59:59
+
+    // Time zone change is picked up after refreshTimeZone().
+    ::setenv ("TZ", "UTC+5", 1);
+    refreshTimeZone ();
+    check (1700000000);
+    CATCH_REQUIRE (localTimeOffset (from_time_t (1700000000)).count ()
+        == -5 * 3600);
+
+    if (old_tz)
+        ::setenv ("TZ", saved_tz.c_str (), 1);
+    else
+        ::unsetenv ("TZ");
+    refreshTimeZone ();
+}
+#endif
+
+
+CATCH_TEST_CASE ("EventClock", "[timehelper]")
+{
+    for (EventClock clock : { EventClock::Precise, EventClock::Coarse,
+            EventClock::TSC })
+    {
+        bool const selected = setEventClock (clock);
+        CATCH_REQUIRE (getEventClock ()
+            == (selected ? clock : EventClock::Precise));
+
+        // Coarse clock lags by up to a scheduler tick.
+        for (int i = 0; i != 1000; ++i)
+        {
+            Time const before = now ();
+            Time const t = eventNow ();
+            Time const after = now ();
+            CATCH_REQUIRE (t >= before - chrono::milliseconds (50));
+            CATCH_REQUIRE (t <= after + chrono::milliseconds (50));
+        }
+    }
+
+    setEventClock (EventClock::Precise);
+    CATCH_REQUIRE (getEventClock () == EventClock::Precise);
+}
+
+
+CATCH_TEST_CASE ("FormattedTimeCache", "[timehelper]")
+{
+    // No separator is available for this format, segments are
+    // formatted one by one.
+    tstring all_control_chars (LOG4CPLUS_TEXT ("%S.%q"));
+    for (tchar ch = 1; ch != 0x20; ++ch)
+        all_control_chars.push_back (ch);
+    all_control_chars.append (LOG4CPLUS_TEXT ("%M.%Q"));
+
+    tstring const formats[] = {
+        LOG4CPLUS_TEXT ("%Y-%m-%d %H:%M:%S,%q"),
+        LOG4CPLUS_TEXT ("%s, %Q%%q%q %%Q %%q=%%%q%%;%%q, %%Q=%Q"),
+        LOG4CPLUS_TEXT ("%q%Q"),
+        LOG4CPLUS_TEXT ("%d.%m.%Y"),
+        LOG4CPLUS_TEXT ("%H:%M:%S.%q %"),
+        LOG4CPLUS_TEXT ("%q%"),
+        LOG4CPLUS_TEXT ("\x01%S\x02%q\x03"),
+        LOG4CPLUS_TEXT (""),
+        all_control_chars };
+    Time const base = from_time_t (1700000000);
+    long long const offsets[] = { 0, 7, 123456, 999999, 1000000, 1000001,
+        1500000, 3600000000LL + 17 };
+
+    for (bool gmtime : { true, false })
+        for (auto const & fmt : formats)
+        {
+            FormattedTimeCache cache (fmt, gmtime);
+            for (long long offset : offsets)
+            {
+                Time const t = base + chrono::microseconds (offset);
+                CATCH_REQUIRE (cache.format (t)
+                    == getFormattedTime (fmt, t, gmtime));
+            }
+        }
+
+    CATCH_SECTION ("trailing percent sign")
+    {
+        CATCH_REQUIRE (getFormattedTime (LOG4CPLUS_TEXT ("%H%"), base, true)
+            == LOG4CPLUS_TEXT ("22%"));
+        FormattedTimeCache cache (LOG4CPLUS_TEXT ("%S,%q%"), true);
+        CATCH_REQUIRE (cache.format (base + chrono::milliseconds (5))
+            == LOG4CPLUS_TEXT ("20,005%"));
+    }
+
+    CATCH_SECTION ("setFormat")
+    {
+        FormattedTimeCache cache (LOG4CPLUS_TEXT ("%H"), true);
+        CATCH_REQUIRE (cache.format (base) == LOG4CPLUS_TEXT ("22"));
+        cache.setFormat (LOG4CPLUS_TEXT ("%M:%S.%q"), true);
+        CATCH_REQUIRE (cache.format (base + chrono::milliseconds (5))
+            == LOG4CPLUS_TEXT ("13:20.005"));
+    }
+}
+#endif
+
+
+
 } // namespace log4cplus::helpers
@@ -0,0 +1,438 @@
+// -*- C++ -*-
+//
+//  Copyright (C) 2026, Vaclav Haisman. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <log4cplus/config.hxx>
+#include <log4cplus/helpers/timeindex.h>
+#include <log4cplus/helpers/loglog.h>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iterator>
+#include <system_error>
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+#include <catch_amalgamated.hpp>
+#endif
+
+
+namespace log4cplus::helpers {
+
+
+namespace
+{
+
+char const index_magic[8] = { 'L', '4', 'C', 'P', 'T', 'I', 'D', 'X' };
+std::uint32_t const index_version = 1;
+
+
+void
+store_le (char * out, std::uint64_t value, std::size_t bytes)
+{
+    for (std::size_t i = 0; i != bytes; ++i)
+        out[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+}
+
+
+std::uint64_t
+get_le (char const * data, std::size_t bytes)
+{
+    std::uint64_t value = 0;
+    for (std::size_t i = bytes; i != 0; --i)
+        value = (value << 8) | static_cast<unsigned char>(data[i - 1]);
+    return value;
+}
+
+
+//! \return Interval of the index or 0 when `header` is not a header of
+//! time index.
+unsigned long
+parse_header (char const * header)
+{
+    if (std::memcmp (header, index_magic, sizeof (index_magic)) != 0
+        || get_le (header + 8, 4) != index_version)
+        return 0;
+
+    return static_cast<unsigned long>(get_le (header + 12, 4));
+}
+
+
+TimeIndexEntry
+parse_entry (char const * data)
+{
+    TimeIndexEntry entry;
+    entry.time = Time (Duration (static_cast<long long>(get_le (data, 8))));
+    entry.offset = get_le (data + 8, 8);
+    return entry;
+}
+
+
+long long const no_entries = (std::numeric_limits<long long>::max) ();
+
+} // namespace
+
+
+tstring
+timeIndexName (tstring const & logName)
+{
+    return logName + LOG4CPLUS_TEXT (".idx");
+}
+
+
+//
+//
+//
+
+TimeIndexWriter::TimeIndexWriter (unsigned long interval)
+    : length (static_cast<long long>((std::max) (interval, 1ul)) * 1000000)
+    , next (no_entries)
+{ }
+
+
+TimeIndexWriter::~TimeIndexWriter ()
+{ }
+
+
+bool
+TimeIndexWriter::open (tstring const & name, bool append,
+    std::uint64_t logSize)
+{
+    close ();
+
+    std::filesystem::path const path (name);
+    std::uint64_t keep = 0;
+    long long last = (std::numeric_limits<long long>::min) ();
+    if (append)
+    {
+        // Keep the entries that belong to the log file.
+        std::ifstream in (path, std::ios_base::in | std::ios_base::binary);
+        char header[header_size];
+        if (in.read (header, header_size)
+            && parse_header (header) * 1000000ull
+                == static_cast<unsigned long long>(length))
+        {
+            keep = header_size;
+            char data[entry_size];
+            while (in.read (data, entry_size))
+            {
+                TimeIndexEntry const entry = parse_entry (data);
+                if (entry.offset > logSize)
+                    break;
+
+                keep += entry_size;
+                last = entry.time.time_since_epoch ().count ();
+            }
+        }
+    }
+
+    std::error_code ec;
+    if (keep != 0)
+    {
+        std::filesystem::resize_file (path, keep, ec);
+        if (ec)
+            keep = 0;
+    }
+
+    if (keep != 0)
+        out.open (path, std::ios_base::out | std::ios_base::app
+            | std::ios_base::binary);
+    else
+    {
+        out.open (path, std::ios_base::out | std::ios_base::trunc
+            | std::ios_base::binary);
+        char header[header_size];
+        std::memcpy (header, index_magic, sizeof (index_magic));
+        store_le (header + 8, index_version, 4);
+        store_le (header + 12,
+            static_cast<std::uint64_t>(length / 1000000), 4);
+        out.write (header, header_size);
+        out.flush ();
+    }
+
+    if (! out.good ())
+    {
+        getLogLog ().error (
+            LOG4CPLUS_TEXT ("TimeIndexWriter: Failed to open ") + name);
+        close ();
+        return false;
+    }
+
+    next = keep > header_size ? last + length
+        : (std::numeric_limits<long long>::min) ();
+    return true;
+}
+
+
+void
+TimeIndexWriter::close ()
+{
+    if (out.is_open ())
+        out.close ();
+    out.clear ();
+    next = no_entries;
+}
+
+
+bool
+TimeIndexWriter::is_open () const
+{
+    return out.is_open ();
+}
+
+
+void
+TimeIndexWriter::addEntry (Time const & timestamp, std::uint64_t offset)
+{
+    long long const time = timestamp.time_since_epoch ().count ();
+    long long start = time / length * length;
+    if (start > time)
+        start -= length;
+
+    char data[entry_size];
+    store_le (data, static_cast<std::uint64_t>(start), 8);
+    store_le (data + 8, offset, 8);
+    // The entry is written immediately, it is at most one write per
+    // interval.
+    out.write (data, entry_size);
+    out.flush ();
+    next = start + length;
+}
+
+
+//
+//
+//
+
+TimeIndexReader::TimeIndexReader ()
+    : seconds (0)
+{ }
+
+
+TimeIndexReader::~TimeIndexReader ()
+{ }
+
+
+bool
+TimeIndexReader::open (tstring const & name)
+{
+    close ();
+
+    std::ifstream in (std::filesystem::path (name),
+        std::ios_base::in | std::ios_base::binary);
+    char header[TimeIndexWriter::header_size];
+    if (! in.read (header, TimeIndexWriter::header_size))
+        return false;
+
+    unsigned long const interval = parse_header (header);
+    if (interval == 0)
+        return false;
+
+    char data[TimeIndexWriter::entry_size];
+    while (in.read (data, TimeIndexWriter::entry_size))
+        items.push_back (parse_entry (data));
+
+    seconds = interval;
+    return true;
+}
+
+
+void
+TimeIndexReader::close ()
+{
+    items.clear ();
+    seconds = 0;
+}
+
+
+unsigned long
+TimeIndexReader::interval () const
+{
+    return seconds;
+}
+
+
+std::vector<TimeIndexEntry> const &
+TimeIndexReader::entries () const
+{
+    return items;
+}
+
+
+std::uint64_t
+TimeIndexReader::find (Time const & time) const
+{
+    // The last entry whose interval starts at or before `time`.
+    auto const it = std::upper_bound (items.begin (), items.end (), time,
+        [] (Time const & t, TimeIndexEntry const & entry) {
+            return t < entry.time; });
+    return it == items.begin () ? 0 : std::prev (it)->offset;
+}
+
+
+std::pair<std::uint64_t, std::uint64_t>
+TimeIndexReader::range (Time const & from, Time const & to) const
+{
+    auto const it = std::upper_bound (items.begin (), items.end (), to,
+        [] (Time const & t, TimeIndexEntry const & entry) {
+            return t < entry.time; });
+    return { find (from), it == items.end () ? npos : it->offset };
+}
+
+
+bool
+TimeIndexReader::readRange (tstring const & logName, Time const & from,
+    Time const & to, std::string & out) const
+{
+    std::ifstream in (std::filesystem::path (logName),
+        std::ios_base::in | std::ios_base::binary);
+    if (! in.is_open ())
+        return false;
+
+    auto const [begin, end] = range (from, to);
+    if (! in.seekg (static_cast<std::streamoff>(begin)))
+        return false;
+
+    char buf[64 * 1024];
+    std::uint64_t remaining = end - begin;
+    while (remaining != 0 && in)
+    {
+        in.read (buf, static_cast<std::streamsize>(
+            (std::min<std::uint64_t>) (remaining, sizeof (buf))));
+        out.append (buf, static_cast<std::size_t>(in.gcount ()));
+        remaining -= static_cast<std::uint64_t>(in.gcount ());
+    }
+
+    return ! in.bad ();
+}
+
+
+#if defined (LOG4CPLUS_WITH_UNIT_TESTS)
+CATCH_TEST_CASE ("TimeIndex", "[timeindex]")
+{
+    tstring const logName (LOG4CPLUS_TEXT ("time_index_test.log"));
+    tstring const indexName (timeIndexName (logName));
+    Time const start = from_time_t (1000000);
+    auto record = [] (int i) {
+        return "record " + std::to_string (i) + "\n";
+    };
+    // Ten records per second.
+    auto write_records = [&] (std::ofstream & log, TimeIndexWriter & index,
+        int first, int count) {
+        for (int i = first; i != first + count; ++i)
+        {
+            index.add (start + chrono::milliseconds (i * 100),
+                static_cast<std::uint64_t>(log.tellp ()));
+            log << record (i);
+        }
+    };
+
+    std::filesystem::remove (std::filesystem::path (logName));
+    std::filesystem::remove (std::filesystem::path (indexName));
+
+    CATCH_SECTION ("range")
+    {
+        {
+            std::ofstream log (std::filesystem::path (logName),
+                std::ios_base::binary);
+            TimeIndexWriter index;
+            CATCH_REQUIRE (index.open (indexName, false, 0));
+            write_records (log, index, 0, 1000);
+        }
+
+        TimeIndexReader reader;
+        CATCH_REQUIRE (reader.open (indexName));
+        CATCH_REQUIRE (reader.interval () == 1);
+        CATCH_REQUIRE (reader.entries ().size () == 100);
+        CATCH_REQUIRE (reader.find (start - chrono::seconds (1)) == 0);
+
+        std::string data;
+        CATCH_REQUIRE (reader.readRange (logName,
+            start + chrono::milliseconds (50 * 100 + 50),
+            start + chrono::milliseconds (52 * 100), data));
+        // Whole seconds around the range are read.
+        std::string expected;
+        for (int i = 50; i != 60; ++i)
+            expected += record (i);
+        CATCH_REQUIRE (data == expected);
+
+        data.clear ();
+        CATCH_REQUIRE (reader.readRange (logName,
+            start + chrono::seconds (99), start + chrono::seconds (200),
+            data));
+        CATCH_REQUIRE (data.find (record (990)) == 0);
+        CATCH_REQUIRE (data.size () == data.rfind (record (999))
+            + record (999).size ());
+    }
+
+    CATCH_SECTION ("append")
+    {
+        std::uint64_t size = 0;
+        {
+            std::ofstream log (std::filesystem::path (logName),
+                std::ios_base::binary);
+            TimeIndexWriter index;
+            CATCH_REQUIRE (index.open (indexName, false, 0));
+            write_records (log, index, 0, 100);
+            size = static_cast<std::uint64_t>(log.tellp ());
+        }
+        {
+            std::ofstream log (std::filesystem::path (logName),
+                std::ios_base::binary | std::ios_base::app);
+            TimeIndexWriter index;
+            CATCH_REQUIRE (index.open (indexName, true, size));
+            // Records of the last indexed second do not add entries.
+            write_records (log, index, 95, 105);
+        }
+
+        TimeIndexReader reader;
+        CATCH_REQUIRE (reader.open (indexName));
+        CATCH_REQUIRE (reader.entries ().size () == 20);
+        CATCH_REQUIRE (reader.entries ()[10].offset == size
+            + record (95).size () * 5);
+
+        // Entries beyond the end of the log file are dropped.
+        {
+            TimeIndexWriter index;
+            CATCH_REQUIRE (index.open (indexName, true, size));
+        }
+        CATCH_REQUIRE (reader.open (indexName));
+        CATCH_REQUIRE (reader.entries ().size () == 10);
+
+        // Index with another interval is started again.
+        {
+            TimeIndexWriter index (60);
+            CATCH_REQUIRE (index.open (indexName, true, size));
+        }
+        CATCH_REQUIRE (reader.open (indexName));
+        CATCH_REQUIRE (reader.interval () == 60);
+        CATCH_REQUIRE (reader.entries ().empty ());
+    }
+
+    std::filesystem::remove (std::filesystem::path (logName));
+    std::filesystem::remove (std::filesystem::path (indexName));
+}
+#endif
+
+
+} // namespace log4cplus::helpers
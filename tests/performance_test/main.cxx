@@ -7,6 +7,12 @@
 #include <log4cplus/helpers/fileinfo.h>
 #include <log4cplus/spi/loggingevent.h>
 #include <log4cplus/initializer.h>
+#include <log4cplus/nullappender.h>
+#include <log4cplus/fileappender.h>
+#include <log4cplus/helpers/property.h>
+#include <cstdio>
+#include <thread>
+#include <vector>
 
 
 using namespace std;
@@ -24,6 +30,7 @@ log4cplus::tostream& operator <<(log4cplus::tostream& s, const Time& t)
 
 
 #define LOOP_COUNT 100000
+#define MAX_THREADS 8
 
 
 log4cplus::tstring
@@ -42,6 +49,106 @@ getPropertiesFileArgument (int argc, char * argv[])
 }
 
 
+//! Logs LOOP_COUNT events from each of `threads_count` threads through
+//! the same logger and returns the time it took.
+double
+measureContention (Logger const & logger, unsigned threads_count)
+{
+    std::vector<std::thread> threads;
+    threads.reserve (threads_count);
+
+    hr_clock::time_point const start = hr_clock::now ();
+    for (unsigned t = 0; t != threads_count; ++t)
+        threads.emplace_back ([&logger] {
+            for (int i = 0; i != LOOP_COUNT; ++i)
+                LOG4CPLUS_WARN_STR (logger,
+                    LOG4CPLUS_TEXT ("This is a WARNING..."));
+        });
+
+    for (auto & th : threads)
+        th.join ();
+    hr_clock::time_point const end = hr_clock::now ();
+
+    return sec_dur_type (end - start).count ();
+}
+
+
+//! Logs LOOP_COUNT events into a file through a FileAppender with the
+//! given `Backend` and `ImmediateFlush` properties and returns the time
+//! it took.
+double
+measureFileBackend (tstring const & backend, bool immediateFlush)
+{
+    tstring const fileName (LOG4CPLUS_TEXT ("performance_test_backend.log"));
+
+    helpers::Properties props;
+    props.setProperty (LOG4CPLUS_TEXT ("File"), fileName);
+    props.setProperty (LOG4CPLUS_TEXT ("Backend"), backend);
+    props.setProperty (LOG4CPLUS_TEXT ("ImmediateFlush"),
+        immediateFlush ? LOG4CPLUS_TEXT ("true") : LOG4CPLUS_TEXT ("false"));
+
+    SharedAppenderPtr appender (new FileAppender (props));
+    appender->setLayout (std::unique_ptr<Layout> (
+        new PatternLayout (LOG4CPLUS_TEXT ("%-5p %c - %m%n"))));
+
+    Logger logger = Logger::getInstance (LOG4CPLUS_TEXT ("file_backend"));
+    logger.setAdditivity (false);
+    logger.removeAllAppenders ();
+    logger.addAppender (appender);
+
+    hr_clock::time_point const start = hr_clock::now ();
+    for (int i = 0; i != LOOP_COUNT; ++i)
+        LOG4CPLUS_WARN_STR (logger, LOG4CPLUS_TEXT ("This is a WARNING..."));
+    appender->close ();
+    hr_clock::time_point const end = hr_clock::now ();
+
+    logger.removeAllAppenders ();
+    std::remove (LOG4CPLUS_TSTRING_TO_STRING (fileName).c_str ());
+
+    return sec_dur_type (end - start).count ();
+}
+
+
+//! Logs `LOOP_COUNT` events through RollingFileAppender with
+//! ImmediateFlush=false and returns the time it took. Files are large
+//! enough so that no rollover happens. This measures the cost of
+//! keeping track of the file size.
+double
+measureRollingFileAppender (tstring const & backend)
+{
+    tstring const fileName (LOG4CPLUS_TEXT ("performance_test_rolling.log"));
+
+    helpers::Properties props;
+    props.setProperty (LOG4CPLUS_TEXT ("File"), fileName);
+    props.setProperty (LOG4CPLUS_TEXT ("Backend"), backend);
+    props.setProperty (LOG4CPLUS_TEXT ("ImmediateFlush"),
+        LOG4CPLUS_TEXT ("false"));
+    props.setProperty (LOG4CPLUS_TEXT ("Append"), LOG4CPLUS_TEXT ("false"));
+    props.setProperty (LOG4CPLUS_TEXT ("MaxFileSize"),
+        LOG4CPLUS_TEXT ("1000MB"));
+
+    SharedAppenderPtr appender (new RollingFileAppender (props));
+    appender->setLayout (std::unique_ptr<Layout> (
+        new PatternLayout (LOG4CPLUS_TEXT ("%-5p %c - %m%n"))));
+
+    Logger logger = Logger::getInstance (LOG4CPLUS_TEXT ("rolling"));
+    logger.setAdditivity (false);
+    logger.removeAllAppenders ();
+    logger.addAppender (appender);
+
+    hr_clock::time_point const start = hr_clock::now ();
+    for (int i = 0; i != LOOP_COUNT; ++i)
+        LOG4CPLUS_WARN_STR (logger, LOG4CPLUS_TEXT ("This is a WARNING..."));
+    appender->close ();
+    hr_clock::time_point const end = hr_clock::now ();
+
+    logger.removeAllAppenders ();
+    std::remove (LOG4CPLUS_TSTRING_TO_STRING (fileName).c_str ());
+
+    return sec_dur_type (end - start).count ();
+}
+
+
 int
 main(int argc, char * argv[])
 {
@@ -136,6 +243,92 @@ main(int argc, char * argv[])
                        << diff_seconds);
         LOG4CPLUS_WARN(root, "getThread() average: "
                        << (diff_seconds/LOOP_COUNT) << endl);
+
+        // Cost of time stamping of events with each of the event
+        // clocks, alone and as part of creating an event.
+        for (EventClock clock : {EventClock::Precise, EventClock::Coarse,
+                EventClock::TSC})
+        {
+            tchar const * const clockName
+                = clock == EventClock::Precise ? LOG4CPLUS_TEXT ("Precise")
+                : clock == EventClock::Coarse ? LOG4CPLUS_TEXT ("Coarse")
+                : LOG4CPLUS_TEXT ("TSC");
+            if (! setEventClock (clock))
+            {
+                LOG4CPLUS_WARN(root, "EventClock " << clockName
+                               << " is not available" << endl);
+                continue;
+            }
+
+            start = hr_clock::now ();
+            for(i=0; i<LOOP_COUNT; ++i) {
+                Time volatile t = eventNow ();
+                (void) t;
+            }
+            end = hr_clock::now ();
+            diff_seconds = sec_dur_type (end - start).count ();
+            LOG4CPLUS_WARN(root, "EventClock " << clockName
+                           << " eventNow() average: "
+                           << (diff_seconds/LOOP_COUNT) << endl);
+
+            start = hr_clock::now ();
+            for(i=0; i<LOOP_COUNT; ++i) {
+                log4cplus::spi::InternalLoggingEvent e(logger.getName(),
+                    log4cplus::WARN_LOG_LEVEL, msg, __FILE__, __LINE__,
+                    "main");
+            }
+            end = hr_clock::now ();
+            diff_seconds = sec_dur_type (end - start).count ();
+            LOG4CPLUS_WARN(root, "EventClock " << clockName
+                           << " creating log object average: "
+                           << (diff_seconds/LOOP_COUNT) << endl);
+        }
+        setEventClock (EventClock::Precise);
+
+        // Appenders dispatch contention. All threads log through one
+        // logger with a NullAppender attached, so the cost is dominated by
+        // synchronization on the logger's appender list.
+        Logger contention = Logger::getInstance(LOG4CPLUS_TEXT("contention"));
+        contention.setAdditivity(false);
+        contention.addAppender(SharedAppenderPtr(new NullAppender));
+        for (unsigned threads = 1; threads <= MAX_THREADS; threads *= 2)
+        {
+            diff_seconds = measureContention (contention, threads);
+            LOG4CPLUS_WARN(root, "Appenders dispatch with " << threads
+                           << " threads: "
+                           << (threads * LOOP_COUNT / diff_seconds)
+                           << " events/s, average per event: "
+                           << (diff_seconds / (threads * LOOP_COUNT))
+                           << endl);
+        }
+
+        // FileAppender throughput, std::ofstream based Stream backend
+        // against file descriptor based Direct and IoUring backends.
+        // IoUring falls back to Direct when io_uring is not available.
+        for (bool immediateFlush : {true, false})
+            for (tchar const * backend : {LOG4CPLUS_TEXT ("Stream"),
+                    LOG4CPLUS_TEXT ("Direct"), LOG4CPLUS_TEXT ("IoUring")})
+            {
+                diff_seconds = measureFileBackend (backend, immediateFlush);
+                LOG4CPLUS_WARN(root, "FileAppender Backend=" << backend
+                               << " ImmediateFlush=" << immediateFlush
+                               << ": " << (LOOP_COUNT / diff_seconds)
+                               << " events/s, average per event: "
+                               << (diff_seconds / LOOP_COUNT) << endl);
+            }
+
+        // RollingFileAppender throughput with buffered output. The
+        // rollover check used to call tellp() for each event.
+        for (tchar const * backend : {LOG4CPLUS_TEXT ("Stream"),
+                LOG4CPLUS_TEXT ("Direct")})
+        {
+            diff_seconds = measureRollingFileAppender (backend);
+            LOG4CPLUS_WARN(root, "RollingFileAppender Backend=" << backend
+                           << " ImmediateFlush=0: "
+                           << (LOOP_COUNT / diff_seconds)
+                           << " events/s, average per event: "
+                           << (diff_seconds / LOOP_COUNT) << endl);
+        }
     }
     catch(...) {
         tcout << LOG4CPLUS_TEXT("Exception...") << endl;